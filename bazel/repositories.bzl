@@ -9,6 +9,7 @@ PPC_SKIP_TARGETS = ["envoy.filters.http.lua"]
 
 WINDOWS_SKIP_TARGETS = [
     "envoy.filters.http.lua",
+    "envoy.stat_sinks.shared_memory",
     "envoy.tracers.dynamic_ot",
     "envoy.tracers.lightstep",
     "envoy.tracers.datadog",
@@ -64,6 +64,16 @@ public:
    */
   virtual void drainConnections() PURE;
 
+  /**
+   * Prefetches an upstream connection, if existing connections do not meet both current and
+   * anticipated load. Called ahead of a stream that is expected to be assigned to this pool.
+   *
+   * @param prefetch_ratio the number of streams to be provisioned for per current stream,
+   *        counting the anticipated stream as pending.
+   * @return true if a connection was prefetched, false otherwise.
+   */
+  virtual bool maybePrefetch(float prefetch_ratio) PURE;
+
   /**
    * @return Upstream::HostDescriptionConstSharedPtr the host for which connections are pooled.
    */
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include "envoy/common/pure.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Decides when the requests of a route are hedged, from the response times of its recent
+ * requests, and bounds how many of them are. A controller is shared by all requests of a route on
+ * all workers. It does not depend on the protocol of the requests, so that any router which can
+ * send a request again can hedge with it.
+ */
+class HedgeController {
+public:
+  virtual ~HedgeController() = default;
+
+  /**
+   * Records a request of the route, which adds to the budget of hedged requests.
+   */
+  virtual void onRequest() PURE;
+
+  /**
+   * @return the time after which a request which is just sent should be hedged, or absl::nullopt
+   *         if too few response times have been recorded to tell.
+   */
+  virtual absl::optional<std::chrono::milliseconds> hedgeDelay() const PURE;
+
+  /**
+   * Takes a hedged request from the budget.
+   * @return whether the budget allows for the request to be hedged.
+   */
+  virtual bool tryHedge() PURE;
+
+  /**
+   * Records the response time of a request, which later hedge delays are based on.
+   * @param response_time supplies the time between sending the request and its first response
+   *        byte.
+   */
+  virtual void recordResponseTime(std::chrono::milliseconds response_time) PURE;
+};
+
+using HedgeControllerSharedPtr = std::shared_ptr<HedgeController>;
+
+} // namespace Router
+} // namespace Envoy
@@ -19,6 +19,7 @@
 #include "envoy/http/conn_pool.h"
 #include "envoy/http/hash_policy.h"
 #include "envoy/http/header_map.h"
+#include "envoy/router/hedge_controller.h"
 #include "envoy/router/internal_redirect.h"
 #include "envoy/tcp/conn_pool.h"
 #include "envoy/tracing/http_tracer.h"
@@ -554,6 +555,12 @@ public:
    * will be canceled immediately.
    */
   virtual bool hedgeOnPerTryTimeout() const PURE;
+
+  /**
+   * @return the controller which hedges the requests of the route once they take longer than most
+   *         of them, or nullptr if requests are not hedged on their latency.
+   */
+  virtual HedgeController* latencyHedgeController() const PURE;
 };
 
 class MetadataMatchCriterion {
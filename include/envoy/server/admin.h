@@ -21,6 +21,12 @@ class AdminStream {
 public:
   virtual ~AdminStream() = default;
 
+  /**
+   * Callback appending the next chunk of a response to the buffer.
+   * @return bool whether more chunks follow.
+   */
+  using NextChunkCb = std::function<bool(Buffer::Instance& response)>;
+
   /**
    * @param end_stream set to false for streaming response. Default is true, which will
    * end the response when the initial handler completes.
@@ -33,6 +39,15 @@ public:
    */
   virtual void addOnDestroyCallback(std::function<void()> cb) PURE;
 
+  /**
+   * Continues the response of the handler in chunks, rendered after the handler returns and its
+   * response is sent. Chunks are rendered one per event loop iteration, and only while the client
+   * keeps up with the response, which bounds the memory and main thread time spent on large
+   * responses. Only one chunk callback may be set per stream.
+   * @param next_chunk called to render each chunk.
+   */
+  virtual void setNextChunkCallback(NextChunkCb next_chunk) PURE;
+
   /**
    * @return Http::StreamDecoderFilterCallbacks& to be used by the handler to get HTTP request data
    * for streaming.
@@ -58,6 +58,15 @@ public:
   virtual const SymbolTable& constSymbolTable() const PURE;
   virtual SymbolTable& symbolTable() PURE;
 
+  /**
+   * Sets the prefixes of the names of the counters to shard per thread. Sharded counters are
+   * incremented without contention between threads, at the cost of a few kilobytes each and of
+   * slower reads, which suits the counters of the busiest clusters and listeners. Only counters
+   * allocated after this is called are affected.
+   * @param prefixes supplies the stat name prefixes.
+   */
+  virtual void setShardedCounterPrefixes(const std::vector<std::string>& prefixes) PURE;
+
   // TODO(jmarantz): create a parallel mechanism to instantiate histograms. At
   // the moment, histograms don't fit the same pattern of counters and gauges
   // as they are not actually created in the context of a stats allocator.
@@ -24,6 +24,22 @@ public:
    * @return The buckets for the histogram. Each value is an upper bound of a bucket.
    */
   virtual ConstSupportedBuckets& buckets(absl::string_view stat_name) const PURE;
+
+  /**
+   * @return whether the histogram is compact, i.e. only counts the samples falling in each of its
+   *         buckets instead of approximating the distribution of the samples. Compact histograms
+   *         are much cheaper to record and merge, but their quantiles are only interpolated
+   *         within their buckets.
+   */
+  virtual bool compact(absl::string_view stat_name) const PURE;
+
+  /**
+   * @return the number of samples each thread buffers before recording them in its histogram and
+   *         delivering them to the sinks in a batch, or 0 if samples are recorded as they come.
+   *         Buffering amortizes the cost of recording samples of histograms recorded many times
+   *         per request, but sinks receive the samples late, at the latest on the next merge.
+   */
+  virtual uint32_t sampleBufferSize(absl::string_view stat_name) const PURE;
 };
 
 using HistogramSettingsConstPtr = std::unique_ptr<const HistogramSettings>;
@@ -7,6 +7,8 @@
 #include "envoy/stats/histogram.h"
 #include "envoy/stats/stats.h"
 
+#include "absl/types/span.h"
+
 namespace Envoy {
 namespace Stats {
 
@@ -40,6 +42,18 @@ public:
    * @return a snapshot of all text readouts.
    */
   virtual const std::vector<std::reference_wrapper<const TextReadout>>& textReadouts() PURE;
+
+  /**
+   * @return the subset of counters() with a non-zero delta, i.e. the counters incremented since
+   *         the previous flush. Sinks reporting deltas can use this to skip untouched counters.
+   */
+  virtual const std::vector<CounterSnapshot>& changedCounters() PURE;
+
+  /**
+   * @return the subset of gauges() written since the previous flush. Sinks whose backend retains
+   *         the last reported value of a gauge can use this to skip untouched gauges.
+   */
+  virtual const std::vector<std::reference_wrapper<const Gauge>>& changedGauges() PURE;
 };
 
 /**
@@ -62,6 +76,22 @@ public:
    * @param value the value of the sample.
    */
   virtual void onHistogramComplete(const Histogram& histogram, uint64_t value) PURE;
+
+  /**
+   * Flush a batch of samples of a single histogram, as recorded by histograms buffering their
+   * samples per thread. Like onHistogramComplete(), this is called on the recording thread, so
+   * implementations must be thread-safe. By default, each sample is flushed with
+   * onHistogramComplete().
+   * @param histogram the histogram that these samples apply to. This may be the thread local
+   *        histogram the samples were buffered in, which has the same name, tags and unit as the
+   *        histogram they were recorded with.
+   * @param values the values of the samples, in the order they were recorded.
+   */
+  virtual void onHistogramSamples(const Histogram& histogram, absl::Span<const uint64_t> values) {
+    for (const uint64_t value : values) {
+      onHistogramComplete(histogram, value);
+    }
+  }
 };
 
 using SinkPtr = std::unique_ptr<Sink>;
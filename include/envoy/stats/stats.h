@@ -87,11 +87,13 @@ public:
    * Flags:
    * Used: used by all stats types to figure out whether they have been used.
    * Logic...: used by gauges to cache how they should be combined with a parent's value.
+   * Dirty: used by gauges to track whether they have been written since the last sink flush.
    */
   struct Flags {
     static const uint8_t Used = 0x01;
     static const uint8_t LogicAccumulate = 0x02;
     static const uint8_t NeverImport = 0x04;
+    static const uint8_t Dirty = 0x08;
   };
   virtual SymbolTable& symbolTable() PURE;
   virtual const SymbolTable& constSymbolTable() const PURE;
@@ -159,6 +161,15 @@ public:
    * @param import_mode the new import mode.
    */
   virtual void mergeImportMode(ImportMode import_mode) PURE;
+
+  /**
+   * Clears the dirty bit of the gauge, which is set whenever the gauge is written. This is called
+   * once per sink flush, so that sinks can skip gauges which have not been touched since the
+   * previous flush.
+   *
+   * @return whether the gauge has been written since the previous call.
+   */
+  virtual bool clearDirty() PURE;
 };
 
 using GaugeSharedPtr = RefcountPtr<Gauge>;
@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "envoy/common/pure.h"
@@ -85,6 +86,12 @@ public:
    */
   virtual void setHistogramSettings(HistogramSettingsConstPtr&& histogram_settings) PURE;
 
+  /**
+   * Set the prefixes of the names of the counters to shard per thread. See
+   * Allocator::setShardedCounterPrefixes().
+   */
+  virtual void setShardedCounterPrefixes(const std::vector<std::string>& prefixes) PURE;
+
   /**
    * Initialize the store for threading. This will be called once after all worker threads have
    * been initialized. At this point the store can initialize itself for multi-threaded operation.
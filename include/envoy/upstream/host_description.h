@@ -10,6 +10,7 @@
 #include "envoy/stats/primitive_stats_macros.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/upstream/health_check_host_monitor.h"
+#include "envoy/upstream/host_latency_monitor.h"
 #include "envoy/upstream/outlier_detection.h"
 
 #include "absl/strings/string_view.h"
@@ -97,6 +98,11 @@ public:
    */
   virtual HealthCheckHostMonitor& healthChecker() const PURE;
 
+  /**
+   * @return the host's response latency monitor.
+   */
+  virtual HostLatencyMonitor& latencyMonitor() const PURE;
+
   /**
    * @return The hostname used as the host header for health checking.
    */
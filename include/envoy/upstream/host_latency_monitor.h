@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include "envoy/common/pure.h"
+#include "envoy/common/time.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * A monitor of a host's response latency, used by latency aware load balancing. Response times are
+ * reported from every worker as upstream requests complete and the estimate is read by the load
+ * balancers of every worker, so implementations must be thread safe.
+ */
+class HostLatencyMonitor {
+public:
+  virtual ~HostLatencyMonitor() = default;
+
+  /**
+   * Add a response time for the host.
+   * @param time supplies the response time.
+   * @param now supplies the current monotonic time.
+   */
+  virtual void putResponseTime(std::chrono::microseconds time, MonotonicTime now) PURE;
+
+  /**
+   * @param now supplies the current monotonic time.
+   * @return the latency estimate for the host in microseconds as of now, or absl::nullopt if no
+   *         response time has been reported for the host.
+   */
+  virtual absl::optional<double> latencyEstimate(MonotonicTime now) const PURE;
+};
+
+using HostLatencyMonitorPtr = std::unique_ptr<HostLatencyMonitor>;
+
+} // namespace Upstream
+} // namespace Envoy
@@ -99,6 +99,14 @@ public:
    *        is missing and use sensible defaults.
    */
   virtual HostConstSharedPtr chooseHost(LoadBalancerContext* context) PURE;
+
+  /**
+   * Returns a best effort prediction of the next host to be picked, or nullptr if not predictable.
+   * Each call predicts one pick further ahead. Subsequent calls to chooseHost() make their picks
+   * with their own context, so they may not return the predicted hosts.
+   * @param context supplies the context of the stream the prediction is made along with.
+   */
+  virtual HostConstSharedPtr peekAnotherHost(LoadBalancerContext* context) PURE;
 };
 
 using LoadBalancerPtr = std::unique_ptr<LoadBalancer>;
@@ -557,7 +557,11 @@ public:
   COUNTER(upstream_cx_max_requests)                                                                \
   COUNTER(upstream_cx_none_healthy)                                                                \
   COUNTER(upstream_cx_overflow)                                                                    \
+  COUNTER(upstream_cx_pool_idle_evicted)                                                           \
   COUNTER(upstream_cx_pool_overflow)                                                               \
+  COUNTER(upstream_cx_prefetch_total)                                                              \
+  COUNTER(upstream_cx_prefetch_unused)                                                             \
+  COUNTER(upstream_cx_prefetch_used)                                                               \
   COUNTER(upstream_cx_protocol_error)                                                              \
   COUNTER(upstream_cx_rx_bytes_total)                                                              \
   COUNTER(upstream_cx_total)                                                                       \
@@ -570,6 +574,9 @@ public:
   COUNTER(upstream_internal_redirect_succeeded_total)                                              \
   COUNTER(upstream_rq_cancelled)                                                                   \
   COUNTER(upstream_rq_completed)                                                                   \
+  COUNTER(upstream_rq_hedge)                                                                       \
+  COUNTER(upstream_rq_hedge_abandoned)                                                             \
+  COUNTER(upstream_rq_hedge_budget_exceeded)                                                       \
   COUNTER(upstream_rq_maintenance_mode)                                                            \
   COUNTER(upstream_rq_max_duration_reached)                                                        \
   COUNTER(upstream_rq_pending_failure_eject)                                                       \
@@ -710,6 +717,9 @@ public:
     static const uint64_t USE_DOWNSTREAM_PROTOCOL = 0x2;
     // Whether connections should be immediately closed upon health failure.
     static const uint64_t CLOSE_CONNECTIONS_ON_HOST_HEALTH_FAILURE = 0x4;
+    // Whether HTTP/2 connections should be owned by the shared connection pool threads rather than
+    // by each worker. This is used when creating connection pools.
+    static const uint64_t SHARED_HTTP2_CONNECTION_POOL = 0x8;
   };
 
   virtual ~ClusterInfo() = default;
@@ -735,6 +745,17 @@ public:
    */
   virtual float prefetchRatio() const PURE;
 
+  /**
+   * @return how many streams should be anticipated across the cluster for each current stream.
+   */
+  virtual float predictivePrefetchRatio() const PURE;
+
+  /**
+   * @return the maximum number of idle connection pools each worker keeps for a host of this
+   *         cluster at each priority, beyond which the least recently used ones are freed.
+   */
+  virtual uint32_t maxIdleConnPoolsPerHost() const PURE;
+
   /**
    * @return soft limit on size of the cluster's connections read and write buffers.
    */
@@ -810,6 +831,12 @@ public:
   virtual const absl::optional<envoy::config::cluster::v3::Cluster::RingHashLbConfig>&
   lbRingHashConfig() const PURE;
 
+  /**
+   * @return configuration for peak EWMA load balancing, only used if type is set to peak EWMA.
+   */
+  virtual const absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig>&
+  lbPeakEwmaConfig() const PURE;
+
   /**
    * @return const absl::optional<envoy::config::cluster::v3::Cluster::OriginalDstLbConfig>& the
    * configuration for the Original Destination load balancing policy, only used if type is set to
@@ -0,0 +1,44 @@
+#include "common/common/sharded_counter.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace Envoy {
+
+namespace {
+
+uint32_t roundUpToPowerOfTwo(uint32_t value) {
+  uint32_t power = 1;
+  while (power < value) {
+    power <<= 1;
+  }
+  return power;
+}
+
+} // namespace
+
+ShardedCounter::ShardedCounter(uint32_t num_slots)
+    : slot_mask_(roundUpToPowerOfTwo(std::max<uint32_t>(num_slots, 1)) - 1),
+      slots_(new Slot[slot_mask_ + 1]) {}
+
+uint32_t ShardedCounter::defaultNumSlots() {
+  static const uint32_t num_slots =
+      std::min<uint32_t>(std::max<uint32_t>(std::thread::hardware_concurrency(), 1), 64);
+  return num_slots;
+}
+
+int64_t ShardedCounter::sum() const {
+  int64_t sum = 0;
+  for (uint32_t i = 0; i <= slot_mask_; ++i) {
+    sum += slots_[i].value_.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+uint32_t ShardedCounter::threadIndex() {
+  static std::atomic<uint32_t> next_index{0};
+  thread_local const uint32_t index = next_index++;
+  return index;
+}
+
+} // namespace Envoy
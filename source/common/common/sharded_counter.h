@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * A signed counter split into slots which each sit on their own cache line. Each thread updates
+ * the slot it is assigned on its first use of any sharded counter, so that threads updating the
+ * same counter at the same time mostly write to different cache lines instead of bouncing a
+ * single one between cores. The value of the counter is the sum of its slots, which readers walk,
+ * so it suits counters which are updated much more often than they are read.
+ *
+ * The slot of a thread may hold a negative value, when the thread takes away from the counter more
+ * than it added to it, e.g. when resources are released on another thread than the one which
+ * acquired them.
+ */
+class ShardedCounter : NonCopyable {
+public:
+  /**
+   * @param num_slots supplies the number of slots, which is rounded up to a power of two. Threads
+   *        beyond that number share slots.
+   */
+  explicit ShardedCounter(uint32_t num_slots);
+
+  /**
+   * @return the number of slots counters get by default: one per hardware thread, up to 64.
+   */
+  static uint32_t defaultNumSlots();
+
+  /**
+   * Adds to the slot of the calling thread.
+   * @param amount supplies the amount to add, which may be negative.
+   * @return the value of the slot after the addition.
+   */
+  int64_t add(int64_t amount) {
+    return slot().value_.fetch_add(amount, std::memory_order_relaxed) + amount;
+  }
+
+  /**
+   * Resets the slot of the calling thread to 0.
+   * @return the value the slot held.
+   */
+  int64_t take() { return slot().value_.exchange(0, std::memory_order_relaxed); }
+
+  /**
+   * @return the sum of all slots. It may miss updates made while it is computed.
+   */
+  int64_t sum() const;
+
+  uint32_t numSlots() const { return slot_mask_ + 1; }
+
+private:
+  struct alignas(64) Slot {
+    std::atomic<int64_t> value_{0};
+  };
+
+  // The index threads are assigned in order of their first use of a sharded counter.
+  static uint32_t threadIndex();
+
+  Slot& slot() { return slots_[threadIndex() & slot_mask_]; }
+
+  const uint32_t slot_mask_;
+  const std::unique_ptr<Slot[]> slots_;
+};
+
+} // namespace Envoy
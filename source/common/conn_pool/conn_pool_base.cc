@@ -33,7 +33,15 @@ void ConnPoolImplBase::destructAllConnections() {
   dispatcher_.clearDeferredDeleteList();
 }
 
-bool ConnPoolImplBase::shouldCreateNewConnection() const {
+bool ConnPoolImplBase::shouldCreateNewConnection(float global_prefetch_ratio) const {
+  // If global prefetching is on, the stream the prefetch is made for is anticipated on top of the
+  // pending and active streams, as it has not been assigned to this pool yet.
+  if (global_prefetch_ratio > 1.0 &&
+      ((pending_streams_.size() + 1 + num_active_streams_) * global_prefetch_ratio >
+       (connecting_stream_capacity_ + num_active_streams_))) {
+    return true;
+  }
+
   // The number of streams we want to be provisioned for is the number of
   // pending and active streams times the prefetch ratio.
   // The number of streams we are (theoretically) provisioned for is the
@@ -67,9 +75,21 @@ void ConnPoolImplBase::tryCreateNewConnections() {
   }
 }
 
-bool ConnPoolImplBase::tryCreateNewConnection() {
+bool ConnPoolImplBase::maybePrefetchImpl(float global_prefetch_ratio) {
+  if (!Runtime::runtimeFeatureEnabled("envoy.reloadable_features.allow_prefetch")) {
+    return false;
+  }
+  // Prefetching is speculative, so unlike tryCreateNewConnection() it never creates a connection
+  // beyond the connection circuit breaker.
+  if (!host_->cluster().resourceManager(priority_).connections().canCreate()) {
+    return false;
+  }
+  return tryCreateNewConnection(global_prefetch_ratio);
+}
+
+bool ConnPoolImplBase::tryCreateNewConnection(float global_prefetch_ratio) {
   // There are already enough CONNECTING connections for the number of queued streams.
-  if (!shouldCreateNewConnection()) {
+  if (!shouldCreateNewConnection(global_prefetch_ratio)) {
     return false;
   }
 
@@ -84,11 +104,18 @@ bool ConnPoolImplBase::tryCreateNewConnection() {
   if (can_create_connection ||
       (ready_clients_.empty() && busy_clients_.empty() && connecting_clients_.empty())) {
     ENVOY_LOG(debug, "creating a new connection");
+    // The connection is prefetched if the queued streams are already covered by the connecting
+    // capacity, i.e. it is only created in anticipation of future streams.
+    const bool prefetched = pending_streams_.size() <= connecting_stream_capacity_;
     ActiveClientPtr client = instantiateActiveClient();
     ASSERT(client->state_ == ActiveClient::State::CONNECTING);
     ASSERT(std::numeric_limits<uint64_t>::max() - connecting_stream_capacity_ >=
            client->effectiveConcurrentRequestLimit());
     ASSERT(client->real_host_description_);
+    if (prefetched) {
+      client->prefetched_ = true;
+      host_->cluster().stats().upstream_cx_prefetch_total_.inc();
+    }
     connecting_stream_capacity_ += client->effectiveConcurrentRequestLimit();
     LinkedList::moveIntoList(std::move(client), owningList(client->state_));
   }
@@ -107,6 +134,10 @@ void ConnPoolImplBase::attachRequestToClient(Envoy::ConnectionPool::ActiveClient
   } else {
     ENVOY_CONN_LOG(debug, "creating stream", client);
 
+    if (client.prefetched_) {
+      client.prefetched_ = false;
+      host_->cluster().stats().upstream_cx_prefetch_used_.inc();
+    }
     client.remaining_streams_--;
     if (client.remaining_streams_ == 0) {
       ENVOY_CONN_LOG(debug, "maximum streams per connection, DRAINING", client);
@@ -293,6 +324,9 @@ void ConnPoolImplBase::onConnectionEvent(ActiveClient& client, absl::string_view
     ENVOY_CONN_LOG(debug, "client disconnected, failure reason: {}", client, failure_reason);
 
     Envoy::Upstream::reportUpstreamCxDestroy(host_, event);
+    if (client.prefetched_) {
+      host_->cluster().stats().upstream_cx_prefetch_unused_.inc();
+    }
     const bool incomplete_stream = client.closingWithIncompleteRequest();
     if (incomplete_stream) {
       Envoy::Upstream::reportUpstreamCxDestroyActiveRequest(host_, event);
@@ -76,6 +76,9 @@ public:
   Event::TimerPtr connect_timer_;
   bool resources_released_{false};
   bool timed_out_{false};
+  // Set if the connection was established ahead of the streams that would use it, until it serves
+  // its first stream.
+  bool prefetched_{false};
 };
 
 // TODO(alyssawilk) renames for Request classes and functions -> Stream classes and functions.
@@ -116,6 +119,7 @@ public:
 
   void addDrainedCallbackImpl(Instance::DrainedCb cb);
   void drainConnectionsImpl();
+  bool maybePrefetchImpl(float global_prefetch_ratio);
 
   // Closes and destroys all connections. This must be called in the destructor of
   // derived classes because the derived ActiveClient will downcast parent_ to a more
@@ -175,8 +179,9 @@ protected:
   void tryCreateNewConnections();
 
   // Creates a new connection if there is sufficient demand, it is allowed by resourceManager, or
-  // to avoid starving this pool.
-  bool tryCreateNewConnection();
+  // to avoid starving this pool. A global_prefetch_ratio greater than one also anticipates an
+  // incoming stream which has not been assigned to the pool yet.
+  bool tryCreateNewConnection(float global_prefetch_ratio = 0);
 
   // A helper function which determines if a canceled pending connection should
   // be closed as excess or not.
@@ -184,7 +189,7 @@ protected:
 
   // A helper function which determines if a new incoming stream should trigger
   // connection prefetch.
-  bool shouldCreateNewConnection() const;
+  bool shouldCreateNewConnection(float global_prefetch_ratio) const;
 
   float prefetchRatio() const;
 
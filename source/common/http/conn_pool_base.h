@@ -48,6 +48,7 @@ public:
   // ConnectionPool::Instance
   void addDrainedCallback(DrainedCb cb) override { addDrainedCallbackImpl(cb); }
   void drainConnections() override { drainConnectionsImpl(); }
+  bool maybePrefetch(float ratio) override { return maybePrefetchImpl(ratio); }
   Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
   ConnectionPool::Cancellable* newStream(Http::ResponseDecoder& response_decoder,
                                          Http::ConnectionPool::Callbacks& callbacks) override;
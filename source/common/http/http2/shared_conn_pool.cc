@@ -0,0 +1,628 @@
+#include "common/http/http2/shared_conn_pool.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+#include "common/http/header_map_impl.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+SharedConnPoolSet::SharedConnPoolSet(Api::Api& api, ThreadLocal::Instance& tls,
+                                     uint32_t num_threads, SharedConnPoolFactory factory)
+    : api_(api), tls_(tls), factory_(std::move(factory)) {
+  ASSERT(num_threads > 0);
+  for (uint32_t i = 0; i < num_threads; i++) {
+    auto thread = std::make_unique<IoThread>(*this);
+    thread->dispatcher_ = api.allocateDispatcher(absl::StrCat("h2pool_", i));
+    tls.registerThread(*thread->dispatcher_, false);
+    threads_.push_back(std::move(thread));
+  }
+}
+
+SharedConnPoolSet::~SharedConnPoolSet() { shutdown(); }
+
+void SharedConnPoolSet::start(Server::GuardDog& guard_dog) {
+  ASSERT(!shutdown_);
+  for (const IoThreadPtr& thread : threads_) {
+    ASSERT(!thread->thread_);
+    IoThread& io_thread = *thread;
+    io_thread.thread_ = api_.threadFactory().createThread(
+        [&io_thread, &guard_dog]() -> void { io_thread.threadRoutine(guard_dog); },
+        Thread::Options{io_thread.dispatcher_->name()});
+  }
+  ENVOY_LOG(debug, "started {} shared HTTP/2 connection pool threads", threads_.size());
+}
+
+void SharedConnPoolSet::shutdown() {
+  if (shutdown_) {
+    return;
+  }
+  shutdown_ = true;
+
+  for (const IoThreadPtr& thread : threads_) {
+    if (!thread->thread_) {
+      continue;
+    }
+    IoThread& io_thread = *thread;
+    io_thread.dispatcher_->post([&io_thread]() -> void {
+      while (!io_thread.streams_.empty()) {
+        io_thread.streams_.front()->abort();
+      }
+      // Closing the connections may fire drained callbacks, which must not find the pools.
+      {
+        IoThread::PoolMap pools;
+        pools.swap(io_thread.pools_);
+      }
+      io_thread.dispatcher_->exit();
+    });
+  }
+  for (const IoThreadPtr& thread : threads_) {
+    if (thread->thread_) {
+      thread->thread_->join();
+    }
+  }
+}
+
+ConnectionPool::InstancePtr SharedConnPoolSet::createConnPool(
+    Event::Dispatcher& dispatcher, Upstream::HostConstSharedPtr host,
+    Upstream::ResourcePriority priority, const Network::ConnectionSocket::OptionsSharedPtr& options,
+    const Network::TransportSocketOptionsSharedPtr& transport_socket_options) {
+  auto key = std::make_shared<PoolKey>();
+  // The host is kept alive by the pools using the key, so its address identifies it among them.
+  const uintptr_t host_id = reinterpret_cast<uintptr_t>(host.get());
+  key->hash_key_.insert(key->hash_key_.end(), reinterpret_cast<const uint8_t*>(&host_id),
+                        reinterpret_cast<const uint8_t*>(&host_id) + sizeof(host_id));
+  key->hash_key_.push_back(uint8_t(priority));
+  if (options != nullptr) {
+    for (const auto& option : *options) {
+      option->hashKey(key->hash_key_);
+    }
+  }
+  if (transport_socket_options != nullptr) {
+    transport_socket_options->hashKey(key->hash_key_);
+  }
+  key->host_ = host;
+  key->priority_ = priority;
+  key->options_ = options;
+  key->transport_socket_options_ = transport_socket_options;
+
+  // All the pools of a host are owned by the same thread, so that every worker ends up on the same
+  // connections for it.
+  IoThread& thread =
+      *threads_[HashUtil::xxHash64(host->address()->asStringView()) % threads_.size()];
+  return std::make_unique<SharedConnPool>(thread, dispatcher, std::move(key));
+}
+
+void SharedConnPoolSet::IoThread::threadRoutine(Server::GuardDog& guard_dog) {
+  // As for workers, the watch dog is created once the dispatcher runs and has flushed the events
+  // posted so far, which is when thread local stat scopes start working.
+  dispatcher_->post([this, &guard_dog]() -> void {
+    watch_dog_ = guard_dog.createWatchDog(parent_.api_.threadFactory().currentThreadId(),
+                                          dispatcher_->name());
+    watch_dog_->startWatchdog(*dispatcher_);
+  });
+  dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+  guard_dog.stopWatching(watch_dog_);
+
+  // Everything referencing thread locals must be gone before they are shut down.
+  dispatcher_->clearDeferredDeleteList();
+  parent_.tls_.shutdownThread();
+  watch_dog_.reset();
+}
+
+ConnectionPool::Instance& SharedConnPoolSet::IoThread::pool(const PoolKey& key) {
+  auto it = pools_.find(key.hash_key_);
+  if (it == pools_.end()) {
+    Pool pool;
+    pool.pool_ = parent_.factory_(*dispatcher_, key.host_, key.priority_, key.options_,
+                                  key.transport_socket_options_);
+    it = pools_.emplace(key.hash_key_, std::move(pool)).first;
+  }
+  return *it->second.pool_;
+}
+
+void SharedConnPoolSet::IoThread::drainPool(const PoolKey& key) {
+  auto it = pools_.find(key.hash_key_);
+  if (it == pools_.end()) {
+    return;
+  }
+
+  it->second.pool_->drainConnections();
+  removeWhenDrained(it);
+}
+
+void SharedConnPoolSet::IoThread::addDrainedCallback(const PoolKey& key,
+                                                     std::function<void()> cb) {
+  auto it = pools_.find(key.hash_key_);
+  if (it == pools_.end()) {
+    cb();
+    return;
+  }
+
+  ConnectionPool::Instance& pool = *it->second.pool_;
+  removeWhenDrained(it);
+  pool.addDrainedCallback(cb);
+}
+
+void SharedConnPoolSet::IoThread::removeWhenDrained(PoolMap::iterator it) {
+  if (it->second.draining_) {
+    return;
+  }
+  it->second.draining_ = true;
+  ConnectionPool::Instance* pool = it->second.pool_.get();
+  pool->addDrainedCallback([this, pool, hash_key = it->first]() -> void {
+    // Drained callbacks may fire repeatedly, by which time a new pool may have taken the key.
+    auto it = pools_.find(hash_key);
+    if (it != pools_.end() && it->second.pool_.get() == pool) {
+      dispatcher_->deferredDelete(std::move(it->second.pool_));
+      pools_.erase(it);
+    }
+  });
+}
+
+SharedConnPoolSet::IoStream::IoStream(IoThread& thread, Event::Dispatcher& worker_dispatcher,
+                                      const StreamHandleSharedPtr& handle,
+                                      const PoolHandleSharedPtr& pool)
+    : thread_(thread), worker_dispatcher_(worker_dispatcher), handle_(handle), pool_(pool) {
+  handle_->io_ = this;
+}
+
+SharedConnPoolSet::IoStream::~IoStream() { handle_->io_ = nullptr; }
+
+void SharedConnPoolSet::IoStream::start(const PoolKey& key) {
+  // The callbacks may fire inline, in which case no handle is returned.
+  ConnectionPool::Cancellable* cancellable = thread_.pool(key).newStream(*this, *this);
+  if (!done_ && encoder_ == nullptr) {
+    cancellable_ = cancellable;
+  }
+}
+
+void SharedConnPoolSet::IoStream::encodeHeaders(RequestHeaderMapPtr&& headers, bool end_stream) {
+  ASSERT(encoder_ != nullptr);
+  encoder_->encodeHeaders(*headers, end_stream);
+  if (end_stream) {
+    onLocalComplete();
+  }
+}
+
+void SharedConnPoolSet::IoStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  ASSERT(encoder_ != nullptr);
+  encoder_->encodeData(data, end_stream);
+  if (end_stream) {
+    onLocalComplete();
+  }
+}
+
+void SharedConnPoolSet::IoStream::encodeTrailers(RequestTrailerMapPtr&& trailers) {
+  ASSERT(encoder_ != nullptr);
+  encoder_->encodeTrailers(*trailers);
+  onLocalComplete();
+}
+
+void SharedConnPoolSet::IoStream::encodeMetadata(const MetadataMapVector& metadata_map_vector) {
+  ASSERT(encoder_ != nullptr);
+  encoder_->encodeMetadata(metadata_map_vector);
+}
+
+void SharedConnPoolSet::IoStream::readDisable(bool disable) {
+  if (encoder_ != nullptr) {
+    encoder_->getStream().readDisable(disable);
+  }
+}
+
+void SharedConnPoolSet::IoStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  if (encoder_ != nullptr) {
+    encoder_->getStream().setFlushTimeout(timeout);
+  }
+}
+
+void SharedConnPoolSet::IoStream::reset(StreamResetReason reason) {
+  if (cancellable_ != nullptr) {
+    cancellable_->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+    cancellable_ = nullptr;
+  } else if (encoder_ != nullptr) {
+    Stream& stream = encoder_->getStream();
+    encoder_ = nullptr;
+    stream.removeCallbacks(*this);
+    stream.resetStream(reason);
+  }
+  done();
+}
+
+void SharedConnPoolSet::IoStream::abort() {
+  if (cancellable_ != nullptr) {
+    postToWorker([](WorkerStream& stream) -> void {
+      stream.onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                           "shared connection pool shutdown");
+    });
+  } else {
+    postToWorker([](WorkerStream& stream) -> void {
+      stream.onResetStream(StreamResetReason::ConnectionTermination);
+    });
+  }
+  reset(StreamResetReason::LocalReset);
+}
+
+void SharedConnPoolSet::IoStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                absl::string_view transport_failure_reason,
+                                                Upstream::HostDescriptionConstSharedPtr) {
+  cancellable_ = nullptr;
+  postToWorker([reason, transport_failure_reason = std::string(transport_failure_reason)](
+                   WorkerStream& stream) -> void {
+    stream.onPoolFailure(reason, transport_failure_reason);
+  });
+  done();
+}
+
+void SharedConnPoolSet::IoStream::onPoolReady(RequestEncoder& encoder,
+                                              Upstream::HostDescriptionConstSharedPtr,
+                                              const StreamInfo::StreamInfo&) {
+  cancellable_ = nullptr;
+  encoder_ = &encoder;
+  encoder.getStream().addCallbacks(*this);
+  postToWorker([local_address = encoder.getStream().connectionLocalAddress()](
+                   WorkerStream& stream) -> void { stream.onPoolReady(local_address); });
+}
+
+void SharedConnPoolSet::IoStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  auto buffer = std::make_shared<Buffer::OwnedImpl>();
+  buffer->move(data);
+  postToWorker([buffer, end_stream](WorkerStream& stream) -> void {
+    stream.decodeData(*buffer, end_stream);
+  });
+  if (end_stream) {
+    onRemoteComplete();
+  }
+}
+
+void SharedConnPoolSet::IoStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  auto holder = std::make_shared<MetadataMapPtr>(std::move(metadata_map));
+  postToWorker(
+      [holder](WorkerStream& stream) -> void { stream.decodeMetadata(std::move(*holder)); });
+}
+
+void SharedConnPoolSet::IoStream::decode100ContinueHeaders(ResponseHeaderMapPtr&& headers) {
+  auto holder = std::make_shared<ResponseHeaderMapPtr>(std::move(headers));
+  postToWorker([holder](WorkerStream& stream) -> void {
+    stream.decode100ContinueHeaders(std::move(*holder));
+  });
+}
+
+void SharedConnPoolSet::IoStream::decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) {
+  auto holder = std::make_shared<ResponseHeaderMapPtr>(std::move(headers));
+  postToWorker([holder, end_stream](WorkerStream& stream) -> void {
+    stream.decodeHeaders(std::move(*holder), end_stream);
+  });
+  if (end_stream) {
+    onRemoteComplete();
+  }
+}
+
+void SharedConnPoolSet::IoStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  auto holder = std::make_shared<ResponseTrailerMapPtr>(std::move(trailers));
+  postToWorker(
+      [holder](WorkerStream& stream) -> void { stream.decodeTrailers(std::move(*holder)); });
+  onRemoteComplete();
+}
+
+void SharedConnPoolSet::IoStream::onResetStream(StreamResetReason reason, absl::string_view) {
+  // The stream is going away, and will not fire any further callbacks.
+  encoder_ = nullptr;
+  postToWorker([reason](WorkerStream& stream) -> void { stream.onResetStream(reason); });
+  done();
+}
+
+void SharedConnPoolSet::IoStream::onAboveWriteBufferHighWatermark() {
+  postToWorker([](WorkerStream& stream) -> void { stream.onAboveWriteBufferHighWatermark(); });
+}
+
+void SharedConnPoolSet::IoStream::onBelowWriteBufferLowWatermark() {
+  postToWorker([](WorkerStream& stream) -> void { stream.onBelowWriteBufferLowWatermark(); });
+}
+
+void SharedConnPoolSet::IoStream::postToWorker(std::function<void(WorkerStream&)> event) {
+  worker_dispatcher_.post([handle = handle_, event = std::move(event)]() -> void {
+    if (handle->worker_ != nullptr) {
+      event(*handle->worker_);
+    }
+  });
+}
+
+void SharedConnPoolSet::IoStream::onLocalComplete() {
+  local_complete_ = true;
+  if (remote_complete_) {
+    done();
+  }
+}
+
+void SharedConnPoolSet::IoStream::onRemoteComplete() {
+  remote_complete_ = true;
+  if (local_complete_) {
+    done();
+  }
+}
+
+void SharedConnPoolSet::IoStream::done() {
+  if (done_) {
+    return;
+  }
+  done_ = true;
+  handle_->io_ = nullptr;
+  if (encoder_ != nullptr) {
+    encoder_->getStream().removeCallbacks(*this);
+    encoder_ = nullptr;
+  }
+  worker_dispatcher_.post([pool = pool_]() -> void {
+    if (pool->pool_ != nullptr) {
+      pool->pool_->onIoStreamDone();
+    }
+  });
+  thread_.dispatcher_->deferredDelete(removeFromList(thread_.streams_));
+}
+
+WorkerStream::WorkerStream(SharedConnPool& parent, ResponseDecoder& decoder,
+                           ConnectionPool::Callbacks& callbacks,
+                           const SharedConnPoolSet::StreamHandleSharedPtr& handle)
+    : parent_(parent), decoder_(decoder), callbacks_(&callbacks), handle_(handle) {
+  handle_->worker_ = this;
+}
+
+WorkerStream::~WorkerStream() { handle_->worker_ = nullptr; }
+
+void WorkerStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                 const std::string& transport_failure_reason) {
+  ASSERT(callbacks_ != nullptr);
+  ConnectionPool::Callbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  Upstream::HostDescriptionConstSharedPtr host = parent_.host();
+  done();
+  callbacks->onPoolFailure(reason, transport_failure_reason, host);
+}
+
+void WorkerStream::onPoolReady(const Network::Address::InstanceConstSharedPtr& local_address) {
+  ASSERT(callbacks_ != nullptr);
+  ConnectionPool::Callbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  local_address_ = local_address;
+  callbacks->onPoolReady(*this, parent_.host(), parent_.stream_info_);
+}
+
+void WorkerStream::decode100ContinueHeaders(ResponseHeaderMapPtr&& headers) {
+  decoder_.decode100ContinueHeaders(std::move(headers));
+}
+
+void WorkerStream::decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) {
+  remote_complete_ = end_stream;
+  decoder_.decodeHeaders(std::move(headers), end_stream);
+  if (end_stream) {
+    onRemoteComplete();
+  }
+}
+
+void WorkerStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  remote_complete_ = end_stream;
+  decoder_.decodeData(data, end_stream);
+  if (end_stream) {
+    onRemoteComplete();
+  }
+}
+
+void WorkerStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  remote_complete_ = true;
+  decoder_.decodeTrailers(std::move(trailers));
+  onRemoteComplete();
+}
+
+void WorkerStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  decoder_.decodeMetadata(std::move(metadata_map));
+}
+
+void WorkerStream::onResetStream(StreamResetReason reason) {
+  runResetCallbacks(reason);
+  done();
+}
+
+void WorkerStream::onPoolDestroy() {
+  postToIo([](SharedConnPoolSet::IoStream& stream) -> void {
+    stream.reset(StreamResetReason::LocalReset);
+  });
+  if (callbacks_ == nullptr) {
+    runResetCallbacks(StreamResetReason::ConnectionTermination);
+  }
+  done();
+}
+
+void WorkerStream::cancel(Envoy::ConnectionPool::CancelPolicy) {
+  callbacks_ = nullptr;
+  postToIo([](SharedConnPoolSet::IoStream& stream) -> void {
+    stream.reset(StreamResetReason::LocalReset);
+  });
+  done();
+}
+
+void WorkerStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  auto buffer = std::make_shared<Buffer::OwnedImpl>();
+  buffer->move(data);
+  postToIo([buffer, end_stream](SharedConnPoolSet::IoStream& stream) -> void {
+    stream.encodeData(*buffer, end_stream);
+  });
+  if (end_stream) {
+    onLocalComplete();
+  }
+}
+
+void WorkerStream::encodeMetadata(const MetadataMapVector& metadata_map_vector) {
+  auto copy = std::make_shared<MetadataMapVector>();
+  for (const MetadataMapPtr& metadata_map : metadata_map_vector) {
+    copy->push_back(std::make_unique<MetadataMap>(*metadata_map));
+  }
+  postToIo([copy](SharedConnPoolSet::IoStream& stream) -> void { stream.encodeMetadata(*copy); });
+}
+
+void WorkerStream::encodeHeaders(const RequestHeaderMap& headers, bool end_stream) {
+  auto holder =
+      std::make_shared<RequestHeaderMapPtr>(createHeaderMap<RequestHeaderMapImpl>(headers));
+  postToIo([holder, end_stream](SharedConnPoolSet::IoStream& stream) -> void {
+    stream.encodeHeaders(std::move(*holder), end_stream);
+  });
+  if (end_stream) {
+    onLocalComplete();
+  }
+}
+
+void WorkerStream::encodeTrailers(const RequestTrailerMap& trailers) {
+  auto holder =
+      std::make_shared<RequestTrailerMapPtr>(createHeaderMap<RequestTrailerMapImpl>(trailers));
+  postToIo([holder](SharedConnPoolSet::IoStream& stream) -> void {
+    stream.encodeTrailers(std::move(*holder));
+  });
+  onLocalComplete();
+}
+
+void WorkerStream::resetStream(StreamResetReason reason) {
+  if (done_) {
+    return;
+  }
+  postToIo([reason](SharedConnPoolSet::IoStream& stream) -> void { stream.reset(reason); });
+  runResetCallbacks(reason);
+  done();
+}
+
+void WorkerStream::readDisable(bool disable) {
+  postToIo([disable](SharedConnPoolSet::IoStream& stream) -> void { stream.readDisable(disable); });
+}
+
+uint32_t WorkerStream::bufferLimit() {
+  return parent_.host()->cluster().perConnectionBufferLimitBytes();
+}
+
+void WorkerStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  postToIo(
+      [timeout](SharedConnPoolSet::IoStream& stream) -> void { stream.setFlushTimeout(timeout); });
+}
+
+void WorkerStream::postToIo(std::function<void(SharedConnPoolSet::IoStream&)> event) {
+  parent_.thread_.dispatcher_->post([handle = handle_, event = std::move(event)]() -> void {
+    if (handle->io_ != nullptr) {
+      event(*handle->io_);
+    }
+  });
+}
+
+void WorkerStream::onLocalComplete() {
+  local_end_stream_ = true;
+  if (remote_complete_) {
+    done();
+  }
+}
+
+void WorkerStream::onRemoteComplete() {
+  if (local_end_stream_) {
+    done();
+  }
+}
+
+void WorkerStream::done() {
+  if (done_) {
+    return;
+  }
+  done_ = true;
+  handle_->worker_ = nullptr;
+  parent_.onStreamDone(*this);
+}
+
+SharedConnPool::SharedConnPool(SharedConnPoolSet::IoThread& thread, Event::Dispatcher& dispatcher,
+                               SharedConnPoolSet::PoolKeySharedPtr key)
+    : thread_(thread), dispatcher_(dispatcher), key_(std::move(key)),
+      stream_info_(Protocol::Http2, dispatcher.timeSource()),
+      handle_(std::make_shared<SharedConnPoolSet::PoolHandle>()) {
+  handle_->pool_ = this;
+}
+
+SharedConnPool::~SharedConnPool() {
+  handle_->pool_ = nullptr;
+  while (!streams_.empty()) {
+    streams_.front()->onPoolDestroy();
+  }
+}
+
+ConnectionPool::Cancellable* SharedConnPool::newStream(ResponseDecoder& response_decoder,
+                                                       ConnectionPool::Callbacks& callbacks) {
+  auto handle = std::make_shared<SharedConnPoolSet::StreamHandle>();
+  auto stream = std::make_unique<WorkerStream>(*this, response_decoder, callbacks, handle);
+  WorkerStream& ret = *stream;
+  LinkedList::moveIntoList(std::move(stream), streams_);
+  io_streams_++;
+
+  thread_.dispatcher_->post([&thread = thread_, &worker_dispatcher = dispatcher_, handle,
+                             pool = handle_, key = key_]() -> void {
+    auto stream =
+        std::make_unique<SharedConnPoolSet::IoStream>(thread, worker_dispatcher, handle, pool);
+    SharedConnPoolSet::IoStream& io_stream = *stream;
+    LinkedList::moveIntoList(std::move(stream), thread.streams_);
+    io_stream.start(*key);
+  });
+  return &ret;
+}
+
+void SharedConnPool::addDrainedCallback(DrainedCb cb) {
+  if (drained_callbacks_.empty()) {
+    // The connections are owned by the other thread, so this pool is only drained once the pool
+    // there is.
+    thread_.dispatcher_->post([&thread = thread_, &worker_dispatcher = dispatcher_, pool = handle_,
+                               key = key_]() -> void {
+      thread.addDrainedCallback(*key, [&worker_dispatcher, pool]() -> void {
+        worker_dispatcher.post([pool]() -> void {
+          if (pool->pool_ != nullptr) {
+            pool->pool_->onIoDrained();
+          }
+        });
+      });
+    });
+  }
+  drained_callbacks_.push_back(cb);
+  checkForDrained();
+}
+
+void SharedConnPool::drainConnections() {
+  thread_.dispatcher_->post(
+      [&thread = thread_, key = key_]() -> void { thread.drainPool(*key); });
+}
+
+void SharedConnPool::onStreamDone(WorkerStream& stream) {
+  dispatcher_.deferredDelete(stream.removeFromList(streams_));
+  checkForDrained();
+}
+
+void SharedConnPool::onIoStreamDone() {
+  ASSERT(io_streams_ > 0);
+  io_streams_--;
+  checkForDrained();
+}
+
+void SharedConnPool::onIoDrained() {
+  io_drained_ = true;
+  checkForDrained();
+}
+
+void SharedConnPool::checkForDrained() {
+  if (drained_callbacks_.empty() || hasActiveConnections() || !io_drained_) {
+    return;
+  }
+
+  ENVOY_LOG(debug, "invoking drained callbacks");
+  for (const DrainedCb& cb : drained_callbacks_) {
+    cb();
+  }
+}
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
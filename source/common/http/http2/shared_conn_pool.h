@@ -0,0 +1,358 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/api/api.h"
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/http/conn_pool.h"
+#include "envoy/server/guarddog.h"
+#include "envoy/server/watchdog.h"
+#include "envoy/thread/thread.h"
+#include "envoy/thread_local/thread_local.h"
+#include "envoy/upstream/upstream.h"
+
+#include "common/common/linked_object.h"
+#include "common/common/logger.h"
+#include "common/http/codec_helper.h"
+#include "common/stream_info/stream_info_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+class SharedConnPool;
+class WorkerStream;
+
+/**
+ * Factory for the HTTP/2 connection pools owned by the threads of a SharedConnPoolSet. Called on
+ * the owning thread, with its dispatcher.
+ */
+using SharedConnPoolFactory = std::function<ConnectionPool::InstancePtr(
+    Event::Dispatcher& dispatcher, Upstream::HostConstSharedPtr host,
+    Upstream::ResourcePriority priority, const Network::ConnectionSocket::OptionsSharedPtr& options,
+    const Network::TransportSocketOptionsSharedPtr& transport_socket_options)>;
+
+/**
+ * The process wide set of dedicated threads owning the upstream HTTP/2 connections of the clusters
+ * sharing them on behalf of all workers. Each upstream host is assigned to one of the threads,
+ * which runs a regular HTTP/2 connection pool per priority and socket options for it. Workers hand
+ * their streams off to that pool via the pools returned by createConnPool(), so that the number of
+ * connections to a host no longer scales with the number of workers.
+ *
+ * Streams and their events are handed between the worker and the owning thread by posting to the
+ * dispatcher of the other side. Each side only ever touches its own half of a stream.
+ *
+ * The set is owned by the main thread. Like workers, its threads are registered for thread local
+ * updates on construction, are watched by the guard dog once started, and are stopped by the main
+ * thread on shutdown.
+ */
+class SharedConnPoolSet : Logger::Loggable<Logger::Id::pool> {
+public:
+  /**
+   * Must be called on the main thread, before any thread local slot is set, so that the threads
+   * see all thread local data.
+   */
+  SharedConnPoolSet(Api::Api& api, ThreadLocal::Instance& tls, uint32_t num_threads,
+                    SharedConnPoolFactory factory);
+  ~SharedConnPoolSet();
+
+  /**
+   * Starts the threads, each watched by the given guard dog. Streams handed off before are queued
+   * until then.
+   */
+  void start(Server::GuardDog& guard_dog);
+
+  /**
+   * Creates the worker side of the shared pool for the given host, priority and options. The
+   * returned pool must be used and destroyed on the thread running the given dispatcher.
+   */
+  ConnectionPool::InstancePtr
+  createConnPool(Event::Dispatcher& dispatcher, Upstream::HostConstSharedPtr host,
+                 Upstream::ResourcePriority priority,
+                 const Network::ConnectionSocket::OptionsSharedPtr& options,
+                 const Network::TransportSocketOptionsSharedPtr& transport_socket_options);
+
+  /**
+   * Closes all connections and stops the threads, which shut down their thread local storage.
+   * Streams still in flight are reset. Must be called on the main thread, after the workers have
+   * stopped. This is called on destruction if it has not been called before.
+   */
+  void shutdown();
+
+  uint32_t numThreads() const { return threads_.size(); }
+
+private:
+  friend class SharedConnPool;
+  friend class WorkerStream;
+  class IoStream;
+  using IoStreamPtr = std::unique_ptr<IoStream>;
+
+  // The state of a stream that both of its halves can reach. Each pointer is only accessed on the
+  // thread owning the object it points to, and is cleared when that object goes away.
+  struct StreamHandle {
+    WorkerStream* worker_{};
+    IoStream* io_{};
+  };
+  using StreamHandleSharedPtr = std::shared_ptr<StreamHandle>;
+
+  // Lets events posted to a worker find its side of a pool, if it is still around. Only accessed
+  // on the worker.
+  struct PoolHandle {
+    SharedConnPool* pool_{};
+  };
+  using PoolHandleSharedPtr = std::shared_ptr<PoolHandle>;
+
+  struct PoolKey {
+    Upstream::HostConstSharedPtr host_;
+    Upstream::ResourcePriority priority_;
+    Network::ConnectionSocket::OptionsSharedPtr options_;
+    Network::TransportSocketOptionsSharedPtr transport_socket_options_;
+    // Uniquely identifies the pool on its owning thread.
+    std::vector<uint8_t> hash_key_;
+  };
+  using PoolKeySharedPtr = std::shared_ptr<const PoolKey>;
+
+  struct IoThread {
+    struct Pool {
+      ConnectionPool::InstancePtr pool_;
+      bool draining_{};
+    };
+    using PoolMap = absl::flat_hash_map<std::vector<uint8_t>, Pool>;
+
+    IoThread(SharedConnPoolSet& parent) : parent_(parent) {}
+
+    void threadRoutine(Server::GuardDog& guard_dog);
+    // Returns the pool for the given key, creating it if needed.
+    ConnectionPool::Instance& pool(const PoolKey& key);
+    // Drains the pool for the given key, if any, and removes it once drained.
+    void drainPool(const PoolKey& key);
+    // Calls the given callback whenever the pool for the given key has no streams and connections
+    // left, or right away if there is no such pool. The pool is removed once drained.
+    void addDrainedCallback(const PoolKey& key, std::function<void()> cb);
+    // Removes the pool once drained. This may happen right away, invalidating the iterator.
+    void removeWhenDrained(PoolMap::iterator it);
+
+    SharedConnPoolSet& parent_;
+    Event::DispatcherPtr dispatcher_;
+    Thread::ThreadPtr thread_;
+    // Only accessed on the thread itself.
+    Server::WatchDogSharedPtr watch_dog_;
+    PoolMap pools_;
+    std::list<IoStreamPtr> streams_;
+  };
+  using IoThreadPtr = std::unique_ptr<IoThread>;
+
+  /**
+   * The half of a stream living on the owning thread. It acts as the callbacks and response
+   * decoder of the stream created on the real pool, and forwards all events to the worker.
+   */
+  class IoStream : public LinkedObject<IoStream>,
+                   public Event::DeferredDeletable,
+                   public ConnectionPool::Callbacks,
+                   public ResponseDecoder,
+                   public StreamCallbacks,
+                   Logger::Loggable<Logger::Id::pool> {
+  public:
+    IoStream(IoThread& thread, Event::Dispatcher& worker_dispatcher,
+             const StreamHandleSharedPtr& handle, const PoolHandleSharedPtr& pool);
+    ~IoStream() override;
+
+    void start(const PoolKey& key);
+
+    // Events from the worker.
+    void encodeHeaders(RequestHeaderMapPtr&& headers, bool end_stream);
+    void encodeData(Buffer::Instance& data, bool end_stream);
+    void encodeTrailers(RequestTrailerMapPtr&& trailers);
+    void encodeMetadata(const MetadataMapVector& metadata_map_vector);
+    void readDisable(bool disable);
+    void setFlushTimeout(std::chrono::milliseconds timeout);
+    void reset(StreamResetReason reason);
+
+    // Resets the stream, and tells the worker, because the owning thread is shutting down.
+    void abort();
+
+    // Http::ConnectionPool::Callbacks
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                       absl::string_view transport_failure_reason,
+                       Upstream::HostDescriptionConstSharedPtr host) override;
+    void onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr host,
+                     const StreamInfo::StreamInfo& info) override;
+
+    // Http::StreamDecoder
+    void decodeData(Buffer::Instance& data, bool end_stream) override;
+    void decodeMetadata(MetadataMapPtr&& metadata_map) override;
+
+    // Http::ResponseDecoder
+    void decode100ContinueHeaders(ResponseHeaderMapPtr&& headers) override;
+    void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) override;
+    void decodeTrailers(ResponseTrailerMapPtr&& trailers) override;
+
+    // Http::StreamCallbacks
+    void onResetStream(StreamResetReason reason,
+                       absl::string_view transport_failure_reason) override;
+    void onAboveWriteBufferHighWatermark() override;
+    void onBelowWriteBufferLowWatermark() override;
+
+  private:
+    // Posts the given event to the worker half of the stream, if it is still around.
+    void postToWorker(std::function<void(WorkerStream&)> event);
+    void onLocalComplete();
+    void onRemoteComplete();
+    void done();
+
+    IoThread& thread_;
+    Event::Dispatcher& worker_dispatcher_;
+    StreamHandleSharedPtr handle_;
+    PoolHandleSharedPtr pool_;
+    ConnectionPool::Cancellable* cancellable_{};
+    RequestEncoder* encoder_{};
+    bool local_complete_{};
+    bool remote_complete_{};
+    bool done_{};
+  };
+
+  Api::Api& api_;
+  ThreadLocal::Instance& tls_;
+  const SharedConnPoolFactory factory_;
+  std::vector<IoThreadPtr> threads_;
+  bool shutdown_{};
+};
+
+using SharedConnPoolSetPtr = std::unique_ptr<SharedConnPoolSet>;
+
+/**
+ * The half of a stream living on the worker. It is what the worker uses as the request encoder
+ * and stream, and forwards all of it to the owning thread of the shared pool.
+ */
+class WorkerStream : public LinkedObject<WorkerStream>,
+                     public Event::DeferredDeletable,
+                     public ConnectionPool::Cancellable,
+                     public RequestEncoder,
+                     public Stream,
+                     public StreamCallbackHelper {
+public:
+  WorkerStream(SharedConnPool& parent, ResponseDecoder& decoder,
+               ConnectionPool::Callbacks& callbacks,
+               const SharedConnPoolSet::StreamHandleSharedPtr& handle);
+  ~WorkerStream() override;
+
+  // Events from the owning thread.
+  void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                     const std::string& transport_failure_reason);
+  void onPoolReady(const Network::Address::InstanceConstSharedPtr& local_address);
+  void decode100ContinueHeaders(ResponseHeaderMapPtr&& headers);
+  void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream);
+  void decodeData(Buffer::Instance& data, bool end_stream);
+  void decodeTrailers(ResponseTrailerMapPtr&& trailers);
+  void decodeMetadata(MetadataMapPtr&& metadata_map);
+  void onResetStream(StreamResetReason reason);
+  void onAboveWriteBufferHighWatermark() { runHighWatermarkCallbacks(); }
+  void onBelowWriteBufferLowWatermark() { runLowWatermarkCallbacks(); }
+
+  // Resets the stream because the worker side pool is going away.
+  void onPoolDestroy();
+
+  // ConnectionPool::Cancellable
+  void cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) override;
+
+  // Http::StreamEncoder
+  void encodeData(Buffer::Instance& data, bool end_stream) override;
+  Stream& getStream() override { return *this; }
+  void encodeMetadata(const MetadataMapVector& metadata_map_vector) override;
+  Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override { return absl::nullopt; }
+
+  // Http::RequestEncoder
+  void encodeHeaders(const RequestHeaderMap& headers, bool end_stream) override;
+  void encodeTrailers(const RequestTrailerMap& trailers) override;
+
+  // Http::Stream
+  void addCallbacks(StreamCallbacks& callbacks) override { addCallbacksHelper(callbacks); }
+  void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacksHelper(callbacks); }
+  void resetStream(StreamResetReason reason) override;
+  void readDisable(bool disable) override;
+  uint32_t bufferLimit() override;
+  const Network::Address::InstanceConstSharedPtr& connectionLocalAddress() override {
+    return local_address_;
+  }
+  void setFlushTimeout(std::chrono::milliseconds timeout) override;
+
+private:
+  // Posts the given event to the owning thread half of the stream, if it is still around.
+  void postToIo(std::function<void(SharedConnPoolSet::IoStream&)> event);
+  void onLocalComplete();
+  void onRemoteComplete();
+  void done();
+
+  SharedConnPool& parent_;
+  ResponseDecoder& decoder_;
+  ConnectionPool::Callbacks* callbacks_;
+  SharedConnPoolSet::StreamHandleSharedPtr handle_;
+  Network::Address::InstanceConstSharedPtr local_address_;
+  bool remote_complete_{};
+  bool done_{};
+};
+
+using WorkerStreamPtr = std::unique_ptr<WorkerStream>;
+
+/**
+ * The worker side of a shared HTTP/2 connection pool. It owns no connections itself, and hands all
+ * of its streams to the pool for the same host, priority and options on the owning thread. A stream
+ * keeps the pool active until both of its halves are done, and the pool is only drained once the
+ * pool on the owning thread is.
+ */
+class SharedConnPool : public ConnectionPool::Instance, Logger::Loggable<Logger::Id::pool> {
+public:
+  SharedConnPool(SharedConnPoolSet::IoThread& thread, Event::Dispatcher& dispatcher,
+                 SharedConnPoolSet::PoolKeySharedPtr key);
+  ~SharedConnPool() override;
+
+  // Http::ConnectionPool::Instance
+  Http::Protocol protocol() const override { return Http::Protocol::Http2; }
+  bool hasActiveConnections() const override { return !streams_.empty() || io_streams_ > 0; }
+  ConnectionPool::Cancellable* newStream(ResponseDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks) override;
+
+  // Envoy::ConnectionPool::Instance
+  void addDrainedCallback(DrainedCb cb) override;
+  void drainConnections() override;
+  // Prefetching is left to the connection pool on the owning thread.
+  bool maybePrefetch(float) override { return false; }
+  Upstream::HostDescriptionConstSharedPtr host() const override { return key_->host_; }
+
+private:
+  friend class SharedConnPoolSet;
+  friend class WorkerStream;
+
+  void onStreamDone(WorkerStream& stream);
+  // Events from the owning thread.
+  void onIoStreamDone();
+  void onIoDrained();
+  void checkForDrained();
+
+  SharedConnPoolSet::IoThread& thread_;
+  Event::Dispatcher& dispatcher_;
+  const SharedConnPoolSet::PoolKeySharedPtr key_;
+  // The connection level stream info handed out on pool ready. The connection itself lives on
+  // another thread, so it only carries the connection level filter state.
+  StreamInfo::StreamInfoImpl stream_info_;
+  const SharedConnPoolSet::PoolHandleSharedPtr handle_;
+  std::list<WorkerStreamPtr> streams_;
+  // The number of streams of this pool not yet done on the owning thread.
+  uint32_t io_streams_{};
+  std::list<DrainedCb> drained_callbacks_;
+  // Whether the pool on the owning thread was drained since drained callbacks were added.
+  bool io_drained_{};
+};
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
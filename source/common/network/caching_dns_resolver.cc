@@ -0,0 +1,166 @@
+#include "common/network/caching_dns_resolver.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Network {
+
+namespace {
+// The cache is not scanned for expired entries until it holds at least this many names.
+constexpr size_t MinRemovalSize = 1024;
+} // namespace
+
+CachingDnsResolver::CachingDnsResolver(
+    DnsResolverSharedPtr resolver, TimeSource& time_source,
+    const envoy::config::core::v3::DnsResolutionCacheConfig& config, Stats::Scope& scope)
+    : resolver_(std::move(resolver)), time_source_(time_source),
+      min_ttl_(PROTOBUF_GET_MS_OR_DEFAULT(config, min_ttl, 0)),
+      max_ttl_(PROTOBUF_GET_MS_OR_DEFAULT(config, max_ttl, 300000)),
+      negative_ttl_(PROTOBUF_GET_MS_OR_DEFAULT(config, negative_ttl, 5000)),
+      stale_ttl_(PROTOBUF_GET_MS_OR_DEFAULT(config, stale_ttl, 0)),
+      stats_({ALL_DNS_RESOLUTION_CACHE_STATS(POOL_COUNTER_PREFIX(scope, "dns_resolution_cache."),
+                                             POOL_GAUGE_PREFIX(scope, "dns_resolution_cache."))}),
+      next_removal_size_(MinRemovalSize) {}
+
+CachingDnsResolver::~CachingDnsResolver() {
+  for (auto& entry : entries_) {
+    if (entry.second.active_query_ != nullptr) {
+      entry.second.active_query_->cancel();
+    }
+  }
+  stats_.num_entries_.set(0);
+}
+
+ActiveDnsQuery* CachingDnsResolver::resolve(const std::string& dns_name,
+                                            DnsLookupFamily dns_lookup_family,
+                                            ResolveCb callback) {
+  const MonotonicTime now = time_source_.monotonicTime();
+  const EntryKey key(dns_name, dns_lookup_family);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    if (!delivering_ && entries_.size() >= next_removal_size_) {
+      removeExpiredEntries(now);
+    }
+    it = entries_.try_emplace(key).first;
+    stats_.num_entries_.set(entries_.size());
+  }
+  Entry& entry = it->second;
+
+  if (entry.resolved_ && now < entry.stale_expiry_) {
+    if (now >= entry.expiry_) {
+      ENVOY_LOG(debug, "serving stale DNS result for '{}' while refreshing it", dns_name);
+      stats_.cache_stale_hit_.inc();
+      if (!entry.query_in_flight_) {
+        startQuery(key, entry);
+      }
+    } else if (entry.status_ == ResolutionStatus::Success && !entry.responses_.empty()) {
+      stats_.cache_hit_.inc();
+    } else {
+      stats_.cache_negative_hit_.inc();
+    }
+    callback(entry.status_, cachedResponses(entry, now));
+    return nullptr;
+  }
+
+  if (entry.query_in_flight_) {
+    stats_.coalesced_query_.inc();
+  } else {
+    stats_.cache_miss_.inc();
+  }
+  auto pending_resolution = std::make_unique<PendingResolution>(entry, callback);
+  PendingResolution* pending_resolution_ptr = pending_resolution.get();
+  entry.pending_resolutions_.push_back(std::move(pending_resolution));
+  pending_resolution_ptr->entry_it_ = std::prev(entry.pending_resolutions_.end());
+  if (!entry.query_in_flight_) {
+    startQuery(key, entry);
+    if (!entry.query_in_flight_) {
+      // The underlying resolver completed inline, and so did this resolution.
+      return nullptr;
+    }
+  }
+  return pending_resolution_ptr;
+}
+
+void CachingDnsResolver::startQuery(const EntryKey& key, Entry& entry) {
+  ASSERT(!entry.query_in_flight_);
+  entry.query_in_flight_ = true;
+  Entry* entry_ptr = &entry;
+  ActiveDnsQuery* query = resolver_->resolve(
+      key.first, key.second,
+      [this, entry_ptr](ResolutionStatus status, std::list<DnsResponse>&& responses) -> void {
+        entry_ptr->active_query_ = nullptr;
+        onQueryComplete(*entry_ptr, status, std::move(responses));
+      });
+  if (entry.query_in_flight_) {
+    entry.active_query_ = query;
+  }
+}
+
+void CachingDnsResolver::onQueryComplete(Entry& entry, ResolutionStatus status,
+                                         std::list<DnsResponse>&& responses) {
+  const MonotonicTime now = time_source_.monotonicTime();
+  entry.query_in_flight_ = false;
+  entry.resolved_ = true;
+  entry.status_ = status;
+  entry.responses_ = std::move(responses);
+  if (status == ResolutionStatus::Success && !entry.responses_.empty()) {
+    std::chrono::milliseconds ttl = max_ttl_;
+    for (const DnsResponse& response : entry.responses_) {
+      ttl = std::min<std::chrono::milliseconds>(ttl, response.ttl_);
+    }
+    entry.expiry_ = now + std::max(ttl, min_ttl_);
+    entry.stale_expiry_ = entry.expiry_ + stale_ttl_;
+  } else {
+    entry.expiry_ = now + negative_ttl_;
+    entry.stale_expiry_ = entry.expiry_;
+  }
+
+  // Callbacks may resolve other names, or cancel the resolutions which did not run yet, so each
+  // resolution is taken off the entry right before its callback runs.
+  const bool was_delivering = delivering_;
+  delivering_ = true;
+  while (!entry.pending_resolutions_.empty()) {
+    PendingResolutionPtr pending_resolution = std::move(entry.pending_resolutions_.front());
+    entry.pending_resolutions_.pop_front();
+    pending_resolution->callback_(entry.status_, cachedResponses(entry, now));
+  }
+  delivering_ = was_delivering;
+}
+
+std::list<DnsResponse> CachingDnsResolver::cachedResponses(const Entry& entry,
+                                                           MonotonicTime now) const {
+  // The TTL of cached addresses is the time left until the cache refreshes them, so that callers
+  // which honor it resolve again when a fresh result is due.
+  const std::chrono::seconds ttl = std::chrono::duration_cast<std::chrono::seconds>(
+      std::max<MonotonicTime::duration>(entry.expiry_ - now, MonotonicTime::duration(0)));
+  std::list<DnsResponse> responses;
+  for (const DnsResponse& response : entry.responses_) {
+    responses.emplace_back(response.address_, ttl);
+  }
+  return responses;
+}
+
+void CachingDnsResolver::removeExpiredEntries(MonotonicTime now) {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    const Entry& entry = it->second;
+    if (!entry.query_in_flight_ && entry.pending_resolutions_.empty() &&
+        now >= entry.stale_expiry_) {
+      entries_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  next_removal_size_ = std::max(2 * entries_.size(), MinRemovalSize);
+  stats_.num_entries_.set(entries_.size());
+}
+
+void CachingDnsResolver::PendingResolution::cancel() {
+  // The underlying query keeps going, so that its result is cached for later resolutions.
+  entry_.pending_resolutions_.erase(entry_it_);
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "envoy/common/time.h"
+#include "envoy/config/core/v3/resolver.pb.h"
+#include "envoy/network/dns.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+
+#include "absl/container/node_hash_map.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * All DNS resolution cache stats. @see stats_macros.h
+ */
+#define ALL_DNS_RESOLUTION_CACHE_STATS(COUNTER, GAUGE)                                             \
+  COUNTER(cache_hit)                                                                               \
+  COUNTER(cache_miss)                                                                              \
+  COUNTER(cache_negative_hit)                                                                      \
+  COUNTER(cache_stale_hit)                                                                         \
+  COUNTER(coalesced_query)                                                                         \
+  GAUGE(num_entries, NeverImport)
+
+/**
+ * Struct definition for all DNS resolution cache stats. @see stats_macros.h
+ */
+struct DnsResolutionCacheStats {
+  ALL_DNS_RESOLUTION_CACHE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * A DnsResolver which fronts another resolver with a cache of its results. Concurrent resolutions
+ * of a name share a single query, successful results are kept for the TTL of their records, and
+ * failed or empty results are kept for a fixed negative TTL. Once a successful result expires, it
+ * may still be returned for a while as its refresh is in flight (stale-while-revalidate).
+ *
+ * Results served from the cache are delivered inline, in which case resolve() returns nullptr, as
+ * allowed by the DnsResolver contract. All calls and callbacks happen on the thread of the
+ * underlying resolver.
+ */
+class CachingDnsResolver : public DnsResolver, Logger::Loggable<Logger::Id::upstream> {
+public:
+  CachingDnsResolver(DnsResolverSharedPtr resolver, TimeSource& time_source,
+                     const envoy::config::core::v3::DnsResolutionCacheConfig& config,
+                     Stats::Scope& scope);
+  ~CachingDnsResolver() override;
+
+  // Network::DnsResolver
+  ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                          ResolveCb callback) override;
+
+  /**
+   * @return the number of names in the cache, including the ones with a query in flight.
+   */
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct Entry;
+
+  // A resolution waiting for the query of its entry to complete.
+  struct PendingResolution : public ActiveDnsQuery {
+    PendingResolution(Entry& entry, ResolveCb callback) : entry_(entry), callback_(callback) {}
+
+    // Network::ActiveDnsQuery
+    void cancel() override;
+
+    Entry& entry_;
+    const ResolveCb callback_;
+    std::list<std::unique_ptr<PendingResolution>>::iterator entry_it_;
+  };
+  using PendingResolutionPtr = std::unique_ptr<PendingResolution>;
+
+  struct Entry {
+    // Whether the entry holds the result of a completed query.
+    bool resolved_{};
+    ResolutionStatus status_{ResolutionStatus::Failure};
+    std::list<DnsResponse> responses_;
+    // The result is fresh until expiry_, and may be served stale until stale_expiry_.
+    MonotonicTime expiry_;
+    MonotonicTime stale_expiry_;
+    // Whether a query of the underlying resolver is in flight, and its handle if it has one.
+    bool query_in_flight_{};
+    ActiveDnsQuery* active_query_{};
+    std::list<PendingResolutionPtr> pending_resolutions_;
+  };
+  using EntryKey = std::pair<std::string, DnsLookupFamily>;
+
+  void startQuery(const EntryKey& key, Entry& entry);
+  void onQueryComplete(Entry& entry, ResolutionStatus status, std::list<DnsResponse>&& responses);
+  std::list<DnsResponse> cachedResponses(const Entry& entry, MonotonicTime now) const;
+  void removeExpiredEntries(MonotonicTime now);
+
+  const DnsResolverSharedPtr resolver_;
+  TimeSource& time_source_;
+  const std::chrono::milliseconds min_ttl_;
+  const std::chrono::milliseconds max_ttl_;
+  const std::chrono::milliseconds negative_ttl_;
+  const std::chrono::milliseconds stale_ttl_;
+  DnsResolutionCacheStats stats_;
+  absl::node_hash_map<EntryKey, Entry> entries_;
+  // Expired entries are removed once the cache doubles in size since the last removal.
+  size_t next_removal_size_;
+  // Set while results are delivered to the pending resolutions of an entry, during which no
+  // entry may be removed.
+  bool delivering_{};
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -57,7 +57,11 @@ std::string SslRedirector::newPath(const Http::RequestHeaderMap& headers) const
 HedgePolicyImpl::HedgePolicyImpl(const envoy::config::route::v3::HedgePolicy& hedge_policy)
     : initial_requests_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(hedge_policy, initial_requests, 1)),
       additional_request_chance_(hedge_policy.additional_request_chance()),
-      hedge_on_per_try_timeout_(hedge_policy.hedge_on_per_try_timeout()) {}
+      hedge_on_per_try_timeout_(hedge_policy.hedge_on_per_try_timeout()),
+      latency_hedge_controller_(
+          hedge_policy.has_latency_hedging()
+              ? std::make_shared<HedgeControllerImpl>(hedge_policy.latency_hedging())
+              : nullptr) {}
 
 HedgePolicyImpl::HedgePolicyImpl() : initial_requests_(1), hedge_on_per_try_timeout_(false) {}
 
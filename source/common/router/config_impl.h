@@ -26,6 +26,7 @@
 #include "common/router/config_utility.h"
 #include "common/router/header_formatter.h"
 #include "common/router/header_parser.h"
+#include "common/router/hedge_controller_impl.h"
 #include "common/router/metadatamatchcriteria_impl.h"
 #include "common/router/router_ratelimit.h"
 #include "common/router/tls_context_match_criteria_impl.h"
@@ -333,11 +334,16 @@ public:
     return additional_request_chance_;
   }
   bool hedgeOnPerTryTimeout() const override { return hedge_on_per_try_timeout_; }
+  HedgeController* latencyHedgeController() const override {
+    return latency_hedge_controller_.get();
+  }
 
 private:
   const uint32_t initial_requests_;
   const envoy::type::v3::FractionalPercent additional_request_chance_;
   const bool hedge_on_per_try_timeout_;
+  // Shared by the requests of the route on all workers.
+  const std::shared_ptr<HedgeControllerImpl> latency_hedge_controller_;
 };
 
 /**
@@ -0,0 +1,96 @@
+#include "common/router/hedge_controller_impl.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Router {
+
+namespace {
+// The counts are halved at least this often, so that they follow the recent requests.
+constexpr uint64_t MinDecayInterval = 1000;
+} // namespace
+
+HedgeControllerImpl::HedgeControllerImpl(
+    const envoy::config::route::v3::HedgePolicy::LatencyHedging& latency_hedging)
+    : percentile_(PROTOBUF_PERCENT_TO_DOUBLE_OR_DEFAULT(latency_hedging, percentile, 95.0)),
+      budget_percent_(PROTOBUF_PERCENT_TO_DOUBLE_OR_DEFAULT(latency_hedging, budget, 10.0)),
+      min_delay_(
+          std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(latency_hedging, min_delay, 1))),
+      min_samples_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(latency_hedging, min_samples, 100)),
+      // Halving leaves at least min_samples_ response times in the histogram.
+      decay_interval_(std::max<uint64_t>(MinDecayInterval, 2 * uint64_t(min_samples_))) {}
+
+void HedgeControllerImpl::onRequest() {
+  uint64_t requests = requests_.fetch_add(1) + 1;
+  // Only the request which wins the exchange halves the counts.
+  if (requests >= decay_interval_ && requests_.compare_exchange_strong(requests, requests / 2)) {
+    hedges_.store(hedges_.load() / 2);
+  }
+}
+
+absl::optional<std::chrono::milliseconds> HedgeControllerImpl::hedgeDelay() const {
+  std::array<uint64_t, NumBuckets> counts;
+  uint64_t total = 0;
+  for (size_t i = 0; i < NumBuckets; ++i) {
+    counts[i] = buckets_[i].load();
+    total += counts[i];
+  }
+  if (total == 0 || total < min_samples_) {
+    return absl::nullopt;
+  }
+
+  const uint64_t rank =
+      std::max<uint64_t>(1, std::ceil(static_cast<double>(total) * percentile_ / 100.0));
+  uint64_t seen = 0;
+  size_t index = 0;
+  for (; index < NumBuckets - 1; ++index) {
+    seen += counts[index];
+    if (seen >= rank) {
+      break;
+    }
+  }
+  return std::max(min_delay_, bucketUpperBound(index));
+}
+
+bool HedgeControllerImpl::tryHedge() {
+  if (100.0 * (hedges_.load() + 1) > budget_percent_ * requests_.load()) {
+    return false;
+  }
+  hedges_++;
+  return true;
+}
+
+void HedgeControllerImpl::recordResponseTime(std::chrono::milliseconds response_time) {
+  buckets_[bucketIndex(response_time)]++;
+  if ((samples_.fetch_add(1) + 1) % decay_interval_ == 0) {
+    for (auto& bucket : buckets_) {
+      bucket.fetch_sub(bucket.load() / 2);
+    }
+  }
+}
+
+size_t HedgeControllerImpl::bucketIndex(std::chrono::milliseconds response_time) {
+  if (response_time.count() < 4) {
+    return std::max<int64_t>(response_time.count(), 0);
+  }
+  const uint64_t value = response_time.count();
+  // The power of two of the value, and the quarter of it the value falls in.
+  const uint32_t exponent = 63 - __builtin_clzll(value);
+  const uint64_t quarter = (value >> (exponent - 2)) & 3;
+  return std::min<size_t>(4 * (exponent - 1) + quarter, NumBuckets - 1);
+}
+
+std::chrono::milliseconds HedgeControllerImpl::bucketUpperBound(size_t index) {
+  if (index < 4) {
+    return std::chrono::milliseconds(index);
+  }
+  const uint32_t exponent = index / 4 + 1;
+  const uint64_t lower_bound = (4 + index % 4) << (exponent - 2);
+  return std::chrono::milliseconds(lower_bound + (uint64_t(1) << (exponent - 2)) - 1);
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/config/route/v3/route_components.pb.h"
+#include "envoy/router/hedge_controller.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * HedgeController which hedges requests after a percentile of the recent response times of the
+ * route, tracked in a histogram shared by all workers, and allows for a percentage of the recent
+ * requests to be hedged.
+ *
+ * The histogram and the budget decay by halving their counts, once every so many response times
+ * and requests respectively, so that they follow the recent behavior of the route. The halving
+ * races with concurrent updates, which may be lost, but either only skews the estimates slightly.
+ */
+class HedgeControllerImpl : public HedgeController {
+public:
+  explicit HedgeControllerImpl(
+      const envoy::config::route::v3::HedgePolicy::LatencyHedging& latency_hedging);
+
+  // Router::HedgeController
+  void onRequest() override;
+  absl::optional<std::chrono::milliseconds> hedgeDelay() const override;
+  bool tryHedge() override;
+  void recordResponseTime(std::chrono::milliseconds response_time) override;
+
+  // Response times are counted in buckets which each cover a quarter of a power of two
+  // milliseconds, up to about two minutes.
+  static constexpr size_t NumBuckets = 64;
+  static size_t bucketIndex(std::chrono::milliseconds response_time);
+  static std::chrono::milliseconds bucketUpperBound(size_t index);
+
+private:
+  const double percentile_;
+  const double budget_percent_;
+  const std::chrono::milliseconds min_delay_;
+  const uint32_t min_samples_;
+  // The number of response times, and of requests, after which the counts are halved.
+  const uint64_t decay_interval_;
+
+  std::array<std::atomic<uint64_t>, NumBuckets> buckets_{};
+  std::atomic<uint64_t> samples_{};
+  std::atomic<uint64_t> requests_{};
+  std::atomic<uint64_t> hedges_{};
+};
+
+} // namespace Router
+} // namespace Envoy
@@ -248,7 +248,14 @@ RetryStatus RetryStateImpl::shouldRetry(bool would_retry, DoRetryCallback callba
 
   retries_remaining_--;
 
-  if (!cluster_.resourceManager(priority_).retries().canCreate()) {
+  // The retry is reserved before it is checked against the limit, so that the workers retrying
+  // at the same time, as they do when an upstream partially fails, can't all see room for one
+  // more retry and overshoot the limit together. With a retry budget, the limit scales with the
+  // active requests of the cluster.
+  ResourceLimit& retries = cluster_.resourceManager(priority_).retries();
+  retries.inc();
+  if (retries.count() > retries.max()) {
+    retries.dec();
     cluster_.stats().upstream_rq_retry_overflow_.inc();
     if (vcluster_) {
       vcluster_->stats().upstream_rq_retry_overflow_.inc();
@@ -257,12 +264,12 @@ RetryStatus RetryStateImpl::shouldRetry(bool would_retry, DoRetryCallback callba
   }
 
   if (!runtime_.snapshot().featureEnabled("upstream.use_retry", 100)) {
+    retries.dec();
     return RetryStatus::No;
   }
 
   ASSERT(!callback_);
   callback_ = callback;
-  cluster_.resourceManager(priority_).retries().inc();
   cluster_.stats().upstream_rq_retry_.inc();
   if (vcluster_) {
     vcluster_->stats().upstream_rq_retry_.inc();
@@ -730,6 +730,10 @@ void Filter::cleanup() {
     response_timeout_->disableTimer();
     response_timeout_.reset();
   }
+  if (hedge_timer_) {
+    hedge_timer_->disableTimer();
+    hedge_timer_.reset();
+  }
 }
 
 void Filter::maybeDoShadowing() {
@@ -778,6 +782,16 @@ void Filter::onRequestComplete() {
         upstream_request->setupPerTryTimeout();
       }
     }
+
+    HedgeController* hedge_controller = route_entry_->hedgePolicy().latencyHedgeController();
+    if (hedge_controller != nullptr) {
+      hedge_controller->onRequest();
+      const absl::optional<std::chrono::milliseconds> hedge_delay = hedge_controller->hedgeDelay();
+      if (hedge_delay.has_value() && retry_state_) {
+        hedge_timer_ = dispatcher.createTimer([this]() -> void { onHedgeTimeout(); });
+        hedge_timer_->enableTimer(hedge_delay.value());
+      }
+    }
   }
 }
 
@@ -855,7 +869,7 @@ void Filter::onSoftPerTryTimeout(UpstreamRequest& upstream_request) {
       // back.
       upstream_request.retried(true);
 
-      // TODO: cluster stat for hedge attempted.
+      cluster_->stats().upstream_rq_hedge_.inc();
     } else if (retry_status == RetryStatus::NoOverflow) {
       callbacks_->streamInfo().setResponseFlag(StreamInfo::ResponseFlag::UpstreamOverflow);
     } else if (retry_status == RetryStatus::NoRetryLimitExceeded) {
@@ -865,6 +879,33 @@ void Filter::onSoftPerTryTimeout(UpstreamRequest& upstream_request) {
   }
 }
 
+void Filter::onHedgeTimeout() {
+  if (downstream_response_started_ || !retry_state_ || numRequestsAwaitingHeaders() == 0) {
+    return;
+  }
+
+  // The hedges of the route are limited to a percentage of its requests, so that hedging does not
+  // add much load when the upstream is slow for all requests.
+  if (!route_entry_->hedgePolicy().latencyHedgeController()->tryHedge()) {
+    cluster_->stats().upstream_rq_hedge_budget_exceeded_.inc();
+    return;
+  }
+
+  RetryStatus retry_status =
+      retry_state_->shouldHedgeRetryPerTryTimeout([this]() -> void { doRetry(); });
+  if (retry_status == RetryStatus::Yes) {
+    pending_retries_++;
+    // As for hedging on per try timeout, errors of the outstanding requests are only charged to
+    // their hosts if no response arrives.
+    for (auto& upstream_request : upstream_requests_) {
+      if (upstream_request->awaitingHeaders()) {
+        upstream_request->retried(true);
+      }
+    }
+    cluster_->stats().upstream_rq_hedge_.inc();
+  }
+}
+
 void Filter::onPerTryTimeout(UpstreamRequest& upstream_request) {
   if (hedging_params_.hedge_on_per_try_timeout_) {
     onSoftPerTryTimeout(upstream_request);
@@ -1161,7 +1202,7 @@ void Filter::resetOtherUpstreams(UpstreamRequest& upstream_request) {
     if (upstream_request_tmp.get() != &upstream_request) {
       upstream_request_tmp->resetStream();
       // TODO: per-host stat for hedge abandoned.
-      // TODO: cluster stat for hedge abandoned.
+      cluster_->stats().upstream_rq_hedge_abandoned_.inc();
     } else {
       final_upstream_request = std::move(upstream_request_tmp);
     }
@@ -1358,6 +1399,28 @@ void Filter::onUpstreamComplete(UpstreamRequest& upstream_request) {
   std::chrono::milliseconds response_time = std::chrono::duration_cast<std::chrono::milliseconds>(
       dispatcher.timeSource().monotonicTime() - downstream_request_complete_time_);
 
+  // Latency aware load balancing uses the time to first response byte of this upstream request,
+  // which unlike response_time does not include earlier retries or the response body. Hosts only
+  // track their latency when the cluster uses a latency aware load balancer.
+  const StreamInfo::UpstreamTiming& upstream_timing = upstream_request.upstreamTiming();
+  if (upstream_timing.first_upstream_tx_byte_sent_.has_value() &&
+      upstream_timing.first_upstream_rx_byte_received_.has_value()) {
+    const MonotonicTime::duration first_byte_latency =
+        upstream_timing.first_upstream_rx_byte_received_.value() -
+        upstream_timing.first_upstream_tx_byte_sent_.value();
+    if (cluster_->lbType() == Upstream::LoadBalancerType::PeakEwma) {
+      upstream_request.upstreamHost()->latencyMonitor().putResponseTime(
+          std::chrono::duration_cast<std::chrono::microseconds>(first_byte_latency),
+          dispatcher.timeSource().monotonicTime());
+    }
+    // Latency hedging delays the hedges of the route by a percentile of the same latency.
+    HedgeController* hedge_controller = route_entry_->hedgePolicy().latencyHedgeController();
+    if (hedge_controller != nullptr) {
+      hedge_controller->recordResponseTime(
+          std::chrono::duration_cast<std::chrono::milliseconds>(first_byte_latency));
+    }
+  }
+
   Upstream::ClusterTimeoutBudgetStatsOptRef tb_stats = cluster()->timeoutBudgetStats();
   if (tb_stats.has_value()) {
     tb_stats->get().upstream_rq_timeout_budget_percent_used_.recordValue(
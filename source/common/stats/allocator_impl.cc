@@ -8,6 +8,7 @@
 #include "common/common/hash.h"
 #include "common/common/lock_guard.h"
 #include "common/common/logger.h"
+#include "common/common/sharded_counter.h"
 #include "common/common/thread.h"
 #include "common/common/thread_annotations.h"
 #include "common/common/utility.h"
@@ -16,6 +17,7 @@
 #include "common/stats/symbol_table_impl.h"
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
 
 namespace Envoy {
 namespace Stats {
@@ -144,6 +146,47 @@ private:
   std::atomic<uint64_t> pending_increment_{0};
 };
 
+// A counter which threads increment in slots of their own, for the counters which many threads
+// increment at once. Reads walk the slots, which is fine as counters are mostly read when stats
+// are flushed and by admin requests.
+class ShardedCounterImpl : public StatsSharedImpl<Counter> {
+public:
+  ShardedCounterImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
+                     const StatNameTagVector& stat_name_tags)
+      : StatsSharedImpl(name, alloc, tag_extracted_name, stat_name_tags),
+        value_(ShardedCounter::defaultNumSlots()) {}
+
+  void removeFromSetLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) override {
+    const size_t count = alloc_.counters_.erase(statName());
+    ASSERT(count == 1);
+  }
+
+  // Stats::Counter
+  void add(uint64_t amount) override {
+    value_.add(amount);
+    // Only write the flags the first time, so that increments don't share a cache line.
+    if (!(flags_.load(std::memory_order_relaxed) & Flags::Used)) {
+      flags_ |= Flags::Used;
+    }
+  }
+  void inc() override { add(1); }
+  uint64_t latch() override {
+    // The slots only ever grow, modulo wrapping around, so the increment since the previous latch
+    // is the difference between the sums.
+    const uint64_t total = value_.sum();
+    return total - latched_total_.exchange(total);
+  }
+  // Like CounterImpl, a reset only restarts value(), and the next latch() still reports the
+  // increments made since the previous one.
+  void reset() override { reset_total_ = value_.sum(); }
+  uint64_t value() const override { return static_cast<uint64_t>(value_.sum()) - reset_total_; }
+
+private:
+  ShardedCounter value_;
+  std::atomic<uint64_t> latched_total_{0};
+  std::atomic<uint64_t> reset_total_{0};
+};
+
 class GaugeImpl : public StatsSharedImpl<Gauge> {
 public:
   GaugeImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
@@ -173,18 +216,19 @@ public:
   // Stats::Gauge
   void add(uint64_t amount) override {
     child_value_ += amount;
-    flags_ |= Flags::Used;
+    markUsedAndDirty();
   }
   void dec() override { sub(1); }
   void inc() override { add(1); }
   void set(uint64_t value) override {
     child_value_ = value;
-    flags_ |= Flags::Used;
+    markUsedAndDirty();
   }
   void sub(uint64_t amount) override {
     ASSERT(child_value_ >= amount);
     ASSERT(used() || amount == 0);
     child_value_ -= amount;
+    markDirty();
   }
   uint64_t value() const override { return child_value_ + parent_value_; }
 
@@ -224,9 +268,30 @@ public:
     }
   }
 
-  void setParentValue(uint64_t value) override { parent_value_ = value; }
+  void setParentValue(uint64_t value) override {
+    parent_value_ = value;
+    markDirty();
+  }
+
+  bool clearDirty() override {
+    return (flags_.fetch_and(static_cast<uint16_t>(~Flags::Dirty)) & Flags::Dirty) != 0;
+  }
 
 private:
+  // Skip the atomic read-modify-write when the bits are already set, as they are for all but the
+  // first write between two flushes.
+  void markUsedAndDirty() {
+    constexpr uint16_t UsedAndDirty = Flags::Used | Flags::Dirty;
+    if ((flags_.load(std::memory_order_relaxed) & UsedAndDirty) != UsedAndDirty) {
+      flags_ |= UsedAndDirty;
+    }
+  }
+  void markDirty() {
+    if ((flags_.load(std::memory_order_relaxed) & Flags::Dirty) == 0) {
+      flags_ |= Flags::Dirty;
+    }
+  }
+
   std::atomic<uint64_t> parent_value_{0};
   std::atomic<uint64_t> child_value_{0};
 };
@@ -303,6 +368,24 @@ TextReadoutSharedPtr AllocatorImpl::makeTextReadout(StatName name, StatName tag_
   return text_readout;
 }
 
+void AllocatorImpl::setShardedCounterPrefixes(const std::vector<std::string>& prefixes) {
+  Thread::LockGuard lock(mutex_);
+  sharded_counter_prefixes_ = prefixes;
+}
+
+bool AllocatorImpl::shardCounter(StatName name) const {
+  if (sharded_counter_prefixes_.empty()) {
+    return false;
+  }
+  const std::string name_str = symbol_table_.toString(name);
+  for (const std::string& prefix : sharded_counter_prefixes_) {
+    if (absl::StartsWith(name_str, prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool AllocatorImpl::isMutexLockedForTest() {
   bool locked = mutex_.tryLock();
   if (locked) {
@@ -313,6 +396,9 @@ bool AllocatorImpl::isMutexLockedForTest() {
 
 Counter* AllocatorImpl::makeCounterInternal(StatName name, StatName tag_extracted_name,
                                             const StatNameTagVector& stat_name_tags) {
+  if (shardCounter(name)) {
+    return new ShardedCounterImpl(name, *this, tag_extracted_name, stat_name_tags);
+  }
   return new CounterImpl(name, *this, tag_extracted_name, stat_name_tags);
 }
 
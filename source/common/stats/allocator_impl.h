@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include "envoy/stats/allocator.h"
@@ -32,6 +33,7 @@ public:
                                        const StatNameTagVector& stat_name_tags) override;
   SymbolTable& symbolTable() override { return symbol_table_; }
   const SymbolTable& constSymbolTable() const override { return symbol_table_; }
+  void setShardedCounterPrefixes(const std::vector<std::string>& prefixes) override;
 
 #ifndef ENVOY_CONFIG_COVERAGE
   void debugPrint();
@@ -54,6 +56,7 @@ protected:
 private:
   template <class BaseClass> friend class StatsSharedImpl;
   friend class CounterImpl;
+  friend class ShardedCounterImpl;
   friend class GaugeImpl;
   friend class TextReadoutImpl;
   friend class NotifyingAllocatorImpl;
@@ -61,10 +64,14 @@ private:
   void removeCounterFromSetLockHeld(Counter* counter) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void removeGaugeFromSetLockHeld(Gauge* gauge) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void removeTextReadoutFromSetLockHeld(Counter* counter) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool shardCounter(StatName name) const;
 
   StatSet<Counter> counters_ ABSL_GUARDED_BY(mutex_);
   StatSet<Gauge> gauges_ ABSL_GUARDED_BY(mutex_);
   StatSet<TextReadout> text_readouts_ ABSL_GUARDED_BY(mutex_);
+  // Written under mutex_, which makeCounter() holds when it reads them. This is not annotated as
+  // makeCounterInternal() is overridden by classes which can't name the mutex.
+  std::vector<std::string> sharded_counter_prefixes_;
 
   SymbolTable& symbol_table_;
 
@@ -1,6 +1,7 @@
 #include "common/stats/histogram_impl.h"
 
 #include <algorithm>
+#include <cmath>
 #include <string>
 
 #include "common/common/utility.h"
@@ -17,6 +18,11 @@ const ConstSupportedBuckets default_buckets{};
 HistogramStatisticsImpl::HistogramStatisticsImpl()
     : supported_buckets_(default_buckets), computed_quantiles_(supportedQuantiles().size(), 0.0) {}
 
+HistogramStatisticsImpl::HistogramStatisticsImpl(ConstSupportedBuckets& supported_buckets)
+    : supported_buckets_(supported_buckets),
+      computed_quantiles_(HistogramStatisticsImpl::supportedQuantiles().size(), 0.0),
+      computed_buckets_(supported_buckets.size(), 0), sample_count_(0), sample_sum_(0) {}
+
 HistogramStatisticsImpl::HistogramStatisticsImpl(const histogram_t* histogram_ptr,
                                                  ConstSupportedBuckets& supported_buckets)
     : supported_buckets_(supported_buckets),
@@ -81,25 +87,110 @@ void HistogramStatisticsImpl::refresh(const histogram_t* new_histogram_ptr) {
   }
 }
 
+void HistogramStatisticsImpl::refresh(const CompactHistogram& new_histogram) {
+  ASSERT(supportedQuantiles().size() == computed_quantiles_.size());
+  for (size_t i = 0; i < computed_quantiles_.size(); ++i) {
+    computed_quantiles_[i] = new_histogram.quantile(supportedQuantiles()[i]);
+  }
+
+  sample_count_ = new_histogram.sampleCount();
+  sample_sum_ = new_histogram.sampleSum();
+
+  // The histogram counts the samples of each of the supported buckets exactly.
+  ASSERT(supportedBuckets().size() == computed_buckets_.size());
+  ASSERT(&supportedBuckets() == &new_histogram.buckets());
+  uint64_t count_below = 0;
+  for (size_t i = 0; i < computed_buckets_.size(); ++i) {
+    count_below += new_histogram.counts()[i];
+    computed_buckets_[i] = count_below;
+  }
+}
+
+void CompactHistogram::merge(const CompactHistogram& other) {
+  ASSERT(counts_.size() == other.counts_.size());
+  // A plain loop over two arrays, which compilers vectorize.
+  uint64_t* counts = counts_.data();
+  const uint64_t* other_counts = other.counts_.data();
+  const size_t size = counts_.size();
+  for (size_t i = 0; i < size; ++i) {
+    counts[i] += other_counts[i];
+  }
+  sample_sum_ += other.sample_sum_;
+}
+
+void CompactHistogram::clear() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  sample_sum_ = 0;
+}
+
+uint64_t CompactHistogram::sampleCount() const {
+  uint64_t count = 0;
+  for (const uint64_t bucket_count : counts_) {
+    count += bucket_count;
+  }
+  return count;
+}
+
+double CompactHistogram::quantile(double fraction) const {
+  const uint64_t count = sampleCount();
+  if (count == 0) {
+    return std::nan("");
+  }
+  const double rank = fraction * count;
+  uint64_t count_below = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    if (counts_[i] == 0) {
+      continue;
+    }
+    const double lower_bound = i == 0 ? 0 : buckets_[i - 1];
+    if (i == buckets_.size()) {
+      // Nothing is known of the samples above the last bucket but their lower bound.
+      return lower_bound;
+    }
+    if (count_below + counts_[i] >= rank) {
+      return lower_bound + (buckets_[i] - lower_bound) * (rank - count_below) / counts_[i];
+    }
+    count_below += counts_[i];
+  }
+  return buckets_.back();
+}
+
 HistogramSettingsImpl::HistogramSettingsImpl(const envoy::config::metrics::v3::StatsConfig& config)
     : configs_([&config]() {
         std::vector<Config> configs;
         for (const auto& matcher : config.histogram_bucket_settings()) {
           std::vector<double> buckets{matcher.buckets().begin(), matcher.buckets().end()};
           std::sort(buckets.begin(), buckets.end());
-          configs.emplace_back(matcher.match(), std::move(buckets));
+          configs.push_back(Config{Matchers::StringMatcherImpl(matcher.match()), std::move(buckets),
+                                   matcher.compact(), matcher.sample_buffer_size()});
         }
 
         return configs;
       }()) {}
 
-const ConstSupportedBuckets& HistogramSettingsImpl::buckets(absl::string_view stat_name) const {
+const HistogramSettingsImpl::Config*
+HistogramSettingsImpl::findConfig(absl::string_view stat_name) const {
   for (const auto& config : configs_) {
-    if (config.first.match(stat_name)) {
-      return config.second;
+    if (config.matcher_.match(stat_name)) {
+      return &config;
     }
   }
-  return defaultBuckets();
+  return nullptr;
+}
+
+const ConstSupportedBuckets& HistogramSettingsImpl::buckets(absl::string_view stat_name) const {
+  const Config* config = findConfig(stat_name);
+  return config != nullptr ? config->buckets_ : defaultBuckets();
+}
+
+bool HistogramSettingsImpl::compact(absl::string_view stat_name) const {
+  const Config* config = findConfig(stat_name);
+  return config != nullptr && config->compact_;
+}
+
+uint32_t HistogramSettingsImpl::sampleBufferSize(absl::string_view stat_name) const {
+  const Config* config = findConfig(stat_name);
+  return config != nullptr ? config->sample_buffer_size_ : 0;
 }
 
 const ConstSupportedBuckets& HistogramSettingsImpl::defaultBuckets() {
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/config/metrics/v3/stats.pb.h"
 #include "envoy/stats/histogram.h"
@@ -24,21 +26,87 @@ public:
 
   // HistogramSettings
   const ConstSupportedBuckets& buckets(absl::string_view stat_name) const override;
+  bool compact(absl::string_view stat_name) const override;
+  uint32_t sampleBufferSize(absl::string_view stat_name) const override;
 
   static ConstSupportedBuckets& defaultBuckets();
 
 private:
-  using Config = std::pair<Matchers::StringMatcherImpl, ConstSupportedBuckets>;
+  struct Config {
+    Matchers::StringMatcherImpl matcher_;
+    ConstSupportedBuckets buckets_;
+    bool compact_;
+    uint32_t sample_buffer_size_;
+  };
+
+  const Config* findConfig(absl::string_view stat_name) const;
+
   const std::vector<Config> configs_{};
 };
 
 /**
- * Implementation of HistogramStatistics for circllhist.
+ * A histogram which only counts the samples falling in each of a fixed set of buckets, along with
+ * their sum. Unlike a circllhist, it never allocates once created, and recording and merging are
+ * a handful of additions, at the cost of quantiles only interpolated within the buckets. It is not
+ * thread safe.
+ */
+class CompactHistogram : NonCopyable {
+public:
+  /**
+   * @param buckets supplies the sorted upper bounds of the buckets, which must outlive the
+   *        histogram. Samples above the last bound are counted in an extra overflow bucket.
+   */
+  explicit CompactHistogram(ConstSupportedBuckets& buckets)
+      : buckets_(buckets), counts_(buckets.size() + 1, 0) {}
+
+  void recordValue(uint64_t value) {
+    counts_[std::lower_bound(buckets_.begin(), buckets_.end(), static_cast<double>(value)) -
+            buckets_.begin()]++;
+    sample_sum_ += value;
+  }
+
+  /**
+   * Adds the samples of another histogram with the same buckets to this one.
+   */
+  void merge(const CompactHistogram& other);
+
+  void clear();
+
+  ConstSupportedBuckets& buckets() const { return buckets_; }
+
+  /**
+   * @return the number of samples in each bucket, followed by the number of samples above the
+   *         last bucket.
+   */
+  const std::vector<uint64_t>& counts() const { return counts_; }
+
+  uint64_t sampleCount() const;
+  uint64_t sampleSum() const { return sample_sum_; }
+
+  /**
+   * @return the value below which the given fraction of the samples fall, interpolated linearly
+   *         within its bucket, or NaN if there is no sample.
+   */
+  double quantile(double fraction) const;
+
+private:
+  ConstSupportedBuckets& buckets_;
+  std::vector<uint64_t> counts_;
+  uint64_t sample_sum_{0};
+};
+
+/**
+ * Implementation of HistogramStatistics for circllhist and compact histograms.
  */
 class HistogramStatisticsImpl : public HistogramStatistics, NonCopyable {
 public:
   HistogramStatisticsImpl();
 
+  /**
+   * Constructs the statistics of an empty histogram with the given buckets.
+   */
+  explicit HistogramStatisticsImpl(ConstSupportedBuckets& supported_buckets);
+
   /**
    * HistogramStatisticsImpl object is constructed using the passed in histogram.
    * @param histogram_ptr pointer to the histogram for which stats will be calculated. This pointer
@@ -51,6 +119,7 @@ public:
   static ConstSupportedBuckets& defaultSupportedBuckets();
 
   void refresh(const histogram_t* new_histogram_ptr);
+  void refresh(const CompactHistogram& new_histogram);
 
   // HistogramStatistics
   std::string quantileSummary() const override;
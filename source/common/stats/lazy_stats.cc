@@ -0,0 +1,36 @@
+#include "common/stats/lazy_stats.h"
+
+namespace Envoy {
+namespace Stats {
+
+Counter& LazyStatPool::counterFromString(const std::string& name) {
+  counters_.emplace_back(scope_, names_.add(name));
+  return counters_.back();
+}
+
+Gauge& LazyStatPool::gaugeFromString(const std::string& name, Gauge::ImportMode import_mode) {
+  gauges_.emplace_back(scope_, names_.add(name), import_mode);
+  return gauges_.back();
+}
+
+Histogram& LazyStatPool::histogramFromString(const std::string& name, Histogram::Unit unit) {
+  histograms_.emplace_back(scope_, names_.add(name), unit);
+  return histograms_.back();
+}
+
+uint64_t LazyStatPool::numAllocated() const {
+  uint64_t num_allocated = 0;
+  for (const LazyCounter& counter : counters_) {
+    num_allocated += counter.isAllocated();
+  }
+  for (const LazyGauge& gauge : gauges_) {
+    num_allocated += gauge.isAllocated();
+  }
+  for (const LazyHistogram& histogram : histograms_) {
+    num_allocated += histogram.isAllocated();
+  }
+  return num_allocated;
+}
+
+} // namespace Stats
+} // namespace Envoy
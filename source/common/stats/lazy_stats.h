@@ -0,0 +1,209 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <string>
+
+#include "envoy/stats/histogram.h"
+#include "envoy/stats/refcount_ptr.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats.h"
+
+#include "common/stats/symbol_table_impl.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Stands in for a stat which is only allocated in its scope when first written. Until then it reads
+ * as zero and unused, and is absent from the scope, so admin and the sinks don't see it. Accessing
+ * the name or tags allocates the stat, as those come from the scope.
+ */
+template <class StatType> class LazyStatBase : public StatType {
+public:
+  LazyStatBase(Scope& scope, StatName name) : scope_(scope), name_(name) {}
+
+  // Metric
+  std::string name() const override { return stat().name(); }
+  StatName statName() const override { return stat().statName(); }
+  TagVector tags() const override { return stat().tags(); }
+  std::string tagExtractedName() const override { return stat().tagExtractedName(); }
+  StatName tagExtractedStatName() const override { return stat().tagExtractedStatName(); }
+  void iterateTagStatNames(const Metric::TagStatNameIterFn& fn) const override {
+    stat().iterateTagStatNames(fn);
+  }
+  bool used() const override {
+    const StatType* stat = allocated();
+    return stat != nullptr && stat->used();
+  }
+  SymbolTable& symbolTable() override { return scope_.symbolTable(); }
+  const SymbolTable& constSymbolTable() const override { return scope_.constSymbolTable(); }
+
+  /**
+   * @return whether the stat has been allocated in the scope.
+   */
+  bool isAllocated() const { return allocated() != nullptr; }
+
+  // RefcountInterface
+  void incRefCount() override { refcount_helper_.incRefCount(); }
+  bool decRefCount() override { return refcount_helper_.decRefCount(); }
+  uint32_t use_count() const override { return refcount_helper_.use_count(); }
+
+protected:
+  /**
+   * @return the stat in the scope, or nullptr if it has not been allocated yet.
+   */
+  StatType* allocated() const { return stat_.load(std::memory_order_acquire); }
+
+  /**
+   * @return the stat in the scope, allocating it if needed. Threads racing to allocate the stat
+   *         get the same one from the scope, so the last store wins harmlessly.
+   */
+  StatType& stat() const {
+    StatType* stat = allocated();
+    if (stat == nullptr) {
+      stat = &allocate(scope_, name_);
+      stat_.store(stat, std::memory_order_release);
+    }
+    return *stat;
+  }
+
+private:
+  virtual StatType& allocate(Scope& scope, StatName name) const PURE;
+
+  Scope& scope_;
+  const StatName name_;
+  mutable std::atomic<StatType*> stat_{nullptr};
+  RefcountHelper refcount_helper_;
+};
+
+class LazyCounter : public LazyStatBase<Counter> {
+public:
+  using LazyStatBase::LazyStatBase;
+
+  // Counter
+  void add(uint64_t amount) override {
+    if (amount != 0) {
+      stat().add(amount);
+    }
+  }
+  void inc() override { stat().inc(); }
+  uint64_t latch() override {
+    Counter* counter = allocated();
+    return counter != nullptr ? counter->latch() : 0;
+  }
+  void reset() override {
+    Counter* counter = allocated();
+    if (counter != nullptr) {
+      counter->reset();
+    }
+  }
+  uint64_t value() const override {
+    const Counter* counter = allocated();
+    return counter != nullptr ? counter->value() : 0;
+  }
+
+private:
+  Counter& allocate(Scope& scope, StatName name) const override {
+    return scope.counterFromStatName(name);
+  }
+};
+
+class LazyGauge : public LazyStatBase<Gauge> {
+public:
+  LazyGauge(Scope& scope, StatName name, ImportMode import_mode)
+      : LazyStatBase(scope, name), import_mode_(import_mode) {}
+
+  // Gauge
+  void add(uint64_t amount) override {
+    if (amount != 0) {
+      stat().add(amount);
+    }
+  }
+  void dec() override { stat().dec(); }
+  void inc() override { stat().inc(); }
+  void set(uint64_t value) override {
+    // Setting an unallocated gauge to zero is a no-op, which keeps the gauges that clusters set on
+    // every host update, such as membership_degraded, from being allocated for nothing.
+    if (value != 0 || allocated() != nullptr) {
+      stat().set(value);
+    }
+  }
+  void sub(uint64_t amount) override { stat().sub(amount); }
+  uint64_t value() const override {
+    const Gauge* gauge = allocated();
+    return gauge != nullptr ? gauge->value() : 0;
+  }
+  void setParentValue(uint64_t parent_value) override { stat().setParentValue(parent_value); }
+  ImportMode importMode() const override {
+    const Gauge* gauge = allocated();
+    return gauge != nullptr ? gauge->importMode() : import_mode_;
+  }
+  void mergeImportMode(ImportMode import_mode) override { stat().mergeImportMode(import_mode); }
+  bool clearDirty() override {
+    Gauge* gauge = allocated();
+    return gauge != nullptr && gauge->clearDirty();
+  }
+
+private:
+  Gauge& allocate(Scope& scope, StatName name) const override {
+    return scope.gaugeFromStatName(name, import_mode_);
+  }
+
+  const ImportMode import_mode_;
+};
+
+class LazyHistogram : public LazyStatBase<Histogram> {
+public:
+  LazyHistogram(Scope& scope, StatName name, Unit unit) : LazyStatBase(scope, name), unit_(unit) {}
+
+  // Histogram
+  Unit unit() const override {
+    const Histogram* histogram = allocated();
+    return histogram != nullptr ? histogram->unit() : unit_;
+  }
+  void recordValue(uint64_t value) override { stat().recordValue(value); }
+
+private:
+  Histogram& allocate(Scope& scope, StatName name) const override {
+    return scope.histogramFromStatName(name, unit_);
+  }
+
+  const Unit unit_;
+};
+
+/**
+ * Hands out stats of a scope which are only allocated when first written, through the same
+ * counterFromString(), gaugeFromString() and histogramFromString() calls as a Scope, so that it can
+ * be passed to the POOL_* stats macros. Large configurations, such as thousands of clusters most of
+ * which see little traffic, save most of the memory of the stats they never write; the cost is an
+ * extra indirection on each write, and stats which were never written are missing from admin and
+ * the sinks rather than reported as zero.
+ *
+ * The pool owns the placeholders, so it must outlive every reference to them, and the scope must
+ * outlive the pool.
+ */
+class LazyStatPool {
+public:
+  explicit LazyStatPool(Scope& scope) : scope_(scope), names_(scope.symbolTable()) {}
+
+  Counter& counterFromString(const std::string& name);
+  Gauge& gaugeFromString(const std::string& name, Gauge::ImportMode import_mode);
+  Histogram& histogramFromString(const std::string& name, Histogram::Unit unit);
+
+  /**
+   * @return the number of stats handed out whose stat has been allocated in the scope.
+   */
+  uint64_t numAllocated() const;
+
+private:
+  Scope& scope_;
+  StatNamePool names_;
+  // Deques keep the placeholders at stable addresses as they are added.
+  std::deque<LazyCounter> counters_;
+  std::deque<LazyGauge> gauges_;
+  std::deque<LazyHistogram> histograms_;
+};
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "envoy/stats/symbol_table.h"
+
+#include "common/common/assert.h"
+#include "common/stats/symbol_table_impl.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Caches values rendered from stat names, such as the names and tags of metrics formatted for an
+ * exposition format, so that they are not decoded from the symbol table and rendered again on
+ * every flush or scrape. Each lookup marks its entry with a generation supplied by the caller,
+ * typically the number of the flush or scrape, and sweep() drops the entries which were not used
+ * since a given generation, including those of the metrics which were freed. This is not thread
+ * safe.
+ */
+template <class Value> class StatNameCache {
+public:
+  explicit StatNameCache(SymbolTable& symbol_table) : symbol_table_(symbol_table) {}
+  ~StatNameCache() { clear(); }
+
+  /**
+   * Looks up the value of a stat name, rendering it if it is not cached yet.
+   * @param name supplies the stat name.
+   * @param generation supplies the generation the entry is marked as used in.
+   * @param render supplies the function returning the value of the stat name, which is only called
+   *        if the value is not cached.
+   * @return the value of the stat name, which is valid until the entry is swept.
+   */
+  template <class RenderFn>
+  const Value& get(StatName name, uint64_t generation, const RenderFn& render) {
+    const Value* value = find(name, generation);
+    return value != nullptr ? *value : insert(name, generation, render());
+  }
+
+  /**
+   * Looks up the value of a stat name, for the callers which may not cache a value for every stat
+   * name.
+   * @param name supplies the stat name.
+   * @param generation supplies the generation the entry is marked as used in, if it is cached.
+   * @return the value of the stat name, or nullptr if it is not cached.
+   */
+  const Value* find(StatName name, uint64_t generation) {
+    const auto iter = entries_.find(name);
+    if (iter == entries_.end()) {
+      return nullptr;
+    }
+    iter->second->generation_ = generation;
+    return &iter->second->value_;
+  }
+
+  /**
+   * Caches the value of a stat name which is not cached yet.
+   * @param name supplies the stat name.
+   * @param generation supplies the generation the entry is marked as used in.
+   * @param value supplies the value of the stat name.
+   * @return the cached value, which is valid until the entry is swept.
+   */
+  const Value& insert(StatName name, uint64_t generation, Value&& value) {
+    auto entry = std::make_unique<Entry>(name, symbol_table_, std::move(value));
+    entry->generation_ = generation;
+    const StatName key = entry->name_.statName();
+    const auto result = entries_.emplace(key, std::move(entry));
+    ASSERT(result.second);
+    return result.first->second->value_;
+  }
+
+  /**
+   * Drops the entries which were last used in a generation lower than the given one.
+   * @param generation supplies the lowest generation of the entries which are kept.
+   */
+  void sweep(uint64_t generation) {
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+      if (iter->second->generation_ < generation) {
+        iter->second->name_.free(symbol_table_);
+        entries_.erase(iter++);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  /**
+   * Drops all the entries.
+   */
+  void clear() {
+    for (auto& entry : entries_) {
+      entry.second->name_.free(symbol_table_);
+    }
+    entries_.clear();
+  }
+
+  /**
+   * @return the number of cached entries.
+   */
+  uint64_t size() const { return entries_.size(); }
+
+private:
+  struct Entry {
+    Entry(StatName name, SymbolTable& symbol_table, Value&& value)
+        : name_(name, symbol_table), value_(std::move(value)) {}
+
+    // Backs the key of the entry in the map.
+    StatNameStorage name_;
+    const Value value_;
+    uint64_t generation_{};
+  };
+
+  SymbolTable& symbol_table_;
+  StatNameHashMap<std::unique_ptr<Entry>> entries_;
+};
+
+} // namespace Stats
+} // namespace Envoy
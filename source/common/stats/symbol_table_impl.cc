@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iostream>
 #include <memory>
+#include <tuple>
 #include <vector>
 
 #include "common/common/assert.h"
@@ -157,11 +158,8 @@ void SymbolTableImpl::Encoding::decodeTokens(
 std::vector<absl::string_view> SymbolTableImpl::decodeStrings(const SymbolTable::Storage array,
                                                               size_t size) const {
   std::vector<absl::string_view> strings;
-  Thread::LockGuard lock(lock_);
   Encoding::decodeTokens(
-      array, size,
-      [this, &strings](Symbol symbol)
-          ABSL_NO_THREAD_SAFETY_ANALYSIS { strings.push_back(fromSymbol(symbol)); },
+      array, size, [this, &strings](Symbol symbol) { strings.push_back(fromSymbol(symbol)); },
       [&strings](absl::string_view str) { strings.push_back(str); });
   return strings;
 }
@@ -182,6 +180,54 @@ void SymbolTableImpl::Encoding::appendToMemBlock(StatName stat_name,
   }
 }
 
+SymbolTableImpl::SymbolEntryTable::~SymbolEntryTable() {
+  for (std::atomic<Middle*>& middle : root_) {
+    Middle* middle_ptr = middle.load(std::memory_order_relaxed);
+    if (middle_ptr == nullptr) {
+      continue;
+    }
+    for (std::atomic<Leaf*>& leaf : middle_ptr->leaves_) {
+      delete leaf.load(std::memory_order_relaxed);
+    }
+    delete middle_ptr;
+  }
+}
+
+SymbolTableImpl::SymbolEntry* SymbolTableImpl::SymbolEntryTable::get(Symbol symbol) const {
+  const Middle* middle = root_[symbol >> (MiddleBits + LeafBits)].load(std::memory_order_acquire);
+  if (middle == nullptr) {
+    return nullptr;
+  }
+  const Leaf* leaf = middle->leaves_[(symbol >> LeafBits) & ((1 << MiddleBits) - 1)].load(
+      std::memory_order_acquire);
+  if (leaf == nullptr) {
+    return nullptr;
+  }
+  return leaf->entries_[symbol & ((1 << LeafBits) - 1)].load(std::memory_order_acquire);
+}
+
+void SymbolTableImpl::SymbolEntryTable::set(Symbol symbol, SymbolEntry* entry) {
+  // Nodes may be added by several threads setting different symbols at once, in which case the
+  // first one wins.
+  std::atomic<Middle*>& middle_ref = root_[symbol >> (MiddleBits + LeafBits)];
+  Middle* middle = middle_ref.load(std::memory_order_acquire);
+  if (middle == nullptr) {
+    auto new_middle = std::make_unique<Middle>();
+    if (middle_ref.compare_exchange_strong(middle, new_middle.get(), std::memory_order_acq_rel)) {
+      middle = new_middle.release();
+    }
+  }
+  std::atomic<Leaf*>& leaf_ref = middle->leaves_[(symbol >> LeafBits) & ((1 << MiddleBits) - 1)];
+  Leaf* leaf = leaf_ref.load(std::memory_order_acquire);
+  if (leaf == nullptr) {
+    auto new_leaf = std::make_unique<Leaf>();
+    if (leaf_ref.compare_exchange_strong(leaf, new_leaf.get(), std::memory_order_acq_rel)) {
+      leaf = new_leaf.release();
+    }
+  }
+  leaf->entries_[symbol & ((1 << LeafBits) - 1)].store(entry, std::memory_order_release);
+}
+
 SymbolTableImpl::SymbolTableImpl()
     // Have to be explicitly initialized, if we want to use the ABSL_GUARDED_BY macro.
     : next_symbol_(FirstValidSymbol), monotonic_counter_(FirstValidSymbol) {}
@@ -202,24 +248,25 @@ void SymbolTableImpl::addTokensToEncoding(const absl::string_view name, Encoding
     return;
   }
 
-  // We want to hold the lock for the minimum amount of time, so we do the
-  // string-splitting and prepare a temp vector of Symbol first.
+  if (track_recent_lookups_.load(std::memory_order_relaxed)) {
+    Thread::LockGuard lock(recent_lookups_lock_);
+    recent_lookups_.lookup(name);
+  } else {
+    untracked_lookups_.fetch_add(1, std::memory_order_relaxed);
+  }
+
   const std::vector<absl::string_view> tokens = absl::StrSplit(name, '.');
   std::vector<Symbol> symbols;
   symbols.reserve(tokens.size());
 
-  // Now take the lock and populate the Symbol objects, which involves bumping
-  // ref-counts in this.
-  {
-    Thread::LockGuard lock(lock_);
-    recent_lookups_.lookup(name);
-    for (auto& token : tokens) {
-      // TODO(jmarantz): consider using StatNameDynamicStorage for tokens with
-      // length below some threshold, say 4 bytes. It might be preferable not to
-      // reserve Symbols for every 3 digit number found (for example) in ipv4
-      // addresses.
-      symbols.push_back(toSymbol(token));
-    }
+  // Populate the Symbol objects, which involves bumping ref-counts in this, under the lock of the
+  // shard of each token.
+  for (auto& token : tokens) {
+    // TODO(jmarantz): consider using StatNameDynamicStorage for tokens with
+    // length below some threshold, say 4 bytes. It might be preferable not to
+    // reserve Symbols for every 3 digit number found (for example) in ipv4
+    // addresses.
+    symbols.push_back(toSymbol(token));
   }
 
   // Now efficiently encode the array of 32-bit symbols into a uint8_t array.
@@ -227,9 +274,12 @@ void SymbolTableImpl::addTokensToEncoding(const absl::string_view name, Encoding
 }
 
 uint64_t SymbolTableImpl::numSymbols() const {
-  Thread::LockGuard lock(lock_);
-  ASSERT(encode_map_.size() == decode_map_.size());
-  return encode_map_.size();
+  uint64_t num_symbols = 0;
+  for (const EncodeShard& shard : encode_shards_) {
+    Thread::LockGuard lock(shard.lock_);
+    num_symbols += shard.map_.size();
+  }
+  return num_symbols;
 }
 
 std::string SymbolTableImpl::toString(const StatName& stat_name) const {
@@ -242,60 +292,67 @@ void SymbolTableImpl::callWithStringView(StatName stat_name,
 }
 
 void SymbolTableImpl::incRefCount(const StatName& stat_name) {
-  // Before taking the lock, decode the array of symbols from the SymbolTable::Storage.
-  const SymbolVec symbols = Encoding::decodeSymbols(stat_name.data(), stat_name.dataSize());
+  // As stat_name holds references to its symbols, they can't be freed meanwhile, so no lock is
+  // needed.
+  Encoding::decodeTokens(
+      stat_name.data(), stat_name.dataSize(),
+      [this](Symbol symbol) {
+        SymbolEntry* entry = symbol_entries_.get(symbol);
+        ASSERT(entry != nullptr);
+        entry->ref_count_.fetch_add(1, std::memory_order_relaxed);
+      },
+      [](absl::string_view) {});
+}
 
-  Thread::LockGuard lock(lock_);
-  for (Symbol symbol : symbols) {
-    auto decode_search = decode_map_.find(symbol);
-    ASSERT(decode_search != decode_map_.end());
+void SymbolTableImpl::free(const StatName& stat_name) {
+  Encoding::decodeTokens(
+      stat_name.data(), stat_name.dataSize(), [this](Symbol symbol) { releaseSymbol(symbol); },
+      [](absl::string_view) {});
+}
 
-    auto encode_search = encode_map_.find(decode_search->second->toStringView());
-    ASSERT(encode_search != encode_map_.end());
+void SymbolTableImpl::releaseSymbol(Symbol symbol) {
+  SymbolEntry* entry = symbol_entries_.get(symbol);
+  ASSERT(entry != nullptr);
 
-    ++encode_search->second.ref_count_;
+  // Other references than the last one are dropped without a lock.
+  uint32_t ref_count = entry->ref_count_.load(std::memory_order_relaxed);
+  while (ref_count > 1) {
+    if (entry->ref_count_.compare_exchange_weak(ref_count, ref_count - 1,
+                                                std::memory_order_relaxed)) {
+      return;
+    }
   }
-}
 
-void SymbolTableImpl::free(const StatName& stat_name) {
-  // Before taking the lock, decode the array of symbols from the SymbolTable::Storage.
-  const SymbolVec symbols = Encoding::decodeSymbols(stat_name.data(), stat_name.dataSize());
-
-  Thread::LockGuard lock(lock_);
-  for (Symbol symbol : symbols) {
-    auto decode_search = decode_map_.find(symbol);
-    ASSERT(decode_search != decode_map_.end());
-
-    auto encode_search = encode_map_.find(decode_search->second->toStringView());
-    ASSERT(encode_search != encode_map_.end());
-
-    // If that was the last remaining client usage of the symbol, erase the
-    // current mappings and add the now-unused symbol to the reuse pool.
-    //
-    // The "if (--EXPR.ref_count_)" pattern speeds up BM_CreateRace by 20% in
-    // symbol_table_speed_test.cc, relative to breaking out the decrement into a
-    // separate step, likely due to the non-trivial dereferences in EXPR.
-    if (--encode_search->second.ref_count_ == 0) {
-      decode_map_.erase(decode_search);
-      encode_map_.erase(encode_search);
-      pool_.push(symbol);
+  // The last reference is dropped under the lock of the shard, as encode() may find the entry and
+  // add a reference to it meanwhile. If not, erase the mappings and add the now-unused symbol to
+  // the reuse pool.
+  {
+    EncodeShard& shard = encodeShard(entry->str_->toStringView());
+    Thread::LockGuard lock(shard.lock_);
+    if (--entry->ref_count_ != 0) {
+      return;
     }
+    symbol_entries_.set(symbol, nullptr);
+    shard.map_.erase(entry->str_->toStringView());
   }
+  Thread::LockGuard lock(symbol_lock_);
+  pool_.push(symbol);
 }
 
 uint64_t SymbolTableImpl::getRecentLookups(const RecentLookupsFn& iter) const {
   uint64_t total = 0;
   absl::flat_hash_map<std::string, uint64_t> name_count_map;
 
-  // We don't want to hold lock_ while calling the iterator, but we need it to
-  // access recent_lookups_, so we buffer in name_count_map.
+  // We don't want to hold recent_lookups_lock_ while calling the iterator, but
+  // we need it to access recent_lookups_, so we buffer in name_count_map.
   {
-    Thread::LockGuard lock(lock_);
+    Thread::LockGuard lock(recent_lookups_lock_);
     recent_lookups_.forEach(
         [&name_count_map](absl::string_view str, uint64_t count)
             ABSL_NO_THREAD_SAFETY_ANALYSIS { name_count_map[std::string(str)] += count; });
     total += recent_lookups_.total();
   }
+  total += untracked_lookups_.load(std::memory_order_relaxed);
 
   // Now we have the collated name-count map data: we need to vectorize and
   // sort. We define the pair with the count first as std::pair::operator<
@@ -340,17 +397,19 @@ DynamicSpans SymbolTableImpl::getDynamicSpans(StatName stat_name) const {
 }
 
 void SymbolTableImpl::setRecentLookupCapacity(uint64_t capacity) {
-  Thread::LockGuard lock(lock_);
+  Thread::LockGuard lock(recent_lookups_lock_);
   recent_lookups_.setCapacity(capacity);
+  track_recent_lookups_ = capacity != 0;
 }
 
 void SymbolTableImpl::clearRecentLookups() {
-  Thread::LockGuard lock(lock_);
+  Thread::LockGuard lock(recent_lookups_lock_);
   recent_lookups_.clear();
+  untracked_lookups_ = 0;
 }
 
 uint64_t SymbolTableImpl::recentLookupCapacity() const {
-  Thread::LockGuard lock(lock_);
+  Thread::LockGuard lock(recent_lookups_lock_);
   return recent_lookups_.capacity();
 }
 
@@ -361,39 +420,41 @@ StatNameSetPtr SymbolTableImpl::makeSet(absl::string_view name) {
 }
 
 Symbol SymbolTableImpl::toSymbol(absl::string_view sv) {
-  Symbol result;
-  auto encode_find = encode_map_.find(sv);
-  // If the string segment doesn't already exist,
-  if (encode_find == encode_map_.end()) {
-    // We create the actual string, place it in the decode_map_, and then insert
-    // a string_view pointing to it in the encode_map_. This allows us to only
-    // store the string once. We use unique_ptr so copies are not made as
-    // flat_hash_map moves values around.
-    InlineStringPtr str = InlineString::create(sv);
-    auto encode_insert = encode_map_.insert({str->toStringView(), SharedSymbol(next_symbol_)});
-    ASSERT(encode_insert.second);
-    auto decode_insert = decode_map_.insert({next_symbol_, std::move(str)});
-    ASSERT(decode_insert.second);
-
-    result = next_symbol_;
-    newSymbol();
-  } else {
-    // If the insertion didn't take place, return the actual value at that location and up the
-    // refcount at that location
-    result = encode_find->second.symbol_;
-    ++(encode_find->second.ref_count_);
+  EncodeShard& shard = encodeShard(sv);
+  Thread::LockGuard lock(shard.lock_);
+  auto encode_find = shard.map_.find(sv);
+  if (encode_find != shard.map_.end()) {
+    // If the string segment already exists, return its symbol and up its refcount.
+    encode_find->second->ref_count_.fetch_add(1, std::memory_order_relaxed);
+    return encode_find->second->symbol_;
   }
-  return result;
+
+  // We create the actual string in the entry, and then insert a string_view
+  // pointing to it in the map. This allows us to only store the string once.
+  // The entry is published in symbol_entries_ before the map, so that the
+  // symbol decodes by the time any other thread gets it.
+  auto entry = std::make_unique<SymbolEntry>(InlineString::create(sv), allocateSymbol());
+  const Symbol symbol = entry->symbol_;
+  symbol_entries_.set(symbol, entry.get());
+  auto encode_insert = shard.map_.emplace(entry->str_->toStringView(), std::move(entry));
+  ASSERT(encode_insert.second);
+  return symbol;
 }
 
-absl::string_view SymbolTableImpl::fromSymbol(const Symbol symbol) const
-    ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
-  auto search = decode_map_.find(symbol);
-  RELEASE_ASSERT(search != decode_map_.end(), "no such symbol");
-  return search->second->toStringView();
+absl::string_view SymbolTableImpl::fromSymbol(const Symbol symbol) const {
+  const SymbolEntry* entry = symbol_entries_.get(symbol);
+  RELEASE_ASSERT(entry != nullptr, "no such symbol");
+  return entry->str_->toStringView();
 }
 
-void SymbolTableImpl::newSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+Symbol SymbolTableImpl::allocateSymbol() {
+  Thread::LockGuard lock(symbol_lock_);
+  const Symbol symbol = next_symbol_;
+  newSymbol();
+  return symbol;
+}
+
+void SymbolTableImpl::newSymbol() {
   if (pool_.empty()) {
     next_symbol_ = ++monotonic_counter_;
   } else {
@@ -423,16 +484,17 @@ bool SymbolTableImpl::lessThan(const StatName& a, const StatName& b) const {
 
 #ifndef ENVOY_CONFIG_COVERAGE
 void SymbolTableImpl::debugPrint() const {
-  Thread::LockGuard lock(lock_);
-  std::vector<Symbol> symbols;
-  for (const auto& p : decode_map_) {
-    symbols.push_back(p.first);
+  std::vector<std::tuple<Symbol, std::string, uint32_t>> symbols;
+  for (const EncodeShard& shard : encode_shards_) {
+    Thread::LockGuard lock(shard.lock_);
+    for (const auto& p : shard.map_) {
+      symbols.emplace_back(p.second->symbol_, std::string(p.first), p.second->ref_count_.load());
+    }
   }
   std::sort(symbols.begin(), symbols.end());
-  for (Symbol symbol : symbols) {
-    const InlineString& token = *decode_map_.find(symbol)->second;
-    const SharedSymbol& shared_symbol = encode_map_.find(token.toStringView())->second;
-    ENVOY_LOG_MISC(info, "{}: '{}' ({})", symbol, token.toStringView(), shared_symbol.ref_count_);
+  for (const auto& symbol : symbols) {
+    ENVOY_LOG_MISC(info, "{}: '{}' ({})", std::get<0>(symbol), std::get<1>(symbol),
+                   std::get<2>(symbol));
   }
 }
 #endif
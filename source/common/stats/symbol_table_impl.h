@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <stack>
@@ -21,6 +22,7 @@
 
 #include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 
@@ -62,6 +64,11 @@ using SymbolVec = std::vector<Symbol>;
  * that if a string is encoded, the resulting stat is destroyed, and then that
  * same string is re-encoded, it may or may not encode to the same underlying
  * symbol.
+ *
+ * Decoding, and adding references to the symbols of existing StatNames, take no
+ * lock, as the symbols of a StatName can't be freed while it is referenced.
+ * Encoding takes the lock of one of several shards of the string to symbol map
+ * per token, so that threads encoding different names rarely contend.
  */
 class SymbolTableImpl : public SymbolTable {
 public:
@@ -205,15 +212,61 @@ private:
   friend class StatNameTest;
   friend class StatNameDeathTest;
 
-  struct SharedSymbol {
-    SharedSymbol(Symbol symbol) : symbol_(symbol), ref_count_(1) {}
+  struct SymbolEntry {
+    SymbolEntry(InlineStringPtr&& str, Symbol symbol) : str_(std::move(str)), symbol_(symbol) {}
+
+    const InlineStringPtr str_;
+    const Symbol symbol_;
+    // Only goes from 0 to 1 and from 1 to 0 under the lock of the shard of the entry, so that an
+    // entry is never found by encode() while it is being freed.
+    std::atomic<uint32_t> ref_count_{1};
+  };
+
+  using SymbolEntryPtr = std::unique_ptr<SymbolEntry>;
 
-    Symbol symbol_;
-    uint32_t ref_count_;
+  // A shard of the string to symbol map, on its own cache line. The map owns the entries.
+  struct alignas(64) EncodeShard {
+    mutable Thread::MutexBasicLockable lock_;
+    absl::flat_hash_map<absl::string_view, SymbolEntryPtr> map_ ABSL_GUARDED_BY(lock_);
   };
 
-  // This must be held during both encode() and free().
-  mutable Thread::MutexBasicLockable lock_;
+  static constexpr uint32_t NumEncodeShards = 16;
+
+  /**
+   * Maps symbols to their entries, to be read without a lock. As freed symbols are reused, symbols
+   * stay below the largest number of symbols ever live at once, so this is a radix tree of arrays
+   * indexed by symbol, whose nodes are allocated when first needed and only freed with the tree.
+   */
+  class SymbolEntryTable : NonCopyable {
+  public:
+    SymbolEntryTable() = default;
+    ~SymbolEntryTable();
+
+    /**
+     * @return the entry of the symbol, or nullptr. The symbol must be referenced by the caller, or
+     *         the entry may be freed meanwhile.
+     */
+    SymbolEntry* get(Symbol symbol) const;
+
+    /**
+     * Sets or clears the entry of a symbol, which must not be read by another thread meanwhile.
+     */
+    void set(Symbol symbol, SymbolEntry* entry);
+
+  private:
+    static constexpr uint32_t LeafBits = 12;
+    static constexpr uint32_t MiddleBits = 10;
+    static constexpr uint32_t RootBits = 32 - LeafBits - MiddleBits;
+
+    struct Leaf {
+      std::atomic<SymbolEntry*> entries_[1 << LeafBits]{};
+    };
+    struct Middle {
+      std::atomic<Leaf*> leaves_[1 << MiddleBits]{};
+    };
+
+    std::atomic<Middle*> root_[1 << RootBits]{};
+  };
 
   /**
    * Decodes a uint8_t array into an array of period-delimited strings. Note
@@ -230,13 +283,19 @@ private:
    */
   std::vector<absl::string_view> decodeStrings(const Storage array, size_t size) const;
 
+  EncodeShard& encodeShard(absl::string_view sv) {
+    // The maps of the shards hash the low bits again, so pick the shard with high bits.
+    return encode_shards_[(static_cast<uint64_t>(absl::Hash<absl::string_view>()(sv)) >> 48) %
+                          NumEncodeShards];
+  }
+
   /**
    * Convenience function for encode(), symbolizing one string segment at a time.
    *
    * @param sv the individual string to be encoded as a symbol.
    * @return Symbol the encoded string.
    */
-  Symbol toSymbol(absl::string_view sv) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  Symbol toSymbol(absl::string_view sv);
 
   /**
    * Convenience function for decode(), decoding one symbol at a time.
@@ -244,12 +303,24 @@ private:
    * @param symbol the individual symbol to be decoded.
    * @return absl::string_view the decoded string.
    */
-  absl::string_view fromSymbol(Symbol symbol) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  absl::string_view fromSymbol(Symbol symbol) const;
+
+  /**
+   * Drops a reference to a symbol, freeing it if it was the last one.
+   *
+   * @param symbol the symbol to release.
+   */
+  void releaseSymbol(Symbol symbol);
+
+  /**
+   * @return the symbol staged for the next insertion, after staging another one.
+   */
+  Symbol allocateSymbol();
 
   /**
    * Stages a new symbol for use. To be called after a successful insertion.
    */
-  void newSymbol();
+  void newSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(symbol_lock_);
 
   /**
    * Tokenizes name, finds or allocates symbols for each token, and adds them
@@ -261,30 +332,38 @@ private:
   void addTokensToEncoding(absl::string_view name, Encoding& encoding);
 
   Symbol monotonicCounter() {
-    Thread::LockGuard lock(lock_);
+    Thread::LockGuard lock(symbol_lock_);
     return monotonic_counter_;
   }
 
+  // The string to symbol map, split in shards which each have their own lock.
+  EncodeShard encode_shards_[NumEncodeShards];
+
+  // The symbol to string map, which is read without a lock.
+  SymbolEntryTable symbol_entries_;
+
+  // Guards the allocation of symbols.
+  mutable Thread::MutexBasicLockable symbol_lock_;
+
   // Stores the symbol to be used at next insertion. This should exist ahead of insertion time so
   // that if insertion succeeds, the value written is the correct one.
-  Symbol next_symbol_ ABSL_GUARDED_BY(lock_);
+  Symbol next_symbol_ ABSL_GUARDED_BY(symbol_lock_);
 
   // If the free pool is exhausted, we monotonically increase this counter.
-  Symbol monotonic_counter_;
-
-  // Bitmap implementation.
-  // The encode map stores both the symbol and the ref count of that symbol.
-  // Using absl::string_view lets us only store the complete string once, in the decode map.
-  using EncodeMap = absl::flat_hash_map<absl::string_view, SharedSymbol>;
-  using DecodeMap = absl::flat_hash_map<Symbol, InlineStringPtr>;
-  EncodeMap encode_map_ ABSL_GUARDED_BY(lock_);
-  DecodeMap decode_map_ ABSL_GUARDED_BY(lock_);
+  Symbol monotonic_counter_ ABSL_GUARDED_BY(symbol_lock_);
 
   // Free pool of symbols for re-use.
   // TODO(ambuc): There might be an optimization here relating to storing ranges of freed symbols
   // using an Envoy::IntervalSet.
-  std::stack<Symbol> pool_ ABSL_GUARDED_BY(lock_);
-  RecentLookups recent_lookups_ ABSL_GUARDED_BY(lock_);
+  std::stack<Symbol> pool_ ABSL_GUARDED_BY(symbol_lock_);
+
+  // Recent lookups are only tracked under recent_lookups_lock_ when their capacity is set, so that
+  // encoding doesn't take a lock shared by all names otherwise. The lookups made meanwhile are
+  // only counted, in untracked_lookups_.
+  mutable Thread::MutexBasicLockable recent_lookups_lock_;
+  RecentLookups recent_lookups_ ABSL_GUARDED_BY(recent_lookups_lock_);
+  std::atomic<bool> track_recent_lookups_{false};
+  std::atomic<uint64_t> untracked_lookups_{0};
 };
 
 // Base class for holding the backing-storing for a StatName. The two derived
@@ -11,6 +11,9 @@
 
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
 
 namespace Envoy {
 namespace Stats {
@@ -23,9 +26,17 @@ bool regexStartsWithDot(absl::string_view regex) {
 
 } // namespace
 
+TagExtractorImplBase::TagExtractorImplBase(const std::string& name, const std::string& prefix,
+                                           const std::string& substr)
+    : name_(name), prefix_(prefix), substr_(substr) {}
+
+bool TagExtractorImplBase::substrMismatch(absl::string_view stat_name) const {
+  return !substr_.empty() && stat_name.find(substr_) == absl::string_view::npos;
+}
+
 TagExtractorImpl::TagExtractorImpl(const std::string& name, const std::string& regex,
                                    const std::string& substr)
-    : name_(name), prefix_(std::string(extractRegexPrefix(regex))), substr_(substr),
+    : TagExtractorImplBase(name, extractRegexPrefix(regex), substr),
       regex_(Regex::Utility::parseStdRegex(regex)) {}
 
 std::string TagExtractorImpl::extractRegexPrefix(absl::string_view regex) {
@@ -59,13 +70,13 @@ TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
     throw EnvoyException(fmt::format(
         "No regex specified for tag specifier and no default regex for name: '{}'", name));
   }
+  const absl::optional<std::string> pattern = TagExtractorTokensImpl::patternFromRegex(regex);
+  if (pattern.has_value()) {
+    return TagExtractorPtr{new TagExtractorTokensImpl(name, pattern.value(), substr)};
+  }
   return TagExtractorPtr{new TagExtractorImpl(name, regex, substr)};
 }
 
-bool TagExtractorImpl::substrMismatch(absl::string_view stat_name) const {
-  return !substr_.empty() && stat_name.find(substr_) == absl::string_view::npos;
-}
-
 bool TagExtractorImpl::extractTag(absl::string_view stat_name, TagVector& tags,
                                   IntervalSet<size_t>& remove_characters) const {
   PERF_OPERATION(perf);
@@ -105,5 +116,118 @@ bool TagExtractorImpl::extractTag(absl::string_view stat_name, TagVector& tags,
   return false;
 }
 
+TagExtractorTokensImpl::TagExtractorTokensImpl(const std::string& name,
+                                               const std::string& pattern,
+                                               const std::string& substr)
+    : TagExtractorImplBase(name, patternPrefix(pattern), substr),
+      tokens_(absl::StrSplit(pattern, '.')) {
+  if (tokens_.back() == "**") {
+    tokens_.pop_back();
+    match_remaining_ = true;
+  }
+  uint32_t num_captures = 0;
+  for (uint32_t i = 0; i < tokens_.size(); ++i) {
+    if (tokens_[i] == "$") {
+      capture_index_ = i;
+      ++num_captures;
+    } else if (tokens_[i] == "**") {
+      throw EnvoyException(
+          fmt::format("Invalid tag pattern '{}': '**' can only be the last token", pattern));
+    }
+  }
+  if (num_captures != 1) {
+    throw EnvoyException(
+        fmt::format("Invalid tag pattern '{}': expected exactly one '$' token", pattern));
+  }
+}
+
+std::string TagExtractorTokensImpl::patternPrefix(absl::string_view pattern) {
+  const absl::string_view prefix = pattern.substr(0, pattern.find('.'));
+  if (prefix == "$" || prefix == "*" || prefix == "**") {
+    return "";
+  }
+  return std::string(prefix);
+}
+
+absl::optional<std::string> TagExtractorTokensImpl::patternFromRegex(absl::string_view regex) {
+  // The regex must be of the form ^literal\.literal\.((.*?)\.), where the non-greedy capture
+  // stops at the first dot, i.e. it captures exactly one token, and requires a dot after it, i.e.
+  // another token, however empty.
+  constexpr absl::string_view Capture = "((.*?)\\.)";
+  if (!absl::ConsumePrefix(&regex, "^")) {
+    return absl::nullopt;
+  }
+  std::string pattern;
+  while (regex != Capture) {
+    absl::string_view::size_type length = 0;
+    while (length < regex.size() && (absl::ascii_isalnum(regex[length]) || regex[length] == '_')) {
+      ++length;
+    }
+    if (length == 0 || !absl::StartsWith(regex.substr(length), "\\.")) {
+      return absl::nullopt;
+    }
+    absl::StrAppend(&pattern, regex.substr(0, length), ".");
+    regex.remove_prefix(length + 2);
+  }
+  return absl::StrCat(pattern, "$.*.**");
+}
+
+bool TagExtractorTokensImpl::extractTag(absl::string_view stat_name, TagVector& tags,
+                                        IntervalSet<size_t>& remove_characters) const {
+  PERF_OPERATION(perf);
+
+  if (substrMismatch(stat_name)) {
+    PERF_RECORD(perf, "tokens-skip-substr", name_);
+    return false;
+  }
+
+  // Walks the tokens of the name and of the pattern in step. start is the offset of the current
+  // token of the name, and is past the end of the name once all its tokens have been matched.
+  absl::string_view::size_type start = 0;
+  absl::string_view::size_type capture_start = 0;
+  absl::string_view value;
+  for (uint32_t i = 0; i < tokens_.size(); ++i) {
+    if (start > stat_name.size()) {
+      PERF_RECORD(perf, "tokens-miss", name_);
+      return false;
+    }
+    absl::string_view::size_type end = stat_name.find('.', start);
+    if (end == absl::string_view::npos) {
+      end = stat_name.size();
+    }
+    const absl::string_view token = stat_name.substr(start, end - start);
+    if (i == capture_index_) {
+      capture_start = start;
+      value = token;
+    } else if (tokens_[i] != "*" && tokens_[i] != token) {
+      PERF_RECORD(perf, "tokens-miss", name_);
+      return false;
+    }
+    start = end + 1;
+  }
+  if (!match_remaining_ && start <= stat_name.size()) {
+    PERF_RECORD(perf, "tokens-miss", name_);
+    return false;
+  }
+
+  tags.emplace_back();
+  Tag& tag = tags.back();
+  tag.name_ = name_;
+  tag.value_ = std::string(value);
+
+  // Removes the captured token with the dot following it, or the one preceding it if it ends the
+  // name.
+  const absl::string_view::size_type capture_end = capture_start + value.size();
+  if (capture_end < stat_name.size()) {
+    remove_characters.insert(capture_start, capture_end + 1);
+  } else if (capture_start > 0) {
+    remove_characters.insert(capture_start - 1, capture_end);
+  } else {
+    remove_characters.insert(capture_start, capture_end);
+  }
+  PERF_RECORD(perf, "tokens-match", name_);
+  return true;
+}
+
 } // namespace Stats
 } // namespace Envoy
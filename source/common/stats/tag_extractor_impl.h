@@ -3,18 +3,43 @@
 #include <cstdint>
 #include <regex>
 #include <string>
+#include <vector>
 
 #include "envoy/stats/tag_extractor.h"
 
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Stats {
 
-class TagExtractorImpl : public TagExtractor {
+class TagExtractorImplBase : public TagExtractor {
+public:
+  TagExtractorImplBase(const std::string& name, const std::string& prefix,
+                       const std::string& substr);
+
+  std::string name() const override { return name_; }
+  absl::string_view prefixToken() const override { return prefix_; }
+
+  /**
+   * @param stat_name The stat name
+   * @return bool indicates whether tag extraction should be skipped for this stat_name due
+   * to a substring mismatch.
+   */
+  bool substrMismatch(absl::string_view stat_name) const;
+
+protected:
+  const std::string name_;
+  const std::string prefix_;
+  const std::string substr_;
+};
+
+class TagExtractorImpl : public TagExtractorImplBase {
 public:
   /**
-   * Creates a tag extractor from the regex provided. name and regex must be non-empty.
+   * Creates a tag extractor from the regex provided. name and regex must be non-empty. Regexes
+   * which only capture the token following some literal tokens, such as "^cluster\.((.*?)\.)",
+   * are compiled to a TagExtractorTokensImpl, which extracts the same tag without a regex.
    * @param name name for tag extractor.
    * @param regex regex expression.
    * @param substr a substring that -- if provided -- must be present in a stat name
@@ -27,17 +52,8 @@ public:
 
   TagExtractorImpl(const std::string& name, const std::string& regex,
                    const std::string& substr = "");
-  std::string name() const override { return name_; }
   bool extractTag(absl::string_view tag_extracted_name, TagVector& tags,
                   IntervalSet<size_t>& remove_characters) const override;
-  absl::string_view prefixToken() const override { return prefix_; }
-
-  /**
-   * @param stat_name The stat name
-   * @return bool indicates whether tag extraction should be skipped for this stat_name due
-   * to a substring mismatch.
-   */
-  bool substrMismatch(absl::string_view stat_name) const;
 
 private:
   /**
@@ -47,11 +63,53 @@ private:
    * @return std::string the prefix, or "" if no prefix found.
    */
   static std::string extractRegexPrefix(absl::string_view regex);
-  const std::string name_;
-  const std::string prefix_;
-  const std::string substr_;
   const std::regex regex_;
 };
 
+/**
+ * Extracts a tag by matching the '.' separated tokens of a stat name against a pattern of tokens,
+ * in a single pass over the name and without a regex. Each token of the pattern is either:
+ *   - a literal, which the token of the name must be equal to,
+ *   - "$", which matches any token and captures it as the tag value,
+ *   - "*", which matches any token,
+ *   - "**", which can only be the last token, and matches any number of tokens.
+ * A pattern captures exactly one token, which is removed from the tag-extracted name along with the
+ * '.' following it, or preceding it if it is the last token of the name. For example, the pattern
+ * "cluster.$.*.**" extracts the cluster name from "cluster.foo.upstream_rq_total" as the regex
+ * "^cluster\.((.*?)\.)" does.
+ */
+class TagExtractorTokensImpl : public TagExtractorImplBase {
+public:
+  /**
+   * @param name name for tag extractor.
+   * @param pattern the '.' separated tokens to match, as above.
+   * @param substr a substring that -- if provided -- must be present in a stat name
+   *               in order to match the pattern.
+   */
+  TagExtractorTokensImpl(const std::string& name, const std::string& pattern,
+                         const std::string& substr = "");
+
+  /**
+   * Compiles a regex which anchors some literal tokens and captures the token following them, with
+   * the dot after it, to the equivalent pattern of tokens.
+   * @param regex the regex to compile.
+   * @return the pattern, or nullopt if the regex does not have that form.
+   */
+  static absl::optional<std::string> patternFromRegex(absl::string_view regex);
+
+  bool extractTag(absl::string_view stat_name, TagVector& tags,
+                  IntervalSet<size_t>& remove_characters) const override;
+
+private:
+  static std::string patternPrefix(absl::string_view pattern);
+
+  // The tokens of the pattern, without the trailing "**" if any.
+  std::vector<std::string> tokens_;
+  // The index in tokens_ of the "$" token.
+  uint32_t capture_index_{0};
+  // Whether the pattern ends with "**".
+  bool match_remaining_{false};
+};
+
 } // namespace Stats
 } // namespace Envoy
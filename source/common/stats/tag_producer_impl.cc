@@ -64,24 +64,6 @@ void TagProducerImpl::addExtractor(TagExtractorPtr extractor) {
   }
 }
 
-void TagProducerImpl::forEachExtractorMatching(
-    absl::string_view stat_name, std::function<void(const TagExtractorPtr&)> f) const {
-  IntervalSetImpl<size_t> remove_characters;
-  for (const TagExtractorPtr& tag_extractor : tag_extractors_without_prefix_) {
-    f(tag_extractor);
-  }
-  const absl::string_view::size_type dot = stat_name.find('.');
-  if (dot != std::string::npos) {
-    const absl::string_view token = absl::string_view(stat_name.data(), dot);
-    const auto iter = tag_extractor_prefix_map_.find(token);
-    if (iter != tag_extractor_prefix_map_.end()) {
-      for (const TagExtractorPtr& tag_extractor : iter->second) {
-        f(tag_extractor);
-      }
-    }
-  }
-}
-
 std::string TagProducerImpl::produceTags(absl::string_view metric_name, TagVector& tags) const {
   // TODO(jmarantz): Skip the creation of string-based tags, creating a StatNameTagVector instead.
   tags.insert(tags.end(), default_tags_.begin(), default_tags_.end());
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <cstdint>
-#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -86,11 +85,27 @@ private:
    * In the future, we may also do substring searches in some cases.
    * See DefaultTagRegexTester::produceTagsReverse in test/common/stats/stats_impl_test.cc.
    *
+   * This is a template rather than taking a std::function as it is on the path of every stat
+   * creation.
+   *
    * @param stat_name const std::string& the stat name.
-   * @param f std::function<void(const TagExtractorPtr&)> function to call for each extractor.
+   * @param f function to call for each extractor, taking const TagExtractorPtr&.
    */
-  void forEachExtractorMatching(absl::string_view stat_name,
-                                std::function<void(const TagExtractorPtr&)> f) const;
+  template <class Fn> void forEachExtractorMatching(absl::string_view stat_name, Fn f) const {
+    for (const TagExtractorPtr& tag_extractor : tag_extractors_without_prefix_) {
+      f(tag_extractor);
+    }
+    const absl::string_view::size_type dot = stat_name.find('.');
+    if (dot != std::string::npos) {
+      const absl::string_view token = absl::string_view(stat_name.data(), dot);
+      const auto iter = tag_extractor_prefix_map_.find(token);
+      if (iter != tag_extractor_prefix_map_.end()) {
+        for (const TagExtractorPtr& tag_extractor : iter->second) {
+          f(tag_extractor);
+        }
+      }
+    }
+  }
 
   std::vector<TagExtractorPtr> tag_extractors_without_prefix_;
 
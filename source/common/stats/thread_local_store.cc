@@ -292,9 +292,15 @@ ThreadLocalStoreImpl::TlsCache::insertScope(uint64_t scope_id) {
 void ThreadLocalStoreImpl::TlsCache::eraseScope(uint64_t scope_id) { scope_cache_.erase(scope_id); }
 void ThreadLocalStoreImpl::TlsCache::eraseHistogram(uint64_t histogram_id) {
   // This is called for every histogram in every thread, even though the
-  // histogram may not have been cached in each thread yet. So we don't
-  // want to check whether the erase() call erased anything.
-  tls_histogram_cache_.erase(histogram_id);
+  // histogram may not have been cached in each thread yet, so the histogram
+  // may not be found.
+  auto it = tls_histogram_cache_.find(histogram_id);
+  if (it != tls_histogram_cache_.end()) {
+    // The parent histogram is gone, so the buffered values would never be merged. Deliver them
+    // to the sinks before the last reference to the thread local histogram is dropped.
+    it->second->recordBufferedValues();
+    tls_histogram_cache_.erase(it);
+  }
 }
 
 void ThreadLocalStoreImpl::clearScopeFromCaches(uint64_t scope_id,
@@ -505,6 +511,18 @@ Counter& ThreadLocalStoreImpl::ScopeImpl::counterFromStatNameWithTags(
       tls_cache, tls_rejected_stats, parent_.null_counter_);
 }
 
+void ThreadLocalStoreImpl::deliverHistogramValuesToSinks(const Histogram& histogram,
+                                                         absl::Span<const uint64_t> values) {
+  // See ScopeImpl::deliverHistogramToSinks() for why deliveries are blocked during shutdown.
+  if (shutting_down_) {
+    return;
+  }
+
+  for (Sink& sink : timer_sinks_) {
+    sink.onHistogramSamples(histogram, values);
+  }
+}
+
 void ThreadLocalStoreImpl::ScopeImpl::deliverHistogramToSinks(const Histogram& histogram,
                                                               uint64_t value) {
   // Thread local deliveries must be blocked outright for histograms and timers during shutdown.
@@ -604,10 +622,14 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::histogramFromStatNameWithTags(
     StatNameTagHelper tag_helper(parent_, joiner.tagExtractedName(), stat_name_tags);
 
     ConstSupportedBuckets* buckets = nullptr;
-    symbolTable().callWithStringView(final_stat_name,
-                                     [&buckets, this](absl::string_view stat_name) {
-                                       buckets = &parent_.histogram_settings_->buckets(stat_name);
-                                     });
+    bool compact = false;
+    uint32_t sample_buffer_size = 0;
+    symbolTable().callWithStringView(
+        final_stat_name, [&buckets, &compact, &sample_buffer_size, this](absl::string_view name) {
+          buckets = &parent_.histogram_settings_->buckets(name);
+          compact = parent_.histogram_settings_->compact(name);
+          sample_buffer_size = parent_.histogram_settings_->sampleBufferSize(name);
+        });
 
     RefcountPtr<ParentHistogramImpl> stat;
     {
@@ -618,7 +640,8 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::histogramFromStatNameWithTags(
       } else {
         stat = new ParentHistogramImpl(final_stat_name, unit, parent_,
                                        tag_helper.tagExtractedName(), tag_helper.statNameTags(),
-                                       *buckets, parent_.next_histogram_id_++);
+                                       *buckets, compact, sample_buffer_size,
+                                       parent_.next_histogram_id_++);
         if (!parent_.shutting_down_) {
           parent_.histogram_set_.insert(stat.get());
         }
@@ -695,7 +718,8 @@ TextReadoutOptConstRef ThreadLocalStoreImpl::ScopeImpl::findTextReadout(StatName
   return findStatLockHeld<TextReadout>(name, central_cache_->text_readouts_);
 }
 
-Histogram& ThreadLocalStoreImpl::tlsHistogram(ParentHistogramImpl& parent, uint64_t id) {
+ThreadLocalHistogramImpl& ThreadLocalStoreImpl::tlsHistogram(ParentHistogramImpl& parent,
+                                                             uint64_t id) {
   // tlsHistogram() is generally not called for a histogram that is rejected by
   // the matcher, so no further rejection-checking is needed at this level.
   // TlsHistogram inherits its reject/accept status from ParentHistogram.
@@ -713,9 +737,11 @@ Histogram& ThreadLocalStoreImpl::tlsHistogram(ParentHistogramImpl& parent, uint6
 
   StatNameTagHelper tag_helper(*this, parent.statName(), absl::nullopt);
 
-  TlsHistogramSharedPtr hist_tls_ptr(
-      new ThreadLocalHistogramImpl(parent.statName(), parent.unit(), tag_helper.tagExtractedName(),
-                                   tag_helper.statNameTags(), symbolTable()));
+  // Without a TLS cache, a histogram is made for each value, which leaves nothing to buffer.
+  TlsHistogramSharedPtr hist_tls_ptr(new ThreadLocalHistogramImpl(
+      parent.statName(), parent.unit(), tag_helper.tagExtractedName(), tag_helper.statNameTags(),
+      symbolTable(), parent.compactBuckets(),
+      tls_histogram != nullptr ? parent.sampleBufferSize() : 0, *this));
 
   parent.addTlsHistogram(hist_tls_ptr);
 
@@ -729,24 +755,59 @@ Histogram& ThreadLocalStoreImpl::tlsHistogram(ParentHistogramImpl& parent, uint6
 ThreadLocalHistogramImpl::ThreadLocalHistogramImpl(StatName name, Histogram::Unit unit,
                                                    StatName tag_extracted_name,
                                                    const StatNameTagVector& stat_name_tags,
-                                                   SymbolTable& symbol_table)
+                                                   SymbolTable& symbol_table,
+                                                   ConstSupportedBuckets* compact_buckets,
+                                                   uint32_t sample_buffer_size,
+                                                   ThreadLocalStoreImpl& store)
     : HistogramImplHelper(name, tag_extracted_name, stat_name_tags, symbol_table), unit_(unit),
       current_active_(0), used_(false), created_thread_id_(std::this_thread::get_id()),
-      symbol_table_(symbol_table) {
-  histograms_[0] = hist_alloc();
-  histograms_[1] = hist_alloc();
+      symbol_table_(symbol_table), sample_buffer_size_(sample_buffer_size), store_(store) {
+  if (sample_buffer_size_ != 0) {
+    buffered_values_ = std::make_unique<uint64_t[]>(sample_buffer_size_);
+  }
+  if (compact_buckets != nullptr) {
+    compact_histograms_[0] = std::make_unique<CompactHistogram>(*compact_buckets);
+    compact_histograms_[1] = std::make_unique<CompactHistogram>(*compact_buckets);
+  } else {
+    histograms_[0] = hist_alloc();
+    histograms_[1] = hist_alloc();
+  }
 }
 
 ThreadLocalHistogramImpl::~ThreadLocalHistogramImpl() {
   MetricImpl::clear(symbol_table_);
-  hist_free(histograms_[0]);
-  hist_free(histograms_[1]);
+  if (histograms_[0] != nullptr) {
+    hist_free(histograms_[0]);
+    hist_free(histograms_[1]);
+  }
 }
 
 void ThreadLocalHistogramImpl::recordValue(uint64_t value) {
   ASSERT(std::this_thread::get_id() == created_thread_id_);
-  hist_insert_intscale(histograms_[current_active_], value, 0, 1);
-  used_ = true;
+  if (sample_buffer_size_ != 0) {
+    buffered_values_[num_buffered_values_++] = value;
+    if (num_buffered_values_ == sample_buffer_size_) {
+      recordBufferedValues();
+    }
+  } else {
+    recordInHistogram(value);
+  }
+  if (!used_.load(std::memory_order_relaxed)) {
+    used_ = true;
+  }
+}
+
+void ThreadLocalHistogramImpl::recordBufferedValues() {
+  ASSERT(std::this_thread::get_id() == created_thread_id_);
+  if (num_buffered_values_ == 0) {
+    return;
+  }
+  const absl::Span<const uint64_t> values(buffered_values_.get(), num_buffered_values_);
+  for (const uint64_t value : values) {
+    recordInHistogram(value);
+  }
+  store_.deliverHistogramValuesToSinks(*this, values);
+  num_buffered_values_ = 0;
 }
 
 void ThreadLocalHistogramImpl::merge(histogram_t* target) {
@@ -755,23 +816,40 @@ void ThreadLocalHistogramImpl::merge(histogram_t* target) {
   hist_clear(*other_histogram);
 }
 
+void ThreadLocalHistogramImpl::merge(CompactHistogram& target) {
+  CompactHistogram& other_histogram = *compact_histograms_[otherHistogramIndex()];
+  target.merge(other_histogram);
+  other_histogram.clear();
+}
+
 ParentHistogramImpl::ParentHistogramImpl(StatName name, Histogram::Unit unit,
                                          ThreadLocalStoreImpl& thread_local_store,
                                          StatName tag_extracted_name,
                                          const StatNameTagVector& stat_name_tags,
-                                         ConstSupportedBuckets& supported_buckets, uint64_t id)
+                                         ConstSupportedBuckets& supported_buckets, bool compact,
+                                         uint32_t sample_buffer_size, uint64_t id)
     : MetricImpl(name, tag_extracted_name, stat_name_tags, thread_local_store.symbolTable()),
-      unit_(unit), thread_local_store_(thread_local_store), interval_histogram_(hist_alloc()),
-      cumulative_histogram_(hist_alloc()),
-      interval_statistics_(interval_histogram_, supported_buckets),
-      cumulative_statistics_(cumulative_histogram_, supported_buckets), merged_(false), id_(id) {}
+      unit_(unit), thread_local_store_(thread_local_store), interval_statistics_(supported_buckets),
+      cumulative_statistics_(supported_buckets), merged_(false),
+      sample_buffer_size_(sample_buffer_size), id_(id) {
+  if (compact) {
+    compact_interval_histogram_ = std::make_unique<CompactHistogram>(supported_buckets);
+    compact_cumulative_histogram_ = std::make_unique<CompactHistogram>(supported_buckets);
+  } else {
+    interval_histogram_ = hist_alloc();
+    cumulative_histogram_ = hist_alloc();
+  }
+  refreshStatistics();
+}
 
 ParentHistogramImpl::~ParentHistogramImpl() {
   thread_local_store_.releaseHistogramCrossThread(id_);
   ASSERT(ref_count_ == 0);
   MetricImpl::clear(thread_local_store_.symbolTable());
-  hist_free(interval_histogram_);
-  hist_free(cumulative_histogram_);
+  if (interval_histogram_ != nullptr) {
+    hist_free(interval_histogram_);
+    hist_free(cumulative_histogram_);
+  }
 }
 
 void ParentHistogramImpl::incRefCount() { ++ref_count_; }
@@ -824,9 +902,11 @@ SymbolTable& ParentHistogramImpl::symbolTable() { return thread_local_store_.sym
 Histogram::Unit ParentHistogramImpl::unit() const { return unit_; }
 
 void ParentHistogramImpl::recordValue(uint64_t value) {
-  Histogram& tls_histogram = thread_local_store_.tlsHistogram(*this, id_);
+  ThreadLocalHistogramImpl& tls_histogram = thread_local_store_.tlsHistogram(*this, id_);
   tls_histogram.recordValue(value);
-  thread_local_store_.deliverHistogramToSinks(*this, value);
+  if (!tls_histogram.buffersValues()) {
+    thread_local_store_.deliverHistogramToSinks(*this, value);
+  }
 }
 
 bool ParentHistogramImpl::used() const {
@@ -837,20 +917,38 @@ bool ParentHistogramImpl::used() const {
 void ParentHistogramImpl::merge() {
   Thread::ReleasableLockGuard lock(merge_lock_);
   if (merged_ || usedLockHeld()) {
-    hist_clear(interval_histogram_);
-    // Here we could copy all the pointers to TLS histograms in the tls_histogram_ list,
-    // then release the lock before we do the actual merge. However it is not a big deal
-    // because the tls_histogram merge is not that expensive as it is a single histogram
-    // merge and adding TLS histograms is rare.
-    for (const TlsHistogramSharedPtr& tls_histogram : tls_histograms_) {
-      tls_histogram->merge(interval_histogram_);
+    if (compact_interval_histogram_ != nullptr) {
+      compact_interval_histogram_->clear();
+      for (const TlsHistogramSharedPtr& tls_histogram : tls_histograms_) {
+        tls_histogram->merge(*compact_interval_histogram_);
+      }
+      lock.release();
+      compact_cumulative_histogram_->merge(*compact_interval_histogram_);
+    } else {
+      hist_clear(interval_histogram_);
+      // Here we could copy all the pointers to TLS histograms in the tls_histogram_ list,
+      // then release the lock before we do the actual merge. However it is not a big deal
+      // because the tls_histogram merge is not that expensive as it is a single histogram
+      // merge and adding TLS histograms is rare.
+      for (const TlsHistogramSharedPtr& tls_histogram : tls_histograms_) {
+        tls_histogram->merge(interval_histogram_);
+      }
+      // Since TLS merge is done, we can release the lock here.
+      lock.release();
+      hist_accumulate(cumulative_histogram_, &interval_histogram_, 1);
     }
-    // Since TLS merge is done, we can release the lock here.
-    lock.release();
-    hist_accumulate(cumulative_histogram_, &interval_histogram_, 1);
+    refreshStatistics();
+    merged_ = true;
+  }
+}
+
+void ParentHistogramImpl::refreshStatistics() {
+  if (compact_interval_histogram_ != nullptr) {
+    cumulative_statistics_.refresh(*compact_cumulative_histogram_);
+    interval_statistics_.refresh(*compact_interval_histogram_);
+  } else {
     cumulative_statistics_.refresh(cumulative_histogram_);
     interval_statistics_.refresh(interval_histogram_);
-    merged_ = true;
   }
 }
 
@@ -22,23 +22,39 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/types/span.h"
 #include "circllhist.h"
 
 namespace Envoy {
 namespace Stats {
 
+class ThreadLocalStoreImpl;
+
 /**
  * A histogram that is stored in TLS and used to record values per thread. This holds two
  * histograms, one to collect the values and other as backup that is used for merge process. The
  * swap happens during the merge process.
+ *
+ * If configured with a sample buffer, the values are first buffered, and recorded in the histogram
+ * and delivered to the sinks in batches, when the buffer is full or the merge process begins.
  */
 class ThreadLocalHistogramImpl : public HistogramImplHelper {
 public:
+  /**
+   * @param compact_buckets supplies the buckets of the parent histogram if it is compact, or
+   *        nullptr to record in circllhists.
+   * @param sample_buffer_size supplies the number of values to buffer, or 0 to record each value
+   *        as it comes, in which case the caller delivers it to the sinks.
+   * @param store supplies the store delivering the buffered values to the sinks.
+   */
   ThreadLocalHistogramImpl(StatName name, Histogram::Unit unit, StatName tag_extracted_name,
-                           const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table);
+                           const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table,
+                           ConstSupportedBuckets* compact_buckets, uint32_t sample_buffer_size,
+                           ThreadLocalStoreImpl& store);
   ~ThreadLocalHistogramImpl() override;
 
   void merge(histogram_t* target);
+  void merge(CompactHistogram& target);
 
   /**
    * Called in the beginning of merge process. Swaps the histogram used for collection so that we do
@@ -47,9 +63,21 @@ public:
   void beginMerge() {
     // This switches the current_active_ between 1 and 0.
     ASSERT(std::this_thread::get_id() == created_thread_id_);
+    recordBufferedValues();
     current_active_ = otherHistogramIndex();
   }
 
+  /**
+   * @return whether values are buffered, and delivered to the sinks by this histogram.
+   */
+  bool buffersValues() const { return sample_buffer_size_ != 0; }
+
+  /**
+   * Records the buffered values in the active histogram and delivers them to the sinks. Must be
+   * called on the thread which created the histogram.
+   */
+  void recordBufferedValues();
+
   // Stats::Histogram
   Histogram::Unit unit() const override {
     // If at some point ThreadLocalHistogramImpl will hold a pointer to its parent we can just
@@ -65,17 +93,28 @@ public:
 private:
   Histogram::Unit unit_;
   uint64_t otherHistogramIndex() const { return 1 - current_active_; }
+  void recordInHistogram(uint64_t value) {
+    if (compact_histograms_[0] != nullptr) {
+      compact_histograms_[current_active_]->recordValue(value);
+    } else {
+      hist_insert_intscale(histograms_[current_active_], value, 0, 1);
+    }
+  }
   uint64_t current_active_;
-  histogram_t* histograms_[2];
+  histogram_t* histograms_[2]{};
+  std::unique_ptr<CompactHistogram> compact_histograms_[2];
   std::atomic<bool> used_;
   std::thread::id created_thread_id_;
   SymbolTable& symbol_table_;
+  const uint32_t sample_buffer_size_;
+  // The values not recorded yet, if sample_buffer_size_ is non-zero.
+  std::unique_ptr<uint64_t[]> buffered_values_;
+  uint32_t num_buffered_values_{0};
+  ThreadLocalStoreImpl& store_;
 };
 
 using TlsHistogramSharedPtr = RefcountPtr<ThreadLocalHistogramImpl>;
 
-class ThreadLocalStoreImpl;
-
 /**
  * Log Linear Histogram implementation that is stored in the main thread.
  */
@@ -83,11 +122,25 @@ class ParentHistogramImpl : public MetricImpl<ParentHistogram> {
 public:
   ParentHistogramImpl(StatName name, Histogram::Unit unit, ThreadLocalStoreImpl& parent,
                       StatName tag_extracted_name, const StatNameTagVector& stat_name_tags,
-                      ConstSupportedBuckets& supported_buckets, uint64_t id);
+                      ConstSupportedBuckets& supported_buckets, bool compact,
+                      uint32_t sample_buffer_size, uint64_t id);
   ~ParentHistogramImpl() override;
 
   void addTlsHistogram(const TlsHistogramSharedPtr& hist_ptr);
 
+  /**
+   * @return the buckets of the histogram if it is compact, or nullptr.
+   */
+  ConstSupportedBuckets* compactBuckets() const {
+    return compact_interval_histogram_ != nullptr ? &compact_interval_histogram_->buckets()
+                                                   : nullptr;
+  }
+
+  /**
+   * @return the number of values each thread buffers, or 0 if values are recorded as they come.
+   */
+  uint32_t sampleBufferSize() const { return sample_buffer_size_; }
+
   // Stats::Histogram
   Histogram::Unit unit() const override;
   void recordValue(uint64_t value) override;
@@ -122,16 +175,21 @@ public:
 
 private:
   bool usedLockHeld() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(merge_lock_);
+  void refreshStatistics();
 
   Histogram::Unit unit_;
   ThreadLocalStoreImpl& thread_local_store_;
-  histogram_t* interval_histogram_;
-  histogram_t* cumulative_histogram_;
+  // Either the circllhists or the compact histograms are set.
+  histogram_t* interval_histogram_{};
+  histogram_t* cumulative_histogram_{};
+  std::unique_ptr<CompactHistogram> compact_interval_histogram_;
+  std::unique_ptr<CompactHistogram> compact_cumulative_histogram_;
   HistogramStatisticsImpl interval_statistics_;
   HistogramStatisticsImpl cumulative_statistics_;
   mutable Thread::MutexBasicLockable merge_lock_;
   std::list<TlsHistogramSharedPtr> tls_histograms_ ABSL_GUARDED_BY(merge_lock_);
   bool merged_;
+  const uint32_t sample_buffer_size_;
   std::atomic<bool> shutting_down_{false};
   std::atomic<uint32_t> ref_count_{0};
   const uint64_t id_; // Index into TlsCache::histogram_cache_.
@@ -250,12 +308,23 @@ public:
   }
   void setStatsMatcher(StatsMatcherPtr&& stats_matcher) override;
   void setHistogramSettings(HistogramSettingsConstPtr&& histogram_settings) override;
+  void setShardedCounterPrefixes(const std::vector<std::string>& prefixes) override {
+    alloc_.setShardedCounterPrefixes(prefixes);
+  }
   void initializeThreading(Event::Dispatcher& main_thread_dispatcher,
                            ThreadLocal::Instance& tls) override;
   void shutdownThreading() override;
   void mergeHistograms(PostMergeCb merge_cb) override;
 
-  Histogram& tlsHistogram(ParentHistogramImpl& parent, uint64_t id);
+  ThreadLocalHistogramImpl& tlsHistogram(ParentHistogramImpl& parent, uint64_t id);
+
+  /**
+   * Delivers a batch of values buffered by a thread local histogram to the sinks.
+   * @param histogram the thread local histogram.
+   * @param values the values, in the order they were recorded.
+   */
+  void deliverHistogramValuesToSinks(const Histogram& histogram,
+                                     absl::Span<const uint64_t> values);
 
   /**
    * @return a thread synchronizer object used for controlling thread behavior in tests.
@@ -147,6 +147,8 @@ public:
     }
   }
 
+  bool maybePrefetch(float ratio) override { return maybePrefetchImpl(ratio); }
+
   void closeConnections() override {
     for (auto* list : {&ready_clients_, &busy_clients_, &connecting_clients_}) {
       while (!list->empty()) {
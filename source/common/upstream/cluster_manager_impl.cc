@@ -834,7 +834,15 @@ ClusterManagerImpl::httpConnPoolForCluster(const std::string& cluster, ResourceP
   }
 
   // Select a host and create a connection pool for it if it does not already exist.
-  return entry->second->connPool(priority, protocol, context);
+  Http::ConnectionPool::Instance* pool =
+      entry->second->connPool(priority, protocol, context, false);
+
+  // The caller creates a stream on the returned pool next, so see if connections should be
+  // prefetched for the streams anticipated to follow it.
+  maybePrefetch(*entry->second, [&entry, priority, &protocol, context]() {
+    return entry->second->connPool(priority, protocol, context, true);
+  });
+  return pool;
 }
 
 Tcp::ConnectionPool::Instance*
@@ -848,7 +856,32 @@ ClusterManagerImpl::tcpConnPoolForCluster(const std::string& cluster, ResourcePr
   }
 
   // Select a host and create a connection pool for it if it does not already exist.
-  return entry->second->tcpConnPool(priority, context);
+  Tcp::ConnectionPool::Instance* pool = entry->second->tcpConnPool(priority, context, false);
+
+  maybePrefetch(*entry->second, [&entry, priority, context]() {
+    return entry->second->tcpConnPool(priority, context, true);
+  });
+  return pool;
+}
+
+void ClusterManagerImpl::maybePrefetch(
+    ThreadLocalClusterManagerImpl::ClusterEntry& cluster_entry,
+    const std::function<ConnectionPool::Instance*()>& pick_prefetch_pool) {
+  const float prefetch_ratio = cluster_entry.cluster_info_->predictivePrefetchRatio();
+  if (prefetch_ratio <= 1.0) {
+    return;
+  }
+
+  // Somewhat arbitrarily cap the number of connections prefetched per stream, as is done for
+  // per upstream prefetching in ConnPoolImplBase::tryCreateNewConnections().
+  for (int i = 0; i < 3; ++i) {
+    ConnectionPool::Instance* prefetch_pool = pick_prefetch_pool();
+    if (prefetch_pool == nullptr || !prefetch_pool->maybePrefetch(prefetch_ratio)) {
+      // The host predicted next may well need a connection, but err on the side of caution and
+      // wait for the next stream.
+      return;
+    }
+  }
 }
 
 void ClusterManagerImpl::postThreadLocalDrainConnections(const Cluster& cluster,
@@ -863,12 +896,16 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(const Cluster& cluster, ui
                                                       const HostVector& hosts_removed) {
   const auto& host_set = cluster.prioritySet().hostSetsPerPriority()[priority];
 
+  // The update is posted to every worker, so the deltas are shared rather than copied once per
+  // worker. The host vectors in the update params are already shared.
   tls_->runOnAllThreads([this, name = cluster.info()->name(), priority,
                          update_params = HostSetImpl::updateHostsParams(*host_set),
-                         locality_weights = host_set->localityWeights(), hosts_added, hosts_removed,
+                         locality_weights = host_set->localityWeights(),
+                         hosts_added = std::make_shared<const HostVector>(hosts_added),
+                         hosts_removed = std::make_shared<const HostVector>(hosts_removed),
                          overprovisioning_factor = host_set->overprovisioningFactor()]() {
     ThreadLocalClusterManagerImpl::updateClusterMembership(
-        name, priority, update_params, locality_weights, hosts_added, hosts_removed, *tls_,
+        name, priority, update_params, locality_weights, *hosts_added, *hosts_removed, *tls_,
         overprovisioning_factor);
   });
 }
@@ -1265,6 +1302,14 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
                                                      parent.parent_.random_, cluster->lbConfig());
       break;
     }
+    case LoadBalancerType::PeakEwma: {
+      ASSERT(lb_factory_ == nullptr);
+      lb_ = std::make_unique<PeakEwmaLoadBalancer>(
+          priority_set_, parent_.local_priority_set_, cluster->stats(), parent.parent_.runtime_,
+          parent.parent_.random_, cluster->lbConfig(),
+          parent.thread_local_dispatcher_.timeSource());
+      break;
+    }
     case LoadBalancerType::ClusterProvided:
     case LoadBalancerType::RingHash:
     case LoadBalancerType::Maglev:
@@ -1292,11 +1337,13 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::~ClusterEntry()
 Http::ConnectionPool::Instance*
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::connPool(
     ResourcePriority priority, absl::optional<Http::Protocol> downstream_protocol,
-    LoadBalancerContext* context) {
-  HostConstSharedPtr host = lb_->chooseHost(context);
+    LoadBalancerContext* context, bool peek) {
+  HostConstSharedPtr host = peek ? lb_->peekAnotherHost(context) : lb_->chooseHost(context);
   if (!host) {
-    ENVOY_LOG(debug, "no healthy host for HTTP connection pool");
-    cluster_info_->stats().upstream_cx_none_healthy_.inc();
+    if (!peek) {
+      ENVOY_LOG(debug, "no healthy host for HTTP connection pool");
+      cluster_info_->stats().upstream_cx_none_healthy_.inc();
+    }
     return nullptr;
   }
 
@@ -1346,11 +1393,13 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::connPool(
 
 Tcp::ConnectionPool::Instance*
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::tcpConnPool(
-    ResourcePriority priority, LoadBalancerContext* context) {
-  HostConstSharedPtr host = lb_->chooseHost(context);
+    ResourcePriority priority, LoadBalancerContext* context, bool peek) {
+  HostConstSharedPtr host = peek ? lb_->peekAnotherHost(context) : lb_->chooseHost(context);
   if (!host) {
-    ENVOY_LOG(debug, "no healthy host for TCP connection pool");
-    cluster_info_->stats().upstream_cx_none_healthy_.inc();
+    if (!peek) {
+      ENVOY_LOG(debug, "no healthy host for TCP connection pool");
+      cluster_info_->stats().upstream_cx_none_healthy_.inc();
+    }
     return nullptr;
   }
 
@@ -1402,6 +1451,11 @@ Http::ConnectionPool::InstancePtr ProdClusterManagerFactory::allocateConnPool(
     const Network::TransportSocketOptionsSharedPtr& transport_socket_options) {
   if (protocol == Http::Protocol::Http2 &&
       runtime_.snapshot().featureEnabled("upstream.use_http2", 100)) {
+    if (shared_http2_conn_pools_ != nullptr &&
+        (host->cluster().features() & ClusterInfo::Features::SHARED_HTTP2_CONNECTION_POOL)) {
+      return shared_http2_conn_pools_->createConnPool(dispatcher, host, priority, options,
+                                                      transport_socket_options);
+    }
     return Http::Http2::allocateConnPool(dispatcher, host, priority, options,
                                          transport_socket_options);
   } else if (protocol == Http::Protocol::Http3) {
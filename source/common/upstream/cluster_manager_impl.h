@@ -28,6 +28,7 @@
 #include "common/config/grpc_mux_impl.h"
 #include "common/config/subscription_factory_impl.h"
 #include "common/http/async_client_impl.h"
+#include "common/http/http2/shared_conn_pool.h"
 #include "common/upstream/load_stats_reporter.h"
 #include "common/upstream/priority_conn_pool_map.h"
 #include "common/upstream/upstream_impl.h"
@@ -47,13 +48,14 @@ public:
       Event::Dispatcher& main_thread_dispatcher, const LocalInfo::LocalInfo& local_info,
       Secret::SecretManager& secret_manager, ProtobufMessage::ValidationContext& validation_context,
       Api::Api& api, Http::Context& http_context, Grpc::Context& grpc_context,
-      AccessLog::AccessLogManager& log_manager, Singleton::Manager& singleton_manager)
+      AccessLog::AccessLogManager& log_manager, Singleton::Manager& singleton_manager,
+      Http::Http2::SharedConnPoolSet* shared_http2_conn_pools)
       : main_thread_dispatcher_(main_thread_dispatcher), validation_context_(validation_context),
         api_(api), http_context_(http_context), grpc_context_(grpc_context), admin_(admin),
         runtime_(runtime), stats_(stats), tls_(tls), random_(random), dns_resolver_(dns_resolver),
         ssl_context_manager_(ssl_context_manager), local_info_(local_info),
         secret_manager_(secret_manager), log_manager_(log_manager),
-        singleton_manager_(singleton_manager) {}
+        singleton_manager_(singleton_manager), shared_http2_conn_pools_(shared_http2_conn_pools) {}
 
   // Upstream::ClusterManagerFactory
   ClusterManagerPtr
@@ -91,6 +93,8 @@ protected:
   Secret::SecretManager& secret_manager_;
   AccessLog::AccessLogManager& log_manager_;
   Singleton::Manager& singleton_manager_;
+  // The threads owning the HTTP/2 connections shared by all workers, if the server runs any.
+  Http::Http2::SharedConnPoolSet* const shared_http2_conn_pools_;
 };
 
 // For friend declaration in ClusterManagerInitHelper.
@@ -334,12 +338,14 @@ private:
                    const LoadBalancerFactorySharedPtr& lb_factory);
       ~ClusterEntry() override;
 
+      // If peek is set, the pool is the one of the host predicted for a future stream, rather than
+      // the one of the host chosen for this stream.
       Http::ConnectionPool::Instance* connPool(ResourcePriority priority,
                                                absl::optional<Http::Protocol> downstream_protocol,
-                                               LoadBalancerContext* context);
+                                               LoadBalancerContext* context, bool peek);
 
       Tcp::ConnectionPool::Instance* tcpConnPool(ResourcePriority priority,
-                                                 LoadBalancerContext* context);
+                                                 LoadBalancerContext* context, bool peek);
 
       // Upstream::ThreadLocalCluster
       const PrioritySet& prioritySet() override { return priority_set_; }
@@ -481,6 +487,11 @@ private:
   void loadCluster(const envoy::config::cluster::v3::Cluster& cluster,
                    const std::string& version_info, bool added_via_api, ClusterMap& cluster_map);
   void onClusterInit(Cluster& cluster);
+  // Prefetches connections to the hosts predicted to serve the streams following the current one,
+  // as configured by the cluster's predictive prefetch ratio.
+  static void
+  maybePrefetch(ThreadLocalClusterManagerImpl::ClusterEntry& cluster_entry,
+                const std::function<ConnectionPool::Instance*()>& pick_prefetch_pool);
   void postThreadLocalHealthFailure(const HostSharedPtr& host);
   void updateClusterCounts();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <list>
 #include <vector>
 
 #include "envoy/event/dispatcher.h"
@@ -15,7 +16,10 @@
 namespace Envoy {
 namespace Upstream {
 /**
- *  A class mapping keys to connection pools, with some recycling logic built in.
+ *  A class mapping keys to connection pools, with some recycling logic built in. Pools are kept in
+ *  least recently used order, so that when pools have to be freed, either to make room under the
+ *  connection pool circuit breaker or to keep the number of idle pools for the host under the
+ *  cluster's limit, the idle pools which have gone unused the longest are freed first.
  */
 template <typename KEY_TYPE, typename POOL_TYPE> class ConnPoolMap {
 public:
@@ -57,18 +61,38 @@ public:
   void drainConnections();
 
 private:
+  struct PoolEntry {
+    KEY_TYPE key_;
+    std::unique_ptr<POOL_TYPE> pool_;
+  };
+  using PoolList = std::list<PoolEntry>;
+
   /**
-   * Frees the first idle pool in `active_pools_`.
+   * Frees the least recently used idle pool in `active_pools_`.
    * @return false if no pool was freed.
    */
   bool freeOnePool();
 
+  /**
+   * Frees the least recently used idle pools beyond the cluster's limit on idle pools per host. The
+   * most recently used pool is never freed, as it is about to be used by the caller.
+   */
+  void freeExcessIdlePools();
+
+  /**
+   * Removes a pool from the map and updates resource tracking.
+   * @return the entry following the removed one.
+   */
+  typename PoolList::iterator erasePool(typename PoolList::iterator pool_iter);
+
   /**
    * Cleans up the active_pools_ map and updates resource tracking
    **/
   void clearActivePools();
 
-  absl::flat_hash_map<KEY_TYPE, std::unique_ptr<POOL_TYPE>> active_pools_;
+  // Ordered from the most to the least recently used pool.
+  PoolList active_pools_;
+  absl::flat_hash_map<KEY_TYPE, typename PoolList::iterator> pool_index_;
   Event::Dispatcher& thread_local_dispatcher_;
   std::vector<DrainedCb> cached_callbacks_;
   Common::DebugRecursionChecker recursion_checker_;
@@ -26,9 +26,10 @@ ConnPoolMap<KEY_TYPE, POOL_TYPE>::getPool(KEY_TYPE key, const PoolFactory& facto
   // TODO(klarose): Consider how we will change the connection pool's configuration in the future.
   // The plan is to change the downstream socket options... We may want to take those as a parameter
   // here. Maybe we'll pass them to the factory function?
-  auto pool_iter = active_pools_.find(key);
-  if (pool_iter != active_pools_.end()) {
-    return std::ref(*(pool_iter->second));
+  auto index_iter = pool_index_.find(key);
+  if (index_iter != pool_index_.end()) {
+    active_pools_.splice(active_pools_.begin(), active_pools_, index_iter->second);
+    return std::ref(*(index_iter->second->pool_));
   }
   ResourceLimit& connPoolResource = host_->cluster().resourceManager(priority_).connectionPools();
   // We need a new pool. Check if we have room.
@@ -56,8 +57,10 @@ ConnPoolMap<KEY_TYPE, POOL_TYPE>::getPool(KEY_TYPE key, const PoolFactory& facto
     new_pool->addDrainedCallback(cb);
   }
 
-  auto inserted = active_pools_.emplace(key, std::move(new_pool));
-  return std::ref(*inserted.first->second);
+  active_pools_.push_front(PoolEntry{key, std::move(new_pool)});
+  pool_index_.emplace(std::move(key), active_pools_.begin());
+  freeExcessIdlePools();
+  return std::ref(*active_pools_.front().pool_);
 }
 
 template <typename KEY_TYPE, typename POOL_TYPE>
@@ -67,8 +70,8 @@ size_t ConnPoolMap<KEY_TYPE, POOL_TYPE>::size() const {
 
 template <typename KEY_TYPE, typename POOL_TYPE> void ConnPoolMap<KEY_TYPE, POOL_TYPE>::clear() {
   Common::AutoDebugRecursionChecker assert_not_in(recursion_checker_);
-  for (auto& pool_pair : active_pools_) {
-    thread_local_dispatcher_.deferredDelete(std::move(pool_pair.second));
+  for (auto& entry : active_pools_) {
+    thread_local_dispatcher_.deferredDelete(std::move(entry.pool_));
   }
   clearActivePools();
 }
@@ -76,8 +79,8 @@ template <typename KEY_TYPE, typename POOL_TYPE> void ConnPoolMap<KEY_TYPE, POOL
 template <typename KEY_TYPE, typename POOL_TYPE>
 void ConnPoolMap<KEY_TYPE, POOL_TYPE>::addDrainedCallback(const DrainedCb& cb) {
   Common::AutoDebugRecursionChecker assert_not_in(recursion_checker_);
-  for (auto& pool_pair : active_pools_) {
-    pool_pair.second->addDrainedCallback(cb);
+  for (auto& entry : active_pools_) {
+    entry.pool_->addDrainedCallback(cb);
   }
 
   cached_callbacks_.emplace_back(std::move(cb));
@@ -86,35 +89,63 @@ void ConnPoolMap<KEY_TYPE, POOL_TYPE>::addDrainedCallback(const DrainedCb& cb) {
 template <typename KEY_TYPE, typename POOL_TYPE>
 void ConnPoolMap<KEY_TYPE, POOL_TYPE>::drainConnections() {
   Common::AutoDebugRecursionChecker assert_not_in(recursion_checker_);
-  for (auto& pool_pair : active_pools_) {
-    pool_pair.second->drainConnections();
+  for (auto& entry : active_pools_) {
+    entry.pool_->drainConnections();
   }
 }
 
 template <typename KEY_TYPE, typename POOL_TYPE>
 bool ConnPoolMap<KEY_TYPE, POOL_TYPE>::freeOnePool() {
-  // Try to find a pool that isn't doing anything.
-  auto pool_iter = active_pools_.begin();
-  while (pool_iter != active_pools_.end()) {
-    if (!pool_iter->second->hasActiveConnections()) {
+  // Try to find the least recently used pool that isn't doing anything.
+  auto pool_iter = active_pools_.rbegin();
+  while (pool_iter != active_pools_.rend()) {
+    if (!pool_iter->pool_->hasActiveConnections()) {
       break;
     }
     ++pool_iter;
   }
 
-  if (pool_iter != active_pools_.end()) {
+  if (pool_iter != active_pools_.rend()) {
     // We found one. Free it up, and let the caller know.
-    active_pools_.erase(pool_iter);
-    host_->cluster().resourceManager(priority_).connectionPools().dec();
+    erasePool(std::prev(pool_iter.base()));
     return true;
   }
 
   return false;
 }
 
+template <typename KEY_TYPE, typename POOL_TYPE>
+void ConnPoolMap<KEY_TYPE, POOL_TYPE>::freeExcessIdlePools() {
+  const uint32_t max_idle_pools = host_->cluster().maxIdleConnPoolsPerHost();
+  if (active_pools_.size() <= max_idle_pools) {
+    return;
+  }
+
+  uint32_t idle_pools = 0;
+  auto pool_iter = std::next(active_pools_.begin());
+  while (pool_iter != active_pools_.end()) {
+    if (pool_iter->pool_->hasActiveConnections() || idle_pools++ < max_idle_pools) {
+      ++pool_iter;
+      continue;
+    }
+
+    pool_iter = erasePool(pool_iter);
+    host_->cluster().stats().upstream_cx_pool_idle_evicted_.inc();
+  }
+}
+
+template <typename KEY_TYPE, typename POOL_TYPE>
+typename ConnPoolMap<KEY_TYPE, POOL_TYPE>::PoolList::iterator
+ConnPoolMap<KEY_TYPE, POOL_TYPE>::erasePool(typename PoolList::iterator pool_iter) {
+  pool_index_.erase(pool_iter->key_);
+  host_->cluster().resourceManager(priority_).connectionPools().dec();
+  return active_pools_.erase(pool_iter);
+}
+
 template <typename KEY_TYPE, typename POOL_TYPE>
 void ConnPoolMap<KEY_TYPE, POOL_TYPE>::clearActivePools() {
   host_->cluster().resourceManager(priority_).connectionPools().decBy(active_pools_.size());
+  pool_index_.clear();
   active_pools_.clear();
 }
 } // namespace Upstream
@@ -0,0 +1,123 @@
+#include "common/upstream/health_check_scheduler.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+namespace {
+// Number of slots in the timing wheel. Timers further out than a rotation of the wheel stay in
+// their slot until the tick of their deadline comes around.
+constexpr uint64_t NumSlots = 512;
+} // namespace
+
+HealthCheckScheduler::HealthCheckScheduler(Event::Dispatcher& dispatcher,
+                                           std::chrono::milliseconds resolution)
+    : dispatcher_(dispatcher),
+      resolution_(std::max(resolution, std::chrono::milliseconds(1))),
+      start_time_(dispatcher.timeSource().monotonicTime()), slots_(NumSlots),
+      tick_timer_(dispatcher.createTimer([this]() -> void { onTick(); })) {}
+
+HealthCheckScheduler::~HealthCheckScheduler() { ASSERT(enabled_timers_ == 0); }
+
+Event::TimerPtr HealthCheckScheduler::createTimer(Event::TimerCb cb) {
+  return std::make_unique<WheelTimer>(*this, cb);
+}
+
+uint64_t HealthCheckScheduler::currentTick() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             dispatcher_.timeSource().monotonicTime() - start_time_) /
+         resolution_;
+}
+
+void HealthCheckScheduler::link(WheelTimer& timer, TimerList& list) {
+  ASSERT(timer.list_ == nullptr);
+  timer.entry_ = list.insert(list.end(), &timer);
+  timer.list_ = &list;
+  ++enabled_timers_;
+}
+
+void HealthCheckScheduler::unlink(WheelTimer& timer) {
+  ASSERT(timer.list_ != nullptr);
+  timer.list_->erase(timer.entry_);
+  timer.list_ = nullptr;
+  --enabled_timers_;
+}
+
+void HealthCheckScheduler::onTick() {
+  // Collect the timers whose deadline has passed, visiting each slot at most once in case the
+  // dispatcher was blocked for more than a rotation of the wheel.
+  const uint64_t now_tick = currentTick();
+  const uint64_t ticks = std::min(now_tick - std::min(now_tick, processed_tick_), NumSlots);
+  for (uint64_t tick = now_tick - ticks + 1; tick <= now_tick; ++tick) {
+    TimerList& slot = slots_[tick % NumSlots];
+    for (auto it = slot.begin(); it != slot.end();) {
+      WheelTimer& timer = **it++;
+      if (timer.deadline_tick_ <= now_tick) {
+        expired_.splice(expired_.end(), slot, timer.entry_);
+        timer.list_ = &expired_;
+      }
+    }
+  }
+  processed_tick_ = std::max(processed_tick_, now_tick);
+
+  // Callbacks may enable or destroy any timer, including expired ones which did not run yet, so
+  // each timer is unlinked right before its callback runs. Timers enabled by the callbacks are due
+  // on a later tick, so this terminates.
+  while (!expired_.empty()) {
+    WheelTimer& timer = *expired_.front();
+    unlink(timer);
+    timer.cb_();
+  }
+
+  if (enabled_timers_ > 0) {
+    armTickTimer(processed_tick_ + 1);
+  }
+}
+
+void HealthCheckScheduler::armTickTimer(uint64_t tick) {
+  const MonotonicTime tick_time = start_time_ + resolution_ * static_cast<int64_t>(tick);
+  const MonotonicTime now = dispatcher_.timeSource().monotonicTime();
+  tick_timer_->enableTimer(std::chrono::ceil<std::chrono::milliseconds>(
+      std::max<MonotonicTime::duration>(tick_time - now, MonotonicTime::duration(0))));
+  armed_tick_ = tick;
+}
+
+void HealthCheckScheduler::WheelTimer::disableTimer() {
+  if (list_ != nullptr) {
+    parent_.unlink(*this);
+  }
+}
+
+void HealthCheckScheduler::WheelTimer::enableTimer(const std::chrono::milliseconds& ms,
+                                                   const ScopeTrackedObject* object) {
+  enableHRTimer(std::chrono::duration_cast<std::chrono::microseconds>(ms), object);
+}
+
+void HealthCheckScheduler::WheelTimer::enableHRTimer(const std::chrono::microseconds& us,
+                                                     const ScopeTrackedObject*) {
+  disableTimer();
+  if (parent_.enabled_timers_ == 0) {
+    // Nothing is pending, so skip the ticks which passed while the wheel was idle.
+    parent_.processed_tick_ = std::max(parent_.processed_tick_, parent_.currentTick());
+  }
+
+  // Round the deadline up to the next tick, so that the timer never fires early.
+  const std::chrono::microseconds deadline =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          parent_.dispatcher_.timeSource().monotonicTime() - parent_.start_time_) +
+      us;
+  deadline_tick_ = std::max<uint64_t>(
+      (deadline + parent_.resolution_ - std::chrono::microseconds(1)) / parent_.resolution_,
+      parent_.processed_tick_ + 1);
+  parent_.link(*this, parent_.slots_[deadline_tick_ % NumSlots]);
+
+  if (!parent_.tick_timer_->enabled() || deadline_tick_ < parent_.armed_tick_) {
+    parent_.armTickTimer(deadline_tick_);
+  }
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Schedules the probes and timeouts of many health check sessions with a single dispatcher timer.
+ * Timers created by the scheduler are kept in a hashed timing wheel with slots of `resolution`,
+ * and fire in batches when the single timer ticks. Compared to a dispatcher timer per session,
+ * this avoids churning the dispatcher's timer heap for each probe and coalesces the wakeups of
+ * probes which are due at about the same time, at the cost of rounding their deadlines up to the
+ * next tick.
+ *
+ * The scheduler must outlive the timers created by it.
+ */
+class HealthCheckScheduler : NonCopyable {
+public:
+  HealthCheckScheduler(Event::Dispatcher& dispatcher, std::chrono::milliseconds resolution);
+  ~HealthCheckScheduler();
+
+  /**
+   * @return a timer driven by the scheduler, with the same semantics as a dispatcher timer other
+   *         than the granularity of its deadline.
+   */
+  Event::TimerPtr createTimer(Event::TimerCb cb);
+
+  /**
+   * @return the number of enabled timers.
+   */
+  uint64_t enabledTimers() const { return enabled_timers_; }
+
+private:
+  class WheelTimer;
+  using TimerList = std::list<WheelTimer*>;
+
+  class WheelTimer : public Event::Timer {
+  public:
+    WheelTimer(HealthCheckScheduler& parent, Event::TimerCb cb) : parent_(parent), cb_(cb) {}
+    ~WheelTimer() override { disableTimer(); }
+
+    // Event::Timer
+    void disableTimer() override;
+    void enableTimer(const std::chrono::milliseconds& ms,
+                     const ScopeTrackedObject* object = nullptr) override;
+    void enableHRTimer(const std::chrono::microseconds& us,
+                       const ScopeTrackedObject* object = nullptr) override;
+    bool enabled() override { return list_ != nullptr; }
+
+    HealthCheckScheduler& parent_;
+    const Event::TimerCb cb_;
+    uint64_t deadline_tick_{};
+    // The slot or expired list the timer is linked into while it is enabled.
+    TimerList* list_{};
+    TimerList::iterator entry_;
+  };
+
+  uint64_t currentTick() const;
+  void armTickTimer(uint64_t tick);
+  void link(WheelTimer& timer, TimerList& list);
+  void unlink(WheelTimer& timer);
+  void onTick();
+
+  Event::Dispatcher& dispatcher_;
+  const std::chrono::microseconds resolution_;
+  const MonotonicTime start_time_;
+  std::vector<TimerList> slots_;
+  // Timers whose deadline passed on the tick which is being processed.
+  TimerList expired_;
+  uint64_t processed_tick_{};
+  // The tick the tick timer is armed for, if it is enabled.
+  uint64_t armed_tick_{};
+  uint64_t enabled_timers_{};
+  const Event::TimerPtr tick_timer_;
+};
+
+using HealthCheckSchedulerPtr = std::unique_ptr<HealthCheckScheduler>;
+
+} // namespace Upstream
+} // namespace Envoy
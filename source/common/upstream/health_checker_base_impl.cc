@@ -5,6 +5,7 @@
 #include "envoy/data/core/v3/health_check_event.pb.h"
 #include "envoy/stats/scope.h"
 
+#include "common/common/hash.h"
 #include "common/network/utility.h"
 #include "common/router/router.h"
 
@@ -35,8 +36,14 @@ HealthCheckerImplBase::HealthCheckerImplBase(const Cluster& cluster,
           PROTOBUF_GET_MS_OR_DEFAULT(config, unhealthy_edge_interval, unhealthy_interval_.count())),
       healthy_edge_interval_(
           PROTOBUF_GET_MS_OR_DEFAULT(config, healthy_edge_interval, interval_.count())),
+      spread_initial_probes_(config.probe_scheduling().spread_initial_probes()),
       transport_socket_options_(initTransportSocketOptions(config)),
       transport_socket_match_metadata_(initTransportSocketMatchMetadata(config)) {
+  if (config.has_probe_scheduling()) {
+    scheduler_ = std::make_unique<HealthCheckScheduler>(
+        dispatcher_,
+        std::chrono::milliseconds(PROTOBUF_GET_MS_REQUIRED(config.probe_scheduling(), resolution)));
+  }
   cluster_.prioritySet().addMemberUpdateCb(
       [this](const HostVector& hosts_added, const HostVector& hosts_removed) -> void {
         onClusterMemberUpdate(hosts_added, hosts_removed);
@@ -160,6 +167,13 @@ void HealthCheckerImplBase::addHosts(const HostVector& hosts) {
   }
 }
 
+Event::TimerPtr HealthCheckerImplBase::createTimer(Event::TimerCb cb) {
+  if (scheduler_ != nullptr) {
+    return scheduler_->createTimer(cb);
+  }
+  return dispatcher_.createTimer(cb);
+}
+
 void HealthCheckerImplBase::onClusterMemberUpdate(const HostVector& hosts_added,
                                                   const HostVector& hosts_removed) {
   addHosts(hosts_added);
@@ -220,8 +234,8 @@ void HealthCheckerImplBase::start() {
 HealthCheckerImplBase::ActiveHealthCheckSession::ActiveHealthCheckSession(
     HealthCheckerImplBase& parent, HostSharedPtr host)
     : host_(host), parent_(parent),
-      interval_timer_(parent.dispatcher_.createTimer([this]() -> void { onIntervalBase(); })),
-      timeout_timer_(parent.dispatcher_.createTimer([this]() -> void { onTimeoutBase(); })) {
+      interval_timer_(parent.createTimer([this]() -> void { onIntervalBase(); })),
+      timeout_timer_(parent.createTimer([this]() -> void { onTimeoutBase(); })) {
 
   if (!host->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
     parent.incHealthy();
@@ -380,7 +394,12 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::onTimeoutBase() {
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::onInitialInterval() {
-  if (parent_.initial_jitter_.count() == 0) {
+  if (parent_.spread_initial_probes_) {
+    // Give each host a fixed offset into the interval, so that the probes of all hosts are spread
+    // uniformly across it.
+    interval_timer_->enableTimer(std::chrono::milliseconds(
+        HashUtil::xxHash64(host_->address()->asStringView()) % parent_.interval_.count()));
+  } else if (parent_.initial_jitter_.count() == 0) {
     onIntervalBase();
   } else {
     interval_timer_->enableTimer(
@@ -13,6 +13,7 @@
 #include "common/common/logger.h"
 #include "common/common/matchers.h"
 #include "common/network/transport_socket_options_impl.h"
+#include "common/upstream/health_check_scheduler.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -127,6 +128,7 @@ private:
   };
 
   void addHosts(const HostVector& hosts);
+  Event::TimerPtr createTimer(Event::TimerCb cb);
   void decHealthy();
   void decDegraded();
   HealthCheckerStats generateStats(Stats::Scope& scope);
@@ -154,6 +156,9 @@ private:
   const std::chrono::milliseconds unhealthy_interval_;
   const std::chrono::milliseconds unhealthy_edge_interval_;
   const std::chrono::milliseconds healthy_edge_interval_;
+  const bool spread_initial_probes_;
+  // Drives the timers of all sessions if probe scheduling is configured.
+  HealthCheckSchedulerPtr scheduler_;
   absl::node_hash_map<HostSharedPtr, ActiveHealthCheckSessionPtr> active_sessions_;
   const std::shared_ptr<const Network::TransportSocketOptionsImpl> transport_socket_options_;
   const MetadataConstSharedPtr transport_socket_match_metadata_;
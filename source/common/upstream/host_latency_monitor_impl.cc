@@ -0,0 +1,57 @@
+#include "common/upstream/host_latency_monitor_impl.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+namespace {
+
+int64_t toNanoseconds(MonotonicTime time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+PeakEwmaHostLatencyMonitor::PeakEwmaHostLatencyMonitor(std::chrono::nanoseconds decay_time)
+    : decay_time_ns_(decay_time.count()) {
+  ASSERT(decay_time_ns_ > 0);
+}
+
+void PeakEwmaHostLatencyMonitor::putResponseTime(std::chrono::microseconds time,
+                                                 MonotonicTime now) {
+  const int64_t now_ns = toNanoseconds(now);
+  const int64_t last_update_ns = last_update_ns_.exchange(now_ns, std::memory_order_relaxed);
+  // The first sample becomes the estimate.
+  const double weight = has_sample_.load(std::memory_order_acquire)
+                            ? decayWeight(now_ns - last_update_ns)
+                            : 0.0;
+  const double sample = time.count();
+
+  double current = estimate_us_.load(std::memory_order_relaxed);
+  double next;
+  do {
+    next = sample > current ? sample : current * weight + sample * (1.0 - weight);
+  } while (!estimate_us_.compare_exchange_weak(current, next, std::memory_order_relaxed));
+  has_sample_.store(true, std::memory_order_release);
+}
+
+absl::optional<double> PeakEwmaHostLatencyMonitor::latencyEstimate(MonotonicTime now) const {
+  if (!has_sample_.load(std::memory_order_acquire)) {
+    return absl::nullopt;
+  }
+  return estimate_us_.load(std::memory_order_relaxed) *
+         decayWeight(toNanoseconds(now) - last_update_ns_.load(std::memory_order_relaxed));
+}
+
+double PeakEwmaHostLatencyMonitor::decayWeight(int64_t elapsed_ns) const {
+  // Samples may be reported with a timestamp slightly older than the last update by another
+  // worker.
+  return std::exp(-static_cast<double>(std::max<int64_t>(elapsed_ns, 0)) / decay_time_ns_);
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/upstream/host_latency_monitor.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Null implementation of HostLatencyMonitor, used when the cluster's load balancer does not
+ * consider latency.
+ */
+class HostLatencyMonitorNullImpl : public HostLatencyMonitor {
+public:
+  // Upstream::HostLatencyMonitor
+  void putResponseTime(std::chrono::microseconds, MonotonicTime) override {}
+  absl::optional<double> latencyEstimate(MonotonicTime) const override { return absl::nullopt; }
+};
+
+/**
+ * Peak exponentially weighted moving average of response latency, as used by Finagle and linkerd.
+ * A response slower than the current estimate replaces the estimate immediately (the peak), while
+ * faster responses are averaged in with a weight that depends on the time elapsed since the last
+ * sample, so that the estimate reacts quickly to latency spikes and recovers smoothly. When no
+ * samples arrive the estimate decays toward zero, which lets a host that was avoided be tried again.
+ *
+ * Updates are lock free. Concurrent updates from several workers may lose a sample, which is
+ * acceptable for a load balancing signal.
+ */
+class PeakEwmaHostLatencyMonitor : public HostLatencyMonitor {
+public:
+  explicit PeakEwmaHostLatencyMonitor(std::chrono::nanoseconds decay_time);
+
+  // Upstream::HostLatencyMonitor
+  void putResponseTime(std::chrono::microseconds time, MonotonicTime now) override;
+  absl::optional<double> latencyEstimate(MonotonicTime now) const override;
+
+private:
+  double decayWeight(int64_t elapsed_ns) const;
+
+  const double decay_time_ns_;
+  std::atomic<double> estimate_us_{0};
+  std::atomic<int64_t> last_update_ns_{0};
+  std::atomic<bool> has_sample_{false};
+};
+
+} // namespace Upstream
+} // namespace Envoy
@@ -13,6 +13,7 @@
 #include "common/protobuf/utility.h"
 
 #include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_set.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -123,6 +124,8 @@ LoadBalancerBase::LoadBalancerBase(
       [this](uint32_t priority, const HostVector&, const HostVector&) -> void {
         UNREFERENCED_PARAMETER(priority);
         recalculatePerPriorityPanic();
+        stashed_random_.clear();
+        peeked_hosts_ = 0;
       });
 }
 
@@ -327,14 +330,14 @@ LoadBalancerBase::chooseHostSet(LoadBalancerContext* context) {
         priority_set_, per_priority_load_, Upstream::RetryPriority::defaultPriorityMapping);
 
     const auto priority_and_source =
-        choosePriority(random_.random(), priority_loads.healthy_priority_load_,
+        choosePriority(random(), priority_loads.healthy_priority_load_,
                        priority_loads.degraded_priority_load_);
     return {*priority_set_.hostSetsPerPriority()[priority_and_source.first],
             priority_and_source.second};
   }
 
   const auto priority_and_source =
-      choosePriority(random_.random(), per_priority_load_.healthy_priority_load_,
+      choosePriority(random(), per_priority_load_.healthy_priority_load_,
                      per_priority_load_.degraded_priority_load_);
   return {*priority_set_.hostSetsPerPriority()[priority_and_source.first],
           priority_and_source.second};
@@ -508,6 +511,10 @@ bool ZoneAwareLoadBalancerBase::earlyExitNonLocalityRouting() {
 }
 
 HostConstSharedPtr LoadBalancerBase::chooseHost(LoadBalancerContext* context) {
+  if (peeked_hosts_ > 0) {
+    --peeked_hosts_;
+  }
+
   HostConstSharedPtr host;
   const size_t max_attempts = context ? context->hostSelectionRetryCount() + 1 : 1;
   for (size_t i = 0; i < max_attempts; ++i) {
@@ -525,6 +532,36 @@ HostConstSharedPtr LoadBalancerBase::chooseHost(LoadBalancerContext* context) {
   return host;
 }
 
+HostConstSharedPtr LoadBalancerBase::peekAnotherHost(LoadBalancerContext* context) {
+  if (peeked_hosts_ >= MaxPeekedHosts) {
+    return nullptr;
+  }
+
+  // Only the random values are committed to, not the host: the selection is re-run by a later
+  // chooseHost() with that stream's context (e.g. its retry priority and host predicates) and the
+  // hosts' load at that time, so the prediction may miss but the pick distribution is unchanged.
+  peeking_ = true;
+  HostConstSharedPtr host = chooseHostOnce(context);
+  peeking_ = false;
+  if (host != nullptr) {
+    ++peeked_hosts_;
+  }
+  return host;
+}
+
+uint64_t LoadBalancerBase::random() {
+  if (peeking_) {
+    stashed_random_.push_back(random_.random());
+    return stashed_random_.back();
+  }
+  if (!stashed_random_.empty()) {
+    const uint64_t value = stashed_random_.front();
+    stashed_random_.pop_front();
+    return value;
+  }
+  return random_.random();
+}
+
 bool LoadBalancerBase::isHostSetInPanic(const HostSet& host_set) {
   uint64_t global_panic_threshold = std::min<uint64_t>(
       100, runtime_.snapshot().getInteger(RuntimePanicThreshold, default_healthy_panic_percent_));
@@ -576,7 +613,7 @@ uint32_t ZoneAwareLoadBalancerBase::tryChooseLocalLocalityHosts(const HostSet& h
 
   // If we cannot route all requests to the same locality, we already calculated how much we can
   // push to the local locality, check if we can push to local locality on current iteration.
-  if (random_.random() % 10000 < state.local_percent_to_route_) {
+  if (random() % 10000 < state.local_percent_to_route_) {
     stats_.lb_zone_routing_sampled_.inc();
     return 0;
   }
@@ -588,12 +625,12 @@ uint32_t ZoneAwareLoadBalancerBase::tryChooseLocalLocalityHosts(const HostSet& h
   // locality percentages. In this case just select random locality.
   if (state.residual_capacity_[number_of_localities - 1] == 0) {
     stats_.lb_zone_no_capacity_left_.inc();
-    return random_.random() % number_of_localities;
+    return random() % number_of_localities;
   }
 
   // Random sampling to select specific locality for cross locality traffic based on the additional
   // capacity in localities.
-  uint64_t threshold = random_.random() % state.residual_capacity_[number_of_localities - 1];
+  uint64_t threshold = random() % state.residual_capacity_[number_of_localities - 1];
 
   // This potentially can be optimized to be O(log(N)) where N is the number of localities.
   // Linear scan should be faster for smaller N, in most of the scenarios N will be small.
@@ -699,26 +736,51 @@ EdfLoadBalancerBase::EdfLoadBalancerBase(
     : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
                                 common_config),
       seed_(random_.random()) {
-  // We fully recompute the schedulers for a given host set here on membership change, which is
-  // consistent with what other LB implementations do (e.g. thread aware).
-  // The downside of a full recompute is that time complexity is O(n * log n),
-  // so we will need to do better at delta tracking to scale (see
-  // https://github.com/envoyproxy/envoy/issues/2874).
+  // We recompute the schedulers for a given host set here on membership change. Schedulers whose
+  // hosts only gained some of the added hosts are extended; the others are fully recomputed, which
+  // is O(n * log n) (see https://github.com/envoyproxy/envoy/issues/2874).
   priority_set.addPriorityUpdateCb(
-      [this](uint32_t priority, const HostVector&, const HostVector&) { refresh(priority); });
+      [this](uint32_t priority, const HostVector& hosts_added, const HostVector& hosts_removed) {
+        refresh(priority, hosts_added, hosts_removed);
+      });
 }
 
 void EdfLoadBalancerBase::initialize() {
   for (uint32_t priority = 0; priority < priority_set_.hostSetsPerPriority().size(); ++priority) {
-    refresh(priority);
+    refresh(priority, {}, {});
   }
 }
 
-void EdfLoadBalancerBase::refresh(uint32_t priority) {
-  const auto add_hosts_source = [this](HostsSource source, const HostVector& hosts) {
-    // Nuke existing scheduler if it exists.
-    auto& scheduler = scheduler_[source] = Scheduler{};
+namespace {
+
+// Order independent fingerprint of a set of hosts: the sum of the hashes of its hosts.
+uint64_t hostFingerprint(const Host& host) { return absl::Hash<const Host*>()(&host); }
+
+} // namespace
+
+void EdfLoadBalancerBase::refresh(uint32_t priority, const HostVector& hosts_added,
+                                  const HostVector& hosts_removed) {
+  // Schedules can only be extended when the update only added hosts. Updates that don't change
+  // membership (e.g. health or weight changes) and updates that remove hosts rebuild them, as the
+  // EDF scheduler supports neither removal nor re-weighting.
+  absl::flat_hash_set<const Host*> added;
+  if (hosts_removed.empty()) {
+    added.reserve(hosts_added.size());
+    for (const auto& host : hosts_added) {
+      added.insert(host.get());
+    }
+  }
+
+  const auto add_hosts_source = [this, &added](HostsSource source, const HostVector& hosts) {
+    auto& scheduler = scheduler_[source];
     refreshHostSource(source);
+    if (scheduler.edf_ != nullptr && !added.empty() &&
+        tryAddHostsToScheduler(scheduler, hosts, added)) {
+      return;
+    }
+
+    // Nuke existing scheduler if it exists.
+    scheduler = Scheduler{};
 
     // Check if the original host weights are equal and skip EDF creation if they are. When all
     // original weights are equal we can rely on unweighted host pick to do optimal round robin and
@@ -752,6 +814,10 @@ void EdfLoadBalancerBase::refresh(uint32_t priority) {
         scheduler.edf_->add(hostWeight(*host), host);
       }
     }
+    scheduler.num_hosts_ = hosts.size();
+    for (const auto& host : hosts) {
+      scheduler.hosts_fingerprint_ += hostFingerprint(*host);
+    }
   };
 
   // Populate EdfSchedulers for each valid HostsSource value for the host set at this priority.
@@ -775,6 +841,38 @@ void EdfLoadBalancerBase::refresh(uint32_t priority) {
   }
 }
 
+bool EdfLoadBalancerBase::tryAddHostsToScheduler(
+    Scheduler& scheduler, const HostVector& hosts,
+    const absl::flat_hash_set<const Host*>& hosts_added) {
+  // The hosts are the scheduled hosts plus the added ones if the counts and fingerprints agree.
+  // This also catches existing hosts leaving the source, e.g. on a health change, in the same
+  // update.
+  uint64_t fingerprint = 0;
+  uint64_t added_fingerprint = 0;
+  HostVector hosts_to_schedule;
+  for (const auto& host : hosts) {
+    const uint64_t host_fingerprint = hostFingerprint(*host);
+    fingerprint += host_fingerprint;
+    if (hosts_added.count(host.get()) != 0) {
+      added_fingerprint += host_fingerprint;
+      hosts_to_schedule.push_back(host);
+    }
+  }
+  if (hosts.size() != scheduler.num_hosts_ + hosts_to_schedule.size() ||
+      fingerprint != scheduler.hosts_fingerprint_ + added_fingerprint) {
+    return false;
+  }
+
+  // New hosts are scheduled relative to the current time, so they compete fairly with the
+  // existing hosts from their first pick.
+  for (const auto& host : hosts_to_schedule) {
+    scheduler.edf_->add(hostWeight(*host), host);
+  }
+  scheduler.num_hosts_ = hosts.size();
+  scheduler.hosts_fingerprint_ = fingerprint;
+  return true;
+}
+
 HostConstSharedPtr EdfLoadBalancerBase::chooseHostOnce(LoadBalancerContext* context) {
   const absl::optional<HostsSource> hosts_source = hostSourceToUse(context);
   if (!hosts_source) {
@@ -791,6 +889,10 @@ HostConstSharedPtr EdfLoadBalancerBase::chooseHostOnce(LoadBalancerContext* cont
   // whether to use EDF or do unweighted (fast) selection. EDF is non-null iff the original weights
   // of 2 or more hosts differ.
   if (scheduler.edf_ != nullptr) {
+    if (peeking()) {
+      // The EDF schedule can't be looked ahead without changing it.
+      return nullptr;
+    }
     auto host = scheduler.edf_->pick();
     if (host != nullptr) {
       scheduler.edf_->add(hostWeight(*host), host);
@@ -809,7 +911,7 @@ HostConstSharedPtr LeastRequestLoadBalancer::unweightedHostPick(const HostVector
                                                                 const HostsSource&) {
   HostSharedPtr candidate_host = nullptr;
   for (uint32_t choice_idx = 0; choice_idx < choice_count_; ++choice_idx) {
-    const int rand_idx = random_.random() % hosts_to_use.size();
+    const int rand_idx = random() % hosts_to_use.size();
     HostSharedPtr sampled_host = hosts_to_use[rand_idx];
 
     if (candidate_host == nullptr) {
@@ -839,7 +941,45 @@ HostConstSharedPtr RandomLoadBalancer::chooseHostOnce(LoadBalancerContext* conte
     return nullptr;
   }
 
-  return hosts_to_use[random_.random() % hosts_to_use.size()];
+  return hosts_to_use[random() % hosts_to_use.size()];
+}
+
+HostConstSharedPtr PeakEwmaLoadBalancer::chooseHostOnce(LoadBalancerContext* context) {
+  const absl::optional<HostsSource> hosts_source = hostSourceToUse(context);
+  if (!hosts_source) {
+    return nullptr;
+  }
+
+  const HostVector& hosts_to_use = hostSourceToHosts(*hosts_source);
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+
+  const HostSharedPtr& first = hosts_to_use[random() % hosts_to_use.size()];
+  const HostSharedPtr& second = hosts_to_use[random() % hosts_to_use.size()];
+  if (first == second) {
+    return first;
+  }
+
+  const MonotonicTime now = time_source_.monotonicTime();
+  return hostCost(*second, now) < hostCost(*first, now) ? second : first;
+}
+
+double PeakEwmaLoadBalancer::hostCost(const Host& host, MonotonicTime now) const {
+  // Cost assigned to a host on probation that already has a request in flight. It is larger than
+  // any real cost so such a host is only picked when both choices are on probation, in which case
+  // the one with fewer active requests wins.
+  static constexpr double ProbationPenalty = 1e12;
+
+  const uint64_t active_rq = host.stats().rq_active_.value();
+  const absl::optional<double> latency = host.latencyMonitor().latencyEstimate(now);
+  double cost;
+  if (!latency.has_value() || latency.value() == 0.0) {
+    cost = active_rq == 0 ? 0.0 : ProbationPenalty + active_rq;
+  } else {
+    cost = latency.value() * (active_rq + 1);
+  }
+  return cost / std::max<uint32_t>(host.weight(), 1);
 }
 
 SubsetSelectorImpl::SubsetSelectorImpl(
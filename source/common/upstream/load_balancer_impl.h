@@ -2,12 +2,14 @@
 
 #include <cmath>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <queue>
 #include <set>
 #include <vector>
 
 #include "envoy/common/random_generator.h"
+#include "envoy/common/time.h"
 #include "envoy/config/cluster/v3/cluster.pb.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/load_balancer.h"
@@ -17,6 +19,8 @@
 #include "common/runtime/runtime_protos.h"
 #include "common/upstream/edf_scheduler.h"
 
+#include "absl/container/flat_hash_set.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -40,6 +44,7 @@ public:
                  const DegradedLoad& degraded_per_priority_load);
 
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
+  HostConstSharedPtr peekAnotherHost(LoadBalancerContext* context) override;
 
 protected:
   /**
@@ -92,6 +97,24 @@ protected:
   bool isInPanic(uint32_t priority) const { return per_priority_panic_[priority]; }
 
   ClusterStats& stats_;
+  /**
+   * @return a random value for host selection. While peeking, the values drawn are stashed and
+   *         handed out again by the next host selections, so that these re-run the predicted
+   *         selection with their own context and the hosts' current state.
+   */
+  uint64_t random();
+
+  /**
+   * @return whether the current selection is a prediction made by peekAnotherHost().
+   */
+  bool peeking() const { return peeking_; }
+
+  /**
+   * @return the number of outstanding predictions, i.e. how many host selections ahead of the
+   *         next chooseHost() the current prediction is.
+   */
+  uint32_t peekedHosts() const { return peeked_hosts_; }
+
   Runtime::Loader& runtime_;
   Random::RandomGenerator& random_;
   const uint32_t default_healthy_panic_percent_;
@@ -138,6 +161,17 @@ protected:
   DegradedAvailability per_priority_degraded_;
   // Levels which are in panic
   std::vector<bool> per_priority_panic_;
+
+private:
+  // Bounds how far peekAnotherHost() predicts ahead of chooseHost(). Prefetching is capped at 3
+  // connections per stream, so predicting further ahead is not useful.
+  static constexpr uint32_t MaxPeekedHosts = 3;
+
+  // Random values drawn by peekAnotherHost(), in the order host selections consume them. Dropped
+  // along with the outstanding predictions on membership changes.
+  std::deque<uint64_t> stashed_random_;
+  uint32_t peeked_hosts_{};
+  bool peeking_{};
 };
 
 class LoadBalancerContextBase : public LoadBalancerContext {
@@ -367,11 +401,24 @@ protected:
     // host weights of 2 or more hosts differ. When not present, the
     // implementation of chooseHostOnce falls back to unweightedHostPick.
     std::unique_ptr<EdfScheduler<const Host>> edf_;
+    // The number of hosts scheduled by edf_ and an order independent fingerprint of them, so that
+    // a refresh which only adds hosts can extend the schedule instead of recomputing it. Only
+    // populated along with edf_.
+    uint32_t num_hosts_{};
+    uint64_t hosts_fingerprint_{};
   };
 
   void initialize();
 
-  virtual void refresh(uint32_t priority);
+  // Recomputes the schedulers of the given priority. When the update only added hosts, schedulers
+  // whose hosts are exactly the previously scheduled hosts plus some of hosts_added are extended
+  // in place instead.
+  virtual void refresh(uint32_t priority, const HostVector& hosts_added,
+                       const HostVector& hosts_removed);
+  // Brings the schedule up to date with hosts if they only differ from the scheduled hosts by
+  // hosts in hosts_added. Returns false if the schedule must be recomputed.
+  bool tryAddHostsToScheduler(Scheduler& scheduler, const HostVector& hosts,
+                              const absl::flat_hash_set<const Host*>& hosts_added);
 
   // Seed to allow us to desynchronize load balancers across a fleet. If we don't
   // do this, multiple Envoys that receive an update at the same time (or even
@@ -419,6 +466,10 @@ private:
     // host source as the key. This means that each LB decision will require two map lookups in
     // the unweighted case. We might consider trying to optimize this in the future.
     ASSERT(rr_indexes_.find(source) != rr_indexes_.end());
+    if (peeking()) {
+      // Predict the host the index will point at once the outstanding predictions are picked.
+      return hosts_to_use[(rr_indexes_[source] + peekedHosts()) % hosts_to_use.size()];
+    }
     return hosts_to_use[rr_indexes_[source]++ % hosts_to_use.size()];
   }
 
@@ -466,7 +517,8 @@ public:
   }
 
 protected:
-  void refresh(uint32_t priority) override {
+  void refresh(uint32_t priority, const HostVector& hosts_added,
+               const HostVector& hosts_removed) override {
     active_request_bias_ =
         active_request_bias_runtime_ != nullptr ? active_request_bias_runtime_->value() : 1.0;
 
@@ -476,7 +528,7 @@ protected:
       active_request_bias_ = 1.0;
     }
 
-    EdfLoadBalancerBase::refresh(priority);
+    EdfLoadBalancerBase::refresh(priority, hosts_added, hosts_removed);
   }
 
 private:
@@ -516,8 +568,8 @@ private:
   const uint32_t choice_count_;
 
   // The exponent used to calculate host weights can be configured via runtime. We cache it for
-  // performance reasons and refresh it in `LeastRequestLoadBalancer::refresh(uint32_t priority)`
-  // whenever a `HostSet` is updated.
+  // performance reasons and refresh it in `LeastRequestLoadBalancer::refresh()` whenever a
+  // `HostSet` is updated.
   double active_request_bias_{};
 
   const std::unique_ptr<Runtime::Double> active_request_bias_runtime_;
@@ -538,6 +590,35 @@ public:
   HostConstSharedPtr chooseHostOnce(LoadBalancerContext* context) override;
 };
 
+/**
+ * Latency aware load balancer. Each host's cost is its peak EWMA response latency (see
+ * PeakEwmaHostLatencyMonitor) multiplied by its number of active requests plus one, divided by its
+ * load balancing weight. Two hosts are sampled at random and the cheaper one is picked (P2C).
+ *
+ * A host without a latency estimate (a new host, or one whose estimate fully decayed) is on
+ * probation: it is preferred while it has no active requests and avoided otherwise, so that it
+ * receives one request at a time until its first response time is known.
+ */
+class PeakEwmaLoadBalancer : public ZoneAwareLoadBalancerBase {
+public:
+  PeakEwmaLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
+                       ClusterStats& stats, Runtime::Loader& runtime,
+                       Random::RandomGenerator& random,
+                       const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config,
+                       TimeSource& time_source)
+      : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
+                                  common_config),
+        time_source_(time_source) {}
+
+  // Upstream::LoadBalancerBase
+  HostConstSharedPtr chooseHostOnce(LoadBalancerContext* context) override;
+
+private:
+  double hostCost(const Host& host, MonotonicTime now) const;
+
+  TimeSource& time_source_;
+};
+
 /**
  * Implementation of SubsetSelector
  */
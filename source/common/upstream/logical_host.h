@@ -84,6 +84,7 @@ public:
   }
   const ClusterInfo& cluster() const override { return logical_host_->cluster(); }
   HealthCheckHostMonitor& healthChecker() const override { return logical_host_->healthChecker(); }
+  HostLatencyMonitor& latencyMonitor() const override { return logical_host_->latencyMonitor(); }
   Outlier::DetectorHostMonitor& outlierDetector() const override {
     return logical_host_->outlierDetector();
   }
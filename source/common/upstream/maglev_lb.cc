@@ -5,9 +5,32 @@
 namespace Envoy {
 namespace Upstream {
 
+const MaglevPermutationCache::Permutation&
+MaglevPermutationCache::getOrCompute(const HostConstSharedPtr& host, uint64_t table_size,
+                                     bool use_hostname_for_hashing) {
+  auto it = permutations_.find(host);
+  if (it == permutations_.end()) {
+    const std::string& address =
+        use_hostname_for_hashing ? host->hostname() : host->address()->asString();
+    ASSERT(!address.empty());
+    it = permutations_
+             .emplace(host, Permutation{HashUtil::xxHash64(address) % table_size,
+                                        (HashUtil::xxHash64(address, 1) % (table_size - 1)) + 1})
+             .first;
+  }
+  return it->second;
+}
+
+void MaglevPermutationCache::remove(const HostVector& hosts_removed) {
+  for (const auto& host : hosts_removed) {
+    permutations_.erase(host);
+  }
+}
+
 MaglevTable::MaglevTable(const NormalizedHostWeightVector& normalized_host_weights,
                          double max_normalized_weight, uint64_t table_size,
-                         bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats)
+                         bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats,
+                         MaglevPermutationCache* permutation_cache)
     : table_size_(table_size), stats_(stats) {
   // TODO(mattklein123): The Maglev table must have a size that is a prime number for the algorithm
   // to work. Currently, the table size is not user configurable. In the future, if the table size
@@ -24,22 +47,60 @@ MaglevTable::MaglevTable(const NormalizedHostWeightVector& normalized_host_weigh
   // Implementation of pseudocode listing 1 in the paper (see header file for more info).
   std::vector<TableBuildEntry> table_build_entries;
   table_build_entries.reserve(normalized_host_weights.size());
+  hosts_.reserve(normalized_host_weights.size());
   for (const auto& host_weight : normalized_host_weights) {
     const auto& host = host_weight.first;
-    const std::string& address =
-        use_hostname_for_hashing ? host->hostname() : host->address()->asString();
-    ASSERT(!address.empty());
-    table_build_entries.emplace_back(host, HashUtil::xxHash64(address) % table_size_,
-                                     (HashUtil::xxHash64(address, 1) % (table_size_ - 1)) + 1,
-                                     host_weight.second);
+    if (permutation_cache != nullptr) {
+      const auto& permutation =
+          permutation_cache->getOrCompute(host, table_size_, use_hostname_for_hashing);
+      table_build_entries.emplace_back(permutation.offset_, permutation.skip_, host_weight.second);
+    } else {
+      const std::string& address =
+          use_hostname_for_hashing ? host->hostname() : host->address()->asString();
+      ASSERT(!address.empty());
+      table_build_entries.emplace_back(HashUtil::xxHash64(address) % table_size_,
+                                       (HashUtil::xxHash64(address, 1) % (table_size_ - 1)) + 1,
+                                       host_weight.second);
+    }
+    hosts_.push_back(host);
+  }
+
+  // The largest index value is reserved to mark empty table entries during the build.
+  if (hosts_.size() < std::numeric_limits<uint16_t>::max()) {
+    buildTable(compact_table_, table_build_entries, max_normalized_weight);
+  } else {
+    buildTable(table_, table_build_entries, max_normalized_weight);
+  }
+
+  uint64_t min_entries_per_host = table_size_;
+  uint64_t max_entries_per_host = 0;
+  for (const auto& entry : table_build_entries) {
+    min_entries_per_host = std::min(entry.count_, min_entries_per_host);
+    max_entries_per_host = std::max(entry.count_, max_entries_per_host);
+  }
+  stats_.min_entries_per_host_.set(min_entries_per_host);
+  stats_.max_entries_per_host_.set(max_entries_per_host);
+
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    for (uint64_t i = 0; i < table_size_; i++) {
+      const auto& host = hosts_[hostIndex(i)];
+      ENVOY_LOG(trace, "maglev: i={} host={}", i,
+                use_hostname_for_hashing ? host->hostname() : host->address()->asString());
+    }
   }
+}
 
-  table_.resize(table_size_);
+template <class IndexType>
+void MaglevTable::buildTable(std::vector<IndexType>& table,
+                             std::vector<TableBuildEntry>& table_build_entries,
+                             double max_normalized_weight) {
+  constexpr IndexType empty_entry = std::numeric_limits<IndexType>::max();
+  table.assign(table_size_, empty_entry);
 
   // Iterate through the table build entries as many times as it takes to fill up the table.
   uint64_t table_index = 0;
   for (uint32_t iteration = 1; table_index < table_size_; ++iteration) {
-    for (uint64_t i = 0; i < table_build_entries.size() && table_index < table_size; i++) {
+    for (uint64_t i = 0; i < table_build_entries.size() && table_index < table_size_; i++) {
       TableBuildEntry& entry = table_build_entries[i];
       // To understand how target_weight_ and weight_ are used below, consider a host with weight
       // equal to max_normalized_weight. This would be picked on every single iteration. If it had
@@ -49,39 +110,20 @@ MaglevTable::MaglevTable(const NormalizedHostWeightVector& normalized_host_weigh
         continue;
       }
       entry.target_weight_ += max_normalized_weight;
-      uint64_t c = permutation(entry);
-      while (table_[c] != nullptr) {
-        entry.next_++;
-        c = permutation(entry);
+      while (table[entry.position_] != empty_entry) {
+        advance(entry);
       }
 
-      table_[c] = entry.host_;
-      entry.next_++;
+      table[entry.position_] = static_cast<IndexType>(i);
+      advance(entry);
       entry.count_++;
       table_index++;
     }
   }
-
-  uint64_t min_entries_per_host = table_size_;
-  uint64_t max_entries_per_host = 0;
-  for (const auto& entry : table_build_entries) {
-    min_entries_per_host = std::min(entry.count_, min_entries_per_host);
-    max_entries_per_host = std::max(entry.count_, max_entries_per_host);
-  }
-  stats_.min_entries_per_host_.set(min_entries_per_host);
-  stats_.max_entries_per_host_.set(max_entries_per_host);
-
-  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
-    for (uint64_t i = 0; i < table_.size(); i++) {
-      ENVOY_LOG(trace, "maglev: i={} host={}", i,
-                use_hostname_for_hashing ? table_[i]->hostname()
-                                         : table_[i]->address()->asString());
-    }
-  }
 }
 
 HostConstSharedPtr MaglevTable::chooseHost(uint64_t hash, uint32_t attempt) const {
-  if (table_.empty()) {
+  if (hosts_.empty()) {
     return nullptr;
   }
 
@@ -92,11 +134,16 @@ HostConstSharedPtr MaglevTable::chooseHost(uint64_t hash, uint32_t attempt) cons
     hash ^= ~0ULL - attempt + 1;
   }
 
-  return table_[hash % table_size_];
+  return hosts_[hostIndex(hash % table_size_)];
 }
 
-uint64_t MaglevTable::permutation(const TableBuildEntry& entry) {
-  return (entry.offset_ + (entry.skip_ * entry.next_)) % table_size_;
+void MaglevTable::advance(TableBuildEntry& entry) const {
+  // Equivalent to (offset + skip * next) % table_size_ for the next value of next, without a
+  // division per probe. Both position_ and skip_ are less than table_size_.
+  entry.position_ += entry.skip_;
+  if (entry.position_ >= table_size_) {
+    entry.position_ -= table_size_;
+  }
 }
 
 MaglevLoadBalancer::MaglevLoadBalancer(
@@ -109,7 +156,14 @@ MaglevLoadBalancer::MaglevLoadBalancer(
       use_hostname_for_hashing_(
           common_config.has_consistent_hashing_lb_config()
               ? common_config.consistent_hashing_lb_config().use_hostname_for_hashing()
-              : false) {}
+              : false) {
+  // This is registered before ThreadAwareLoadBalancerBase::initialize() registers the table
+  // rebuild, so removed hosts are evicted from the cache before the new tables are computed.
+  priority_set.addPriorityUpdateCb(
+      [this](uint32_t, const HostVector&, const HostVector& hosts_removed) -> void {
+        permutation_cache_.remove(hosts_removed);
+      });
+}
 
 MaglevLoadBalancerStats MaglevLoadBalancer::generateStats(Stats::Scope& scope) {
   return {ALL_MAGLEV_LOAD_BALANCER_STATS(POOL_GAUGE(scope))};
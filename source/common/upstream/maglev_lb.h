@@ -8,6 +8,8 @@
 #include "common/upstream/thread_aware_lb_impl.h"
 #include "common/upstream/upstream_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -25,43 +27,90 @@ struct MaglevLoadBalancerStats {
   ALL_MAGLEV_LOAD_BALANCER_STATS(GENERATE_GAUGE_STRUCT)
 };
 
+/**
+ * Cache of per-host Maglev permutation parameters. Hosts that are unchanged across host set updates
+ * keep their offset/skip so that table rebuilds do not need to re-derive the hash key and re-hash it
+ * for every host. Entries are keyed by the host itself so the cache holds a reference to each host
+ * until it is removed from the priority set. Only accessed from the main thread.
+ */
+class MaglevPermutationCache {
+public:
+  struct Permutation {
+    uint64_t offset_;
+    uint64_t skip_;
+  };
+
+  /**
+   * @return the cached permutation for the host, computing and caching it if not present.
+   */
+  const Permutation& getOrCompute(const HostConstSharedPtr& host, uint64_t table_size,
+                                  bool use_hostname_for_hashing);
+
+  /**
+   * Drop the cached permutations for hosts that are no longer part of the priority set.
+   */
+  void remove(const HostVector& hosts_removed);
+
+  size_t size() const { return permutations_.size(); }
+
+private:
+  absl::flat_hash_map<HostConstSharedPtr, Permutation> permutations_;
+};
+
 /**
  * This is an implementation of Maglev consistent hashing as described in:
  * https://static.googleusercontent.com/media/research.google.com/en//pubs/archive/44824.pdf
  * section 3.4. Specifically, the algorithm shown in pseudocode listing 1 is implemented with a
  * fixed table size of 65537. This is the recommended table size in section 5.3.
+ *
+ * The table stores indices into a vector of hosts rather than a host pointer per entry. When there
+ * are fewer than 65535 hosts the indices are 16 bits wide, otherwise they are 32 bits wide. With
+ * the default table size this is ~128KiB per table instead of ~1MiB of shared pointers.
  */
 class MaglevTable : public ThreadAwareLoadBalancerBase::HashingLoadBalancer,
                     Logger::Loggable<Logger::Id::upstream> {
 public:
   MaglevTable(const NormalizedHostWeightVector& normalized_host_weights,
               double max_normalized_weight, uint64_t table_size, bool use_hostname_for_hashing,
-              MaglevLoadBalancerStats& stats);
+              MaglevLoadBalancerStats& stats, MaglevPermutationCache* permutation_cache = nullptr);
 
   // ThreadAwareLoadBalancerBase::HashingLoadBalancer
   HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
 
+  /**
+   * @return whether the table entries are stored as 16 bit host indices.
+   */
+  bool compact() const { return !compact_table_.empty(); }
+
   // Recommended table size in section 5.3 of the paper.
   static const uint64_t DefaultTableSize = 65537;
 
 private:
   struct TableBuildEntry {
-    TableBuildEntry(const HostConstSharedPtr& host, uint64_t offset, uint64_t skip, double weight)
-        : host_(host), offset_(offset), skip_(skip), weight_(weight) {}
+    TableBuildEntry(uint64_t offset, uint64_t skip, double weight)
+        : skip_(skip), weight_(weight), position_(offset) {}
 
-    HostConstSharedPtr host_;
-    const uint64_t offset_;
     const uint64_t skip_;
     const double weight_;
     double target_weight_{};
-    uint64_t next_{};
+    // Current position in this entry's permutation. This is advanced by skip_ modulo the table
+    // size rather than recomputing (offset + skip * next) % table_size for every probe.
+    uint64_t position_;
     uint64_t count_{};
   };
 
-  uint64_t permutation(const TableBuildEntry& entry);
+  template <class IndexType>
+  void buildTable(std::vector<IndexType>& table, std::vector<TableBuildEntry>& build_entries,
+                  double max_normalized_weight);
+  void advance(TableBuildEntry& entry) const;
+  uint32_t hostIndex(uint64_t table_index) const {
+    return compact() ? compact_table_[table_index] : table_[table_index];
+  }
 
   const uint64_t table_size_;
-  std::vector<HostConstSharedPtr> table_;
+  std::vector<HostConstSharedPtr> hosts_;
+  std::vector<uint16_t> compact_table_;
+  std::vector<uint32_t> table_;
   MaglevLoadBalancerStats& stats_;
 };
 
@@ -76,6 +125,7 @@ public:
                      uint64_t table_size = MaglevTable::DefaultTableSize);
 
   const MaglevLoadBalancerStats& stats() const { return stats_; }
+  const MaglevPermutationCache& permutationCache() const { return permutation_cache_; }
 
 private:
   // ThreadAwareLoadBalancerBase
@@ -83,7 +133,8 @@ private:
   createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
                      double /* min_normalized_weight */, double max_normalized_weight) override {
     return std::make_shared<MaglevTable>(normalized_host_weights, max_normalized_weight,
-                                         table_size_, use_hostname_for_hashing_, stats_);
+                                         table_size_, use_hostname_for_hashing_, stats_,
+                                         &permutation_cache_);
   }
 
   static MaglevLoadBalancerStats generateStats(Stats::Scope& scope);
@@ -92,6 +143,7 @@ private:
   MaglevLoadBalancerStats stats_;
   const uint64_t table_size_;
   const bool use_hostname_for_hashing_;
+  MaglevPermutationCache permutation_cache_;
 };
 
 } // namespace Upstream
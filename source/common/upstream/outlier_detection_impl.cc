@@ -1,6 +1,8 @@
 #include "common/upstream/outlier_detection_impl.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -35,6 +37,73 @@ DetectorSharedPtr DetectorImplFactory::createForCluster(
   }
 }
 
+void LatencyWindow::record(std::chrono::milliseconds response_time) {
+  const uint64_t ms = std::max<int64_t>(response_time.count(), 0);
+  sub_buckets_[current_sub_bucket_.load(std::memory_order_acquire)][bucketIndex(ms)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void LatencyWindow::advance() {
+  // Clear the oldest sub-bucket before publishing it, so that workers only ever record into a
+  // sub-bucket which covers the current fraction of the window.
+  const uint32_t next = (current_sub_bucket_.load(std::memory_order_relaxed) + 1) % NumSubBuckets;
+  for (std::atomic<uint32_t>& count : sub_buckets_[next]) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  current_sub_bucket_.store(next, std::memory_order_release);
+}
+
+void LatencyWindow::clear() {
+  for (SubBucket& sub_bucket : sub_buckets_) {
+    for (std::atomic<uint32_t>& count : sub_bucket) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+absl::optional<uint64_t> LatencyWindow::percentile(double percentile,
+                                                   uint64_t request_volume) const {
+  std::array<uint64_t, NumLatencyBuckets> counts{};
+  uint64_t total = 0;
+  for (const SubBucket& sub_bucket : sub_buckets_) {
+    for (uint32_t i = 0; i < NumLatencyBuckets; ++i) {
+      const uint32_t count = sub_bucket[i].load(std::memory_order_relaxed);
+      counts[i] += count;
+      total += count;
+    }
+  }
+  if (total == 0 || total < request_volume) {
+    return absl::nullopt;
+  }
+
+  const uint64_t rank = std::max<uint64_t>(std::ceil(total * percentile / 100), 1);
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < NumLatencyBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return bucketLowerBound(i);
+    }
+  }
+  return bucketLowerBound(NumLatencyBuckets - 1);
+}
+
+uint32_t LatencyWindow::bucketIndex(uint64_t ms) {
+  // Response times below 8ms have a bucket each. Above, each power of two is split into four
+  // buckets, using the two bits below the most significant one.
+  if (ms < 8) {
+    return ms;
+  }
+  const uint32_t msb = 63 - __builtin_clzll(ms);
+  return std::min<uint32_t>((msb - 1) * 4 + ((ms >> (msb - 2)) & 3), NumLatencyBuckets - 1);
+}
+
+uint64_t LatencyWindow::bucketLowerBound(uint32_t index) {
+  if (index < 8) {
+    return index;
+  }
+  return static_cast<uint64_t>(4 + index % 4) << (index / 4 - 1);
+}
+
 DetectorHostMonitorImpl::DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> detector,
                                                  HostSharedPtr host)
     : detector_(detector), host_(host),
@@ -46,6 +115,9 @@ DetectorHostMonitorImpl::DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> d
   put_result_func_ = detector->config().splitExternalLocalOriginErrors()
                          ? &DetectorHostMonitorImpl::putResultWithLocalExternalSplit
                          : &DetectorHostMonitorImpl::putResultNoLocalExternalSplit;
+  if (detector->config().latencyWindowMs() > 0) {
+    latency_window_ = std::make_unique<LatencyWindow>();
+  }
 }
 
 void DetectorHostMonitorImpl::eject(MonotonicTime ejection_time) {
@@ -53,6 +125,10 @@ void DetectorHostMonitorImpl::eject(MonotonicTime ejection_time) {
   host_.lock()->healthFlagSet(Host::HealthFlag::FAILED_OUTLIER_CHECK);
   num_ejections_++;
   last_ejection_time_ = ejection_time;
+  // The host is judged afresh once it is unejected.
+  if (latency_window_ != nullptr) {
+    latency_window_->clear();
+  }
 }
 
 void DetectorHostMonitorImpl::uneject(MonotonicTime unejection_time) {
@@ -64,6 +140,12 @@ void DetectorHostMonitorImpl::updateCurrentSuccessRateBucket() {
   local_origin_sr_monitor_.updateCurrentSuccessRateBucket();
 }
 
+void DetectorHostMonitorImpl::putResponseTime(std::chrono::milliseconds response_time) {
+  if (latency_window_ != nullptr) {
+    latency_window_->record(response_time);
+  }
+}
+
 void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
   external_origin_sr_monitor_.incTotalReqCounter();
   if (Http::CodeUtility::is5xx(response_code)) {
@@ -250,7 +332,19 @@ DetectorConfig::DetectorConfig(const envoy::config::cluster::v3::OutlierDetectio
                                           DEFAULT_ENFORCING_CONSECUTIVE_LOCAL_ORIGIN_FAILURE))),
       enforcing_local_origin_success_rate_(static_cast<uint64_t>(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, enforcing_local_origin_success_rate,
-                                          DEFAULT_ENFORCING_LOCAL_ORIGIN_SUCCESS_RATE))) {}
+                                          DEFAULT_ENFORCING_LOCAL_ORIGIN_SUCCESS_RATE))),
+      latency_window_ms_(
+          static_cast<uint64_t>(PROTOBUF_GET_MS_OR_DEFAULT(config, latency_window, 0))),
+      latency_percentile_(static_cast<uint64_t>(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, latency_percentile, DEFAULT_LATENCY_PERCENTILE))),
+      latency_threshold_percent_(static_cast<uint64_t>(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, latency_threshold_percent, DEFAULT_LATENCY_THRESHOLD_PERCENT))),
+      latency_minimum_hosts_(static_cast<uint64_t>(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, latency_minimum_hosts, DEFAULT_LATENCY_MINIMUM_HOSTS))),
+      latency_request_volume_(static_cast<uint64_t>(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, latency_request_volume, DEFAULT_LATENCY_REQUEST_VOLUME))),
+      enforcing_latency_(static_cast<uint64_t>(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, enforcing_latency, DEFAULT_ENFORCING_LATENCY))) {}
 
 DetectorImpl::DetectorImpl(const Cluster& cluster,
                            const envoy::config::cluster::v3::OutlierDetection& config,
@@ -259,6 +353,9 @@ DetectorImpl::DetectorImpl(const Cluster& cluster,
     : config_(config), dispatcher_(dispatcher), runtime_(runtime), time_source_(time_source),
       stats_(generateStats(cluster.info()->statsScope())),
       interval_timer_(dispatcher.createTimer([this]() -> void { onIntervalTimer(); })),
+      latency_timer_(config_.latencyWindowMs() > 0
+                         ? dispatcher.createTimer([this]() -> void { onLatencyTimer(); })
+                         : nullptr),
       event_logger_(event_logger) {
   // Insert success rate initial numbers for each type of SR detector
   external_origin_sr_num_ = {-1, -1};
@@ -310,6 +407,9 @@ void DetectorImpl::initialize(const Cluster& cluster) {
       });
 
   armIntervalTimer();
+  if (latency_timer_ != nullptr) {
+    armLatencyTimer();
+  }
 }
 
 void DetectorImpl::addHostMonitor(HostSharedPtr host) {
@@ -324,6 +424,11 @@ void DetectorImpl::armIntervalTimer() {
       runtime_.snapshot().getInteger("outlier_detection.interval_ms", config_.intervalMs())));
 }
 
+void DetectorImpl::armLatencyTimer() {
+  latency_timer_->enableTimer(std::chrono::milliseconds(
+      std::max<uint64_t>(config_.latencyWindowMs() / LatencyWindow::NumSubBuckets, 1)));
+}
+
 void DetectorImpl::checkHostForUneject(HostSharedPtr host, DetectorHostMonitorImpl* monitor,
                                        MonotonicTime now) {
   if (!host->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
@@ -446,15 +551,19 @@ void DetectorImpl::updateDetectedEjectionStats(
   }
 }
 
-void DetectorImpl::ejectHost(HostSharedPtr host,
-                             envoy::data::cluster::v2alpha::OutlierEjectionType type) {
+bool DetectorImpl::belowMaxEjectionPercent() {
   uint64_t max_ejection_percent = std::min<uint64_t>(
       100, runtime_.snapshot().getInteger("outlier_detection.max_ejection_percent",
                                           config_.maxEjectionPercent()));
   double ejected_percent = 100.0 * ejections_active_helper_.value() / host_monitors_.size();
   // Note this is not currently checked per-priority level, so it is possible
   // for outlier detection to eject all hosts at any given priority level.
-  if (ejected_percent < max_ejection_percent) {
+  return ejected_percent < max_ejection_percent;
+}
+
+void DetectorImpl::ejectHost(HostSharedPtr host,
+                             envoy::data::cluster::v2alpha::OutlierEjectionType type) {
+  if (belowMaxEjectionPercent()) {
     if (type == envoy::data::cluster::v2alpha::CONSECUTIVE_5XX ||
         type == envoy::data::cluster::v2alpha::SUCCESS_RATE) {
       // Deprecated counter, preserving old behaviour until it's removed.
@@ -478,6 +587,23 @@ void DetectorImpl::ejectHost(HostSharedPtr host,
   }
 }
 
+void DetectorImpl::ejectHostForLatency(HostSharedPtr host) {
+  // Latency ejections have no type in the outlier detection event log, so unlike the other
+  // ejections they are only reported through stats.
+  if (!belowMaxEjectionPercent()) {
+    stats_.ejections_overflow_.inc();
+    return;
+  }
+  if (runtime_.snapshot().featureEnabled("outlier_detection.enforcing_latency",
+                                         config_.enforcingLatency())) {
+    ejections_active_helper_.inc();
+    stats_.ejections_enforced_total_.inc();
+    stats_.ejections_enforced_latency_.inc();
+    host_monitors_[host]->eject(time_source_.monotonicTime());
+    runCallbacks(host);
+  }
+}
+
 DetectionStats DetectorImpl::generateStats(Stats::Scope& scope) {
   std::string prefix("outlier_detection.");
   return {ALL_OUTLIER_DETECTION_STATS(POOL_COUNTER_PREFIX(scope, prefix),
@@ -706,6 +832,65 @@ void DetectorImpl::onIntervalTimer() {
   armIntervalTimer();
 }
 
+void DetectorImpl::processLatencyEjections() {
+  const uint64_t minimum_hosts = runtime_.snapshot().getInteger(
+      "outlier_detection.latency_minimum_hosts", config_.latencyMinimumHosts());
+  if (host_monitors_.size() < minimum_hosts) {
+    return;
+  }
+  const uint64_t request_volume = runtime_.snapshot().getInteger(
+      "outlier_detection.latency_request_volume", config_.latencyRequestVolume());
+  const double percentile = std::min<uint64_t>(
+      100, runtime_.snapshot().getInteger("outlier_detection.latency_percentile",
+                                          config_.latencyPercentile()));
+
+  std::vector<std::pair<HostSharedPtr, uint64_t>> host_latencies;
+  for (const auto& host : host_monitors_) {
+    // Ejected hosts don't take part, so that they don't skew the median.
+    if (host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      continue;
+    }
+    const absl::optional<uint64_t> latency =
+        host.second->latencyWindow()->percentile(percentile, request_volume);
+    if (latency.has_value()) {
+      host_latencies.emplace_back(host.first, latency.value());
+    }
+  }
+  if (host_latencies.empty() || host_latencies.size() < minimum_hosts) {
+    return;
+  }
+
+  std::vector<uint64_t> latencies;
+  latencies.reserve(host_latencies.size());
+  for (const auto& host_latency : host_latencies) {
+    latencies.push_back(host_latency.second);
+  }
+  auto median = latencies.begin() + latencies.size() / 2;
+  std::nth_element(latencies.begin(), median, latencies.end());
+  // A median below a millisecond would make any host with a response time of a few milliseconds
+  // an outlier.
+  const uint64_t threshold =
+      std::max<uint64_t>(*median, 1) *
+      runtime_.snapshot().getInteger("outlier_detection.latency_threshold_percent",
+                                     config_.latencyThresholdPercent()) /
+      100;
+
+  for (const auto& host_latency : host_latencies) {
+    if (host_latency.second > threshold) {
+      stats_.ejections_detected_latency_.inc();
+      ejectHostForLatency(host_latency.first);
+    }
+  }
+}
+
+void DetectorImpl::onLatencyTimer() {
+  processLatencyEjections();
+  for (const auto& host : host_monitors_) {
+    host.second->latencyWindow()->advance();
+  }
+  armLatencyTimer();
+}
+
 void DetectorImpl::runCallbacks(HostSharedPtr host) {
   for (const ChangeStateCb& cb : callbacks_) {
     cb(host);
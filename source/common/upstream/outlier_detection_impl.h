@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -132,6 +133,63 @@ private:
   double success_rate_;
 };
 
+/**
+ * Sliding window of the response times of a host, made of a ring of sub-buckets which each cover a
+ * fraction of the window. Workers record response times into the current sub-bucket without
+ * locking, and the main thread advances the ring, which drops the oldest sub-bucket. Response
+ * times are counted in log-linear buckets with four buckets per power of two, which bounds the
+ * relative error of a percentile to 25%.
+ */
+class LatencyWindow {
+public:
+  static constexpr uint32_t NumSubBuckets = 10;
+  static constexpr uint32_t NumLatencyBuckets = 64;
+
+  LatencyWindow() { clear(); }
+
+  /**
+   * Records a response time into the current sub-bucket. May be called from any thread.
+   */
+  void record(std::chrono::milliseconds response_time);
+
+  /**
+   * Clears the oldest sub-bucket and makes it the current one. Only called from the main thread.
+   */
+  void advance();
+
+  /**
+   * Clears all sub-buckets. Only called from the main thread.
+   */
+  void clear();
+
+  /**
+   * @param percentile the percentile to compute, in [0, 100].
+   * @param request_volume the minimum number of response times the window must hold in order to
+   *                       compute a significant percentile.
+   * @return the lower bound in milliseconds of the bucket holding the percentile of the response
+   *         times in the window, or an empty optional if there were not enough responses.
+   */
+  absl::optional<uint64_t> percentile(double percentile, uint64_t request_volume) const;
+
+  /**
+   * @return the index of the bucket counting a response time of `ms` milliseconds.
+   */
+  static uint32_t bucketIndex(uint64_t ms);
+
+  /**
+   * @return the smallest response time in milliseconds counted by the bucket at `index`.
+   */
+  static uint64_t bucketLowerBound(uint32_t index);
+
+private:
+  using SubBucket = std::array<std::atomic<uint32_t>, NumLatencyBuckets>;
+
+  std::array<SubBucket, NumSubBuckets> sub_buckets_;
+  std::atomic<uint32_t> current_sub_bucket_{0};
+};
+
+using LatencyWindowPtr = std::unique_ptr<LatencyWindow>;
+
 class DetectorImpl;
 
 /**
@@ -153,7 +211,7 @@ public:
   uint32_t numEjections() override { return num_ejections_; }
   void putHttpResponseCode(uint64_t response_code) override;
   void putResult(Result result, absl::optional<uint64_t> code) override;
-  void putResponseTime(std::chrono::milliseconds) override {}
+  void putResponseTime(std::chrono::milliseconds response_time) override;
   const absl::optional<MonotonicTime>& lastEjectionTime() override { return last_ejection_time_; }
   const absl::optional<MonotonicTime>& lastUnejectionTime() override {
     return last_unejection_time_;
@@ -182,6 +240,9 @@ public:
   void localOriginFailure();
   void localOriginNoFailure();
 
+  // The response time window of the host, or nullptr if latency based ejection is disabled.
+  LatencyWindow* latencyWindow() { return latency_window_.get(); }
+
 private:
   std::weak_ptr<DetectorImpl> detector_;
   std::weak_ptr<Host> host_;
@@ -204,6 +265,10 @@ private:
   SuccessRateMonitor external_origin_sr_monitor_;
   SuccessRateMonitor local_origin_sr_monitor_;
 
+  // Only set on construction, so that workers can record into it while the main thread advances
+  // it.
+  LatencyWindowPtr latency_window_;
+
   void putResultNoLocalExternalSplit(Result result, absl::optional<uint64_t> code);
   void putResultWithLocalExternalSplit(Result result, absl::optional<uint64_t> code);
   std::function<void(DetectorHostMonitorImpl*, Result, absl::optional<uint64_t> code)>
@@ -229,6 +294,8 @@ private:
   COUNTER(ejections_enforced_local_origin_success_rate)                                            \
   COUNTER(ejections_detected_local_origin_failure_percentage)                                      \
   COUNTER(ejections_enforced_local_origin_failure_percentage)                                      \
+  COUNTER(ejections_detected_latency)                                                              \
+  COUNTER(ejections_enforced_latency)                                                              \
   COUNTER(ejections_enforced_total)                                                                \
   COUNTER(ejections_overflow)                                                                      \
   COUNTER(ejections_success_rate)                                                                  \
@@ -275,6 +342,12 @@ public:
     return enforcing_consecutive_local_origin_failure_;
   }
   uint64_t enforcingLocalOriginSuccessRate() const { return enforcing_local_origin_success_rate_; }
+  uint64_t latencyWindowMs() const { return latency_window_ms_; }
+  uint64_t latencyPercentile() const { return latency_percentile_; }
+  uint64_t latencyThresholdPercent() const { return latency_threshold_percent_; }
+  uint64_t latencyMinimumHosts() const { return latency_minimum_hosts_; }
+  uint64_t latencyRequestVolume() const { return latency_request_volume_; }
+  uint64_t enforcingLatency() const { return enforcing_latency_; }
 
 private:
   const uint64_t interval_ms_;
@@ -297,6 +370,12 @@ private:
   const uint64_t consecutive_local_origin_failure_;
   const uint64_t enforcing_consecutive_local_origin_failure_;
   const uint64_t enforcing_local_origin_success_rate_;
+  const uint64_t latency_window_ms_;
+  const uint64_t latency_percentile_;
+  const uint64_t latency_threshold_percent_;
+  const uint64_t latency_minimum_hosts_;
+  const uint64_t latency_request_volume_;
+  const uint64_t enforcing_latency_;
 
   static const uint64_t DEFAULT_INTERVAL_MS = 10000;
   static const uint64_t DEFAULT_BASE_EJECTION_TIME_MS = 30000;
@@ -317,6 +396,11 @@ private:
   static const uint64_t DEFAULT_CONSECUTIVE_LOCAL_ORIGIN_FAILURE = 5;
   static const uint64_t DEFAULT_ENFORCING_CONSECUTIVE_LOCAL_ORIGIN_FAILURE = 100;
   static const uint64_t DEFAULT_ENFORCING_LOCAL_ORIGIN_SUCCESS_RATE = 100;
+  static const uint64_t DEFAULT_LATENCY_PERCENTILE = 99;
+  static const uint64_t DEFAULT_LATENCY_THRESHOLD_PERCENT = 300;
+  static const uint64_t DEFAULT_LATENCY_MINIMUM_HOSTS = 5;
+  static const uint64_t DEFAULT_LATENCY_REQUEST_VOLUME = 100;
+  static const uint64_t DEFAULT_ENFORCING_LATENCY = 100;
 };
 
 /**
@@ -374,8 +458,11 @@ private:
 
   void addHostMonitor(HostSharedPtr host);
   void armIntervalTimer();
+  void armLatencyTimer();
+  bool belowMaxEjectionPercent();
   void checkHostForUneject(HostSharedPtr host, DetectorHostMonitorImpl* monitor, MonotonicTime now);
   void ejectHost(HostSharedPtr host, envoy::data::cluster::v2alpha::OutlierEjectionType type);
+  void ejectHostForLatency(HostSharedPtr host);
   static DetectionStats generateStats(Stats::Scope& scope);
   void initialize(const Cluster& cluster);
   void onConsecutiveErrorWorker(HostSharedPtr host,
@@ -383,6 +470,8 @@ private:
   void notifyMainThreadConsecutiveError(HostSharedPtr host,
                                         envoy::data::cluster::v2alpha::OutlierEjectionType type);
   void onIntervalTimer();
+  void onLatencyTimer();
+  void processLatencyEjections();
   void runCallbacks(HostSharedPtr host);
   bool enforceEjection(envoy::data::cluster::v2alpha::OutlierEjectionType type);
   void updateEnforcedEjectionStats(envoy::data::cluster::v2alpha::OutlierEjectionType type);
@@ -413,6 +502,9 @@ private:
   DetectionStats stats_;
   EjectionsActiveHelper ejections_active_helper_{stats_.ejections_active_};
   Event::TimerPtr interval_timer_;
+  // Advances the latency windows of the hosts every sub-bucket, if latency based ejection is
+  // enabled.
+  Event::TimerPtr latency_timer_;
   std::list<ChangeStateCb> callbacks_;
   absl::node_hash_map<HostSharedPtr, DetectorHostMonitorImpl*> host_monitors_;
   EventLoggerSharedPtr event_logger_;
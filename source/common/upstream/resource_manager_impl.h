@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <memory>
@@ -12,30 +13,64 @@
 
 #include "common/common/assert.h"
 #include "common/common/basic_resource_impl.h"
+#include "common/common/sharded_counter.h"
+
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Upstream {
 
 struct ManagedResourceImpl : public BasicResourceLimitImpl {
   ManagedResourceImpl(uint64_t max, Runtime::Loader& runtime, const std::string& runtime_key,
-                      Stats::Gauge& open_gauge, Stats::Gauge& remaining)
+                      Stats::Gauge& open_gauge, Stats::Gauge& remaining,
+                      bool per_worker_counters = false)
       : BasicResourceLimitImpl(max, runtime, runtime_key), open_gauge_(open_gauge),
-        remaining_(remaining) {
+        remaining_(remaining),
+        sharded_count_(per_worker_counters
+                           ? std::make_unique<ShardedCounter>(ShardedCounter::defaultNumSlots())
+                           : nullptr) {
     remaining_.set(max);
   }
 
   // Upstream::Resource
-  bool canCreate() override { return current_ < max(); }
+  bool canCreate() override {
+    if (sharded_count_ == nullptr) {
+      return current_ < max();
+    }
+    // The exact count exceeds the published count by at most the unpublished slack, so the slots
+    // only need to be walked once the count nears the limit.
+    const uint64_t max_copy = max();
+    const int64_t upper_bound = published_.load() + unpublishedSlack();
+    if (upper_bound < 0 || static_cast<uint64_t>(upper_bound) < max_copy) {
+      return true;
+    }
+    return count() < max_copy;
+  }
   void inc() override {
+    if (sharded_count_ != nullptr) {
+      addSharded(1);
+      return;
+    }
     BasicResourceLimitImpl::inc();
     updateRemaining();
     open_gauge_.set(BasicResourceLimitImpl::canCreate() ? 0 : 1);
   }
   void decBy(uint64_t amount) override {
+    if (sharded_count_ != nullptr) {
+      addSharded(-static_cast<int64_t>(amount));
+      return;
+    }
     BasicResourceLimitImpl::decBy(amount);
     updateRemaining();
     open_gauge_.set(BasicResourceLimitImpl::canCreate() ? 0 : 1);
   }
+  uint64_t count() const override {
+    if (sharded_count_ == nullptr) {
+      return current_.load();
+    }
+    const int64_t count = published_.load() + sharded_count_->sum();
+    return count > 0 ? count : 0;
+  }
 
   /**
    * We set the gauge instead of incrementing and decrementing because,
@@ -61,6 +96,30 @@ struct ManagedResourceImpl : public BasicResourceLimitImpl {
    * The number of resources remaining before the circuit breaker opens.
    */
   Stats::Gauge& remaining_;
+
+private:
+  // The amount by which a slot of a sharded count may move before it is published.
+  static constexpr int64_t PublishThreshold = 4;
+
+  int64_t unpublishedSlack() const { return sharded_count_->numSlots() * (PublishThreshold - 1); }
+
+  // With per worker counters, every worker counts in its own slot and only publishes to the shared
+  // count once its slot has moved by PublishThreshold, which is also when the gauges are updated.
+  void addSharded(int64_t amount) {
+    const int64_t pending = sharded_count_->add(amount);
+    if (pending < PublishThreshold && pending > -PublishThreshold) {
+      return;
+    }
+    const int64_t published = published_ += sharded_count_->take();
+    const uint64_t approximate_count = published > 0 ? published : 0;
+    const uint64_t max_copy = max();
+    remaining_.set(max_copy > approximate_count ? max_copy - approximate_count : 0);
+    open_gauge_.set(approximate_count < max_copy ? 0 : 1);
+  }
+
+  // Only set with per worker counters, in which case current_ is unused.
+  const std::unique_ptr<ShardedCounter> sharded_count_;
+  std::atomic<int64_t> published_{0};
 };
 
 /**
@@ -71,6 +130,9 @@ struct ManagedResourceImpl : public BasicResourceLimitImpl {
  *    occur during high contention.
  * 2) Though atomics are used, it is possible for resources to temporarily go above the supplied
  *    maximums. This should not effect overall behavior.
+ * 3) With per worker counters, the counts are sharded so that the workers of a busy cluster don't
+ *    all update the same cache lines. The counts are then only computed exactly near the limits,
+ *    and the gauges follow them approximately.
  */
 class ResourceManagerImpl : public ResourceManager {
 public:
@@ -78,19 +140,21 @@ public:
                       uint64_t max_connections, uint64_t max_pending_requests,
                       uint64_t max_requests, uint64_t max_retries, uint64_t max_connection_pools,
                       ClusterCircuitBreakersStats cb_stats, absl::optional<double> budget_percent,
-                      absl::optional<uint32_t> min_retry_concurrency)
+                      absl::optional<uint32_t> min_retry_concurrency, bool per_worker_counters)
       : connections_(max_connections, runtime, runtime_key + "max_connections", cb_stats.cx_open_,
-                     cb_stats.remaining_cx_),
+                     cb_stats.remaining_cx_, per_worker_counters),
         pending_requests_(max_pending_requests, runtime, runtime_key + "max_pending_requests",
-                          cb_stats.rq_pending_open_, cb_stats.remaining_pending_),
+                          cb_stats.rq_pending_open_, cb_stats.remaining_pending_,
+                          per_worker_counters),
         requests_(max_requests, runtime, runtime_key + "max_requests", cb_stats.rq_open_,
-                  cb_stats.remaining_rq_),
+                  cb_stats.remaining_rq_, per_worker_counters),
         connection_pools_(max_connection_pools, runtime, runtime_key + "max_connection_pools",
-                          cb_stats.cx_pool_open_, cb_stats.remaining_cx_pools_),
+                          cb_stats.cx_pool_open_, cb_stats.remaining_cx_pools_,
+                          per_worker_counters),
         retries_(budget_percent, min_retry_concurrency, max_retries, runtime,
                  runtime_key + "retry_budget.", runtime_key + "max_retries",
                  cb_stats.rq_retry_open_, cb_stats.remaining_retries_, requests_,
-                 pending_requests_) {}
+                 pending_requests_, per_worker_counters) {}
 
   // Upstream::ResourceManager
   ResourceLimit& connections() override { return connections_; }
@@ -107,9 +171,9 @@ private:
                     Runtime::Loader& runtime, const std::string& retry_budget_runtime_key,
                     const std::string& max_retries_runtime_key, Stats::Gauge& open_gauge,
                     Stats::Gauge& remaining, const ResourceLimit& requests,
-                    const ResourceLimit& pending_requests)
-        : runtime_(runtime),
-          max_retry_resource_(max_retries, runtime, max_retries_runtime_key, open_gauge, remaining),
+                    const ResourceLimit& pending_requests, bool per_worker_counters)
+        : runtime_(runtime), max_retry_resource_(max_retries, runtime, max_retries_runtime_key,
+                                                 open_gauge, remaining, per_worker_counters),
           budget_percent_(budget_percent), min_retry_concurrency_(min_retry_concurrency),
           budget_percent_key_(retry_budget_runtime_key + "budget_percent"),
           min_retry_concurrency_key_(retry_budget_runtime_key + "min_retry_concurrency"),
@@ -117,11 +181,12 @@ private:
 
     // Envoy::ResourceLimit
     bool canCreate() override {
-      if (!useRetryBudget()) {
+      const absl::optional<uint64_t> budget = retryBudget();
+      if (!budget.has_value()) {
         return max_retry_resource_.canCreate();
       }
-      clearRemainingGauge();
-      return count() < max();
+      remaining_.set(0);
+      return count() < budget.value();
     }
     void inc() override {
       max_retry_resource_.inc();
@@ -136,37 +201,49 @@ private:
       clearRemainingGauge();
     }
     uint64_t max() override {
-      if (!useRetryBudget()) {
+      const absl::optional<uint64_t> budget = retryBudget();
+      if (!budget.has_value()) {
         return max_retry_resource_.max();
       }
+      remaining_.set(0);
+      return budget.value();
+    }
+    uint64_t count() const override { return max_retry_resource_.count(); }
+
+  private:
+    bool useRetryBudget(const Runtime::Snapshot& snapshot) const {
+      // The configured budget is checked first, as it saves the runtime lookups.
+      return budget_percent_ || min_retry_concurrency_ ||
+             snapshot.get(budget_percent_key_).has_value() ||
+             snapshot.get(min_retry_concurrency_key_).has_value();
+    }
+
+    // Returns the number of concurrent retries the retry budget allows for, from the requests
+    // currently active or pending on the cluster, or absl::nullopt if the retry budget is not in
+    // use. The runtime snapshot is only fetched once, as this is checked for every retry.
+    absl::optional<uint64_t> retryBudget() const {
+      const Runtime::Snapshot& snapshot = runtime_.snapshot();
+      if (!useRetryBudget(snapshot)) {
+        return absl::nullopt;
+      }
 
       const uint64_t current_active = requests_.count() + pending_requests_.count();
-      const double budget_percent = runtime_.snapshot().getDouble(
+      const double budget_percent = snapshot.getDouble(
           budget_percent_key_, budget_percent_ ? *budget_percent_ : 20.0);
-      const uint32_t min_retry_concurrency = runtime_.snapshot().getInteger(
+      const uint32_t min_retry_concurrency = snapshot.getInteger(
           min_retry_concurrency_key_, min_retry_concurrency_ ? *min_retry_concurrency_ : 3);
 
-      clearRemainingGauge();
-
       // We enforce that the retry concurrency is never allowed to go below the
       // min_retry_concurrency, even if the configured percent of the current active requests
       // yields a value that is smaller.
       return std::max<uint64_t>(budget_percent / 100.0 * current_active, min_retry_concurrency);
     }
-    uint64_t count() const override { return max_retry_resource_.count(); }
-
-  private:
-    bool useRetryBudget() const {
-      return runtime_.snapshot().get(budget_percent_key_).has_value() ||
-             runtime_.snapshot().get(min_retry_concurrency_key_).has_value() || budget_percent_ ||
-             min_retry_concurrency_;
-    }
 
     // If the retry budget is in use, the stats tracking remaining retries do not make sense since
     // they would dependent on other resources that can change without a call to this object.
     // Therefore, the gauge should just be reset to 0.
     void clearRemainingGauge() {
-      if (useRetryBudget()) {
+      if (useRetryBudget(runtime_.snapshot())) {
         remaining_.set(0);
       }
     }
@@ -14,7 +14,7 @@
 #include "common/upstream/maglev_lb.h"
 #include "common/upstream/ring_hash_lb.h"
 
-#include "absl/container/node_hash_set.h"
+#include "absl/container/flat_hash_set.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -39,6 +39,12 @@ SubsetLoadBalancer::SubsetLoadBalancer(
       scale_locality_weight_(subsets.scaleLocalityWeight()), list_as_any_(subsets.listAsAny()) {
   ASSERT(subsets.isEnabled());
 
+  for (const auto& subset_selector : subset_selectors_) {
+    for (const auto& key : subset_selector->selectorKeys()) {
+      key_ids_.try_emplace(key, key_ids_.size());
+    }
+  }
+
   if (fallback_policy_ != envoy::config::cluster::v3::Cluster::LbSubsetConfig::NO_FALLBACK) {
     HostPredicate predicate;
     if (fallback_policy_ == envoy::config::cluster::v3::Cluster::LbSubsetConfig::ANY_ENDPOINT) {
@@ -76,16 +82,15 @@ SubsetLoadBalancer::SubsetLoadBalancer(
           // the right subsets.
           //
           // Note, note, note: if metadata for existing endpoints changed _and_ hosts were also
-          // added or removed, we don't need to hit this path. That's fine, given that
-          // findOrCreateSubset() will be called from processSubsets because it'll be triggered by
-          // either hosts_added or hosts_removed. That's where the new subsets will be created.
+          // added or removed, we don't need to hit this path. That's fine, given that update()
+          // re-evaluates the subsets of every host whose metadata changed.
           refreshSubsets(priority);
         } else {
           // This is a regular update with deltas.
           update(priority, hosts_added, hosts_removed);
         }
 
-        purgeEmptySubsets(subsets_);
+        purgeEmptySubsets();
       });
 }
 
@@ -93,7 +98,7 @@ SubsetLoadBalancer::~SubsetLoadBalancer() {
   original_priority_set_callback_handle_->remove();
 
   // Ensure gauges reflect correct values.
-  forEachSubset(subsets_, [&](LbSubsetEntryPtr entry) {
+  forEachSubset([&](LbSubsetEntryPtr entry) {
     if (entry->active()) {
       stats_.lb_subsets_removed_.inc();
       stats_.lb_subsets_active_.dec();
@@ -110,7 +115,9 @@ void SubsetLoadBalancer::refreshSubsets() {
 void SubsetLoadBalancer::refreshSubsets(uint32_t priority) {
   const auto& host_sets = original_priority_set_.hostSetsPerPriority();
   ASSERT(priority < host_sets.size());
-  update(priority, host_sets[priority]->hosts(), {});
+  const HostVector& hosts = host_sets[priority]->hosts();
+  refreshHostSubsets(hosts);
+  updateSubsets(priority, hosts, {});
 }
 
 void SubsetLoadBalancer::initSubsetAnyOnce() {
@@ -293,43 +300,31 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
   return entry->priority_subset_->lb_->chooseHost(context);
 }
 
-// Iterates over the given metadata match criteria (which must be lexically sorted by key) and find
-// a matching LbSubsetEntryPtr, if any.
+// Interns the given metadata match criteria (which must be lexically sorted by key) and looks up
+// the matching LbSubsetEntryPtr, if any.
 SubsetLoadBalancer::LbSubsetEntryPtr SubsetLoadBalancer::findSubset(
     const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& match_criteria) {
-  const LbSubsetMap* subsets = &subsets_;
-
   // Because the match_criteria and the host metadata used to populate subsets_ are sorted in the
-  // same order, we can iterate over the criteria and perform a lookup for each key and value,
-  // starting with the root LbSubsetMap and using the previous iteration's LbSubsetMap thereafter
-  // (tracked in subsets). If ever a criterion's key or value is not found, there is no subset for
-  // this criteria. If we reach the last criterion, we've found the LbSubsetEntry for the criteria,
-  // which may or may not have a subset attached to it.
-  for (uint32_t i = 0; i < match_criteria.size(); i++) {
-    const Router::MetadataMatchCriterion& match_criterion = *match_criteria[i];
-    const auto& subset_it = subsets->find(match_criterion.name());
-    if (subset_it == subsets->end()) {
-      // No subsets with this key (at this level in the hierarchy).
-      break;
-    }
-
-    const ValueSubsetMap& vs_map = subset_it->second;
-    const auto& vs_it = vs_map.find(match_criterion.value());
-    if (vs_it == vs_map.end()) {
-      // No subsets with this value.
-      break;
+  // same order, the interned criteria are equal to the key of the matching subset. If any
+  // criterion's key or value has never been seen on a host, there is no subset for this criteria.
+  SubsetKey subset_key;
+  subset_key.reserve(match_criteria.size());
+  for (const auto& match_criterion : match_criteria) {
+    const auto key_it = key_ids_.find(match_criterion->name());
+    if (key_it == key_ids_.end()) {
+      return nullptr;
     }
 
-    const LbSubsetEntryPtr& entry = vs_it->second;
-    if (i + 1 == match_criteria.size()) {
-      // We've reached the end of the criteria, and they all matched.
-      return entry;
+    const auto value_it = value_ids_.find(match_criterion->value());
+    if (value_it == value_ids_.end()) {
+      return nullptr;
     }
 
-    subsets = &entry->children_;
+    subset_key.push_back(static_cast<uint64_t>(key_it->second) << 32 | value_it->second);
   }
 
-  return nullptr;
+  const auto it = subsets_.find(subset_key);
+  return it != subsets_.end() ? it->second : nullptr;
 }
 
 void SubsetLoadBalancer::updateFallbackSubset(uint32_t priority, const HostVector& hosts_added,
@@ -358,61 +353,18 @@ void SubsetLoadBalancer::updateFallbackSubset(uint32_t priority, const HostVecto
   ASSERT(panic_mode_subset_ == nullptr || panic_mode_subset_ == subset_any_);
 }
 
-// Iterates over the added and removed hosts, looking up an LbSubsetEntryPtr for each. For every
-// unique LbSubsetEntryPtr found, it either invokes new_cb or update_cb depending on whether the
-// LbSubsetEntryPtr is already initialized (update_cb) or not (new_cb). In addition, update_cb is
-// invoked for any otherwise unmodified but active and initialized LbSubsetEntryPtr to allow host
-// health to be updated.
-void SubsetLoadBalancer::processSubsets(
-    const HostVector& hosts_added, const HostVector& hosts_removed,
-    std::function<void(LbSubsetEntryPtr)> update_cb,
-    std::function<void(LbSubsetEntryPtr, HostPredicate, const SubsetMetadata&)> new_cb) {
-  absl::node_hash_set<LbSubsetEntryPtr> subsets_modified;
-
-  std::pair<const HostVector&, bool> steps[] = {{hosts_added, true}, {hosts_removed, false}};
-  for (const auto& step : steps) {
-    const auto& hosts = step.first;
-    const bool adding_hosts = step.second;
-    for (const auto& host : hosts) {
-      for (const auto& subset_selector : subset_selectors_) {
-        const auto& keys = subset_selector->selectorKeys();
-        // For each host, for each subset key, attempt to extract the metadata corresponding to the
-        // key from the host.
-        std::vector<SubsetMetadata> all_kvs = extractSubsetMetadata(keys, *host);
-        for (const auto& kvs : all_kvs) {
-          // The host has metadata for each key, find or create its subset.
-          auto entry = findOrCreateSubset(subsets_, kvs, 0);
-          if (entry != nullptr) {
-            if (subsets_modified.find(entry) != subsets_modified.end()) {
-              // We've already invoked the callback for this entry.
-              continue;
-            }
-            subsets_modified.emplace(entry);
-
-            if (entry->initialized()) {
-              update_cb(entry);
-            } else {
-              HostPredicate predicate = [this, kvs](const Host& host) -> bool {
-                return hostMatches(kvs, host);
-              };
-              if (adding_hosts) {
-                new_cb(entry, predicate, kvs);
-              }
-            }
-          }
-        }
+// Visits every subset, invoking new_cb for subsets that gained their first hosts and update_cb for
+// all other subsets with hosts. Subsets are updated even when none of their hosts were added or
+// removed to allow host health to be updated.
+void SubsetLoadBalancer::processSubsets(std::function<void(LbSubsetEntryPtr)> update_cb,
+                                        std::function<void(LbSubsetEntryPtr)> new_cb) {
+  forEachSubset([&](LbSubsetEntryPtr entry) {
+    if (entry->initialized()) {
+      if (entry->active() || !entry->hosts_.empty()) {
+        update_cb(entry);
       }
-    }
-  }
-
-  forEachSubset(subsets_, [&](LbSubsetEntryPtr entry) {
-    if (subsets_modified.find(entry) != subsets_modified.end()) {
-      // Already handled due to hosts being added or removed.
-      return;
-    }
-
-    if (entry->initialized() && entry->active()) {
-      update_cb(entry);
+    } else if (!entry->hosts_.empty()) {
+      new_cb(entry);
     }
   });
 }
@@ -421,19 +373,39 @@ void SubsetLoadBalancer::processSubsets(
 // new subsets as necessary.
 void SubsetLoadBalancer::update(uint32_t priority, const HostVector& hosts_added,
                                 const HostVector& hosts_removed) {
+  for (const auto& host : hosts_added) {
+    addHostSubsets(*host);
+  }
+  // Metadata of the remaining hosts may have changed along with the deltas.
+  refreshHostSubsets(original_priority_set_.hostSetsPerPriority()[priority]->hosts());
+
+  updateSubsets(priority, hosts_added, hosts_removed);
+
+  // Removed hosts stay members of their subsets until the subsets have been updated, so that the
+  // subsets report them as removed.
+  for (const auto& host : hosts_removed) {
+    removeHostSubsets(*host);
+  }
+}
+
+void SubsetLoadBalancer::updateSubsets(uint32_t priority, const HostVector& hosts_added,
+                                       const HostVector& hosts_removed) {
   updateFallbackSubset(priority, hosts_added, hosts_removed);
 
   processSubsets(
-      hosts_added, hosts_removed,
       [&](LbSubsetEntryPtr entry) {
         entry->priority_subset_->update(priority, hosts_added, hosts_removed);
       },
-      [&](LbSubsetEntryPtr entry, HostPredicate predicate, const SubsetMetadata& kvs) {
-        ENVOY_LOG(debug, "subset lb: creating load balancer for {}", describeMetadata(kvs));
-
-        // Initialize new entry with hosts and update stats. (An uninitialized entry
-        // with only removed hosts is a degenerate case and we leave the entry
-        // uninitialized.)
+      [&](LbSubsetEntryPtr entry) {
+        ENVOY_LOG(debug, "subset lb: creating load balancer for {}",
+                  describeMetadata(entry->metadata_));
+
+        // Initialize new entry with hosts and update stats. Membership of the entry's host set
+        // is the predicate, which saves matching metadata for every host on every update.
+        const LbSubsetEntry* raw_entry = entry.get();
+        HostPredicate predicate = [raw_entry](const Host& host) -> bool {
+          return raw_entry->hasHost(host);
+        };
         entry->priority_subset_ = std::make_shared<PrioritySubsetImpl>(
             *this, predicate, locality_weight_aware_, scale_locality_weight_);
         stats_.lb_subsets_active_.inc();
@@ -441,6 +413,63 @@ void SubsetLoadBalancer::update(uint32_t priority, const HostVector& hosts_added
       });
 }
 
+void SubsetLoadBalancer::addHostSubsets(const Host& host) {
+  HostSubsets& host_subsets = host_subsets_[&host];
+  if (host_subsets.ref_count_++ == 0) {
+    assignHostSubsets(host, host_subsets);
+  }
+}
+
+void SubsetLoadBalancer::removeHostSubsets(const Host& host) {
+  const auto it = host_subsets_.find(&host);
+  if (it == host_subsets_.end() || --it->second.ref_count_ > 0) {
+    return;
+  }
+
+  for (const auto& entry : it->second.entries_) {
+    entry->hosts_.erase(&host);
+  }
+  host_subsets_.erase(it);
+}
+
+// Re-evaluates the subsets of the given hosts whose metadata changed since their subsets were
+// computed. This is a pointer comparison for hosts whose metadata did not change.
+void SubsetLoadBalancer::refreshHostSubsets(const HostVector& hosts) {
+  for (const auto& host : hosts) {
+    const auto it = host_subsets_.find(host.get());
+    if (it == host_subsets_.end()) {
+      // The host was never reported as added.
+      addHostSubsets(*host);
+      continue;
+    }
+
+    HostSubsets& host_subsets = it->second;
+    if (host_subsets.metadata_ == host->metadata()) {
+      continue;
+    }
+
+    for (const auto& entry : host_subsets.entries_) {
+      entry->hosts_.erase(host.get());
+    }
+    assignHostSubsets(*host, host_subsets);
+  }
+}
+
+void SubsetLoadBalancer::assignHostSubsets(const Host& host, HostSubsets& host_subsets) {
+  host_subsets.metadata_ = host.metadata();
+  host_subsets.entries_.clear();
+  for (const auto& subset_selector : subset_selectors_) {
+    // For each subset selector, attempt to extract the metadata corresponding to its keys from
+    // the host. The host belongs to the subset of each resulting set of key-values.
+    for (const auto& kvs : extractSubsetMetadata(subset_selector->selectorKeys(), host)) {
+      LbSubsetEntryPtr entry = findOrCreateSubset(kvs);
+      if (entry->hosts_.insert(&host).second) {
+        host_subsets.entries_.emplace_back(std::move(entry));
+      }
+    }
+  }
+}
+
 bool SubsetLoadBalancer::hostMatches(const SubsetMetadata& kvs, const Host& host) {
   return Config::Metadata::metadataLabelMatch(
       kvs, host.metadata().get(), Config::MetadataFilters::get().ENVOY_LB, list_as_any_);
@@ -529,92 +558,51 @@ std::string SubsetLoadBalancer::describeMetadata(const SubsetLoadBalancer::Subse
   return buf.str();
 }
 
-// Given a vector of key-values (from extractSubsetMetadata), recursively finds the matching
+// Given a vector of key-values (from extractSubsetMetadata), finds or creates the matching
 // LbSubsetEntryPtr.
 SubsetLoadBalancer::LbSubsetEntryPtr
-SubsetLoadBalancer::findOrCreateSubset(LbSubsetMap& subsets, const SubsetMetadata& kvs,
-                                       uint32_t idx) {
-  ASSERT(idx < kvs.size());
-
-  const std::string& name = kvs[idx].first;
-  const ProtobufWkt::Value& pb_value = kvs[idx].second;
-  const HashedValue value(pb_value);
-
-  LbSubsetEntryPtr entry;
-
-  const auto& kv_it = subsets.find(name);
-
-  if (kv_it != subsets.end()) {
-    ValueSubsetMap& value_subset_map = kv_it->second;
-    const auto vs_it = value_subset_map.find(value);
-    if (vs_it != value_subset_map.end()) {
-      entry = vs_it->second;
-    }
-  }
-
-  if (!entry) {
+SubsetLoadBalancer::findOrCreateSubset(const SubsetMetadata& kvs) {
+  SubsetKey subset_key;
+  subset_key.reserve(kvs.size());
+  for (const auto& kv : kvs) {
+    const auto key_it = key_ids_.find(kv.first);
+    ASSERT(key_it != key_ids_.end());
+    // Value ids are never released: there are as many as distinct values seen on hosts.
+    const uint32_t value_id =
+        value_ids_.try_emplace(HashedValue(kv.second), value_ids_.size()).first->second;
+    subset_key.push_back(static_cast<uint64_t>(key_it->second) << 32 | value_id);
+  }
+
+  LbSubsetEntryPtr& entry = subsets_[subset_key];
+  if (entry == nullptr) {
     // Not found. Create an uninitialized entry.
-    entry = std::make_shared<LbSubsetEntry>();
-    if (kv_it != subsets.end()) {
-      ValueSubsetMap& value_subset_map = kv_it->second;
-      value_subset_map.emplace(value, entry);
-    } else {
-      ValueSubsetMap value_subset_map = {{value, entry}};
-      subsets.emplace(name, value_subset_map);
-    }
-  }
-
-  idx++;
-  if (idx == kvs.size()) {
-    // We've matched all the key-values, return the entry.
-    return entry;
+    entry = std::make_shared<LbSubsetEntry>(kvs);
   }
-
-  return findOrCreateSubset(entry->children_, kvs, idx);
+  return entry;
 }
 
-// Invokes cb for each LbSubsetEntryPtr in subsets.
-void SubsetLoadBalancer::forEachSubset(LbSubsetMap& subsets,
-                                       std::function<void(LbSubsetEntryPtr)> cb) {
-  for (auto& vsm : subsets) {
-    for (auto& em : vsm.second) {
-      LbSubsetEntryPtr entry = em.second;
-      cb(entry);
-      forEachSubset(entry->children_, cb);
-    }
+// Invokes cb for each LbSubsetEntryPtr.
+void SubsetLoadBalancer::forEachSubset(std::function<void(LbSubsetEntryPtr)> cb) {
+  for (auto& it : subsets_) {
+    cb(it.second);
   }
 }
 
-void SubsetLoadBalancer::purgeEmptySubsets(LbSubsetMap& subsets) {
-  for (auto subset_it = subsets.begin(); subset_it != subsets.end();) {
-    for (auto it = subset_it->second.begin(); it != subset_it->second.end();) {
-      LbSubsetEntryPtr entry = it->second;
-
-      purgeEmptySubsets(entry->children_);
-
-      if (entry->active() || entry->hasChildren()) {
-        it++;
-        continue;
-      }
-
-      // If it wasn't initialized, it wasn't accounted for.
-      if (entry->initialized()) {
-        stats_.lb_subsets_active_.dec();
-        stats_.lb_subsets_removed_.inc();
-      }
-
-      auto next_it = std::next(it);
-      subset_it->second.erase(it);
-      it = next_it;
+void SubsetLoadBalancer::purgeEmptySubsets() {
+  for (auto it = subsets_.begin(); it != subsets_.end();) {
+    const LbSubsetEntryPtr& entry = it->second;
+    if (entry->active() || !entry->hosts_.empty()) {
+      ++it;
+      continue;
     }
 
-    if (subset_it->second.empty()) {
-      auto next_subset_it = std::next(subset_it);
-      subsets.erase(subset_it);
-      subset_it = next_subset_it;
-    } else {
-      subset_it++;
+    // If it wasn't initialized, it wasn't accounted for.
+    if (entry->initialized()) {
+      stats_.lb_subsets_active_.dec();
+      stats_.lb_subsets_removed_.inc();
     }
+
+    subsets_.erase(it++);
   }
 }
 
@@ -678,8 +666,10 @@ SubsetLoadBalancer::PrioritySubsetImpl::PrioritySubsetImpl(const SubsetLoadBalan
 
   case LoadBalancerType::OriginalDst:
   case LoadBalancerType::ClusterProvided:
+  case LoadBalancerType::PeakEwma:
     // LoadBalancerType::OriginalDst is blocked in the factory. LoadBalancerType::ClusterProvided
     // is impossible because the subset LB returns a null load balancer from its factory.
+    // LoadBalancerType::PeakEwma cannot be combined with lb_subset_config.
     NOT_REACHED_GCOVR_EXCL_LINE;
   }
 
@@ -697,7 +687,7 @@ void SubsetLoadBalancer::HostSubsetImpl::update(const HostVector& hosts_added,
   // since metadata lookups can be expensive.
   //
   // We use an unordered container because this can potentially be in the tens of thousands.
-  absl::node_hash_set<const Host*> matching_hosts;
+  absl::flat_hash_set<const Host*> matching_hosts;
 
   auto cached_predicate = [&matching_hosts](const auto& host) {
     return matching_hosts.count(&host) == 1;
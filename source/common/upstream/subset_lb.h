@@ -15,6 +15,9 @@
 #include "common/protobuf/utility.h"
 #include "common/upstream/upstream_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/types/optional.h"
 
@@ -36,6 +39,8 @@ public:
 
   // Upstream::LoadBalancer
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
+  // Subset picks depend on the metadata of the stream, so they can't be predicted.
+  HostConstSharedPtr peekAnotherHost(LoadBalancerContext*) override { return nullptr; }
 
 private:
   using HostPredicate = std::function<bool(const Host&)>;
@@ -114,14 +119,16 @@ private:
   using PrioritySubsetImplPtr = std::shared_ptr<PrioritySubsetImpl>;
 
   using SubsetMetadata = std::vector<std::pair<std::string, ProtobufWkt::Value>>;
+  // Interned form of a SubsetMetadata: one element per key-value pair, in the same (lexically
+  // sorted by key) order, holding the key id in the upper and the value id in the lower 32 bits.
+  using SubsetKey = absl::InlinedVector<uint64_t, 4>;
 
   class LbSubsetEntry;
   struct SubsetSelectorMap;
 
   using LbSubsetEntryPtr = std::shared_ptr<LbSubsetEntry>;
   using SubsetSelectorMapPtr = std::shared_ptr<SubsetSelectorMap>;
-  using ValueSubsetMap = absl::node_hash_map<HashedValue, LbSubsetEntryPtr>;
-  using LbSubsetMap = absl::node_hash_map<std::string, ValueSubsetMap>;
+  using LbSubsetMap = absl::flat_hash_map<SubsetKey, LbSubsetEntryPtr>;
   using SubsetSelectorFallbackParamsRef = std::reference_wrapper<SubsetSelectorFallbackParams>;
 
   class LoadBalancerContextWrapper : public LoadBalancerContext {
@@ -175,34 +182,52 @@ private:
     SubsetSelectorFallbackParams fallback_params_;
   };
 
-  // Entry in the subset hierarchy.
+  // Entry in the subset index.
   class LbSubsetEntry {
   public:
     LbSubsetEntry() = default;
+    explicit LbSubsetEntry(const SubsetMetadata& metadata) : metadata_(metadata) {}
 
     bool initialized() const { return priority_subset_ != nullptr; }
     bool active() const { return initialized() && !priority_subset_->empty(); }
-    bool hasChildren() const { return !children_.empty(); }
+    bool hasHost(const Host& host) const { return hosts_.count(&host) != 0; }
 
-    LbSubsetMap children_;
+    // The metadata selecting this subset. Empty for the fallback subsets.
+    const SubsetMetadata metadata_;
+    // Hosts, across all priorities, whose metadata selects this subset.
+    absl::flat_hash_set<const Host*> hosts_;
 
-    // Only initialized if a match exists at this level.
+    // Only initialized once a host has been added to the subset.
     PrioritySubsetImplPtr priority_subset_;
   };
 
+  // The subsets a host belongs to, computed from its metadata when the host is added and again
+  // only when its metadata changes.
+  struct HostSubsets {
+    MetadataConstSharedPtr metadata_;
+    std::vector<LbSubsetEntryPtr> entries_;
+    // Number of priorities the host is currently a member of.
+    uint32_t ref_count_{};
+  };
+
   // Create filtered default subset (if necessary) and other subsets based on current hosts.
   void refreshSubsets();
   void refreshSubsets(uint32_t priority);
 
   // Called by HostSet::MemberUpdateCb
   void update(uint32_t priority, const HostVector& hosts_added, const HostVector& hosts_removed);
+  void updateSubsets(uint32_t priority, const HostVector& hosts_added,
+                     const HostVector& hosts_removed);
 
   void updateFallbackSubset(uint32_t priority, const HostVector& hosts_added,
                             const HostVector& hosts_removed);
-  void
-  processSubsets(const HostVector& hosts_added, const HostVector& hosts_removed,
-                 std::function<void(LbSubsetEntryPtr)> update_cb,
-                 std::function<void(LbSubsetEntryPtr, HostPredicate, const SubsetMetadata&)> cb);
+  void processSubsets(std::function<void(LbSubsetEntryPtr)> update_cb,
+                      std::function<void(LbSubsetEntryPtr)> new_cb);
+
+  void addHostSubsets(const Host& host);
+  void removeHostSubsets(const Host& host);
+  void refreshHostSubsets(const HostVector& hosts);
+  void assignHostSubsets(const Host& host, HostSubsets& host_subsets);
 
   HostConstSharedPtr tryChooseHostFromContext(LoadBalancerContext* context, bool& host_chosen);
 
@@ -214,10 +239,9 @@ private:
   LbSubsetEntryPtr
   findSubset(const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& matches);
 
-  LbSubsetEntryPtr findOrCreateSubset(LbSubsetMap& subsets, const SubsetMetadata& kvs,
-                                      uint32_t idx);
-  void forEachSubset(LbSubsetMap& subsets, std::function<void(LbSubsetEntryPtr)> cb);
-  void purgeEmptySubsets(LbSubsetMap& subsets);
+  LbSubsetEntryPtr findOrCreateSubset(const SubsetMetadata& kvs);
+  void forEachSubset(std::function<void(LbSubsetEntryPtr)> cb);
+  void purgeEmptySubsets();
 
   std::vector<SubsetMetadata> extractSubsetMetadata(const std::set<std::string>& subset_keys,
                                                     const Host& host);
@@ -248,8 +272,14 @@ private:
 
   LbSubsetEntryPtr selector_fallback_subset_default_;
 
-  // Forms a trie-like structure. Requires lexically sorted Host and Route metadata.
+  // Ids of the metadata keys used by the subset selectors, assigned at construction.
+  absl::flat_hash_map<std::string, uint32_t> key_ids_;
+  // Ids of the metadata values seen on hosts so far, assigned as they are first seen.
+  absl::flat_hash_map<HashedValue, uint32_t> value_ids_;
+  // All subsets, keyed by their interned metadata. Requires lexically sorted Host and Route
+  // metadata.
   LbSubsetMap subsets_;
+  absl::flat_hash_map<const Host*, HostSubsets> host_subsets_;
   // Forms a trie-like structure of lexically sorted keys+fallback policy from subset
   // selectors configuration
   SubsetSelectorMapPtr selectors_;
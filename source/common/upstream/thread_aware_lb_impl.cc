@@ -1,6 +1,8 @@
 #include "common/upstream/thread_aware_lb_impl.h"
 
+#include <cmath>
 #include <memory>
+#include <numeric>
 
 namespace Envoy {
 namespace Upstream {
@@ -123,6 +125,11 @@ void ThreadAwareLoadBalancerBase::refresh() {
                      min_normalized_weight, max_normalized_weight);
     per_priority_state->current_lb_ =
         createLoadBalancer(normalized_host_weights, min_normalized_weight, max_normalized_weight);
+    if (hash_balance_factor_ > 0) {
+      per_priority_state->current_lb_ = std::make_shared<BoundedLoadHashingLoadBalancer>(
+          per_priority_state->current_lb_, std::move(normalized_host_weights),
+          hash_balance_factor_, stats_.upstream_rq_active_);
+    }
   }
 
   {
@@ -172,6 +179,97 @@ ThreadAwareLoadBalancerBase::LoadBalancerImpl::chooseHost(LoadBalancerContext* c
   return host;
 }
 
+ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::BoundedLoadHashingLoadBalancer(
+    HashingLoadBalancerSharedPtr hashing_lb, NormalizedHostWeightVector&& normalized_host_weights,
+    uint32_t hash_balance_factor, const Stats::Gauge& rq_active)
+    : hashing_lb_(std::move(hashing_lb)),
+      normalized_host_weights_(std::move(normalized_host_weights)),
+      hash_balance_factor_(hash_balance_factor), rq_active_(rq_active) {
+  ASSERT(hash_balance_factor_ >= 100);
+  normalized_host_weights_map_.reserve(normalized_host_weights_.size());
+  for (const auto& host_weight : normalized_host_weights_) {
+    normalized_host_weights_map_.emplace(host_weight.first, host_weight.second);
+  }
+
+  // Pick a handful of strides spread over [1, num_hosts) that are coprime with the number of hosts,
+  // so that different keys overflowing from the same host fan out to different hosts.
+  const uint32_t num_hosts = normalized_host_weights_.size();
+  const uint32_t step = std::max<uint32_t>(num_hosts / MaxProbeStrides, 1);
+  for (uint32_t stride = 1; stride < num_hosts && probe_strides_.size() < MaxProbeStrides;
+       stride += step) {
+    if (std::gcd(stride, num_hosts) == 1) {
+      probe_strides_.push_back(stride);
+    }
+  }
+  if (probe_strides_.empty()) {
+    probe_strides_.push_back(1);
+  }
+}
+
+HostConstSharedPtr
+ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost(uint64_t hash,
+                                                                        uint32_t attempt) const {
+  HostConstSharedPtr host = hashing_lb_->chooseHost(hash, attempt);
+  if (host == nullptr) {
+    return nullptr;
+  }
+
+  // The request being balanced is not yet counted as active, so it is included in the total.
+  const uint64_t total_slots = ((rq_active_.value() + 1) * hash_balance_factor_ + 99) / 100;
+  const auto weight_it = normalized_host_weights_map_.find(host);
+  ASSERT(weight_it != normalized_host_weights_map_.end());
+  double overload_factor = hostOverloadFactor(*host, weight_it->second, total_slots);
+  if (overload_factor <= 1.0) {
+    return host;
+  }
+
+  // Walk the remaining hosts along an arithmetic sequence modulo the number of hosts. Both the
+  // starting host and the stride (which is coprime with the number of hosts so every host is
+  // visited exactly once) are derived from the hash rather than the shared random generator, so
+  // the same key always probes hosts in the same order.
+  const uint32_t num_hosts = normalized_host_weights_.size();
+  uint64_t z = hash + attempt + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  const uint64_t stride = probe_strides_[(z >> 32) % probe_strides_.size()];
+  uint64_t index = z % num_hosts;
+
+  HostConstSharedPtr least_overloaded_host = host;
+  double least_overload_factor = overload_factor;
+  for (uint32_t i = 0; i < num_hosts; i++, index = (index + stride) % num_hosts) {
+    const auto& candidate = normalized_host_weights_[index];
+    if (candidate.first == host) {
+      continue;
+    }
+
+    overload_factor = hostOverloadFactor(*candidate.first, candidate.second, total_slots);
+    if (overload_factor <= 1.0) {
+      return candidate.first;
+    }
+    if (overload_factor < least_overload_factor) {
+      least_overloaded_host = candidate.first;
+      least_overload_factor = overload_factor;
+    }
+  }
+
+  // Only reachable if the cluster's active request gauge lags the hosts' gauges.
+  return least_overloaded_host;
+}
+
+double ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::hostOverloadFactor(
+    const Host& host, double weight, uint64_t total_slots) const {
+  const uint64_t slots =
+      std::max<uint64_t>(static_cast<uint64_t>(std::ceil(total_slots * weight)), 1);
+  const uint64_t host_active = host.stats().rq_active_.value();
+  if (host_active >= slots) {
+    ENVOY_LOG_MISC(trace, "bounded load: host {} at capacity: rq_active {} slots {}",
+                   host.address()->asString(), host_active, slots);
+  }
+  // A host exactly at its bound cannot take another request.
+  return static_cast<double>(host_active + 1) / slots;
+}
+
 LoadBalancerPtr ThreadAwareLoadBalancerBase::LoadBalancerFactoryImpl::create() {
   auto lb = std::make_unique<LoadBalancerImpl>(stats_, random_);
 
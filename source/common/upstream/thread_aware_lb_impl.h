@@ -2,8 +2,10 @@
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
+#include "common/protobuf/utility.h"
 #include "common/upstream/load_balancer_impl.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/mutex.h"
 
 namespace Envoy {
@@ -28,6 +30,42 @@ public:
   };
   using HashingLoadBalancerSharedPtr = std::shared_ptr<HashingLoadBalancer>;
 
+  /**
+   * Implements consistent hashing with bounded loads (https://arxiv.org/abs/1608.01350) on top of
+   * another hashing load balancer. Each host may serve at most hash_balance_factor / 100 times its
+   * weighted share of the cluster's active requests. When the host chosen by the wrapped load
+   * balancer is over its bound, the remaining hosts are probed with a start and stride derived
+   * from the hash so that a given key always overflows to the same sequence of hosts, which avoids
+   * the cascading overflow of probing the next host in the ring or table. The candidate strides
+   * are computed once per host set so that a pick never allocates.
+   */
+  class BoundedLoadHashingLoadBalancer : public HashingLoadBalancer {
+  public:
+    BoundedLoadHashingLoadBalancer(HashingLoadBalancerSharedPtr hashing_lb,
+                                   NormalizedHostWeightVector&& normalized_host_weights,
+                                   uint32_t hash_balance_factor, const Stats::Gauge& rq_active);
+
+    // ThreadAwareLoadBalancerBase::HashingLoadBalancer
+    HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
+
+  private:
+    /**
+     * @return the ratio of the host's active requests to its bound. Values above 1.0 mean the
+     *         host is overloaded.
+     */
+    double hostOverloadFactor(const Host& host, double weight, uint64_t total_slots) const;
+
+    static constexpr uint32_t MaxProbeStrides = 16;
+
+    const HashingLoadBalancerSharedPtr hashing_lb_;
+    const NormalizedHostWeightVector normalized_host_weights_;
+    absl::flat_hash_map<HostConstSharedPtr, double> normalized_host_weights_map_;
+    const uint32_t hash_balance_factor_;
+    const Stats::Gauge& rq_active_;
+    // Strides coprime with the number of hosts, used to walk the overflow probe sequence.
+    std::vector<uint32_t> probe_strides_;
+  };
+
   // Upstream::ThreadAwareLoadBalancer
   LoadBalancerFactorySharedPtr factory() override { return factory_; }
   void initialize() override;
@@ -43,7 +81,9 @@ protected:
       Random::RandomGenerator& random,
       const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config)
       : LoadBalancerBase(priority_set, stats, runtime, random, common_config),
-        factory_(new LoadBalancerFactoryImpl(stats, random)) {}
+        factory_(new LoadBalancerFactoryImpl(stats, random)),
+        hash_balance_factor_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+            common_config.consistent_hashing_lb_config(), hash_balance_factor, 0)) {}
 
 private:
   struct PerPriorityState {
@@ -58,6 +98,8 @@ private:
 
     // Upstream::LoadBalancer
     HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
+    // Hash based picks can't be predicted without the stream.
+    HostConstSharedPtr peekAnotherHost(LoadBalancerContext*) override { return nullptr; }
 
     ClusterStats& stats_;
     Random::RandomGenerator& random_;
@@ -88,6 +130,8 @@ private:
   void refresh();
 
   std::shared_ptr<LoadBalancerFactoryImpl> factory_;
+  // Zero when host loads are not bounded.
+  const uint32_t hash_balance_factor_;
 };
 
 } // namespace Upstream
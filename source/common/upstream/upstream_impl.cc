@@ -86,6 +86,9 @@ uint64_t parseFeatures(const envoy::config::cluster::v3::Cluster& config) {
   if (config.close_connections_on_host_health_failure()) {
     features |= ClusterInfoImpl::Features::CLOSE_CONNECTIONS_ON_HOST_HEALTH_FAILURE;
   }
+  if (config.has_shared_http2_connection_pool()) {
+    features |= ClusterInfoImpl::Features::SHARED_HTTP2_CONNECTION_POOL;
+  }
   return features;
 }
 
@@ -275,6 +278,14 @@ HostDescriptionImpl::HostDescriptionImpl(
       health_check_config.port_value() == 0
           ? dest_address
           : Network::Utility::getAddressWithPort(*dest_address, health_check_config.port_value());
+  if (cluster_->lbType() == LoadBalancerType::PeakEwma) {
+    const auto& peak_ewma_config = cluster_->lbPeakEwmaConfig();
+    latency_monitor_ =
+        std::make_unique<PeakEwmaHostLatencyMonitor>(std::chrono::milliseconds(
+            peak_ewma_config.has_value()
+                ? PROTOBUF_GET_MS_OR_DEFAULT(peak_ewma_config.value(), decay_time, 10000)
+                : 10000));
+  }
 }
 
 Network::TransportSocketFactory& HostDescriptionImpl::resolveTransportSocketFactory(
@@ -619,6 +630,10 @@ ClusterStats ClusterInfoImpl::generateStats(Stats::Scope& scope) {
   return {ALL_CLUSTER_STATS(POOL_COUNTER(scope), POOL_GAUGE(scope), POOL_HISTOGRAM(scope))};
 }
 
+ClusterStats ClusterInfoImpl::generateStats(Stats::LazyStatPool& pool) {
+  return {ALL_CLUSTER_STATS(POOL_COUNTER(pool), POOL_GAUGE(pool), POOL_HISTOGRAM(pool))};
+}
+
 ClusterRequestResponseSizeStats
 ClusterInfoImpl::generateRequestResponseSizeStats(Stats::Scope& scope) {
   return {ALL_CLUSTER_REQUEST_RESPONSE_SIZE_STATS(POOL_HISTOGRAM(scope))};
@@ -689,10 +704,18 @@ ClusterInfoImpl::ClusterInfoImpl(
           std::chrono::milliseconds(PROTOBUF_GET_MS_REQUIRED(config, connect_timeout))),
       prefetch_ratio_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.prefetch_policy(), prefetch_ratio, 1.0)),
+      predictive_prefetch_ratio_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.prefetch_policy(),
+                                                                 predictive_prefetch_ratio, 1.0)),
+      max_idle_conn_pools_per_host_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, max_idle_connection_pools_per_host, std::numeric_limits<uint32_t>::max())),
       per_connection_buffer_limit_bytes_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_connection_buffer_limit_bytes, 1024 * 1024)),
       socket_matcher_(std::move(socket_matcher)), stats_scope_(std::move(stats_scope)),
-      stats_(generateStats(*stats_scope_)), load_report_stats_store_(stats_scope_->symbolTable()),
+      lazy_stats_(config.track_cluster_stats().lazy_stats()
+                      ? std::make_unique<Stats::LazyStatPool>(*stats_scope_)
+                      : nullptr),
+      stats_(lazy_stats_ != nullptr ? generateStats(*lazy_stats_) : generateStats(*stats_scope_)),
+      load_report_stats_store_(stats_scope_->symbolTable()),
       load_report_stats_(generateLoadReportStats(load_report_stats_store_)),
       optional_cluster_stats_((config.has_track_cluster_stats() || config.track_timeout_budgets())
                                   ? std::make_unique<OptionalClusterStats>(config, *stats_scope_)
@@ -707,6 +730,7 @@ ClusterInfoImpl::ClusterInfoImpl(
       source_address_(getSourceAddress(config, bind_config)),
       lb_least_request_config_(config.least_request_lb_config()),
       lb_ring_hash_config_(config.ring_hash_lb_config()),
+      lb_peak_ewma_config_(config.peak_ewma_lb_config()),
       lb_original_dst_config_(config.original_dst_lb_config()),
       upstream_config_(config.has_upstream_config()
                            ? absl::make_optional<envoy::config::core::v3::TypedExtensionConfig>(
@@ -773,6 +797,15 @@ ClusterInfoImpl::ClusterInfoImpl(
 
     lb_type_ = LoadBalancerType::ClusterProvided;
     break;
+  case envoy::config::cluster::v3::Cluster::PEAK_EWMA:
+    if (config.has_lb_subset_config()) {
+      throw EnvoyException(
+          fmt::format("cluster: LB policy {} cannot be combined with lb_subset_config",
+                      envoy::config::cluster::v3::Cluster::LbPolicy_Name(config.lb_policy())));
+    }
+
+    lb_type_ = LoadBalancerType::PeakEwma;
+    break;
   default:
     NOT_REACHED_GCOVR_EXCL_LINE;
   }
@@ -1153,6 +1186,7 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::config::cluster::v3::Cluste
   uint64_t max_connection_pools = std::numeric_limits<uint64_t>::max();
 
   bool track_remaining = false;
+  bool per_worker_counters = false;
 
   std::string priority_name;
   switch (priority) {
@@ -1185,6 +1219,7 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::config::cluster::v3::Cluste
     max_requests = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_requests, max_requests);
     max_retries = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_retries, max_retries);
     track_remaining = it->track_remaining();
+    per_worker_counters = it->per_worker_counters();
     max_connection_pools =
         PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_connection_pools, max_connection_pools);
     if (it->has_retry_budget()) {
@@ -1205,7 +1240,7 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::config::cluster::v3::Cluste
       runtime, runtime_prefix, max_connections, max_pending_requests, max_requests, max_retries,
       max_connection_pools,
       ClusterInfoImpl::generateCircuitBreakersStats(stats_scope, priority_name, track_remaining),
-      budget_percent, min_retry_concurrency);
+      budget_percent, min_retry_concurrency, per_worker_counters);
 }
 
 PriorityStateManager::PriorityStateManager(ClusterImplBase& cluster,
@@ -47,6 +47,8 @@
 #include "common/network/utility.h"
 #include "common/shared_pool/shared_pool.h"
 #include "common/stats/isolated_store_impl.h"
+#include "common/stats/lazy_stats.h"
+#include "common/upstream/host_latency_monitor_impl.h"
 #include "common/upstream/load_balancer_impl.h"
 #include "common/upstream/outlier_detection_impl.h"
 #include "common/upstream/resource_manager_impl.h"
@@ -123,6 +125,14 @@ public:
       return *null_outlier_detector;
     }
   }
+  HostLatencyMonitor& latencyMonitor() const override {
+    if (latency_monitor_) {
+      return *latency_monitor_;
+    } else {
+      static HostLatencyMonitorNullImpl* null_latency_monitor = new HostLatencyMonitorNullImpl();
+      return *null_latency_monitor;
+    }
+  }
   HostStats& stats() const override { return stats_; }
   const std::string& hostnameForHealthChecks() const override { return health_checks_hostname_; }
   const std::string& hostname() const override { return hostname_; }
@@ -154,6 +164,7 @@ protected:
   mutable HostStats stats_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
   HealthCheckHostMonitorPtr health_checker_;
+  HostLatencyMonitorPtr latency_monitor_;
   std::atomic<uint32_t> priority_;
   Network::TransportSocketFactory& socket_factory_;
 };
@@ -519,6 +530,7 @@ public:
                   bool added_via_api, Server::Configuration::TransportSocketFactoryContext&);
 
   static ClusterStats generateStats(Stats::Scope& scope);
+  static ClusterStats generateStats(Stats::LazyStatPool& pool);
   static ClusterLoadReportStats generateLoadReportStats(Stats::Scope& scope);
   static ClusterCircuitBreakersStats generateCircuitBreakersStats(Stats::Scope& scope,
                                                                   const std::string& stat_prefix,
@@ -536,6 +548,8 @@ public:
     return idle_timeout_;
   }
   float prefetchRatio() const override { return prefetch_ratio_; }
+  float predictivePrefetchRatio() const override { return predictive_prefetch_ratio_; }
+  uint32_t maxIdleConnPoolsPerHost() const override { return max_idle_conn_pools_per_host_; }
   uint32_t perConnectionBufferLimitBytes() const override {
     return per_connection_buffer_limit_bytes_;
   }
@@ -563,6 +577,10 @@ public:
   lbRingHashConfig() const override {
     return lb_ring_hash_config_;
   }
+  const absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig>&
+  lbPeakEwmaConfig() const override {
+    return lb_peak_ewma_config_;
+  }
   const absl::optional<envoy::config::cluster::v3::Cluster::OriginalDstLbConfig>&
   lbOriginalDstConfig() const override {
     return lb_original_dst_config_;
@@ -656,9 +674,13 @@ private:
   const std::chrono::milliseconds connect_timeout_;
   absl::optional<std::chrono::milliseconds> idle_timeout_;
   const float prefetch_ratio_;
+  const float predictive_prefetch_ratio_;
+  const uint32_t max_idle_conn_pools_per_host_;
   const uint32_t per_connection_buffer_limit_bytes_;
   TransportSocketMatcherPtr socket_matcher_;
   Stats::ScopePtr stats_scope_;
+  // Set when the cluster stats are only allocated in stats_scope_ when first written.
+  const std::unique_ptr<Stats::LazyStatPool> lazy_stats_;
   mutable ClusterStats stats_;
   Stats::IsolatedStoreImpl load_report_stats_store_;
   mutable ClusterLoadReportStats load_report_stats_;
@@ -675,6 +697,7 @@ private:
   absl::optional<envoy::config::cluster::v3::Cluster::LeastRequestLbConfig>
       lb_least_request_config_;
   absl::optional<envoy::config::cluster::v3::Cluster::RingHashLbConfig> lb_ring_hash_config_;
+  absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig> lb_peak_ewma_config_;
   absl::optional<envoy::config::cluster::v3::Cluster::OriginalDstLbConfig> lb_original_dst_config_;
   absl::optional<envoy::config::core::v3::TypedExtensionConfig> upstream_config_;
   const bool added_via_api_;
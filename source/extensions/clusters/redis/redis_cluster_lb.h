@@ -189,6 +189,10 @@ private:
 
     // Upstream::LoadBalancerBase
     Upstream::HostConstSharedPtr chooseHost(Upstream::LoadBalancerContext*) override;
+    // The host is determined by the key slot of each request.
+    Upstream::HostConstSharedPtr peekAnotherHost(Upstream::LoadBalancerContext*) override {
+      return nullptr;
+    }
 
   private:
     const SlotArraySharedPtr slot_array_;
@@ -0,0 +1,79 @@
+#include "extensions/common/dynamic_forward_proxy/dns_cache_host_map.h"
+
+#include "common/common/hash.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace DynamicForwardProxy {
+
+namespace {
+
+// The number of hosts each shard holds once the map is full, which bounds the copy made by a
+// change.
+constexpr uint32_t HostsPerShard = 64;
+constexpr size_t MaxShards = 65536;
+
+size_t numShardsFor(uint32_t max_hosts) {
+  // The number of shards is a power of two, so that the shard of a host is picked with a mask.
+  size_t num_shards = 1;
+  while (num_shards < MaxShards && num_shards * HostsPerShard < max_hosts) {
+    num_shards *= 2;
+  }
+  return num_shards;
+}
+
+} // namespace
+
+DnsCacheHostMap::DnsCacheHostMap(uint32_t max_hosts) : shards_(numShardsFor(max_hosts)) {}
+
+const DnsHostInfoSharedPtr* DnsCacheHostMap::find(absl::string_view host) const {
+  const ShardConstSharedPtr& shard = shards_[shardIndex(host)];
+  if (shard == nullptr) {
+    return nullptr;
+  }
+  const auto it = shard->find(host);
+  return it != shard->end() ? &it->second : nullptr;
+}
+
+size_t DnsCacheHostMap::insert(const std::string& host, const DnsHostInfoSharedPtr& host_info) {
+  const size_t index = shardIndex(host);
+  ShardConstSharedPtr& shard = shards_[index];
+  auto new_shard = shard != nullptr ? std::make_shared<Shard>(*shard) : std::make_shared<Shard>();
+  if (new_shard->insert_or_assign(host, host_info).second) {
+    size_++;
+  }
+  shard = std::move(new_shard);
+  return index;
+}
+
+absl::optional<size_t> DnsCacheHostMap::erase(const std::string& host) {
+  const size_t index = shardIndex(host);
+  ShardConstSharedPtr& shard = shards_[index];
+  if (shard == nullptr || shard->count(host) == 0) {
+    return absl::nullopt;
+  }
+  if (shard->size() > 1) {
+    auto new_shard = std::make_shared<Shard>(*shard);
+    new_shard->erase(host);
+    shard = std::move(new_shard);
+  } else {
+    shard.reset();
+  }
+  size_--;
+  return index;
+}
+
+void DnsCacheHostMap::updateShard(size_t index, const ShardConstSharedPtr& shard, size_t size) {
+  shards_[index] = shard;
+  size_ = size;
+}
+
+size_t DnsCacheHostMap::shardIndex(absl::string_view host) const {
+  return HashUtil::xxHash64(host) & (shards_.size() - 1);
+}
+
+} // namespace DynamicForwardProxy
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
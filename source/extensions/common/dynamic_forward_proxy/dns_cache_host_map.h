@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "extensions/common/dynamic_forward_proxy/dns_cache.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace DynamicForwardProxy {
+
+/**
+ * The resolved hosts of a DNS cache, split across shards, each of which is an immutable map
+ * shared by all the copies of the host map. The main thread owns the primary copy, which replaces
+ * a shard with an updated copy on every change (copy-on-write), and publishes the new shard to the
+ * copy of each worker through its thread local slot. A change thus copies a single shard, whose
+ * size is bounded by the number of hosts the map is sized for, rather than every host of the
+ * cache, and a worker looks hosts up in its own copy without any synchronization.
+ *
+ * A host map is not thread safe: each copy must only be used by the thread which owns it.
+ */
+class DnsCacheHostMap {
+public:
+  using Shard = absl::flat_hash_map<std::string, DnsHostInfoSharedPtr>;
+  using ShardConstSharedPtr = std::shared_ptr<const Shard>;
+
+  /**
+   * @param max_hosts supplies the number of hosts the map is expected to hold at most, which sets
+   *        the number of shards.
+   */
+  explicit DnsCacheHostMap(uint32_t max_hosts);
+
+  /**
+   * Looks up a host.
+   * @param host supplies the host to look up.
+   * @return the info of the host, or nullptr if the host is not in the map. The info is owned by
+   *         the map and is only valid until the shard of the host is replaced.
+   */
+  const DnsHostInfoSharedPtr* find(absl::string_view host) const;
+
+  /**
+   * Adds a host, or replaces its info if it is already in the map.
+   * @param host supplies the host to add.
+   * @param host_info supplies the info of the host.
+   * @return the index of the shard which was replaced.
+   */
+  size_t insert(const std::string& host, const DnsHostInfoSharedPtr& host_info);
+
+  /**
+   * Removes a host if it is in the map.
+   * @param host supplies the host to remove.
+   * @return the index of the shard which was replaced, or absl::nullopt if the host was not in
+   *         the map.
+   */
+  absl::optional<size_t> erase(const std::string& host);
+
+  /**
+   * @param index supplies the index of a shard.
+   * @return the shard, which is null if it holds no hosts.
+   */
+  const ShardConstSharedPtr& shard(size_t index) const { return shards_[index]; }
+
+  /**
+   * Replaces a shard with the shard of another copy of the map, sized for the same number of
+   * hosts, after it changed.
+   * @param index supplies the index of the shard.
+   * @param shard supplies the new shard.
+   * @param size supplies the number of hosts of the other copy.
+   */
+  void updateShard(size_t index, const ShardConstSharedPtr& shard, size_t size);
+
+  /**
+   * @return the number of hosts in the map.
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * @return the number of shards the hosts are split across.
+   */
+  size_t numShards() const { return shards_.size(); }
+
+private:
+  size_t shardIndex(absl::string_view host) const;
+
+  // An empty shard is null.
+  std::vector<ShardConstSharedPtr> shards_;
+  size_t size_{};
+};
+
+} // namespace DynamicForwardProxy
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
@@ -4,6 +4,7 @@
 
 #include "common/config/utility.h"
 #include "common/http/utility.h"
+#include "common/network/caching_dns_resolver.h"
 #include "common/network/utility.h"
 
 // TODO(mattklein123): Move DNS family helpers to a smaller include.
@@ -14,16 +15,32 @@ namespace Extensions {
 namespace Common {
 namespace DynamicForwardProxy {
 
+namespace {
+
+Network::DnsResolverSharedPtr
+createResolver(Event::Dispatcher& main_thread_dispatcher, Stats::Scope& scope,
+               const envoy::extensions::common::dynamic_forward_proxy::v3::DnsCacheConfig& config) {
+  Network::DnsResolverSharedPtr resolver =
+      main_thread_dispatcher.createDnsResolver({}, config.use_tcp_for_dns_lookups());
+  if (config.has_resolution_cache()) {
+    resolver = std::make_shared<Network::CachingDnsResolver>(
+        resolver, main_thread_dispatcher.timeSource(), config.resolution_cache(), scope);
+  }
+  return resolver;
+}
+
+} // namespace
+
 DnsCacheImpl::DnsCacheImpl(
     Event::Dispatcher& main_thread_dispatcher, ThreadLocal::SlotAllocator& tls,
     Random::RandomGenerator& random, Runtime::Loader& loader, Stats::Scope& root_scope,
     const envoy::extensions::common::dynamic_forward_proxy::v3::DnsCacheConfig& config)
     : main_thread_dispatcher_(main_thread_dispatcher),
       dns_lookup_family_(Upstream::getDnsLookupFamilyFromEnum(config.dns_lookup_family())),
-      resolver_(main_thread_dispatcher.createDnsResolver({}, config.use_tcp_for_dns_lookups())),
       tls_slot_(tls.allocateSlot()),
       scope_(root_scope.createScope(fmt::format("dns_cache.{}.", config.name()))),
       stats_(generateDnsCacheStats(*scope_)),
+      resolver_(createResolver(main_thread_dispatcher, *scope_, config)),
       resource_manager_(*scope_, loader, config.name(), config.dns_cache_circuit_breaker()),
       refresh_interval_(PROTOBUF_GET_MS_OR_DEFAULT(config, dns_refresh_rate, 60000)),
       failure_backoff_strategy_(
@@ -31,9 +48,12 @@ DnsCacheImpl::DnsCacheImpl(
               envoy::extensions::common::dynamic_forward_proxy::v3::DnsCacheConfig>(
               config, refresh_interval_.count(), random)),
       host_ttl_(PROTOBUF_GET_MS_OR_DEFAULT(config, host_ttl, 300000)),
-      max_hosts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_hosts, 1024)) {
-  tls_slot_->set([](Event::Dispatcher&) { return std::make_shared<ThreadLocalHostInfo>(); });
-  updateTlsHostsMap();
+      max_hosts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_hosts, 1024)),
+      evict_least_recently_used_hosts_(config.evict_least_recently_used_hosts()),
+      host_map_(max_hosts_) {
+  tls_slot_->set([max_hosts = max_hosts_](Event::Dispatcher&) {
+    return std::make_shared<ThreadLocalHostInfo>(max_hosts);
+  });
 }
 
 DnsCacheImpl::~DnsCacheImpl() {
@@ -57,14 +77,14 @@ DnsCacheImpl::loadDnsCacheEntry(absl::string_view host, uint16_t default_port,
                                 LoadDnsCacheEntryCallbacks& callbacks) {
   ENVOY_LOG(debug, "thread local lookup for host '{}'", host);
   auto& tls_host_info = tls_slot_->getTyped<ThreadLocalHostInfo>();
-  auto tls_host = tls_host_info.host_map_->find(host);
-  if (tls_host != tls_host_info.host_map_->end()) {
+  if (tls_host_info.host_map_.find(host) != nullptr) {
     ENVOY_LOG(debug, "thread local hit for host '{}'", host);
     return {LoadDnsCacheEntryStatus::InCache, nullptr};
-  } else if (tls_host_info.host_map_->size() >= max_hosts_) {
+  } else if (!evict_least_recently_used_hosts_ && tls_host_info.host_map_.size() >= max_hosts_) {
     // Given that we do this check in thread local context, it's possible for two threads to race
     // and potentially go slightly above the configured max hosts. This is an OK given compromise
-    // given how much simpler the implementation is.
+    // given how much simpler the implementation is. If least recently used hosts are evicted, the
+    // main thread makes room for the new host instead.
     ENVOY_LOG(debug, "DNS cache overflow for host '{}'", host);
     stats_.host_overflow_.inc();
     return {LoadDnsCacheEntryStatus::Overflow, nullptr};
@@ -118,6 +138,16 @@ void DnsCacheImpl::startCacheLoad(const std::string& host, uint16_t default_port
     return;
   }
 
+  if (evict_least_recently_used_hosts_ && primary_hosts_.size() >= max_hosts_ &&
+      !evictLeastRecentlyUsedHost()) {
+    // Every host is still being resolved for the first time. The pending resolutions of the new
+    // host are completed without it, as if it overflowed on the worker.
+    ENVOY_LOG(debug, "DNS cache overflow for host '{}', no host to evict", host);
+    stats_.host_overflow_.inc();
+    notifyHostMapUpdated(host);
+    return;
+  }
+
   const auto host_attributes = Http::Utility::parseAuthority(host);
 
   // TODO(mattklein123): Right now, the same host with different ports will become two
@@ -131,6 +161,10 @@ void DnsCacheImpl::startCacheLoad(const std::string& host, uint16_t default_port
                                                    host_attributes.is_ip_address_,
                                                    [this, host]() { onReResolve(host); }))
                             .first->second;
+  if (evict_least_recently_used_hosts_) {
+    primary_host.lru_entry_ = lru_hosts_.insert(lru_hosts_.end(), host);
+    primary_host.lru_last_used_time_ = primary_host.host_info_->last_used_time_.load();
+  }
   startResolve(host, primary_host);
 }
 
@@ -145,14 +179,7 @@ void DnsCacheImpl::onReResolve(const std::string& host) {
             primary_host_it->second->host_info_->last_used_time_.load().count());
   if (now_duration - primary_host_it->second->host_info_->last_used_time_.load() > host_ttl_) {
     ENVOY_LOG(debug, "host='{}' TTL expired, removing", host);
-    // If the host has no address then that means that the DnsCacheImpl has never
-    // runAddUpdateCallbacks for this host, and thus the callback targets are not aware of it.
-    // Therefore, runRemoveCallbacks should only be ran if the host's address != nullptr.
-    if (primary_host_it->second->host_info_->address_) {
-      runRemoveCallbacks(host);
-    }
-    primary_hosts_.erase(primary_host_it);
-    updateTlsHostsMap();
+    removeHost(host);
   } else {
     startResolve(host, *primary_host_it->second);
   }
@@ -205,18 +232,18 @@ void DnsCacheImpl::finishResolve(const std::string& host,
   //
   // This means that once a host gets an address it will stick even in the case of a subsequent
   // resolution failure.
-  bool address_changed = false;
   if (new_address != nullptr && (primary_host_info.host_info_->address_ == nullptr ||
                                  *primary_host_info.host_info_->address_ != *new_address)) {
     ENVOY_LOG(debug, "host '{}' address has changed", host);
     primary_host_info.host_info_->address_ = new_address;
     runAddUpdateCallbacks(host, primary_host_info.host_info_);
-    address_changed = true;
     stats_.host_address_changed_.inc();
   }
 
-  if (first_resolve || address_changed) {
-    updateTlsHostsMap();
+  // The workers share the host info, so only its first resolution needs to reach them.
+  if (first_resolve) {
+    publishHostMapShard(host_map_.insert(host, primary_host_info.host_info_));
+    notifyHostMapUpdated(host);
   }
 
   // Kick off the refresh timer.
@@ -248,18 +275,69 @@ void DnsCacheImpl::runRemoveCallbacks(const std::string& host) {
   }
 }
 
-void DnsCacheImpl::updateTlsHostsMap() {
-  TlsHostMapSharedPtr new_host_map = std::make_shared<TlsHostMap>();
-  for (const auto& primary_host : primary_hosts_) {
-    // Do not include hosts that have not resolved at least once.
-    if (primary_host.second->host_info_->first_resolve_complete_) {
-      new_host_map->emplace(primary_host.first, primary_host.second->host_info_);
-    }
+void DnsCacheImpl::notifyHostMapUpdated(const std::string& host) {
+  tls_slot_->runOnAllThreads(
+      [this, host]() { tls_slot_->getTyped<ThreadLocalHostInfo>().onHostMapUpdated(host); });
+}
+
+void DnsCacheImpl::publishHostMapShard(size_t shard_index) {
+  // Only the replaced shard is sent to the workers, which share it with the main thread. Updates
+  // are applied in order, as they are posted to the dispatcher of each worker in order.
+  tls_slot_->runOnAllThreads(
+      [this, shard_index, shard = host_map_.shard(shard_index), size = host_map_.size()]() {
+        tls_slot_->getTyped<ThreadLocalHostInfo>().host_map_.updateShard(shard_index, shard, size);
+      });
+}
+
+void DnsCacheImpl::removeHost(const std::string& host) {
+  const auto primary_host_it = primary_hosts_.find(host);
+  ASSERT(primary_host_it != primary_hosts_.end());
+  PrimaryHostInfo& primary_host = *primary_host_it->second;
+  if (primary_host.active_query_ != nullptr) {
+    primary_host.active_query_->cancel();
+  }
+  // If the host has no address then that means that the DnsCacheImpl has never
+  // runAddUpdateCallbacks for this host, and thus the callback targets are not aware of it.
+  // Therefore, runRemoveCallbacks should only be ran if the host's address != nullptr.
+  if (primary_host.host_info_->address_) {
+    runRemoveCallbacks(host);
   }
+  if (evict_least_recently_used_hosts_) {
+    lru_hosts_.erase(primary_host.lru_entry_);
+  }
+  const absl::optional<size_t> shard_index = host_map_.erase(host);
+  if (shard_index.has_value()) {
+    publishHostMapShard(shard_index.value());
+  }
+  // This may destroy the refresh timer whose callback is running, and the host it captured, so
+  // neither is used afterwards.
+  primary_hosts_.erase(primary_host_it);
+}
 
-  tls_slot_->runOnAllThreads([this, new_host_map]() {
-    tls_slot_->getTyped<ThreadLocalHostInfo>().updateHostMap(new_host_map);
-  });
+bool DnsCacheImpl::evictLeastRecentlyUsedHost() {
+  // Workers mark hosts as used without telling the main thread, so the order of lru_hosts_ is only
+  // approximate. A host at its head which was used since it was put there gets a second chance at
+  // its tail, as does a host whose first resolution is pending since workers are waiting for it.
+  // After a pass over the list every host has been put back with its current last used time, so
+  // a second pass finds a host to evict unless all of them are pending.
+  for (size_t i = 2 * lru_hosts_.size(); i > 0; --i) {
+    const std::string host = lru_hosts_.front();
+    PrimaryHostInfo& primary_host = *primary_hosts_.find(host)->second;
+    const std::chrono::steady_clock::duration last_used_time =
+        primary_host.host_info_->last_used_time_.load();
+    if (!primary_host.host_info_->first_resolve_complete_ ||
+        last_used_time != primary_host.lru_last_used_time_) {
+      primary_host.lru_last_used_time_ = last_used_time;
+      lru_hosts_.splice(lru_hosts_.end(), lru_hosts_, lru_hosts_.begin());
+      continue;
+    }
+
+    ENVOY_LOG(debug, "evicting least recently used host '{}'", host);
+    stats_.host_evicted_.inc();
+    removeHost(host);
+    return true;
+  }
+  return false;
 }
 
 DnsCacheImpl::ThreadLocalHostInfo::~ThreadLocalHostInfo() {
@@ -269,12 +347,11 @@ DnsCacheImpl::ThreadLocalHostInfo::~ThreadLocalHostInfo() {
   }
 }
 
-void DnsCacheImpl::ThreadLocalHostInfo::updateHostMap(const TlsHostMapSharedPtr& new_host_map) {
-  host_map_ = new_host_map;
+void DnsCacheImpl::ThreadLocalHostInfo::onHostMapUpdated(const std::string& host) {
   for (auto pending_resolution_it = pending_resolutions_.begin();
        pending_resolution_it != pending_resolutions_.end();) {
     auto& pending_resolution = **pending_resolution_it;
-    if (host_map_->count(pending_resolution.host_) != 0) {
+    if (pending_resolution.host_ == host) {
       auto& callbacks = pending_resolution.callbacks_;
       pending_resolution.cancel();
       pending_resolution_it = pending_resolutions_.erase(pending_resolution_it);
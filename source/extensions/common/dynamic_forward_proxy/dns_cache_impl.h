@@ -9,6 +9,7 @@
 #include "common/common/cleanup.h"
 
 #include "extensions/common/dynamic_forward_proxy/dns_cache.h"
+#include "extensions/common/dynamic_forward_proxy/dns_cache_host_map.h"
 #include "extensions/common/dynamic_forward_proxy/dns_cache_resource_manager.h"
 
 #include "absl/container/flat_hash_map.h"
@@ -27,6 +28,7 @@ namespace DynamicForwardProxy {
   COUNTER(dns_query_success)                                                                       \
   COUNTER(host_added)                                                                              \
   COUNTER(host_address_changed)                                                                    \
+  COUNTER(host_evicted)                                                                            \
   COUNTER(host_overflow)                                                                           \
   COUNTER(host_removed)                                                                            \
   COUNTER(dns_rq_pending_overflow)                                                                 \
@@ -56,9 +58,6 @@ public:
   canCreateDnsRequest(ResourceLimitOptRef pending_requests) override;
 
 private:
-  using TlsHostMap = absl::flat_hash_map<std::string, DnsHostInfoSharedPtr>;
-  using TlsHostMapSharedPtr = std::shared_ptr<TlsHostMap>;
-
   struct LoadDnsCacheEntryHandleImpl : public LoadDnsCacheEntryHandle,
                                        RaiiListElement<LoadDnsCacheEntryHandleImpl*> {
     LoadDnsCacheEntryHandleImpl(std::list<LoadDnsCacheEntryHandleImpl*>& parent,
@@ -72,10 +71,12 @@ private:
 
   // Per-thread DNS cache info including the currently known hosts as well as any pending callbacks.
   struct ThreadLocalHostInfo : public ThreadLocal::ThreadLocalObject {
+    explicit ThreadLocalHostInfo(uint32_t max_hosts) : host_map_(max_hosts) {}
     ~ThreadLocalHostInfo() override;
-    void updateHostMap(const TlsHostMapSharedPtr& new_host_map);
+    void onHostMapUpdated(const std::string& host);
 
-    TlsHostMapSharedPtr host_map_;
+    // The copy of host_map_ of this thread, whose shards are updated by the main thread.
+    DnsCacheHostMap host_map_;
     std::list<LoadDnsCacheEntryHandleImpl*> pending_resolutions_;
   };
 
@@ -114,6 +115,10 @@ private:
     const Event::TimerPtr refresh_timer_;
     const DnsHostInfoImplSharedPtr host_info_;
     Network::ActiveDnsQuery* active_query_{};
+    // The position of the host in lru_hosts_, and its last used time when it was put there. Only
+    // set if least recently used hosts are evicted.
+    std::list<std::string>::iterator lru_entry_;
+    std::chrono::steady_clock::duration lru_last_used_time_{};
   };
 
   using PrimaryHostInfoPtr = std::unique_ptr<PrimaryHostInfo>;
@@ -133,15 +138,18 @@ private:
                      std::list<Network::DnsResponse>&& response);
   void runAddUpdateCallbacks(const std::string& host, const DnsHostInfoSharedPtr& host_info);
   void runRemoveCallbacks(const std::string& host);
-  void updateTlsHostsMap();
+  void notifyHostMapUpdated(const std::string& host);
+  void publishHostMapShard(size_t shard_index);
   void onReResolve(const std::string& host);
+  void removeHost(const std::string& host);
+  bool evictLeastRecentlyUsedHost();
 
   Event::Dispatcher& main_thread_dispatcher_;
   const Network::DnsLookupFamily dns_lookup_family_;
-  const Network::DnsResolverSharedPtr resolver_;
   const ThreadLocal::SlotPtr tls_slot_;
   Stats::ScopePtr scope_;
   DnsCacheStats stats_;
+  const Network::DnsResolverSharedPtr resolver_;
   std::list<AddUpdateCallbacksHandleImpl*> update_callbacks_;
   absl::flat_hash_map<std::string, PrimaryHostInfoPtr> primary_hosts_;
   DnsCacheResourceManagerImpl resource_manager_;
@@ -149,6 +157,11 @@ private:
   const BackOffStrategyPtr failure_backoff_strategy_;
   const std::chrono::milliseconds host_ttl_;
   const uint32_t max_hosts_;
+  const bool evict_least_recently_used_hosts_;
+  // The hosts which resolved at least once. The shards are shared with the copies of the workers.
+  DnsCacheHostMap host_map_;
+  // The hosts from the least to the most recently used, if least recently used hosts are evicted.
+  std::list<std::string> lru_hosts_;
 };
 
 } // namespace DynamicForwardProxy
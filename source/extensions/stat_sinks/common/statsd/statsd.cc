@@ -1,7 +1,9 @@
 #include "extensions/stat_sinks/common/statsd/statsd.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "envoy/buffer/buffer.h"
@@ -15,12 +17,14 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/fmt.h"
+#include "common/common/logger.h"
 #include "common/common/utility.h"
 #include "common/config/utility.h"
 #include "common/network/socket_interface_impl.h"
 #include "common/network/utility.h"
 #include "common/stats/symbol_table_impl.h"
 
+#include "absl/container/fixed_array.h"
 #include "absl/strings/str_join.h"
 
 namespace Envoy {
@@ -40,72 +44,128 @@ void UdpStatsdSink::WriterImpl::write(const std::string& message) {
   Network::Utility::writeToSocket(*io_handle_, &slice, 1, nullptr, *parent_.server_address_);
 }
 
-void UdpStatsdSink::WriterImpl::writeBuffer(Buffer::Instance& data) {
-  Network::Utility::writeToSocket(*io_handle_, data, nullptr, *parent_.server_address_);
+void UdpStatsdSink::WriterImpl::writeBatch(const DatagramBatch& batch) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  if (!os_sys_calls.supportsMmsg()) {
+    for (uint64_t i = 0; i < batch.size(); ++i) {
+      const absl::string_view datagram = batch.datagram(i);
+      Buffer::RawSlice slice{const_cast<char*>(datagram.data()), datagram.size()};
+      Network::Utility::writeToSocket(*io_handle_, &slice, 1, nullptr, *parent_.server_address_);
+    }
+    return;
+  }
+
+  // Linux writes at most UIO_MAXIOV datagrams per sendmmsg() call.
+  constexpr uint64_t MaxDatagramsPerCall = 1024;
+  const uint64_t max_count = std::min(batch.size(), MaxDatagramsPerCall);
+  absl::FixedArray<mmsghdr> headers(max_count);
+  absl::FixedArray<iovec> iovecs(max_count);
+  uint64_t sent = 0;
+  while (sent < batch.size()) {
+    const uint64_t count = std::min(batch.size() - sent, MaxDatagramsPerCall);
+    for (uint64_t i = 0; i < count; ++i) {
+      const absl::string_view datagram = batch.datagram(sent + i);
+      iovecs[i].iov_base = const_cast<char*>(datagram.data());
+      iovecs[i].iov_len = datagram.size();
+      memset(&headers[i], 0, sizeof(mmsghdr));
+      msghdr& header = headers[i].msg_hdr;
+      header.msg_name = const_cast<sockaddr*>(parent_.server_address_->sockAddr());
+      header.msg_namelen = parent_.server_address_->sockAddrLen();
+      header.msg_iov = &iovecs[i];
+      header.msg_iovlen = 1;
+    }
+    const Api::SysCallIntResult result =
+        os_sys_calls.sendmmsg(io_handle_->fd(), headers.data(), count, 0);
+    if (result.rc_ <= 0) {
+      if (result.rc_ < 0 && result.errno_ == SOCKET_ERROR_INTR) {
+        continue;
+      }
+      // As with a single datagram, the rest of the flush is dropped if the socket can't take it.
+      ENVOY_LOG_MISC(debug, "sendmmsg failed with errno {}", result.errno_);
+      return;
+    }
+    sent += result.rc_;
+  }
+}
+
+void DatagramBatch::add(absl::string_view name, uint64_t value, absl::string_view type,
+                        absl::string_view tags) {
+  char value_buffer[StringUtil::MIN_ITOA_OUT_LEN];
+  const uint32_t value_length = StringUtil::itoa(value_buffer, sizeof(value_buffer), value);
+  const uint64_t length = name.size() + value_length + type.size() + tags.size();
+  const bool fits = length < max_datagram_size_;
+  const uint64_t last_length =
+      datagram_ends_.empty() ? 0 : datagram(datagram_ends_.size() - 1).size();
+  if (last_open_ && fits && last_length + length + 1 <= max_datagram_size_) {
+    data_.push_back('\n');
+  } else {
+    datagram_ends_.push_back(data_.size());
+  }
+  data_.append(name.data(), name.size());
+  data_.append(value_buffer, value_length);
+  data_.append(type.data(), type.size());
+  data_.append(tags.data(), tags.size());
+  datagram_ends_.back() = data_.size();
+  last_open_ = fits;
 }
 
 UdpStatsdSink::UdpStatsdSink(ThreadLocal::SlotAllocator& tls,
                              Network::Address::InstanceConstSharedPtr address, const bool use_tag,
-                             const std::string& prefix, absl::optional<uint64_t> buffer_size)
+                             const std::string& prefix, absl::optional<uint64_t> buffer_size,
+                             const bool skip_unchanged_metrics, Stats::SymbolTable* symbol_table)
     : tls_(tls.allocateSlot()), server_address_(std::move(address)), use_tag_(use_tag),
       prefix_(prefix.empty() ? Statsd::getDefaultPrefix() : prefix),
-      buffer_size_(buffer_size.value_or(0)) {
+      buffer_size_(buffer_size.value_or(0)), skip_unchanged_metrics_(skip_unchanged_metrics),
+      name_cache_(symbol_table != nullptr ? std::make_unique<NameCache>(*symbol_table) : nullptr) {
   tls_->set([this](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return std::make_shared<WriterImpl>(*this);
   });
 }
 
 void UdpStatsdSink::flush(Stats::MetricSnapshot& snapshot) {
-  Writer& writer = tls_->getTyped<Writer>();
-  Buffer::OwnedImpl buffer;
-
-  for (const auto& counter : snapshot.counters()) {
+  DatagramBatch batch(buffer_size_);
+  // Flushes are usually about the same size, so leave some room for growth over the last one to
+  // format the whole flush without reallocating.
+  batch.reserve(last_flush_bytes_ + last_flush_bytes_ / 8);
+
+  // A counter with a zero delta is a no-op increment for statsd, and statsd servers retain the
+  // last value of a gauge, so both can be skipped when unchanged.
+  for (const auto& counter :
+       skip_unchanged_metrics_ ? snapshot.changedCounters() : snapshot.counters()) {
     if (counter.counter_.get().used()) {
-      const std::string counter_str =
-          absl::StrCat(prefix_, ".", getName(counter.counter_.get()), ":", counter.delta_, "|c",
-                       buildTagStr(counter.counter_.get().tags()));
-      writeBuffer(buffer, writer, counter_str);
+      addMetric(batch, counter.counter_.get(), counter.delta_, "|c");
     }
   }
 
-  for (const auto& gauge : snapshot.gauges()) {
+  for (const auto& gauge : skip_unchanged_metrics_ ? snapshot.changedGauges() : snapshot.gauges()) {
     if (gauge.get().used()) {
-      const std::string gauge_str =
-          absl::StrCat(prefix_, ".", getName(gauge.get()), ":", gauge.get().value(), "|g",
-                       buildTagStr(gauge.get().tags()));
-      writeBuffer(buffer, writer, gauge_str);
+      addMetric(batch, gauge.get(), gauge.get().value(), "|g");
     }
   }
-
-  flushBuffer(buffer, writer);
   // TODO(efimki): Add support of text readouts stats.
-}
 
-void UdpStatsdSink::writeBuffer(Buffer::OwnedImpl& buffer, Writer& writer,
-                                const std::string& statsd_metric) const {
-  if (statsd_metric.length() >= buffer_size_) {
-    // Our statsd_metric is too large to fit into the buffer, skip buffering and write directly
-    writer.write(statsd_metric);
-  } else {
-    if ((buffer.length() + statsd_metric.length() + 1) > buffer_size_) {
-      // If we add the new statsd_metric, we'll overflow our buffer. Flush the buffer to make
-      // room for the new statsd_metric.
-      flushBuffer(buffer, writer);
-    } else if (buffer.length() > 0) {
-      // We have room and have metrics already in the buffer, add a newline to separate
-      // metric entries.
-      buffer.add("\n");
-    }
-    buffer.add(statsd_metric);
+  if (name_cache_ != nullptr && ++name_cache_generation_ % NameCacheSweepInterval == 0) {
+    name_cache_->sweep(name_cache_generation_ - NameCacheSweepInterval);
+  }
+  last_flush_bytes_ = batch.bytes();
+  if (batch.size() > 0) {
+    tls_->getTyped<Writer>().writeBatch(batch);
   }
 }
 
-void UdpStatsdSink::flushBuffer(Buffer::OwnedImpl& buffer, Writer& writer) const {
-  if (buffer.length() == 0) {
+void UdpStatsdSink::addMetric(DatagramBatch& batch, const Stats::Metric& metric, uint64_t value,
+                              absl::string_view type) {
+  if (name_cache_ == nullptr) {
+    batch.add(absl::StrCat(prefix_, ".", getName(metric), ":"), value, type,
+              buildTagStr(metric.tags()));
     return;
   }
-  writer.writeBuffer(buffer);
-  buffer.drain(buffer.length());
+  const CachedName& cached_name =
+      name_cache_->get(metric.statName(), name_cache_generation_, [this, &metric]() {
+        return CachedName{absl::StrCat(prefix_, ".", getName(metric), ":"),
+                          buildTagStr(metric.tags())};
+      });
+  batch.add(cached_name.name_, value, type, cached_name.tags_);
 }
 
 void UdpStatsdSink::onHistogramComplete(const Stats::Histogram& histogram, uint64_t value) {
@@ -121,6 +181,21 @@ void UdpStatsdSink::onHistogramComplete(const Stats::Histogram& histogram, uint6
   tls_->getTyped<Writer>().write(message);
 }
 
+void UdpStatsdSink::onHistogramSamples(const Stats::Histogram& histogram,
+                                       absl::Span<const uint64_t> values) {
+  // See the comment at UdpStatsdSink::onHistogramComplete with respect to units. The name and tags
+  // are formatted once for the whole batch, which is packed into datagrams like a flush.
+  DatagramBatch batch(buffer_size_);
+  const std::string name = absl::StrCat(prefix_, ".", getName(histogram), ":");
+  const std::string tags = buildTagStr(histogram.tags());
+  for (const uint64_t value : values) {
+    batch.add(name, std::chrono::milliseconds(value).count(), "|ms", tags);
+  }
+  if (batch.size() > 0) {
+    tls_->getTyped<Writer>().writeBatch(batch);
+  }
+}
+
 const std::string UdpStatsdSink::getName(const Stats::Metric& metric) const {
   if (use_tag_) {
     return metric.tagExtractedName();
@@ -145,8 +220,9 @@ const std::string UdpStatsdSink::buildTagStr(const std::vector<Stats::Tag>& tags
 TcpStatsdSink::TcpStatsdSink(const LocalInfo::LocalInfo& local_info,
                              const std::string& cluster_name, ThreadLocal::SlotAllocator& tls,
                              Upstream::ClusterManager& cluster_manager, Stats::Scope& scope,
-                             const std::string& prefix)
-    : prefix_(prefix.empty() ? Statsd::getDefaultPrefix() : prefix), tls_(tls.allocateSlot()),
+                             const std::string& prefix, const bool skip_unchanged_metrics)
+    : prefix_(prefix.empty() ? Statsd::getDefaultPrefix() : prefix),
+      skip_unchanged_metrics_(skip_unchanged_metrics), tls_(tls.allocateSlot()),
       cluster_manager_(cluster_manager),
       cx_overflow_stat_(scope.counterFromStatName(
           Stats::StatNameManagedStorage("statsd.cx_overflow", scope.symbolTable()).statName())) {
@@ -161,13 +237,14 @@ TcpStatsdSink::TcpStatsdSink(const LocalInfo::LocalInfo& local_info,
 void TcpStatsdSink::flush(Stats::MetricSnapshot& snapshot) {
   TlsSink& tls_sink = tls_->getTyped<TlsSink>();
   tls_sink.beginFlush(true);
-  for (const auto& counter : snapshot.counters()) {
+  for (const auto& counter :
+       skip_unchanged_metrics_ ? snapshot.changedCounters() : snapshot.counters()) {
     if (counter.counter_.get().used()) {
       tls_sink.flushCounter(counter.counter_.get().name(), counter.delta_);
     }
   }
 
-  for (const auto& gauge : snapshot.gauges()) {
+  for (const auto& gauge : skip_unchanged_metrics_ ? snapshot.changedGauges() : snapshot.gauges()) {
     if (gauge.get().used()) {
       tls_sink.flushGauge(gauge.get().name(), gauge.get().value());
     }
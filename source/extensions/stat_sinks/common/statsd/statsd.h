@@ -15,8 +15,12 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/common/macros.h"
 #include "common/network/io_socket_handle_impl.h"
+#include "common/stats/stat_name_cache.h"
+#include "common/stats/symbol_table_impl.h"
 
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -26,6 +30,56 @@ namespace Statsd {
 
 static const std::string& getDefaultPrefix() { CONSTRUCT_ON_FIRST_USE(std::string, "envoy"); }
 
+/**
+ * Newline separated statsd metrics packed into datagrams, formatted into one contiguous buffer so
+ * that all the datagrams of a flush can be written with a few system calls.
+ */
+class DatagramBatch {
+public:
+  /**
+   * @param max_datagram_size the size up to which metrics are packed into a datagram. A metric at
+   *        least this large is sent in a datagram of its own, so 0 sends one metric per datagram.
+   */
+  explicit DatagramBatch(uint64_t max_datagram_size) : max_datagram_size_(max_datagram_size) {}
+
+  /**
+   * Reserves room for the given number of bytes of metrics.
+   */
+  void reserve(uint64_t bytes) { data_.reserve(bytes); }
+
+  /**
+   * Appends the metric <name><value><type><tags>, where name ends with the ':' separating it from
+   * the value.
+   */
+  void add(absl::string_view name, uint64_t value, absl::string_view type, absl::string_view tags);
+
+  /**
+   * @return the number of datagrams in the batch.
+   */
+  uint64_t size() const { return datagram_ends_.size(); }
+
+  /**
+   * @return the datagram at the given index.
+   */
+  absl::string_view datagram(uint64_t index) const {
+    const uint64_t start = index == 0 ? 0 : datagram_ends_[index - 1];
+    return {data_.data() + start, datagram_ends_[index] - start};
+  }
+
+  /**
+   * @return the number of bytes in all the datagrams.
+   */
+  uint64_t bytes() const { return data_.size(); }
+
+private:
+  const uint64_t max_datagram_size_;
+  std::string data_;
+  // The end of each datagram in data_.
+  std::vector<uint64_t> datagram_ends_;
+  // Whether more metrics can be packed into the last datagram.
+  bool last_open_{};
+};
+
 /**
  * Implementation of Sink that writes to a UDP statsd address.
  */
@@ -37,19 +91,29 @@ public:
   class Writer : public ThreadLocal::ThreadLocalObject {
   public:
     virtual void write(const std::string& message) PURE;
-    virtual void writeBuffer(Buffer::Instance& data) PURE;
+    virtual void writeBatch(const DatagramBatch& batch) PURE;
   };
 
+  /**
+   * @param symbol_table supplies the symbol table of the flushed metrics, used to cache their
+   *        formatted names across flushes. If nullptr, names are formatted on every flush.
+   */
   UdpStatsdSink(ThreadLocal::SlotAllocator& tls, Network::Address::InstanceConstSharedPtr address,
                 const bool use_tag, const std::string& prefix = getDefaultPrefix(),
-                absl::optional<uint64_t> buffer_size = absl::nullopt);
+                absl::optional<uint64_t> buffer_size = absl::nullopt,
+                const bool skip_unchanged_metrics = false,
+                Stats::SymbolTable* symbol_table = nullptr);
   // For testing.
   UdpStatsdSink(ThreadLocal::SlotAllocator& tls, const std::shared_ptr<Writer>& writer,
                 const bool use_tag, const std::string& prefix = getDefaultPrefix(),
-                absl::optional<uint64_t> buffer_size = absl::nullopt)
+                absl::optional<uint64_t> buffer_size = absl::nullopt,
+                const bool skip_unchanged_metrics = false,
+                Stats::SymbolTable* symbol_table = nullptr)
       : tls_(tls.allocateSlot()), use_tag_(use_tag),
         prefix_(prefix.empty() ? getDefaultPrefix() : prefix),
-        buffer_size_(buffer_size.value_or(0)) {
+        buffer_size_(buffer_size.value_or(0)), skip_unchanged_metrics_(skip_unchanged_metrics),
+        name_cache_(symbol_table != nullptr ? std::make_unique<NameCache>(*symbol_table)
+                                            : nullptr) {
     tls_->set(
         [writer](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr { return writer; });
   }
@@ -57,12 +121,28 @@ public:
   // Stats::Sink
   void flush(Stats::MetricSnapshot& snapshot) override;
   void onHistogramComplete(const Stats::Histogram& histogram, uint64_t value) override;
+  void onHistogramSamples(const Stats::Histogram& histogram,
+                          absl::Span<const uint64_t> values) override;
 
   bool getUseTagForTest() { return use_tag_; }
   uint64_t getBufferSizeForTest() { return buffer_size_; }
+  uint64_t getNameCacheSizeForTest() { return name_cache_ != nullptr ? name_cache_->size() : 0; }
   const std::string& getPrefix() { return prefix_; }
 
 private:
+  // The statsd name and tags of a metric, cached across flushes so that they are not decoded from
+  // the symbol table and formatted again on every flush.
+  struct CachedName {
+    // The prefixed name followed by ':'.
+    std::string name_;
+    std::string tags_;
+  };
+  using NameCache = Stats::StatNameCache<CachedName>;
+
+  // The cached names which were not used in this many flushes are dropped, including those of
+  // the metrics which were freed.
+  static constexpr uint64_t NameCacheSweepInterval = 16;
+
   /**
    * This is a simple UDP localhost writer for statsd messages.
    */
@@ -72,15 +152,15 @@ private:
 
     // Writer
     void write(const std::string& message) override;
-    void writeBuffer(Buffer::Instance& data) override;
+    void writeBatch(const DatagramBatch& batch) override;
 
   private:
     UdpStatsdSink& parent_;
     const Network::IoHandlePtr io_handle_;
   };
 
-  void flushBuffer(Buffer::OwnedImpl& buffer, Writer& writer) const;
-  void writeBuffer(Buffer::OwnedImpl& buffer, Writer& writer, const std::string& data) const;
+  void addMetric(DatagramBatch& batch, const Stats::Metric& metric, uint64_t value,
+                 absl::string_view type);
 
   const std::string getName(const Stats::Metric& metric) const;
   const std::string buildTagStr(const std::vector<Stats::Tag>& tags) const;
@@ -91,6 +171,13 @@ private:
   // Prefix for all flushed stats.
   const std::string prefix_;
   const uint64_t buffer_size_;
+  // Whether to only flush the counters and gauges written since the previous flush.
+  const bool skip_unchanged_metrics_;
+  const std::unique_ptr<NameCache> name_cache_;
+  // The number of flushes, which the entries of the name cache are marked as used in.
+  uint64_t name_cache_generation_{};
+  // The size of the previous flush, to size the batch of the next one up front.
+  uint64_t last_flush_bytes_{};
 };
 
 /**
@@ -100,7 +187,8 @@ class TcpStatsdSink : public Stats::Sink {
 public:
   TcpStatsdSink(const LocalInfo::LocalInfo& local_info, const std::string& cluster_name,
                 ThreadLocal::SlotAllocator& tls, Upstream::ClusterManager& cluster_manager,
-                Stats::Scope& scope, const std::string& prefix = getDefaultPrefix());
+                Stats::Scope& scope, const std::string& prefix = getDefaultPrefix(),
+                const bool skip_unchanged_metrics = false);
 
   // Stats::Sink
   void flush(Stats::MetricSnapshot& snapshot) override;
@@ -147,6 +235,8 @@ private:
 
   // Prefix for all flushed stats.
   const std::string prefix_;
+  // Whether to only flush the counters and gauges written since the previous flush.
+  const bool skip_unchanged_metrics_;
 
   Upstream::ClusterInfoConstSharedPtr cluster_info_;
   ThreadLocal::SlotPtr tls_;
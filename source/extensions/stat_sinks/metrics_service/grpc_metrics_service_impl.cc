@@ -39,9 +39,11 @@ void GrpcMetricsStreamerImpl::send(envoy::service::metrics::v3::StreamMetricsMes
 
 MetricsServiceSink::MetricsServiceSink(const GrpcMetricsStreamerSharedPtr& grpc_metrics_streamer,
                                        TimeSource& time_source,
-                                       const bool report_counters_as_deltas)
+                                       const bool report_counters_as_deltas,
+                                       const bool skip_unchanged_metrics)
     : grpc_metrics_streamer_(grpc_metrics_streamer), time_source_(time_source),
-      report_counters_as_deltas_(report_counters_as_deltas) {}
+      report_counters_as_deltas_(report_counters_as_deltas),
+      skip_unchanged_metrics_(skip_unchanged_metrics) {}
 
 void MetricsServiceSink::flushCounter(
     const Stats::MetricSnapshot::CounterSnapshot& counter_snapshot) {
@@ -117,15 +119,17 @@ void MetricsServiceSink::flush(Stats::MetricSnapshot& snapshot) {
   // TODO(mrice32): there's probably some more sophisticated preallocation we can do here where we
   // actually preallocate the submessages and then pass ownership to the proto (rather than just
   // preallocating the pointer array).
-  message_.mutable_envoy_metrics()->Reserve(snapshot.counters().size() + snapshot.gauges().size() +
+  const auto& counters = skip_unchanged_metrics_ ? snapshot.changedCounters() : snapshot.counters();
+  const auto& gauges = skip_unchanged_metrics_ ? snapshot.changedGauges() : snapshot.gauges();
+  message_.mutable_envoy_metrics()->Reserve(counters.size() + gauges.size() +
                                             snapshot.histograms().size());
-  for (const auto& counter : snapshot.counters()) {
+  for (const auto& counter : counters) {
     if (counter.counter_.get().used()) {
       flushCounter(counter);
     }
   }
 
-  for (const auto& gauge : snapshot.gauges()) {
+  for (const auto& gauge : gauges) {
     if (gauge.get().used()) {
       flushGauge(gauge.get());
     }
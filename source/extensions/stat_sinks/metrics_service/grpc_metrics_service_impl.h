@@ -80,7 +80,8 @@ class MetricsServiceSink : public Stats::Sink {
 public:
   // MetricsService::Sink
   MetricsServiceSink(const GrpcMetricsStreamerSharedPtr& grpc_metrics_streamer,
-                     TimeSource& time_system, const bool report_counters_as_deltas);
+                     TimeSource& time_system, const bool report_counters_as_deltas,
+                     const bool skip_unchanged_metrics = false);
   void flush(Stats::MetricSnapshot& snapshot) override;
   void onHistogramComplete(const Stats::Histogram&, uint64_t) override {}
 
@@ -93,6 +94,7 @@ private:
   envoy::service::metrics::v3::StreamMetricsMessage message_;
   TimeSource& time_source_;
   const bool report_counters_as_deltas_;
+  const bool skip_unchanged_metrics_;
 };
 
 } // namespace MetricsService
@@ -0,0 +1,49 @@
+#include "extensions/stat_sinks/shared_memory/config.h"
+
+#include <memory>
+
+#include "envoy/config/metrics/v3/stats.pb.h"
+#include "envoy/config/metrics/v3/stats.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "common/protobuf/utility.h"
+
+#include "extensions/stat_sinks/shared_memory/shared_memory_sink.h"
+#include "extensions/stat_sinks/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+
+Stats::SinkPtr
+SharedMemoryStatsSinkFactory::createStatsSink(const Protobuf::Message& config,
+                                              Server::Configuration::ServerFactoryContext& server) {
+  const auto& sink_config =
+      MessageUtil::downcastAndValidate<const envoy::config::metrics::v3::SharedMemoryStatsSink&>(
+          config, server.messageValidationContext().staticValidationVisitor());
+  const uint32_t max_stats = PROTOBUF_GET_WRAPPED_OR_DEFAULT(sink_config, max_stats, 65536);
+  const uint32_t max_name_bytes =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(sink_config, max_name_bytes, max_stats * 128);
+  return std::make_unique<SharedMemoryStatsSink>(sink_config.path(), max_stats, max_name_bytes,
+                                                 server.scope().symbolTable(),
+                                                 server.timeSource());
+}
+
+ProtobufTypes::MessagePtr SharedMemoryStatsSinkFactory::createEmptyConfigProto() {
+  return std::make_unique<envoy::config::metrics::v3::SharedMemoryStatsSink>();
+}
+
+std::string SharedMemoryStatsSinkFactory::name() const {
+  return StatsSinkNames::get().SharedMemory;
+}
+
+/**
+ * Static registration for the shared memory stats sink factory. @see RegisterFactory.
+ */
+REGISTER_FACTORY(SharedMemoryStatsSinkFactory, Server::Configuration::StatsSinkFactory);
+
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
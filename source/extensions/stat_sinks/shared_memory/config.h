@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+#include "server/configuration_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+
+/**
+ * Config registration for the shared memory stats sink. @see StatsSinkFactory.
+ */
+class SharedMemoryStatsSinkFactory : Logger::Loggable<Logger::Id::config>,
+                                     public Server::Configuration::StatsSinkFactory {
+public:
+  // StatsSinkFactory
+  Stats::SinkPtr createStatsSink(const Protobuf::Message& config,
+                                 Server::Configuration::ServerFactoryContext& server) override;
+
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+  std::string name() const override;
+};
+
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+
+/**
+ * The layout of the file the shared memory stats sink mirrors the counters and gauges to. It is
+ * meant to be read by other processes mapping the file, so it only changes along with
+ * LayoutVersion. The file consists of, in order, each starting at an offset multiple of 8:
+ *   - a RegionHeader,
+ *   - max_stats_ StatEntry,
+ *   - the name index, index_size_ uint32_t slots,
+ *   - name_bytes_ bytes holding the names of the stats, which are not null terminated.
+ * All the integers are in the byte order of the host.
+ *
+ * Envoy only appends entries, and then only updates their value_. A reader can rely on the first
+ * num_stats_ entries being complete, along with their names and their slots in the index, once it
+ * has loaded num_stats_ with acquire semantics. Each value_ is naturally aligned, so it is read
+ * whole, but the values of different stats may be from different flushes.
+ *
+ * To look up a stat by name, probe the index from slot nameHash(name) & (index_size_ - 1), moving
+ * to the next slot and wrapping around, until reaching an empty slot, which holds 0. Other slots
+ * hold the position of an entry plus one, which is that of the stat if its name matches.
+ *
+ * When Envoy restarts, it replaces the file rather than rewriting it, so readers of the previous
+ * file keep a valid mapping. Readers can watch flush_count_ to notice that a file is no longer
+ * updated, and map the file again.
+ */
+
+// Changes whenever readers of the previous version can no longer read the file.
+constexpr uint32_t LayoutVersion = 1;
+
+// "ENVSTATS" in ASCII, as a little endian integer.
+constexpr uint64_t LayoutMagic = 0x5354415453564e45;
+
+enum class StatType : uint8_t { Counter = 1, Gauge = 2 };
+
+struct RegionHeader {
+  // Set to LayoutMagic once the rest of the file is initialized.
+  std::atomic<uint64_t> magic_;
+  uint32_t version_;
+  // The size of this header, which is where the entries start.
+  uint32_t header_size_;
+  uint32_t max_stats_;
+  // A power of 2, at least twice max_stats_.
+  uint32_t index_size_;
+  uint32_t name_bytes_;
+  // The number of entries in use.
+  std::atomic<uint32_t> num_stats_;
+  // The number of stats of the last flush which were not exported, as the file was full or their
+  // name too long.
+  std::atomic<uint32_t> num_dropped_;
+  uint32_t reserved_;
+  // Incremented at the end of each flush.
+  std::atomic<uint64_t> flush_count_;
+  // The system time of the last flush, in milliseconds since the epoch.
+  std::atomic<uint64_t> flush_time_ms_;
+};
+
+struct StatEntry {
+  std::atomic<uint64_t> value_;
+  // The offset of the name of the stat from the start of the names.
+  uint32_t name_offset_;
+  uint16_t name_length_;
+  StatType type_;
+  uint8_t reserved_;
+};
+
+static_assert(sizeof(RegionHeader) == 56, "RegionHeader is part of the shared memory layout");
+static_assert(sizeof(StatEntry) == 16, "StatEntry is part of the shared memory layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "Atomics in the shared memory layout must be lock free");
+
+/**
+ * The offsets of the sections of the file, as computed from the sizes in its header.
+ */
+struct RegionLayout {
+  RegionLayout(uint32_t max_stats, uint32_t index_size, uint32_t name_bytes)
+      : entries_offset_(align(sizeof(RegionHeader))),
+        index_offset_(align(entries_offset_ + uint64_t(max_stats) * sizeof(StatEntry))),
+        names_offset_(align(index_offset_ + uint64_t(index_size) * sizeof(uint32_t))),
+        size_(align(names_offset_ + name_bytes)) {}
+
+  /**
+   * @return the number of slots of the index for max_stats stats.
+   */
+  static uint32_t indexSize(uint32_t max_stats) {
+    uint32_t index_size = 1;
+    while (index_size < uint64_t(max_stats) * 2) {
+      index_size *= 2;
+    }
+    return index_size;
+  }
+
+  const uint64_t entries_offset_;
+  const uint64_t index_offset_;
+  const uint64_t names_offset_;
+  const uint64_t size_;
+
+private:
+  static uint64_t align(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+};
+
+/**
+ * @return the hash of a stat name locating it in the index, which is the 64-bit FNV-1a hash of its
+ *         bytes.
+ */
+inline uint64_t nameHash(absl::string_view name) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const char c : name) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,96 @@
+#include "extensions/stat_sinks/shared_memory/shared_memory_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "envoy/common/exception.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/fmt.h"
+#include "common/common/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+
+SharedMemoryStatsReader::SharedMemoryStatsReader(const std::string& path) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    throw EnvoyException(fmt::format("unable to open shared memory stats file '{}': {}", path,
+                                     errorDetails(errno)));
+  }
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) == -1) {
+    const int error = errno;
+    os_sys_calls.close(fd);
+    throw EnvoyException(fmt::format("unable to stat shared memory stats file '{}': {}", path,
+                                     errorDetails(error)));
+  }
+  if (static_cast<uint64_t>(file_stat.st_size) < sizeof(RegionHeader)) {
+    os_sys_calls.close(fd);
+    throw EnvoyException(fmt::format("shared memory stats file '{}' is too small", path));
+  }
+  size_ = file_stat.st_size;
+  const Api::SysCallPtrResult mmap_result =
+      os_sys_calls.mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  os_sys_calls.close(fd);
+  if (mmap_result.rc_ == MAP_FAILED) {
+    throw EnvoyException(fmt::format("unable to map shared memory stats file '{}': {}", path,
+                                     errorDetails(mmap_result.errno_)));
+  }
+  region_ = mmap_result.rc_;
+
+  header_ = static_cast<const RegionHeader*>(region_);
+  if (header_->magic_.load(std::memory_order_acquire) != LayoutMagic ||
+      header_->version_ != LayoutVersion || header_->header_size_ != sizeof(RegionHeader)) {
+    ::munmap(region_, size_);
+    throw EnvoyException(
+        fmt::format("shared memory stats file '{}' does not have layout version {}", path,
+                    LayoutVersion));
+  }
+  const uint32_t index_size = header_->index_size_;
+  const RegionLayout layout(header_->max_stats_, index_size, header_->name_bytes_);
+  if (layout.size_ > size_ || index_size == 0 || (index_size & (index_size - 1)) != 0) {
+    ::munmap(region_, size_);
+    throw EnvoyException(fmt::format("shared memory stats file '{}' is corrupt", path));
+  }
+  const uint8_t* base = static_cast<const uint8_t*>(region_);
+  entries_ = reinterpret_cast<const StatEntry*>(base + layout.entries_offset_);
+  index_ = reinterpret_cast<const std::atomic<uint32_t>*>(base + layout.index_offset_);
+  names_ = reinterpret_cast<const char*>(base + layout.names_offset_);
+}
+
+SharedMemoryStatsReader::~SharedMemoryStatsReader() { ::munmap(region_, size_); }
+
+absl::string_view SharedMemoryStatsReader::name(uint32_t position) const {
+  const StatEntry& entry = entries_[position];
+  return {names_ + entry.name_offset_, entry.name_length_};
+}
+
+absl::optional<uint32_t> SharedMemoryStatsReader::find(absl::string_view name) const {
+  const uint32_t num_stats = numStats();
+  const uint32_t mask = header_->index_size_ - 1;
+  uint32_t slot = nameHash(name) & mask;
+  for (uint32_t probes = 0; probes <= mask; ++probes) {
+    const uint32_t value = index_[slot].load(std::memory_order_relaxed);
+    if (value == 0) {
+      break;
+    }
+    // Slots may be set for entries published after num_stats was loaded, which are skipped.
+    if (value <= num_stats && this->name(value - 1) == name) {
+      return value - 1;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return absl::nullopt;
+}
+
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "extensions/stat_sinks/shared_memory/shared_memory_layout.h"
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+
+/**
+ * Reads the stats a SharedMemoryStatsSink mirrors to a file, possibly from another process, by
+ * mapping the file read only.
+ */
+class SharedMemoryStatsReader {
+public:
+  /**
+   * Maps the file.
+   * @param path the path of the file.
+   * @throw EnvoyException if the file cannot be mapped, or does not have the expected layout.
+   */
+  explicit SharedMemoryStatsReader(const std::string& path);
+  ~SharedMemoryStatsReader();
+
+  /**
+   * @return the number of stats in the file, which are at positions [0, numStats()).
+   */
+  uint32_t numStats() const { return header_->num_stats_.load(std::memory_order_acquire); }
+
+  /**
+   * @return the number of stats of the last flush which were not exported for lack of room in the
+   *         file.
+   */
+  uint32_t numDropped() const { return header_->num_dropped_.load(std::memory_order_relaxed); }
+
+  /**
+   * @return the number of flushes to the file so far.
+   */
+  uint64_t flushCount() const { return header_->flush_count_.load(std::memory_order_acquire); }
+
+  /**
+   * @return the system time of the last flush, in milliseconds since the epoch.
+   */
+  uint64_t flushTimeMs() const { return header_->flush_time_ms_.load(std::memory_order_relaxed); }
+
+  /**
+   * @param position the position of a stat, less than numStats().
+   * @return the name of the stat.
+   */
+  absl::string_view name(uint32_t position) const;
+
+  /**
+   * @param position the position of a stat, less than numStats().
+   * @return the type of the stat.
+   */
+  StatType type(uint32_t position) const { return entries_[position].type_; }
+
+  /**
+   * @param position the position of a stat, less than numStats().
+   * @return the value of the stat as of the last flush.
+   */
+  uint64_t value(uint32_t position) const {
+    return entries_[position].value_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Looks up a stat in the index of the file.
+   * @param name the name of the stat.
+   * @return the position of the stat, or nullopt if it is not in the file.
+   */
+  absl::optional<uint32_t> find(absl::string_view name) const;
+
+private:
+  void* region_{};
+  uint64_t size_{};
+  const RegionHeader* header_{};
+  const StatEntry* entries_{};
+  const std::atomic<uint32_t>* index_{};
+  const char* names_{};
+};
+
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
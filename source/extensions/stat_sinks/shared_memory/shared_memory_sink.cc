@@ -0,0 +1,148 @@
+#include "extensions/stat_sinks/shared_memory/shared_memory_sink.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+#include "envoy/common/exception.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/fmt.h"
+#include "common/common/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+
+SharedMemoryStatsSink::SharedMemoryStatsSink(const std::string& path, uint32_t max_stats,
+                                             uint32_t name_bytes, Stats::SymbolTable& symbol_table,
+                                             TimeSource& time_source)
+    : max_stats_(max_stats), index_size_(RegionLayout::indexSize(max_stats)),
+      name_bytes_(name_bytes), layout_(max_stats_, index_size_, name_bytes_),
+      time_source_(time_source), positions_(symbol_table) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+
+  // Readers may still map the file of a previous Envoy, which would fault if it was truncated under
+  // them, so it is replaced by a new file instead.
+  ::unlink(path.c_str());
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP);
+  if (fd == -1) {
+    throw EnvoyException(fmt::format("unable to create shared memory stats file '{}': {}", path,
+                                     errorDetails(errno)));
+  }
+  const Api::SysCallIntResult truncate_result = os_sys_calls.ftruncate(fd, layout_.size_);
+  if (truncate_result.rc_ == -1) {
+    os_sys_calls.close(fd);
+    throw EnvoyException(fmt::format("unable to size shared memory stats file '{}': {}", path,
+                                     errorDetails(truncate_result.errno_)));
+  }
+  const Api::SysCallPtrResult mmap_result =
+      os_sys_calls.mmap(nullptr, layout_.size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  os_sys_calls.close(fd);
+  if (mmap_result.rc_ == MAP_FAILED) {
+    throw EnvoyException(fmt::format("unable to map shared memory stats file '{}': {}", path,
+                                     errorDetails(mmap_result.errno_)));
+  }
+  region_ = mmap_result.rc_;
+
+  // The new file is all zeros, so only the sizes need to be set before publishing it.
+  RegionHeader& region_header = header();
+  region_header.version_ = LayoutVersion;
+  region_header.header_size_ = sizeof(RegionHeader);
+  region_header.max_stats_ = max_stats_;
+  region_header.index_size_ = index_size_;
+  region_header.name_bytes_ = name_bytes_;
+  region_header.magic_.store(LayoutMagic, std::memory_order_release);
+}
+
+SharedMemoryStatsSink::~SharedMemoryStatsSink() { ::munmap(region_, layout_.size_); }
+
+void SharedMemoryStatsSink::flush(Stats::MetricSnapshot& snapshot) {
+  num_dropped_ = 0;
+  for (const auto& counter : snapshot.counters()) {
+    exportStat(counter.counter_.get(), StatType::Counter, counter.counter_.get().value());
+  }
+  for (const auto& gauge : snapshot.gauges()) {
+    exportStat(gauge.get(), StatType::Gauge, gauge.get().value());
+  }
+
+  RegionHeader& region_header = header();
+  region_header.num_dropped_.store(num_dropped_, std::memory_order_relaxed);
+  region_header.flush_time_ms_.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         time_source_.systemTime().time_since_epoch())
+                                         .count(),
+                                     std::memory_order_relaxed);
+  region_header.flush_count_.fetch_add(1, std::memory_order_release);
+
+  if (++num_flushes_ % PositionSweepInterval == 0) {
+    positions_.sweep(num_flushes_ - PositionSweepInterval);
+  }
+}
+
+void SharedMemoryStatsSink::exportStat(const Stats::Metric& metric, StatType type,
+                                       uint64_t value) {
+  const uint32_t* position = positions_.find(metric.statName(), num_flushes_);
+  if (position != nullptr) {
+    entries()[*position].value_.store(value, std::memory_order_relaxed);
+    return;
+  }
+  const absl::optional<uint32_t> new_position = findOrAddEntry(metric, type, value);
+  if (!new_position.has_value()) {
+    // The stats which are not exported are not cached, so that their names are not kept alive
+    // once they are freed, and they are counted again on each flush.
+    num_dropped_++;
+    return;
+  }
+  positions_.insert(metric.statName(), num_flushes_, uint32_t{new_position.value()});
+}
+
+absl::optional<uint32_t> SharedMemoryStatsSink::findOrAddEntry(const Stats::Metric& metric,
+                                                               StatType type, uint64_t value) {
+  // A stat which was freed and created again, or whose position was swept from the cache, keeps
+  // its entry.
+  const std::string name = metric.name();
+  uint32_t slot = nameHash(name) & (index_size_ - 1);
+  for (uint32_t slot_value; (slot_value = index()[slot].load(std::memory_order_relaxed)) != 0;
+       slot = (slot + 1) & (index_size_ - 1)) {
+    if (entryName(slot_value - 1) == name) {
+      entries()[slot_value - 1].value_.store(value, std::memory_order_relaxed);
+      return slot_value - 1;
+    }
+  }
+
+  if (num_stats_ == max_stats_ || name.size() > std::numeric_limits<uint16_t>::max() ||
+      name.size() > name_bytes_ - name_bytes_used_) {
+    if (!dropped_warned_) {
+      dropped_warned_ = true;
+      ENVOY_LOG(warn, "shared memory stats file has no room for stat '{}', which is not exported",
+                name);
+    }
+    return absl::nullopt;
+  }
+
+  const uint32_t position = num_stats_;
+  std::memcpy(names() + name_bytes_used_, name.data(), name.size());
+  StatEntry& entry = entries()[position];
+  entry.name_offset_ = name_bytes_used_;
+  entry.name_length_ = static_cast<uint16_t>(name.size());
+  entry.type_ = type;
+  entry.value_.store(value, std::memory_order_relaxed);
+  name_bytes_used_ += name.size();
+
+  // The probe above stopped at the empty slot the entry goes in.
+  index()[slot].store(position + 1, std::memory_order_relaxed);
+
+  // Publishes the entry, its name and its slot in the index to the readers.
+  header().num_stats_.store(++num_stats_, std::memory_order_release);
+  return position;
+}
+
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
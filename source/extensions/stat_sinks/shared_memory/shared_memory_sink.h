@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/stats/sink.h"
+#include "envoy/stats/stats.h"
+
+#include "common/common/logger.h"
+#include "common/stats/stat_name_cache.h"
+#include "common/stats/symbol_table_impl.h"
+
+#include "extensions/stat_sinks/shared_memory/shared_memory_layout.h"
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+
+/**
+ * Mirrors the values of the counters and gauges into a file mapped in memory on each flush, with
+ * the layout described in shared_memory_layout.h, so that other processes on the host can read
+ * them without going through the admin endpoints. A stat is added to the file on the first flush
+ * it is part of, and stays there with its last value if it is freed. A stat created again later
+ * with the same name gets its entry back.
+ */
+class SharedMemoryStatsSink : public Stats::Sink, Logger::Loggable<Logger::Id::stats> {
+public:
+  /**
+   * Creates the file, replacing any previous one, and maps it.
+   * @param path the path of the file.
+   * @param max_stats the maximum number of stats in the file.
+   * @param name_bytes the space for the names of the stats in the file, in bytes.
+   * @param symbol_table the symbol table of the flushed stats.
+   * @param time_source the time source for the time of the flushes.
+   * @throw EnvoyException if the file cannot be created or mapped.
+   */
+  SharedMemoryStatsSink(const std::string& path, uint32_t max_stats, uint32_t name_bytes,
+                        Stats::SymbolTable& symbol_table, TimeSource& time_source);
+  ~SharedMemoryStatsSink() override;
+
+  // Stats::Sink
+  void flush(Stats::MetricSnapshot& snapshot) override;
+  void onHistogramComplete(const Stats::Histogram&, uint64_t) override {}
+
+private:
+  // The cached positions which were not used in this many flushes are dropped, including those of
+  // the stats which were freed.
+  static constexpr uint64_t PositionSweepInterval = 16;
+
+  void exportStat(const Stats::Metric& metric, StatType type, uint64_t value);
+  /**
+   * Finds the entry of a stat by name in the file, or adds it if there is room for it.
+   * @return the position of the entry, or absl::nullopt if the stat is not exported.
+   */
+  absl::optional<uint32_t> findOrAddEntry(const Stats::Metric& metric, StatType type,
+                                          uint64_t value);
+
+  RegionHeader& header() { return *static_cast<RegionHeader*>(region_); }
+  StatEntry* entries() { return reinterpret_cast<StatEntry*>(base() + layout_.entries_offset_); }
+  std::atomic<uint32_t>* index() {
+    return reinterpret_cast<std::atomic<uint32_t>*>(base() + layout_.index_offset_);
+  }
+  char* names() { return reinterpret_cast<char*>(base() + layout_.names_offset_); }
+  absl::string_view entryName(uint32_t position) {
+    const StatEntry& entry = entries()[position];
+    return {names() + entry.name_offset_, entry.name_length_};
+  }
+  uint8_t* base() { return static_cast<uint8_t*>(region_); }
+
+  const uint32_t max_stats_;
+  const uint32_t index_size_;
+  const uint32_t name_bytes_;
+  const RegionLayout layout_;
+  TimeSource& time_source_;
+  void* region_{};
+  uint32_t num_stats_{};
+  uint32_t name_bytes_used_{};
+  // The number of stats of the current flush which are not exported.
+  uint32_t num_dropped_{};
+  bool dropped_warned_{};
+  // The entry positions of the recently flushed stats, so that they are not looked up by name in
+  // the file on every flush. Only the exported stats are cached, so the cache is bounded by the
+  // size of the file rather than by the number of stats ever flushed.
+  Stats::StatNameCache<uint32_t> positions_;
+  // The number of flushes, which the cached positions are marked as used in.
+  uint64_t num_flushes_{};
+};
+
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
@@ -930,6 +930,7 @@ Http::Code AdminImpl::request(absl::string_view path_and_query, absl::string_vie
   Buffer::OwnedImpl response;
 
   Http::Code code = runCallback(path_and_query, response_headers, response, filter);
+  filter.renderRemainingChunks(response);
   Utility::populateFallbackResponseHeaders(code, response_headers);
   body = response.toString();
   return code;
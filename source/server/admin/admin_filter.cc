@@ -38,6 +38,12 @@ Http::FilterTrailersStatus AdminFilter::decodeTrailers(Http::RequestTrailerMap&)
 }
 
 void AdminFilter::onDestroy() {
+  if (watermark_callbacks_added_) {
+    decoder_callbacks_->removeDownstreamWatermarkCallbacks(*this);
+    watermark_callbacks_added_ = false;
+  }
+  next_chunk_cb_.reset();
+  next_chunk_ = nullptr;
   for (const auto& callback : on_destroy_callbacks_) {
     callback();
   }
@@ -47,6 +53,44 @@ void AdminFilter::addOnDestroyCallback(std::function<void()> cb) {
   on_destroy_callbacks_.push_back(std::move(cb));
 }
 
+void AdminFilter::setNextChunkCallback(NextChunkCb next_chunk) {
+  ASSERT(next_chunk_ == nullptr);
+  next_chunk_ = std::move(next_chunk);
+}
+
+void AdminFilter::onAboveWriteBufferHighWatermark() { ++high_watermark_count_; }
+
+void AdminFilter::onBelowWriteBufferLowWatermark() {
+  ASSERT(high_watermark_count_ > 0);
+  if (--high_watermark_count_ == 0 && next_chunk_cb_ != nullptr && next_chunk_ != nullptr) {
+    next_chunk_cb_->scheduleCallbackNextIteration();
+  }
+}
+
+void AdminFilter::renderRemainingChunks(Buffer::Instance& response) {
+  if (next_chunk_ == nullptr) {
+    return;
+  }
+  while (next_chunk_(response)) {
+  }
+  next_chunk_ = nullptr;
+}
+
+void AdminFilter::sendNextChunk() {
+  ASSERT(next_chunk_ != nullptr);
+  Buffer::OwnedImpl chunk;
+  const bool more = next_chunk_(chunk);
+  if (!more) {
+    next_chunk_ = nullptr;
+  }
+  // Sending the chunk may take the stream over its high watermark, in which case the next chunk
+  // is scheduled when it goes back under its low watermark.
+  decoder_callbacks_->encodeData(chunk, !more);
+  if (more && high_watermark_count_ == 0) {
+    next_chunk_cb_->scheduleCallbackNextIteration();
+  }
+}
+
 Http::StreamDecoderFilterCallbacks& AdminFilter::getDecoderFilterCallbacks() const {
   ASSERT(decoder_callbacks_ != nullptr);
   return *decoder_callbacks_;
@@ -72,11 +116,21 @@ void AdminFilter::onComplete() {
   Utility::populateFallbackResponseHeaders(code, *header_map);
   decoder_callbacks_->streamInfo().setResponseCodeDetails(
       StreamInfo::ResponseCodeDetails::get().AdminFilterResponse);
-  decoder_callbacks_->encodeHeaders(std::move(header_map),
-                                    end_stream_on_complete_ && response.length() == 0);
+  const bool end_stream = end_stream_on_complete_ && next_chunk_ == nullptr;
+  decoder_callbacks_->encodeHeaders(std::move(header_map), end_stream && response.length() == 0);
 
   if (response.length() > 0) {
-    decoder_callbacks_->encodeData(response, end_stream_on_complete_);
+    decoder_callbacks_->encodeData(response, end_stream);
+  }
+
+  if (next_chunk_ != nullptr) {
+    decoder_callbacks_->addDownstreamWatermarkCallbacks(*this);
+    watermark_callbacks_added_ = true;
+    next_chunk_cb_ =
+        decoder_callbacks_->dispatcher().createSchedulableCallback([this]() { sendNextChunk(); });
+    if (high_watermark_count_ == 0) {
+      next_chunk_cb_->scheduleCallbackNextIteration();
+    }
   }
 }
 
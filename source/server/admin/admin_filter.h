@@ -3,6 +3,8 @@
 #include <functional>
 #include <list>
 
+#include "envoy/event/schedulable_cb.h"
+#include "envoy/http/codec.h"
 #include "envoy/http/filter.h"
 #include "envoy/server/admin.h"
 
@@ -23,6 +25,7 @@ namespace Server {
  */
 class AdminFilter : public Http::PassThroughFilter,
                     public AdminStream,
+                    public Http::DownstreamWatermarkCallbacks,
                     Logger::Loggable<Logger::Id::admin> {
 public:
   using AdminServerCallbackFunction = std::function<Http::Code(
@@ -46,6 +49,7 @@ public:
   // AdminStream
   void setEndStreamOnComplete(bool end_stream) override { end_stream_on_complete_ = end_stream; }
   void addOnDestroyCallback(std::function<void()> cb) override;
+  void setNextChunkCallback(NextChunkCb next_chunk) override;
   Http::StreamDecoderFilterCallbacks& getDecoderFilterCallbacks() const override;
   const Buffer::Instance* getRequestBody() const override;
   const Http::RequestHeaderMap& getRequestHeaders() const override;
@@ -53,15 +57,37 @@ public:
     return encoder_callbacks_->http1StreamEncoderOptions();
   }
 
+  // Http::DownstreamWatermarkCallbacks
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
+
+  /**
+   * Renders all the chunks of the response left, for requests made without a stream to send them
+   * on.
+   * @param response supplies the buffer to append the chunks to.
+   */
+  void renderRemainingChunks(Buffer::Instance& response);
+
 private:
   /**
    * Called when an admin request has been completely received.
    */
   void onComplete();
+
+  /**
+   * Renders and sends the next chunk of the response, scheduling the one after unless the client
+   * is behind.
+   */
+  void sendNextChunk();
+
   AdminServerCallbackFunction admin_server_callback_func_;
   Http::RequestHeaderMap* request_headers_{};
   std::list<std::function<void()>> on_destroy_callbacks_;
   bool end_stream_on_complete_ = true;
+  NextChunkCb next_chunk_;
+  Event::SchedulableCallbackPtr next_chunk_cb_;
+  uint32_t high_watermark_count_{};
+  bool watermark_callbacks_added_{};
 };
 
 } // namespace Server
@@ -1,5 +1,8 @@
 #include "server/admin/prometheus_stats.h"
 
+#include <limits>
+
+#include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/macros.h"
 #include "common/stats/histogram_impl.h"
@@ -48,95 +51,12 @@ struct MetricLessThan {
   }
 };
 
-/**
- * Processes a stat type (counter, gauge, histogram) by generating all output lines, sorting
- * them by tag-extracted metric name, and then outputting them in the correct sorted order into
- * response.
- *
- * @param response The buffer to put the output into.
- * @param used_only Whether to only output stats that are used.
- * @param regex A filter on which stats to output.
- * @param metrics The metrics to output stats for. This must contain all stats of the given type
- *        to be included in the same output.
- * @param generate_output A function which returns the output text for this metric.
- * @param type The name of the prometheus metric type for used in TYPE annotations.
- */
-template <class StatType>
-uint64_t outputStatType(
-    Buffer::Instance& response, const bool used_only, const absl::optional<std::regex>& regex,
-    const std::vector<Stats::RefcountPtr<StatType>>& metrics,
-    const std::function<std::string(
-        const StatType& metric, const std::string& prefixed_tag_extracted_name)>& generate_output,
-    absl::string_view type) {
-
-  /*
-   * From
-   * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
-   *
-   * All lines for a given metric must be provided as one single group, with the optional HELP and
-   * TYPE lines first (in no particular order). Beyond that, reproducible sorting in repeated
-   * expositions is preferred but not required, i.e. do not sort if the computational cost is
-   * prohibitive.
-   */
-
-  // This is an unsorted collection of dumb-pointers (no need to increment then decrement every
-  // refcount; ownership is held throughout by `metrics`). It is unsorted for efficiency, but will
-  // be sorted before producing the final output to satisfy the "preferred" ordering from the
-  // prometheus spec: metrics will be sorted by their tags' textual representation, which will be
-  // consistent across calls.
-  using StatTypeUnsortedCollection = std::vector<const StatType*>;
-
-  // Return early to avoid crashing when getting the symbol table from the first metric.
-  if (metrics.empty()) {
-    return 0;
-  }
-
-  // There should only be one symbol table for all of the stats in the admin
-  // interface. If this assumption changes, the name comparisons in this function
-  // will have to change to compare to convert all StatNames to strings before
-  // comparison.
-  const Stats::SymbolTable& global_symbol_table = metrics.front()->constSymbolTable();
-
-  // Sorted collection of metrics sorted by their tagExtractedName, to satisfy the requirements
-  // of the exposition format.
-  std::map<Stats::StatName, StatTypeUnsortedCollection, Stats::StatNameLessThan> groups(
-      global_symbol_table);
-
-  for (const auto& metric : metrics) {
-    ASSERT(&global_symbol_table == &metric->constSymbolTable());
-
-    if (!shouldShowMetric(*metric, used_only, regex)) {
-      continue;
-    }
-
-    groups[metric->tagExtractedStatName()].push_back(metric.get());
-  }
-
-  for (auto& group : groups) {
-    const std::string prefixed_tag_extracted_name =
-        PrometheusStatsFormatter::metricName(global_symbol_table.toString(group.first));
-    response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name, type));
-
-    // Sort before producing the final output to satisfy the "preferred" ordering from the
-    // prometheus spec: metrics will be sorted by their tags' textual representation, which will
-    // be consistent across calls.
-    std::sort(group.second.begin(), group.second.end(), MetricLessThan());
-
-    for (const auto& metric : group.second) {
-      response.add(generate_output(*metric, prefixed_tag_extracted_name));
-    }
-    response.add("\n");
-  }
-  return groups.size();
-}
-
 /*
  * Return the prometheus output for a numeric Stat (Counter or Gauge).
  */
 template <class StatType>
-std::string generateNumericOutput(const StatType& metric,
+std::string generateNumericOutput(const StatType& metric, const std::string& tags,
                                   const std::string& prefixed_tag_extracted_name) {
-  const std::string tags = PrometheusStatsFormatter::formattedTags(metric.tags());
   return fmt::format("{0}{{{1}}} {2}\n", prefixed_tag_extracted_name, tags, metric.value());
 }
 
@@ -146,8 +66,8 @@ std::string generateNumericOutput(const StatType& metric,
  * (metric_name plus all tags).
  */
 std::string generateHistogramOutput(const Stats::ParentHistogram& histogram,
+                                    const std::string& tags,
                                     const std::string& prefixed_tag_extracted_name) {
-  const std::string tags = PrometheusStatsFormatter::formattedTags(histogram.tags());
   const std::string hist_tags = histogram.tags().empty() ? EMPTY_STRING : (tags + ",");
 
   const Stats::HistogramStatistics& stats = histogram.cumulativeStatistics();
@@ -180,8 +100,154 @@ absl::flat_hash_set<std::string>& prometheusNamespaces() {
   MUTABLE_CONSTRUCT_ON_FIRST_USE(absl::flat_hash_set<std::string>);
 }
 
+// Bumped when the registered namespaces change, which changes the metric names.
+uint64_t& prometheusNamespacesGeneration() { MUTABLE_CONSTRUCT_ON_FIRST_USE(uint64_t, 0); }
+
 } // namespace
 
+const std::string& PrometheusNameCache::metricName(const Stats::Metric& metric) {
+  if (namespaces_generation_ != prometheusNamespacesGeneration()) {
+    metric_names_.clear();
+    namespaces_generation_ = prometheusNamespacesGeneration();
+  }
+  return metric_names_.get(metric.tagExtractedStatName(), generation_, [&metric]() {
+    return PrometheusStatsFormatter::metricName(metric.tagExtractedName());
+  });
+}
+
+const std::string& PrometheusNameCache::formattedTags(const Stats::Metric& metric) {
+  return formatted_tags_.get(metric.statName(), generation_, [&metric]() {
+    return PrometheusStatsFormatter::formattedTags(metric.tags());
+  });
+}
+
+PrometheusStatsRenderer::PrometheusStatsRenderer(
+    std::vector<Stats::CounterSharedPtr> counters, std::vector<Stats::GaugeSharedPtr> gauges,
+    std::vector<Stats::ParentHistogramSharedPtr> histograms, const bool used_only,
+    const absl::optional<std::regex>& regex, PrometheusNameCacheSharedPtr name_cache)
+    : counters_(std::move(counters)), gauges_(std::move(gauges)),
+      histograms_(std::move(histograms)), name_cache_(std::move(name_cache)),
+      unfiltered_(!used_only && !regex.has_value()) {
+  if (name_cache_ != nullptr) {
+    generation_ = name_cache_->startScrape();
+  }
+  addGroups(counters_, Type::Counter, used_only, regex);
+  addGroups(gauges_, Type::Gauge, used_only, regex);
+  addGroups(histograms_, Type::Histogram, used_only, regex);
+}
+
+template <class StatType>
+void PrometheusStatsRenderer::addGroups(const std::vector<Stats::RefcountPtr<StatType>>& metrics,
+                                        Type type, const bool used_only,
+                                        const absl::optional<std::regex>& regex) {
+  /*
+   * From
+   * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
+   *
+   * All lines for a given metric must be provided as one single group, with the optional HELP and
+   * TYPE lines first (in no particular order). Beyond that, reproducible sorting in repeated
+   * expositions is preferred but not required, i.e. do not sort if the computational cost is
+   * prohibitive.
+   */
+
+  // Return early to avoid crashing when getting the symbol table from the first metric.
+  if (metrics.empty()) {
+    return;
+  }
+
+  // There should only be one symbol table for all of the stats in the admin
+  // interface. If this assumption changes, the name comparisons in this function
+  // will have to change to compare to convert all StatNames to strings before
+  // comparison.
+  const Stats::SymbolTable& global_symbol_table = metrics.front()->constSymbolTable();
+
+  // Metrics grouped by their tagExtractedName, sorted to satisfy the requirements of the
+  // exposition format. The metrics of each group are collected unsorted for efficiency, and sorted
+  // when the group is rendered.
+  std::map<Stats::StatName, std::vector<const Stats::Metric*>, Stats::StatNameLessThan> groups(
+      global_symbol_table);
+
+  for (const auto& metric : metrics) {
+    ASSERT(&global_symbol_table == &metric->constSymbolTable());
+
+    if (!shouldShowMetric(*metric, used_only, regex)) {
+      continue;
+    }
+
+    groups[metric->tagExtractedStatName()].push_back(metric.get());
+  }
+
+  groups_.reserve(groups_.size() + groups.size());
+  for (auto& group : groups) {
+    groups_.push_back(Group{type, std::move(group.second)});
+  }
+}
+
+bool PrometheusStatsRenderer::nextChunk(Buffer::Instance& response, uint64_t chunk_size) {
+  std::string output;
+  while (group_index_ < groups_.size() && output.size() < chunk_size) {
+    Group& group = groups_[group_index_];
+    if (metric_index_ == 0) {
+      prefixed_tag_extracted_name_ = metricName(*group.metrics_.front());
+      absl::string_view type = group.type_ == Type::Counter ? "counter"
+                               : group.type_ == Type::Gauge ? "gauge"
+                                                            : "histogram";
+      output.append(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name_, type));
+
+      // Sort before producing the final output to satisfy the "preferred" ordering from the
+      // prometheus spec: metrics will be sorted by their tags' textual representation, which will
+      // be consistent across calls.
+      std::sort(group.metrics_.begin(), group.metrics_.end(), MetricLessThan());
+    }
+
+    output.append(renderMetric(*group.metrics_[metric_index_], group.type_));
+    if (++metric_index_ == group.metrics_.size()) {
+      output.append("\n");
+      ++group_index_;
+      metric_index_ = 0;
+    }
+  }
+  response.add(output);
+
+  if (group_index_ < groups_.size()) {
+    return true;
+  }
+  if (name_cache_ != nullptr && unfiltered_) {
+    name_cache_->sweep(generation_);
+  }
+  return false;
+}
+
+std::string PrometheusStatsRenderer::metricName(const Stats::Metric& metric) {
+  if (name_cache_ != nullptr) {
+    return name_cache_->metricName(metric);
+  }
+  return PrometheusStatsFormatter::metricName(metric.tagExtractedName());
+}
+
+std::string PrometheusStatsRenderer::formattedTags(const Stats::Metric& metric) {
+  if (name_cache_ != nullptr) {
+    return name_cache_->formattedTags(metric);
+  }
+  return PrometheusStatsFormatter::formattedTags(metric.tags());
+}
+
+std::string PrometheusStatsRenderer::renderMetric(const Stats::Metric& metric, Type type) {
+  const std::string tags = formattedTags(metric);
+  switch (type) {
+  case Type::Counter:
+    return generateNumericOutput(static_cast<const Stats::Counter&>(metric), tags,
+                                 prefixed_tag_extracted_name_);
+  case Type::Gauge:
+    return generateNumericOutput(static_cast<const Stats::Gauge&>(metric), tags,
+                                 prefixed_tag_extracted_name_);
+  case Type::Histogram:
+    return generateHistogramOutput(static_cast<const Stats::ParentHistogram&>(metric), tags,
+                                   prefixed_tag_extracted_name_);
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
 std::string PrometheusStatsFormatter::formattedTags(const std::vector<Stats::Tag>& tags) {
   std::vector<std::string> buf;
   buf.reserve(tags.size());
@@ -213,24 +279,19 @@ uint64_t PrometheusStatsFormatter::statsAsPrometheus(
     const std::vector<Stats::GaugeSharedPtr>& gauges,
     const std::vector<Stats::ParentHistogramSharedPtr>& histograms, Buffer::Instance& response,
     const bool used_only, const absl::optional<std::regex>& regex) {
-
-  uint64_t metric_name_count = 0;
-  metric_name_count += outputStatType<Stats::Counter>(
-      response, used_only, regex, counters, generateNumericOutput<Stats::Counter>, "counter");
-
-  metric_name_count += outputStatType<Stats::Gauge>(response, used_only, regex, gauges,
-                                                    generateNumericOutput<Stats::Gauge>, "gauge");
-
-  metric_name_count += outputStatType<Stats::ParentHistogram>(
-      response, used_only, regex, histograms, generateHistogramOutput, "histogram");
-
-  return metric_name_count;
+  PrometheusStatsRenderer renderer(counters, gauges, histograms, used_only, regex, nullptr);
+  while (renderer.nextChunk(response, std::numeric_limits<uint64_t>::max())) {
+  }
+  return renderer.metricNameCount();
 }
 
 bool PrometheusStatsFormatter::registerPrometheusNamespace(absl::string_view prometheus_namespace) {
   if (std::regex_match(prometheus_namespace.begin(), prometheus_namespace.end(),
                        namespaceRegex())) {
-    return prometheusNamespaces().insert(std::string(prometheus_namespace)).second;
+    if (prometheusNamespaces().insert(std::string(prometheus_namespace)).second) {
+      ++prometheusNamespacesGeneration();
+      return true;
+    }
   }
   return false;
 }
@@ -242,6 +303,7 @@ bool PrometheusStatsFormatter::unregisterPrometheusNamespace(
     return false;
   }
   prometheusNamespaces().erase(it);
+  ++prometheusNamespacesGeneration();
   return true;
 }
 
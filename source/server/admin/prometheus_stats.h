@@ -1,14 +1,132 @@
 #pragma once
 
+#include <memory>
 #include <regex>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/stats/histogram.h"
 #include "envoy/stats/stats.h"
+#include "envoy/stats/symbol_table.h"
+
+#include "common/stats/stat_name_cache.h"
+#include "common/stats/symbol_table_impl.h"
+
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Server {
+
+/**
+ * Caches the Prometheus metric names of tag-extracted stat names, and the formatted tags of
+ * metrics, across scrapes, as rendering them is the bulk of the cost of a scrape. The entries that
+ * an unfiltered scrape doesn't use are dropped when it completes, so that the cache follows the
+ * metrics that exist. This must only be used from the main thread.
+ */
+class PrometheusNameCache {
+public:
+  explicit PrometheusNameCache(Stats::SymbolTable& symbol_table)
+      : metric_names_(symbol_table), formatted_tags_(symbol_table) {}
+
+  /**
+   * @return the Prometheus metric name of the tag-extracted name of a metric.
+   */
+  const std::string& metricName(const Stats::Metric& metric);
+
+  /**
+   * @return the formatted tags of a metric.
+   */
+  const std::string& formattedTags(const Stats::Metric& metric);
+
+  /**
+   * Starts a scrape.
+   * @return uint64_t the generation of the scrape, to be passed to sweep() when it completes.
+   */
+  uint64_t startScrape() { return ++generation_; }
+
+  /**
+   * Drops the entries which were not used since the scrape of the given generation started.
+   */
+  void sweep(uint64_t generation) {
+    metric_names_.sweep(generation);
+    formatted_tags_.sweep(generation);
+  }
+
+  /**
+   * @return uint64_t the number of cached entries.
+   */
+  uint64_t size() const { return metric_names_.size() + formatted_tags_.size(); }
+
+private:
+  Stats::StatNameCache<std::string> metric_names_;
+  Stats::StatNameCache<std::string> formatted_tags_;
+  uint64_t generation_{};
+  // The generation of the registered Prometheus namespaces the metric names were rendered with.
+  uint64_t namespaces_generation_{};
+};
+
+using PrometheusNameCacheSharedPtr = std::shared_ptr<PrometheusNameCache>;
+
+/**
+ * Renders counters, gauges and histograms in the Prometheus exposition format, in chunks. The
+ * metrics are filtered and grouped by tag-extracted name up front, which only takes pointers to
+ * them, and their text is rendered as the chunks are requested.
+ */
+class PrometheusStatsRenderer {
+public:
+  /**
+   * @param name_cache supplies a cache of rendered names to use across scrapes, or nullptr.
+   */
+  PrometheusStatsRenderer(std::vector<Stats::CounterSharedPtr> counters,
+                          std::vector<Stats::GaugeSharedPtr> gauges,
+                          std::vector<Stats::ParentHistogramSharedPtr> histograms,
+                          const bool used_only, const absl::optional<std::regex>& regex,
+                          PrometheusNameCacheSharedPtr name_cache);
+
+  /**
+   * Renders metrics until at least chunk_size bytes are appended to the response, or all metrics
+   * are rendered.
+   * @return bool whether metrics are left to render.
+   */
+  bool nextChunk(Buffer::Instance& response, uint64_t chunk_size);
+
+  /**
+   * @return uint64_t the number of metric names, each with a TYPE annotation, in the output.
+   */
+  uint64_t metricNameCount() const { return groups_.size(); }
+
+private:
+  enum class Type { Counter, Gauge, Histogram };
+
+  // The metrics of a tag-extracted name, which are output together.
+  struct Group {
+    Type type_;
+    std::vector<const Stats::Metric*> metrics_;
+  };
+
+  template <class StatType>
+  void addGroups(const std::vector<Stats::RefcountPtr<StatType>>& metrics, Type type,
+                 const bool used_only, const absl::optional<std::regex>& regex);
+  std::string metricName(const Stats::Metric& metric);
+  std::string formattedTags(const Stats::Metric& metric);
+  std::string renderMetric(const Stats::Metric& metric, Type type);
+
+  // Hold the references to the metrics of the groups.
+  const std::vector<Stats::CounterSharedPtr> counters_;
+  const std::vector<Stats::GaugeSharedPtr> gauges_;
+  const std::vector<Stats::ParentHistogramSharedPtr> histograms_;
+  const PrometheusNameCacheSharedPtr name_cache_;
+  uint64_t generation_{};
+  // Whether the scrape renders all metrics, which lets it sweep the name cache.
+  const bool unfiltered_;
+
+  std::vector<Group> groups_;
+  size_t group_index_{};
+  size_t metric_index_{};
+  // The metric name of the group being rendered.
+  std::string prefixed_tag_extracted_name_;
+};
 /**
  * Formatter for metric/labels exported to Prometheus.
  *
@@ -18,7 +136,8 @@ class PrometheusStatsFormatter {
 public:
   /**
    * Extracts counters and gauges and relevant tags, appending them to
-   * the response buffer after sanitizing the metric / label names.
+   * the response buffer after sanitizing the metric / label names. See
+   * PrometheusStatsRenderer to render large outputs in chunks.
    * @return uint64_t total number of metric types inserted in response.
    */
   static uint64_t statsAsPrometheus(const std::vector<Stats::CounterSharedPtr>& counters,
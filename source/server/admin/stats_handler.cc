@@ -1,5 +1,7 @@
 #include "server/admin/stats_handler.h"
 
+#include <cmath>
+
 #include "envoy/admin/v3/mutex_stats.pb.h"
 
 #include "common/common/empty_string.h"
@@ -10,11 +12,64 @@
 #include "server/admin/prometheus_stats.h"
 #include "server/admin/utils.h"
 
+#include "absl/strings/str_join.h"
+
 namespace Envoy {
 namespace Server {
 
 const uint64_t RecentLookupsCapacity = 100;
 
+// The size of the chunks large stats responses are rendered in.
+const uint64_t StatsChunkSize = 64 * 1024;
+
+namespace {
+
+/*
+ * Comparator for Stats::Metric that does not require a string representation
+ * to make the comparison, for memory efficiency.
+ */
+struct MetricLessThan {
+  bool operator()(const Stats::Metric* a, const Stats::Metric* b) const {
+    ASSERT(&a->constSymbolTable() == &b->constSymbolTable());
+    return a->constSymbolTable().lessThan(a->statName(), b->statName());
+  }
+};
+
+/**
+ * Appends a string to a JSON document as a quoted and escaped JSON string.
+ */
+void appendJsonString(absl::string_view str, std::string& output) {
+  output.push_back('"');
+  for (const char c : str) {
+    switch (c) {
+    case '"':
+      output.append("\\\"");
+      break;
+    case '\\':
+      output.append("\\\\");
+      break;
+    case '\n':
+      output.append("\\n");
+      break;
+    case '\r':
+      output.append("\\r");
+      break;
+    case '\t':
+      output.append("\\t");
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        output.append(fmt::format("\\u{:04x}", static_cast<unsigned char>(c)));
+      } else {
+        output.push_back(c);
+      }
+    }
+  }
+  output.push_back('"');
+}
+
+} // namespace
+
 StatsHandler::StatsHandler(Server::Instance& server) : HandlerContextBase(server) {}
 
 Http::Code StatsHandler::handlerResetCounters(absl::string_view, Http::ResponseHeaderMap&,
@@ -71,7 +126,6 @@ Http::Code StatsHandler::handlerStatsRecentLookupsEnable(absl::string_view,
 Http::Code StatsHandler::handlerStats(absl::string_view url,
                                       Http::ResponseHeaderMap& response_headers,
                                       Buffer::Instance& response, AdminStream& admin_stream) {
-  Http::Code rc = Http::Code::OK;
   const Http::Utility::QueryParams params = Http::Utility::parseAndDecodeQueryString(url);
 
   const bool used_only = params.find("usedonly") != params.end();
@@ -80,6 +134,27 @@ Http::Code StatsHandler::handlerStats(absl::string_view url,
     return Http::Code::BadRequest;
   }
 
+  const absl::optional<std::string> format_value = Utility::formatParam(params);
+  if (format_value.has_value() && format_value.value() == "json") {
+    response_headers.setReferenceContentType(Http::Headers::get().ContentTypeValues.Json);
+    auto renderer = std::make_shared<StatsJsonRenderer>(
+        server_.stats().textReadouts(), server_.stats().counters(), server_.stats().gauges(),
+        server_.stats().histograms(), used_only, regex);
+    admin_stream.setNextChunkCallback([renderer](Buffer::Instance& chunk) {
+      return renderer->nextChunk(chunk, StatsChunkSize);
+    });
+    return Http::Code::OK;
+  }
+  if (format_value.has_value() && format_value.value() == "prometheus") {
+    return handlerPrometheusStats(url, response_headers, response, admin_stream);
+  }
+  if (format_value.has_value()) {
+    response.add("usage: /stats?format=json  or /stats?format=prometheus \n");
+    response.add("\n");
+    return Http::Code::NotFound;
+  }
+
+  // Display plain stats if format query param is not there.
   std::map<std::string, uint64_t> all_stats;
   for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
     if (shouldShowMetric(*counter, used_only, regex)) {
@@ -101,43 +176,30 @@ Http::Code StatsHandler::handlerStats(absl::string_view url,
     }
   }
 
-  if (const auto format_value = Utility::formatParam(params)) {
-    if (format_value.value() == "json") {
-      response_headers.setReferenceContentType(Http::Headers::get().ContentTypeValues.Json);
-      response.add(
-          statsAsJson(all_stats, text_readouts, server_.stats().histograms(), used_only, regex));
-    } else if (format_value.value() == "prometheus") {
-      return handlerPrometheusStats(url, response_headers, response, admin_stream);
-    } else {
-      response.add("usage: /stats?format=json  or /stats?format=prometheus \n");
-      response.add("\n");
-      rc = Http::Code::NotFound;
-    }
-  } else { // Display plain stats if format query param is not there.
-    for (const auto& text_readout : text_readouts) {
-      response.add(fmt::format("{}: \"{}\"\n", text_readout.first,
-                               Html::Utility::sanitize(text_readout.second)));
-    }
-    for (const auto& stat : all_stats) {
-      response.add(fmt::format("{}: {}\n", stat.first, stat.second));
-    }
-    std::map<std::string, std::string> all_histograms;
-    for (const Stats::ParentHistogramSharedPtr& histogram : server_.stats().histograms()) {
-      if (shouldShowMetric(*histogram, used_only, regex)) {
-        auto insert = all_histograms.emplace(histogram->name(), histogram->quantileSummary());
-        ASSERT(insert.second); // No duplicates expected.
-      }
-    }
-    for (const auto& histogram : all_histograms) {
-      response.add(fmt::format("{}: {}\n", histogram.first, histogram.second));
+  for (const auto& text_readout : text_readouts) {
+    response.add(fmt::format("{}: \"{}\"\n", text_readout.first,
+                             Html::Utility::sanitize(text_readout.second)));
+  }
+  for (const auto& stat : all_stats) {
+    response.add(fmt::format("{}: {}\n", stat.first, stat.second));
+  }
+  std::map<std::string, std::string> all_histograms;
+  for (const Stats::ParentHistogramSharedPtr& histogram : server_.stats().histograms()) {
+    if (shouldShowMetric(*histogram, used_only, regex)) {
+      auto insert = all_histograms.emplace(histogram->name(), histogram->quantileSummary());
+      ASSERT(insert.second); // No duplicates expected.
     }
   }
-  return rc;
+  for (const auto& histogram : all_histograms) {
+    response.add(fmt::format("{}: {}\n", histogram.first, histogram.second));
+  }
+  return Http::Code::OK;
 }
 
 Http::Code StatsHandler::handlerPrometheusStats(absl::string_view path_and_query,
                                                 Http::ResponseHeaderMap&,
-                                                Buffer::Instance& response, AdminStream&) {
+                                                Buffer::Instance& response,
+                                                AdminStream& admin_stream) {
   const Http::Utility::QueryParams params =
       Http::Utility::parseAndDecodeQueryString(path_and_query);
   const bool used_only = params.find("usedonly") != params.end();
@@ -145,9 +207,12 @@ Http::Code StatsHandler::handlerPrometheusStats(absl::string_view path_and_query
   if (!Utility::filterParam(params, response, regex)) {
     return Http::Code::BadRequest;
   }
-  PrometheusStatsFormatter::statsAsPrometheus(server_.stats().counters(), server_.stats().gauges(),
-                                              server_.stats().histograms(), response, used_only,
-                                              regex);
+  auto renderer = std::make_shared<PrometheusStatsRenderer>(
+      server_.stats().counters(), server_.stats().gauges(), server_.stats().histograms(),
+      used_only, regex, prometheusNameCache());
+  admin_stream.setNextChunkCallback([renderer](Buffer::Instance& chunk) {
+    return renderer->nextChunk(chunk, StatsChunkSize);
+  });
   return Http::Code::OK;
 }
 
@@ -171,85 +236,129 @@ Http::Code StatsHandler::handlerContention(absl::string_view,
   return Http::Code::OK;
 }
 
-std::string
-StatsHandler::statsAsJson(const std::map<std::string, uint64_t>& all_stats,
-                          const std::map<std::string, std::string>& text_readouts,
-                          const std::vector<Stats::ParentHistogramSharedPtr>& all_histograms,
-                          const bool used_only, const absl::optional<std::regex> regex,
-                          const bool pretty_print) {
+PrometheusNameCacheSharedPtr StatsHandler::prometheusNameCache() {
+  if (prometheus_name_cache_ == nullptr) {
+    prometheus_name_cache_ = std::make_shared<PrometheusNameCache>(server_.stats().symbolTable());
+  }
+  return prometheus_name_cache_;
+}
 
-  ProtobufWkt::Struct document;
-  std::vector<ProtobufWkt::Value> stats_array;
-  for (const auto& text_readout : text_readouts) {
-    ProtobufWkt::Struct stat_obj;
-    auto* stat_obj_fields = stat_obj.mutable_fields();
-    (*stat_obj_fields)["name"] = ValueUtil::stringValue(text_readout.first);
-    (*stat_obj_fields)["value"] = ValueUtil::stringValue(text_readout.second);
-    stats_array.push_back(ValueUtil::structValue(stat_obj));
+StatsJsonRenderer::StatsJsonRenderer(std::vector<Stats::TextReadoutSharedPtr> text_readouts,
+                                     std::vector<Stats::CounterSharedPtr> counters,
+                                     std::vector<Stats::GaugeSharedPtr> gauges,
+                                     std::vector<Stats::ParentHistogramSharedPtr> histograms,
+                                     const bool used_only, const absl::optional<std::regex>& regex)
+    : text_readouts_(std::move(text_readouts)), counters_(std::move(counters)),
+      gauges_(std::move(gauges)), histograms_(std::move(histograms)) {
+  for (const Stats::TextReadoutSharedPtr& text_readout : text_readouts_) {
+    if (StatsHandler::shouldShowMetric(*text_readout, used_only, regex)) {
+      shown_text_readouts_.push_back(text_readout.get());
+    }
   }
-  for (const auto& stat : all_stats) {
-    ProtobufWkt::Struct stat_obj;
-    auto* stat_obj_fields = stat_obj.mutable_fields();
-    (*stat_obj_fields)["name"] = ValueUtil::stringValue(stat.first);
-    (*stat_obj_fields)["value"] = ValueUtil::numberValue(stat.second);
-    stats_array.push_back(ValueUtil::structValue(stat_obj));
+  for (const Stats::CounterSharedPtr& counter : counters_) {
+    if (StatsHandler::shouldShowMetric(*counter, used_only, regex)) {
+      shown_numeric_stats_.emplace_back(counter.get(), counter->value());
+    }
+  }
+  for (const Stats::GaugeSharedPtr& gauge : gauges_) {
+    if (StatsHandler::shouldShowMetric(*gauge, used_only, regex)) {
+      ASSERT(gauge->importMode() != Stats::Gauge::ImportMode::Uninitialized);
+      shown_numeric_stats_.emplace_back(gauge.get(), gauge->value());
+    }
+  }
+  for (const Stats::ParentHistogramSharedPtr& histogram : histograms_) {
+    if (StatsHandler::shouldShowMetric(*histogram, used_only, regex)) {
+      shown_histograms_.push_back(histogram.get());
+    }
   }
 
-  ProtobufWkt::Struct histograms_obj;
-  auto* histograms_obj_fields = histograms_obj.mutable_fields();
+  // Stats are sorted by name with the symbol table, which doesn't need their string
+  // representations. All the stats in the admin interface share one symbol table.
+  std::sort(shown_text_readouts_.begin(), shown_text_readouts_.end(), MetricLessThan());
+  std::sort(shown_numeric_stats_.begin(), shown_numeric_stats_.end(),
+            [](const std::pair<const Stats::Metric*, uint64_t>& a,
+               const std::pair<const Stats::Metric*, uint64_t>& b) {
+              return MetricLessThan()(a.first, b.first);
+            });
+  std::sort(shown_histograms_.begin(), shown_histograms_.end(), MetricLessThan());
+}
 
-  ProtobufWkt::Struct histograms_obj_container;
-  auto* histograms_obj_container_fields = histograms_obj_container.mutable_fields();
-  std::vector<ProtobufWkt::Value> computed_quantile_array;
+bool StatsJsonRenderer::nextChunk(Buffer::Instance& response, uint64_t chunk_size) {
+  const size_t num_text_readouts = shown_text_readouts_.size();
+  const size_t num_stats = num_text_readouts + shown_numeric_stats_.size();
+  const size_t num_all = num_stats + shown_histograms_.size();
 
-  bool found_used_histogram = false;
-  for (const Stats::ParentHistogramSharedPtr& histogram : all_histograms) {
-    if (shouldShowMetric(*histogram, used_only, regex)) {
-      if (!found_used_histogram) {
-        // It is not possible for the supported quantiles to differ across histograms, so it is ok
-        // to send them once.
-        Stats::HistogramStatisticsImpl empty_statistics;
-        std::vector<ProtobufWkt::Value> supported_quantile_array;
-        for (double quantile : empty_statistics.supportedQuantiles()) {
-          supported_quantile_array.push_back(ValueUtil::numberValue(quantile * 100));
+  std::string output;
+  if (!started_) {
+    output.append("{\"stats\":[");
+    started_ = true;
+  }
+  while (index_ < num_all && output.size() < chunk_size) {
+    if (index_ > 0 && index_ != num_stats) {
+      output.push_back(',');
+    }
+    if (index_ < num_text_readouts) {
+      const Stats::TextReadout& text_readout = *shown_text_readouts_[index_];
+      output.append("{\"name\":");
+      appendJsonString(text_readout.name(), output);
+      output.append(",\"value\":");
+      appendJsonString(text_readout.value(), output);
+      output.push_back('}');
+    } else if (index_ < num_stats) {
+      const auto& stat = shown_numeric_stats_[index_ - num_text_readouts];
+      output.append("{\"name\":");
+      appendJsonString(stat.first->name(), output);
+      output.append(absl::StrCat(",\"value\":", stat.second, "}"));
+    } else {
+      if (index_ == num_stats) {
+        // The histograms are all rendered into a single element of the stats array. It is not
+        // possible for the supported quantiles to differ across histograms, so it is ok to send
+        // them once.
+        if (num_stats > 0) {
+          output.push_back(',');
         }
-        (*histograms_obj_fields)["supported_quantiles"] =
-            ValueUtil::listValue(supported_quantile_array);
-        found_used_histogram = true;
+        output.append("{\"histograms\":{\"supported_quantiles\":[");
+        Stats::HistogramStatisticsImpl empty_statistics;
+        output.append(absl::StrJoin(empty_statistics.supportedQuantiles(), ",",
+                                    [](std::string* out, double quantile) {
+                                      out->append(fmt::format("{}", quantile * 100));
+                                    }));
+        output.append("],\"computed_quantiles\":[");
       }
-
-      ProtobufWkt::Struct computed_quantile;
-      auto* computed_quantile_fields = computed_quantile.mutable_fields();
-      (*computed_quantile_fields)["name"] = ValueUtil::stringValue(histogram->name());
-
-      std::vector<ProtobufWkt::Value> computed_quantile_value_array;
-      for (size_t i = 0; i < histogram->intervalStatistics().supportedQuantiles().size(); ++i) {
-        ProtobufWkt::Struct computed_quantile_value;
-        auto* computed_quantile_value_fields = computed_quantile_value.mutable_fields();
-        const auto& interval = histogram->intervalStatistics().computedQuantiles()[i];
-        const auto& cumulative = histogram->cumulativeStatistics().computedQuantiles()[i];
-        (*computed_quantile_value_fields)["interval"] =
-            std::isnan(interval) ? ValueUtil::nullValue() : ValueUtil::numberValue(interval);
-        (*computed_quantile_value_fields)["cumulative"] =
-            std::isnan(cumulative) ? ValueUtil::nullValue() : ValueUtil::numberValue(cumulative);
-
-        computed_quantile_value_array.push_back(ValueUtil::structValue(computed_quantile_value));
+      renderHistogram(*shown_histograms_[index_ - num_stats], output);
+      if (index_ + 1 == num_all) {
+        output.append("]}}");
       }
-      (*computed_quantile_fields)["values"] = ValueUtil::listValue(computed_quantile_value_array);
-      computed_quantile_array.push_back(ValueUtil::structValue(computed_quantile));
     }
+    ++index_;
   }
 
-  if (found_used_histogram) {
-    (*histograms_obj_fields)["computed_quantiles"] = ValueUtil::listValue(computed_quantile_array);
-    (*histograms_obj_container_fields)["histograms"] = ValueUtil::structValue(histograms_obj);
-    stats_array.push_back(ValueUtil::structValue(histograms_obj_container));
+  if (index_ < num_all) {
+    response.add(output);
+    return true;
   }
+  output.append("]}");
+  response.add(output);
+  return false;
+}
 
-  auto* document_fields = document.mutable_fields();
-  (*document_fields)["stats"] = ValueUtil::listValue(stats_array);
-
-  return MessageUtil::getJsonStringFromMessage(document, pretty_print, true);
+void StatsJsonRenderer::renderHistogram(const Stats::ParentHistogram& histogram,
+                                        std::string& output) {
+  output.append("{\"name\":");
+  appendJsonString(histogram.name(), output);
+  output.append(",\"values\":[");
+  const Stats::HistogramStatistics& interval_statistics = histogram.intervalStatistics();
+  const Stats::HistogramStatistics& cumulative_statistics = histogram.cumulativeStatistics();
+  for (size_t i = 0; i < interval_statistics.supportedQuantiles().size(); ++i) {
+    const double interval = interval_statistics.computedQuantiles()[i];
+    const double cumulative = cumulative_statistics.computedQuantiles()[i];
+    output.append(absl::StrCat(i == 0 ? "" : ",", "{\"interval\":",
+                               std::isnan(interval) ? "null" : fmt::format("{}", interval),
+                               ",\"cumulative\":",
+                               std::isnan(cumulative) ? "null" : fmt::format("{}", cumulative),
+                               "}"));
+  }
+  output.append("]}");
 }
 
 } // namespace Server
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <regex>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/http/codes.h"
@@ -12,12 +14,50 @@
 #include "common/stats/histogram_impl.h"
 
 #include "server/admin/handler_ctx.h"
+#include "server/admin/prometheus_stats.h"
 
 #include "absl/strings/string_view.h"
 
 namespace Envoy {
 namespace Server {
 
+/**
+ * Renders stats as JSON, in chunks. The stats are filtered and sorted by name up front, which only
+ * takes pointers to them, and their text is rendered as the chunks are requested.
+ */
+class StatsJsonRenderer {
+public:
+  StatsJsonRenderer(std::vector<Stats::TextReadoutSharedPtr> text_readouts,
+                    std::vector<Stats::CounterSharedPtr> counters,
+                    std::vector<Stats::GaugeSharedPtr> gauges,
+                    std::vector<Stats::ParentHistogramSharedPtr> histograms, const bool used_only,
+                    const absl::optional<std::regex>& regex);
+
+  /**
+   * Renders stats until at least chunk_size bytes are appended to the response, or all stats are
+   * rendered.
+   * @return bool whether stats are left to render.
+   */
+  bool nextChunk(Buffer::Instance& response, uint64_t chunk_size);
+
+private:
+  void renderHistogram(const Stats::ParentHistogram& histogram, std::string& output);
+
+  // Hold the references to the stats.
+  const std::vector<Stats::TextReadoutSharedPtr> text_readouts_;
+  const std::vector<Stats::CounterSharedPtr> counters_;
+  const std::vector<Stats::GaugeSharedPtr> gauges_;
+  const std::vector<Stats::ParentHistogramSharedPtr> histograms_;
+
+  std::vector<const Stats::TextReadout*> shown_text_readouts_;
+  // Counters and gauges, with their values when the rendering started.
+  std::vector<std::pair<const Stats::Metric*, uint64_t>> shown_numeric_stats_;
+  std::vector<const Stats::ParentHistogram*> shown_histograms_;
+  // The index of the next stat to render, over the text readouts, numeric stats and histograms.
+  size_t index_{};
+  bool started_{};
+};
+
 class StatsHandler : public HandlerContextBase {
 
 public:
@@ -56,14 +96,11 @@ private:
             (!regex.has_value() || std::regex_search(metric.name(), regex.value())));
   }
 
-  friend class AdminStatsTest;
+  friend class StatsJsonRenderer;
+
+  PrometheusNameCacheSharedPtr prometheusNameCache();
 
-  static std::string statsAsJson(const std::map<std::string, uint64_t>& all_stats,
-                                 const std::map<std::string, std::string>& text_readouts,
-                                 const std::vector<Stats::ParentHistogramSharedPtr>& all_histograms,
-                                 bool used_only,
-                                 const absl::optional<std::regex> regex = absl::nullopt,
-                                 bool pretty_print = false);
+  PrometheusNameCacheSharedPtr prometheus_name_cache_;
 };
 
 } // namespace Server
@@ -33,7 +33,7 @@ public:
       : ProdClusterManagerFactory(admin, runtime, stats, tls, random, dns_resolver,
                                   ssl_context_manager, main_thread_dispatcher, local_info,
                                   secret_manager, validation_context, api, http_context,
-                                  grpc_context, log_manager, singleton_manager),
+                                  grpc_context, log_manager, singleton_manager, nullptr),
         grpc_context_(grpc_context), time_system_(time_system) {}
 
   ClusterManagerPtr
@@ -29,9 +29,11 @@
 #include "common/config/utility.h"
 #include "common/config/version_converter.h"
 #include "common/http/codes.h"
+#include "common/http/http2/conn_pool.h"
 #include "common/local_info/local_info_impl.h"
 #include "common/memory/stats.h"
 #include "common/network/address_impl.h"
+#include "common/network/caching_dns_resolver.h"
 #include "common/network/listener_impl.h"
 #include "common/network/socket_interface.h"
 #include "common/network/socket_interface_impl.h"
@@ -151,7 +153,13 @@ MetricSnapshotImpl::MetricSnapshotImpl(Stats::Store& store) {
   snapped_counters_ = store.counters();
   counters_.reserve(snapped_counters_.size());
   for (const auto& counter : snapped_counters_) {
-    counters_.push_back({counter->latch(), *counter});
+    const uint64_t delta = counter->latch();
+    counters_.push_back({delta, *counter});
+    // A counter needs no dirty bit of its own: its pending increment is non-zero exactly when it
+    // has been written since the previous latch.
+    if (delta != 0) {
+      changed_counters_.push_back({delta, *counter});
+    }
   }
 
   snapped_gauges_ = store.gauges();
@@ -159,6 +167,11 @@ MetricSnapshotImpl::MetricSnapshotImpl(Stats::Store& store) {
   for (const auto& gauge : snapped_gauges_) {
     ASSERT(gauge->importMode() != Stats::Gauge::ImportMode::Uninitialized);
     gauges_.push_back(*gauge);
+    // Dirty bits are cleared on every flush, whether or not any sink asks for changed gauges, so
+    // that they always cover exactly one flush interval.
+    if (gauge->clearDirty()) {
+      changed_gauges_.push_back(*gauge);
+    }
   }
 
   snapped_histograms_ = store.histograms();
@@ -324,6 +337,9 @@ void InstanceImpl::initialize(const Options& options,
   stats_store_.setTagProducer(Config::Utility::createTagProducer(bootstrap_));
   stats_store_.setStatsMatcher(Config::Utility::createStatsMatcher(bootstrap_));
   stats_store_.setHistogramSettings(Config::Utility::createHistogramSettings(bootstrap_));
+  stats_store_.setShardedCounterPrefixes(
+      {bootstrap_.stats_config().sharded_counter_prefixes().begin(),
+       bootstrap_.stats_config().sharded_counter_prefixes().end()});
 
   const std::string server_stats_prefix = "server.";
   server_stats_ = std::make_unique<ServerStats>(
@@ -420,6 +436,14 @@ void InstanceImpl::initialize(const Options& options,
   listener_manager_ = std::make_unique<ListenerManagerImpl>(
       *this, listener_component_factory_, worker_factory_, bootstrap_.enable_dispatcher_stats());
 
+  // The shared HTTP/2 connection pool threads also serve streams of all workers, so they register
+  // for thread local updates along with them.
+  if (bootstrap_.shared_http2_connection_pool_threads() > 0) {
+    shared_http2_conn_pools_ = std::make_unique<Http::Http2::SharedConnPoolSet>(
+        *api_, thread_local_, bootstrap_.shared_http2_connection_pool_threads(),
+        Http::Http2::allocateConnPool);
+  }
+
   // The main thread is also registered for thread local updates so that code that does not care
   // whether it runs on the main thread or on workers can still use TLS.
   thread_local_.registerThread(*dispatcher_, true);
@@ -476,12 +500,16 @@ void InstanceImpl::initialize(const Options& options,
 
   const bool use_tcp_for_dns_lookups = bootstrap_.use_tcp_for_dns_lookups();
   dns_resolver_ = dispatcher_->createDnsResolver({}, use_tcp_for_dns_lookups);
+  if (bootstrap_.has_dns_resolution_cache()) {
+    dns_resolver_ = std::make_shared<Network::CachingDnsResolver>(
+        dns_resolver_, time_source_, bootstrap_.dns_resolution_cache(), stats_store_);
+  }
 
   cluster_manager_factory_ = std::make_unique<Upstream::ProdClusterManagerFactory>(
       *admin_, Runtime::LoaderSingleton::get(), stats_store_, thread_local_, *random_generator_,
       dns_resolver_, *ssl_context_manager_, *dispatcher_, *local_info_, *secret_manager_,
       messageValidationContext(), *api_, http_context_, grpc_context_, access_log_manager_,
-      *singleton_manager_);
+      *singleton_manager_, shared_http2_conn_pools_.get());
 
   // Now the configuration gets parsed. The configuration may start setting
   // thread local data per above. See MainImpl::initialize() for why ConfigImpl
@@ -514,6 +542,12 @@ void InstanceImpl::initialize(const Options& options,
   // GuardDog (deadlock detection) object and thread setup before workers are
   // started and before our own run() loop runs.
   guard_dog_ = std::make_unique<Server::GuardDogImpl>(stats_store_, config_, *api_);
+
+  // Unlike workers, the shared HTTP/2 connection pool threads start right away, as the main thread
+  // may already use them to fetch configuration.
+  if (shared_http2_conn_pools_ != nullptr) {
+    shared_http2_conn_pools_->start(*guard_dog_);
+  }
 }
 
 void InstanceImpl::onClusterManagerPrimaryInitializationComplete() {
@@ -701,6 +735,12 @@ void InstanceImpl::terminate() {
     listener_manager_->stopWorkers();
   }
 
+  // The workers hand their streams off to the shared HTTP/2 connection pool threads, so these are
+  // stopped once the workers are.
+  if (shared_http2_conn_pools_ != nullptr) {
+    shared_http2_conn_pools_->shutdown();
+  }
+
   // Only flush if we have not been hot restarted.
   if (stat_flush_timer_) {
     flushStats();
@@ -29,6 +29,7 @@
 #include "common/grpc/async_client_manager_impl.h"
 #include "common/grpc/context_impl.h"
 #include "common/http/context_impl.h"
+#include "common/http/http2/shared_conn_pool.h"
 #include "common/init/manager_impl.h"
 #include "common/memory/heap_shrinker.h"
 #include "common/protobuf/message_validator_impl.h"
@@ -335,6 +336,7 @@ private:
   ProdListenerComponentFactory listener_component_factory_;
   ProdWorkerFactory worker_factory_;
   std::unique_ptr<ListenerManager> listener_manager_;
+  Http::Http2::SharedConnPoolSetPtr shared_http2_conn_pools_;
   absl::node_hash_map<Stage, LifecycleNotifierCallbacks> stage_callbacks_;
   absl::node_hash_map<Stage, LifecycleNotifierCompletionCallbacks> stage_completable_callbacks_;
   Configuration::MainImpl config_;
@@ -396,12 +398,18 @@ public:
   const std::vector<std::reference_wrapper<const Stats::TextReadout>>& textReadouts() override {
     return text_readouts_;
   }
+  const std::vector<CounterSnapshot>& changedCounters() override { return changed_counters_; }
+  const std::vector<std::reference_wrapper<const Stats::Gauge>>& changedGauges() override {
+    return changed_gauges_;
+  }
 
 private:
   std::vector<Stats::CounterSharedPtr> snapped_counters_;
   std::vector<CounterSnapshot> counters_;
+  std::vector<CounterSnapshot> changed_counters_;
   std::vector<Stats::GaugeSharedPtr> snapped_gauges_;
   std::vector<std::reference_wrapper<const Stats::Gauge>> gauges_;
+  std::vector<std::reference_wrapper<const Stats::Gauge>> changed_gauges_;
   std::vector<Stats::ParentHistogramSharedPtr> snapped_histograms_;
   std::vector<std::reference_wrapper<const Stats::ParentHistogram>> histograms_;
   std::vector<Stats::TextReadoutSharedPtr> snapped_text_readouts_;
@@ -0,0 +1,54 @@
+#include <vector>
+
+#include "common/common/sharded_counter.h"
+
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+TEST(ShardedCounterTest, NumSlots) {
+  EXPECT_EQ(1, ShardedCounter(0).numSlots());
+  EXPECT_EQ(1, ShardedCounter(1).numSlots());
+  EXPECT_EQ(8, ShardedCounter(5).numSlots());
+  EXPECT_EQ(64, ShardedCounter(64).numSlots());
+  EXPECT_LE(1, ShardedCounter::defaultNumSlots());
+  EXPECT_GE(64, ShardedCounter::defaultNumSlots());
+}
+
+TEST(ShardedCounterTest, AddTake) {
+  ShardedCounter counter(4);
+  EXPECT_EQ(0, counter.sum());
+  EXPECT_EQ(3, counter.add(3));
+  EXPECT_EQ(1, counter.add(-2));
+  EXPECT_EQ(1, counter.sum());
+
+  // The slot of this thread is emptied, which leaves the value to the caller.
+  EXPECT_EQ(1, counter.take());
+  EXPECT_EQ(0, counter.sum());
+  EXPECT_EQ(-2, counter.add(-2));
+  EXPECT_EQ(-2, counter.sum());
+}
+
+TEST(ShardedCounterTest, ConcurrentAdds) {
+  ShardedCounter counter(4);
+  std::vector<Thread::ThreadPtr> threads;
+  // More threads than slots, so that some share a slot.
+  for (uint32_t i = 0; i < 8; ++i) {
+    threads.push_back(Thread::threadFactoryForTest().createThread([&counter, i]() {
+      for (uint32_t j = 0; j < 10000; ++j) {
+        counter.add(1);
+      }
+      counter.add(-static_cast<int64_t>(i));
+    }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  EXPECT_EQ(8 * 10000 - 28, counter.sum());
+}
+
+} // namespace
+} // namespace Envoy
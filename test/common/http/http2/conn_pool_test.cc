@@ -1428,6 +1428,38 @@ TEST_F(Http2ConnPoolImplTest, PrefetchAfterTimeout) {
   closeAllClients();
 }
 
+TEST_F(Http2ConnPoolImplTest, PrefetchForAnticipatedStream) {
+  cluster_->http2_options_.mutable_max_concurrent_streams()->set_value(1);
+
+  // Without any streams, a global ratio of 1.5 provisions for 1.5 anticipated streams, so two
+  // connections are prefetched.
+  expectClientsCreate(1);
+  EXPECT_TRUE(pool_->maybePrefetch(1.5));
+  expectClientsCreate(1);
+  EXPECT_TRUE(pool_->maybePrefetch(1.5));
+  EXPECT_FALSE(pool_->maybePrefetch(1.5));
+  EXPECT_FALSE(pool_->maybePrefetch(1));
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_prefetch_total_.value());
+
+  // The anticipated stream uses one of the prefetched connections.
+  expectClientConnect(0);
+  ActiveTestRequest r1(*this, 0, true);
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_prefetch_used_.value());
+
+  // The other one is closed without having served a stream.
+  completeRequest(r1);
+  closeAllClients();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_prefetch_unused_.value());
+}
+
+TEST_F(Http2ConnPoolImplTest, PrefetchForAnticipatedStreamOff) {
+  TestScopedRuntime scoped_runtime;
+  Runtime::LoaderSingleton::getExisting()->mergeValues(
+      {{"envoy.reloadable_features.allow_prefetch", "false"}});
+
+  EXPECT_FALSE(pool_->maybePrefetch(1.5));
+}
+
 TEST_F(Http2ConnPoolImplTest, CloseExcessWithPrefetch) {
   cluster_->http2_options_.mutable_max_concurrent_streams()->set_value(1);
   ON_CALL(*cluster_, prefetchRatio).WillByDefault(Return(1.00));
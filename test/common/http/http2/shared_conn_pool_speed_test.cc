@@ -0,0 +1,183 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures the latency a shared HTTP/2 connection pool adds to a stream by handing it off to the
+// owning thread and back, compared to a pool owned by the worker. The upstream answers inline, so
+// only the cost of getting the stream to and from the pool is measured. In exchange for this cost,
+// each upstream host serves one set of connections rather than one per worker.
+
+#include "common/http/header_map_impl.h"
+#include "common/http/http2/shared_conn_pool.h"
+
+#include "test/benchmark/main.h"
+#include "test/common/upstream/utility.h"
+#include "test/mocks/server/guard_dog.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/upstream/cluster_info.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+namespace {
+
+// An upstream stream which responds as soon as the request is complete.
+class FakeStream : public RequestEncoder, public Stream {
+public:
+  explicit FakeStream(ResponseDecoder& decoder) : decoder_(decoder) {}
+
+  // Http::RequestEncoder
+  void encodeHeaders(const RequestHeaderMap&, bool end_stream) override {
+    if (end_stream) {
+      decoder_.decodeHeaders(
+          createHeaderMap<ResponseHeaderMapImpl>({{Headers::get().Status, "200"}}), true);
+    }
+  }
+  void encodeTrailers(const RequestTrailerMap&) override {}
+
+  // Http::StreamEncoder
+  void encodeData(Buffer::Instance&, bool) override {}
+  Stream& getStream() override { return *this; }
+  void encodeMetadata(const MetadataMapVector&) override {}
+  Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override { return absl::nullopt; }
+
+  // Http::Stream
+  void addCallbacks(StreamCallbacks&) override {}
+  void removeCallbacks(StreamCallbacks&) override {}
+  void resetStream(StreamResetReason) override {}
+  void readDisable(bool) override {}
+  uint32_t bufferLimit() override { return 0; }
+  const Network::Address::InstanceConstSharedPtr& connectionLocalAddress() override {
+    return local_address_;
+  }
+  void setFlushTimeout(std::chrono::milliseconds) override {}
+
+private:
+  ResponseDecoder& decoder_;
+  const Network::Address::InstanceConstSharedPtr local_address_;
+};
+
+// A pool with a single always ready connection to the fake upstream.
+class FakePool : public ConnectionPool::Instance {
+public:
+  FakePool(Upstream::HostConstSharedPtr host, TimeSource& time_source)
+      : host_(host), stream_info_(time_source) {}
+
+  // Http::ConnectionPool::Instance
+  Http::Protocol protocol() const override { return Http::Protocol::Http2; }
+  bool hasActiveConnections() const override { return false; }
+  ConnectionPool::Cancellable* newStream(ResponseDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks) override {
+    stream_ = std::make_unique<FakeStream>(response_decoder);
+    callbacks.onPoolReady(*stream_, host_, stream_info_);
+    return nullptr;
+  }
+
+  // Envoy::ConnectionPool::Instance
+  void addDrainedCallback(DrainedCb cb) override { cb(); }
+  void drainConnections() override {}
+  bool maybePrefetch(float) override { return false; }
+  Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
+
+private:
+  const Upstream::HostConstSharedPtr host_;
+  StreamInfo::StreamInfoImpl stream_info_;
+  std::unique_ptr<FakeStream> stream_;
+};
+
+// The downstream side, sending a header only request on every stream.
+class Client : public ResponseDecoder, public ConnectionPool::Callbacks {
+public:
+  explicit Client(Event::Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+
+  // Http::ConnectionPool::Callbacks
+  void onPoolFailure(ConnectionPool::PoolFailureReason, absl::string_view,
+                     Upstream::HostDescriptionConstSharedPtr) override {}
+  void onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr,
+                   const StreamInfo::StreamInfo&) override {
+    encoder.encodeHeaders(request_headers_, true);
+  }
+
+  // Http::StreamDecoder
+  void decodeData(Buffer::Instance&, bool) override {}
+  void decodeMetadata(MetadataMapPtr&&) override {}
+
+  // Http::ResponseDecoder
+  void decode100ContinueHeaders(ResponseHeaderMapPtr&&) override {}
+  void decodeHeaders(ResponseHeaderMapPtr&&, bool) override {
+    responses_++;
+    if (exit_on_response_) {
+      dispatcher_.exit();
+    }
+  }
+  void decodeTrailers(ResponseTrailerMapPtr&&) override {}
+
+  uint64_t responses_{};
+  // Whether to stop the dispatcher on response, for streams handed off to another thread.
+  bool exit_on_response_{};
+
+private:
+  Event::Dispatcher& dispatcher_;
+  TestRequestHeaderMapImpl request_headers_{
+      {":method", "GET"}, {":path", "/"}, {":authority", "host"}, {":scheme", "http"}};
+};
+
+class SharedConnPoolSpeedTest {
+public:
+  SharedConnPoolSpeedTest()
+      : api_(Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test_thread")),
+        cluster_(std::make_shared<testing::NiceMock<Upstream::MockClusterInfo>>()),
+        host_(Upstream::makeTestHost(cluster_, "tcp://127.0.0.1:80")), client_(*dispatcher_) {}
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  std::shared_ptr<Upstream::MockClusterInfo> cluster_;
+  Upstream::HostSharedPtr host_;
+  Client client_;
+};
+
+} // namespace
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
+
+// Streams on a pool owned by the worker.
+static void workerPool(benchmark::State& state) {
+  Envoy::Http::Http2::SharedConnPoolSpeedTest test;
+  Envoy::Http::Http2::FakePool pool(test.host_, test.dispatcher_->timeSource());
+  for (auto _ : state) {
+    pool.newStream(test.client_, test.client_);
+  }
+  state.counters["responses"] = test.client_.responses_;
+}
+BENCHMARK(workerPool);
+
+// Streams on a pool shared across workers, each handed off to the owning thread and back.
+static void sharedPool(benchmark::State& state) {
+  Envoy::Http::Http2::SharedConnPoolSpeedTest test;
+  testing::NiceMock<Envoy::ThreadLocal::MockInstance> tls;
+  testing::NiceMock<Envoy::Server::MockGuardDog> guard_dog;
+  Envoy::Http::Http2::SharedConnPoolSet set(
+      *test.api_, tls, 1,
+      [](Envoy::Event::Dispatcher& dispatcher, Envoy::Upstream::HostConstSharedPtr host,
+         Envoy::Upstream::ResourcePriority,
+         const Envoy::Network::ConnectionSocket::OptionsSharedPtr&,
+         const Envoy::Network::TransportSocketOptionsSharedPtr&)
+          -> Envoy::Http::ConnectionPool::InstancePtr {
+        return std::make_unique<Envoy::Http::Http2::FakePool>(host, dispatcher.timeSource());
+      });
+  set.start(guard_dog);
+  auto pool = set.createConnPool(*test.dispatcher_, test.host_,
+                                 Envoy::Upstream::ResourcePriority::Default, nullptr, nullptr);
+  test.client_.exit_on_response_ = true;
+  for (auto _ : state) {
+    pool->newStream(test.client_, test.client_);
+    test.dispatcher_->run(Envoy::Event::Dispatcher::RunType::RunUntilExit);
+  }
+  state.counters["responses"] = test.client_.responses_;
+  pool.reset();
+  test.dispatcher_->clearDeferredDeleteList();
+}
+BENCHMARK(sharedPool);
@@ -0,0 +1,322 @@
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common/http/http2/shared_conn_pool.h"
+#include "common/network/utility.h"
+
+#include "test/common/http/common.h"
+#include "test/common/upstream/utility.h"
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/server/guard_dog.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/upstream/cluster_info.h"
+#include "test/test_common/utility.h"
+
+#include "absl/synchronization/notification.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Ref;
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+namespace {
+
+class SharedConnPoolTest : public testing::Test {
+public:
+  SharedConnPoolTest()
+      : api_(Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test_thread")),
+        host_(Upstream::makeTestHost(cluster_, "tcp://127.0.0.1:80")) {
+    EXPECT_CALL(tls_, registerThread(_, false))
+        .WillOnce(Invoke([this](Event::Dispatcher& dispatcher, bool) -> void {
+          io_dispatcher_ = &dispatcher;
+        }));
+    set_ = std::make_unique<SharedConnPoolSet>(
+        *api_, tls_, 1,
+        [this](Event::Dispatcher&, Upstream::HostConstSharedPtr, Upstream::ResourcePriority,
+               const Network::ConnectionSocket::OptionsSharedPtr&,
+               const Network::TransportSocketOptionsSharedPtr&) { return createIoPool(); });
+    EXPECT_CALL(guard_dog_, createWatchDog(_, "h2pool_0"));
+    EXPECT_CALL(*guard_dog_.watch_dog_, startWatchdog(Ref(*io_dispatcher_)));
+    set_->start(guard_dog_);
+    pool_ = set_->createConnPool(*dispatcher_, host_, Upstream::ResourcePriority::Default, nullptr,
+                                 nullptr);
+  }
+
+  // Runs on the owning thread of the pools.
+  ConnectionPool::InstancePtr createIoPool() {
+    pools_created_++;
+    auto pool = std::make_unique<NiceMock<ConnectionPool::MockInstance>>();
+    io_pool_ = pool.get();
+    ON_CALL(*pool, newStream(_, _))
+        .WillByDefault(Invoke([this](ResponseDecoder& decoder, ConnectionPool::Callbacks& callbacks)
+                                  -> ConnectionPool::Cancellable* {
+          io_decoder_ = &decoder;
+          io_callbacks_ = &callbacks;
+          return &io_cancellable_;
+        }));
+    return pool;
+  }
+
+  // Runs the given function on the owning thread, after everything posted to it so far.
+  void runOnIo(std::function<void()> fn) {
+    absl::Notification done;
+    io_dispatcher_->post([&fn, &done]() {
+      fn();
+      done.Notify();
+    });
+    done.WaitForNotification();
+  }
+
+  // Creates a stream and makes it ready on the owning thread.
+  void readyStream(ConnPoolCallbacks& callbacks, ResponseDecoder& decoder) {
+    EXPECT_NE(nullptr, pool_->newStream(decoder, callbacks));
+    runOnIo([this]() { io_callbacks_->onPoolReady(io_encoder_, host_, io_stream_info_); });
+    EXPECT_CALL(callbacks.pool_ready_, ready());
+    dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    ASSERT_NE(nullptr, callbacks.outer_encoder_);
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  std::shared_ptr<Upstream::MockClusterInfo> cluster_{new NiceMock<Upstream::MockClusterInfo>()};
+  Upstream::HostSharedPtr host_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<Server::MockGuardDog> guard_dog_;
+  Event::Dispatcher* io_dispatcher_{};
+  uint32_t pools_created_{};
+  ConnectionPool::MockInstance* io_pool_{};
+  ResponseDecoder* io_decoder_{};
+  ConnectionPool::Callbacks* io_callbacks_{};
+  NiceMock<Envoy::ConnectionPool::MockCancellable> io_cancellable_;
+  NiceMock<MockRequestEncoder> io_encoder_;
+  NiceMock<StreamInfo::MockStreamInfo> io_stream_info_;
+  SharedConnPoolSetPtr set_;
+  ConnectionPool::InstancePtr pool_;
+};
+
+// A request and its response are handed between the worker and the owning thread.
+TEST_F(SharedConnPoolTest, RequestResponse) {
+  ConnPoolCallbacks callbacks;
+  NiceMock<MockResponseDecoder> decoder;
+  readyStream(callbacks, decoder);
+  EXPECT_TRUE(pool_->hasActiveConnections());
+
+  TestRequestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/"}};
+  EXPECT_CALL(io_encoder_, encodeHeaders(HeaderMapEqualRef(&request_headers), false));
+  callbacks.outer_encoder_->encodeHeaders(request_headers, false);
+  Buffer::OwnedImpl request_body("hello");
+  EXPECT_CALL(io_encoder_, encodeData(BufferStringEqual("hello"), true));
+  callbacks.outer_encoder_->encodeData(request_body, true);
+  EXPECT_EQ(0, request_body.length());
+  runOnIo([]() {});
+
+  EXPECT_CALL(decoder, decodeHeaders_(_, false));
+  EXPECT_CALL(decoder, decodeData(BufferStringEqual("world"), true));
+  runOnIo([this]() {
+    io_decoder_->decodeHeaders(
+        ResponseHeaderMapPtr{new TestResponseHeaderMapImpl{{":status", "200"}}}, false);
+    Buffer::OwnedImpl response_body("world");
+    io_decoder_->decodeData(response_body, true);
+  });
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+// A pool failure on the owning thread fails the stream on the worker.
+TEST_F(SharedConnPoolTest, PoolFailure) {
+  ConnPoolCallbacks callbacks;
+  NiceMock<MockResponseDecoder> decoder;
+  EXPECT_NE(nullptr, pool_->newStream(decoder, callbacks));
+  runOnIo([this]() {
+    io_callbacks_->onPoolFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure,
+                                 "connection refused", host_);
+  });
+
+  EXPECT_CALL(callbacks.pool_failure_, ready());
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(ConnectionPool::PoolFailureReason::RemoteConnectionFailure, callbacks.reason_);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+// Canceling a pending stream on the worker cancels it on the owning thread.
+TEST_F(SharedConnPoolTest, CancelPending) {
+  ConnPoolCallbacks callbacks;
+  NiceMock<MockResponseDecoder> decoder;
+  ConnectionPool::Cancellable* handle = pool_->newStream(decoder, callbacks);
+  ASSERT_NE(nullptr, handle);
+
+  EXPECT_CALL(io_cancellable_, cancel(_));
+  handle->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+  runOnIo([]() {});
+}
+
+// Resets are forwarded in both directions.
+TEST_F(SharedConnPoolTest, Resets) {
+  {
+    ConnPoolCallbacks callbacks;
+    NiceMock<MockResponseDecoder> decoder;
+    readyStream(callbacks, decoder);
+
+    NiceMock<MockStreamCallbacks> stream_callbacks;
+    callbacks.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+    EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::LocalReset, _));
+    EXPECT_CALL(io_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+    callbacks.outer_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+    EXPECT_FALSE(pool_->hasActiveConnections());
+    runOnIo([]() {});
+  }
+
+  {
+    ConnPoolCallbacks callbacks;
+    NiceMock<MockResponseDecoder> decoder;
+    readyStream(callbacks, decoder);
+
+    NiceMock<MockStreamCallbacks> stream_callbacks;
+    callbacks.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+    runOnIo([this]() {
+      for (StreamCallbacks* io_callbacks : io_encoder_.stream_.callbacks_) {
+        io_callbacks->onResetStream(StreamResetReason::RemoteReset, "");
+      }
+    });
+    EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::RemoteReset, _));
+    dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    EXPECT_FALSE(pool_->hasActiveConnections());
+  }
+}
+
+// Watermark events of the upstream stream reach the worker.
+TEST_F(SharedConnPoolTest, Watermarks) {
+  ConnPoolCallbacks callbacks;
+  NiceMock<MockResponseDecoder> decoder;
+  readyStream(callbacks, decoder);
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  callbacks.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+  runOnIo([this]() { io_encoder_.stream_.runHighWatermarkCallbacks(); });
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+
+  runOnIo([this]() { io_encoder_.stream_.runLowWatermarkCallbacks(); });
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+
+  EXPECT_CALL(io_encoder_.stream_, readDisable(true));
+  callbacks.outer_encoder_->getStream().readDisable(true);
+  runOnIo([]() {});
+
+  callbacks.outer_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  runOnIo([]() {});
+}
+
+// Pools of different workers for the same host share the pool on the owning thread.
+TEST_F(SharedConnPoolTest, SharedAcrossWorkers) {
+  Event::DispatcherPtr other_dispatcher = api_->allocateDispatcher("other_thread");
+  ConnectionPool::InstancePtr other_pool = set_->createConnPool(
+      *other_dispatcher, host_, Upstream::ResourcePriority::Default, nullptr, nullptr);
+
+  ConnPoolCallbacks callbacks;
+  NiceMock<MockResponseDecoder> decoder;
+  ConnectionPool::Cancellable* handle = pool_->newStream(decoder, callbacks);
+  ConnPoolCallbacks other_callbacks;
+  NiceMock<MockResponseDecoder> other_decoder;
+  ConnectionPool::Cancellable* other_handle = other_pool->newStream(other_decoder, other_callbacks);
+  runOnIo([]() {});
+  EXPECT_EQ(1, pools_created_);
+
+  handle->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  other_handle->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  other_pool.reset();
+  runOnIo([]() {});
+}
+
+// The worker side pool is drained once its streams are done on both threads, and the shared pool
+// is drained too.
+TEST_F(SharedConnPoolTest, Drain) {
+  ConnPoolCallbacks callbacks;
+  NiceMock<MockResponseDecoder> decoder;
+  readyStream(callbacks, decoder);
+
+  ReadyWatcher drained;
+  pool_->addDrainedCallback([&drained]() -> void { drained.ready(); });
+  std::vector<Envoy::ConnectionPool::Instance::DrainedCb> io_drained_callbacks;
+  EXPECT_CALL(*io_pool_, addDrainedCallback(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&io_drained_callbacks](Envoy::ConnectionPool::Instance::DrainedCb cb)
+                                 -> void { io_drained_callbacks.push_back(cb); }));
+  EXPECT_CALL(*io_pool_, drainConnections());
+  pool_->drainConnections();
+  runOnIo([]() {});
+
+  // The stream is done on the worker right away, but not yet on the owning thread.
+  EXPECT_CALL(drained, ready()).Times(0);
+  callbacks.outer_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_TRUE(pool_->hasActiveConnections());
+  runOnIo([]() {});
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+
+  // The shared pool still has connections until it is drained as well.
+  testing::Mock::VerifyAndClearExpectations(&drained);
+  runOnIo([&io_drained_callbacks]() {
+    for (const auto& cb : io_drained_callbacks) {
+      cb();
+    }
+  });
+  EXPECT_CALL(drained, ready());
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+
+  // The drained shared pool was removed, so the next stream gets a new one.
+  ConnPoolCallbacks new_callbacks;
+  NiceMock<MockResponseDecoder> new_decoder;
+  ConnectionPool::Cancellable* handle = pool_->newStream(new_decoder, new_callbacks);
+  runOnIo([]() {});
+  EXPECT_EQ(2, pools_created_);
+  handle->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  runOnIo([]() {});
+}
+
+// A pool which never handed off a stream is drained once the owning thread confirms it.
+TEST_F(SharedConnPoolTest, DrainWithoutStreams) {
+  ReadyWatcher drained;
+  pool_->addDrainedCallback([&drained]() -> void { drained.ready(); });
+  EXPECT_FALSE(pool_->hasActiveConnections());
+
+  runOnIo([]() {});
+  EXPECT_CALL(drained, ready());
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(0, pools_created_);
+}
+
+// Shutting down resets the streams in flight, and releases the threads from the guard dog and from
+// thread local storage.
+TEST_F(SharedConnPoolTest, Shutdown) {
+  ConnPoolCallbacks callbacks;
+  NiceMock<MockResponseDecoder> decoder;
+  readyStream(callbacks, decoder);
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  callbacks.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+  EXPECT_CALL(io_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(guard_dog_, stopWatching(_));
+  EXPECT_CALL(tls_, shutdownThread());
+  set_->shutdown();
+
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::ConnectionTermination, _));
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+} // namespace
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
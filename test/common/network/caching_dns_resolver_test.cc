@@ -0,0 +1,237 @@
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/config/core/v3/resolver.pb.h"
+
+#include "common/network/caching_dns_resolver.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::DoAll;
+using testing::Invoke;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class CachingDnsResolverTest : public testing::Test {
+protected:
+  void initialize(const std::string& yaml = "") {
+    envoy::config::core::v3::DnsResolutionCacheConfig config;
+    if (!yaml.empty()) {
+      TestUtility::loadFromYaml(yaml, config);
+    }
+    resolver_ = std::make_unique<CachingDnsResolver>(upstream_resolver_, time_system_, config,
+                                                     stats_store_);
+  }
+
+  // Expects a query of the underlying resolver for the name, and returns its callback.
+  void expectQuery(const std::string& dns_name, DnsResolver::ResolveCb& callback) {
+    EXPECT_CALL(*upstream_resolver_, resolve(dns_name, DnsLookupFamily::V4Only, _))
+        .WillOnce(DoAll(SaveArg<2>(&callback), Return(&upstream_resolver_->active_query_)));
+  }
+
+  // Resolves the name, recording the status, addresses and TTL of the result in the test.
+  ActiveDnsQuery* resolve(const std::string& dns_name) {
+    return resolver_->resolve(
+        dns_name, DnsLookupFamily::V4Only,
+        [this](DnsResolver::ResolutionStatus status, std::list<DnsResponse>&& responses) {
+          ++results_;
+          status_ = status;
+          addresses_.clear();
+          for (const DnsResponse& response : responses) {
+            addresses_.push_back(response.address_->ip()->addressAsString());
+            ttl_ = response.ttl_;
+          }
+        });
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter("dns_resolution_cache." + name).value();
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  Stats::IsolatedStoreImpl stats_store_;
+  std::shared_ptr<MockDnsResolver> upstream_resolver_{std::make_shared<MockDnsResolver>()};
+  std::unique_ptr<CachingDnsResolver> resolver_;
+  uint32_t results_{};
+  DnsResolver::ResolutionStatus status_{};
+  std::list<std::string> addresses_;
+  std::chrono::seconds ttl_{};
+};
+
+// Concurrent resolutions of a name share a single query.
+TEST_F(CachingDnsResolverTest, CoalescesConcurrentResolutions) {
+  initialize();
+  DnsResolver::ResolveCb callback;
+  expectQuery("foo.com", callback);
+  EXPECT_NE(nullptr, resolve("foo.com"));
+  EXPECT_NE(nullptr, resolve("foo.com"));
+  EXPECT_EQ(1UL, resolver_->size());
+
+  callback(DnsResolver::ResolutionStatus::Success,
+           TestUtility::makeDnsResponse({"10.0.0.1"}, std::chrono::seconds(10)));
+  EXPECT_EQ(2U, results_);
+  EXPECT_EQ(DnsResolver::ResolutionStatus::Success, status_);
+  EXPECT_EQ(std::list<std::string>{"10.0.0.1"}, addresses_);
+  EXPECT_EQ(std::chrono::seconds(10), ttl_);
+  EXPECT_EQ(1, counter("cache_miss"));
+  EXPECT_EQ(1, counter("coalesced_query"));
+}
+
+// Results are served from the cache until the TTL of their records expires.
+TEST_F(CachingDnsResolverTest, HonorsRecordTtl) {
+  initialize();
+  DnsResolver::ResolveCb callback;
+  expectQuery("foo.com", callback);
+  resolve("foo.com");
+  callback(DnsResolver::ResolutionStatus::Success,
+           TestUtility::makeDnsResponse({"10.0.0.1", "10.0.0.2"}, std::chrono::seconds(10)));
+
+  time_system_.advanceTimeWait(std::chrono::seconds(4));
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ(2U, results_);
+  EXPECT_EQ((std::list<std::string>{"10.0.0.1", "10.0.0.2"}), addresses_);
+  EXPECT_EQ(std::chrono::seconds(6), ttl_);
+  EXPECT_EQ(1, counter("cache_hit"));
+
+  time_system_.advanceTimeWait(std::chrono::seconds(6));
+  expectQuery("foo.com", callback);
+  EXPECT_NE(nullptr, resolve("foo.com"));
+  callback(DnsResolver::ResolutionStatus::Success,
+           TestUtility::makeDnsResponse({"10.0.0.3"}, std::chrono::seconds(10)));
+  EXPECT_EQ(3U, results_);
+  EXPECT_EQ(std::list<std::string>{"10.0.0.3"}, addresses_);
+  EXPECT_EQ(2, counter("cache_miss"));
+}
+
+TEST_F(CachingDnsResolverTest, TtlBounds) {
+  initialize(R"EOF(
+min_ttl: 5s
+max_ttl: 60s
+  )EOF");
+  DnsResolver::ResolveCb callback;
+  expectQuery("foo.com", callback);
+  resolve("foo.com");
+  callback(DnsResolver::ResolutionStatus::Success,
+           TestUtility::makeDnsResponse({"10.0.0.1"}, std::chrono::seconds(0)));
+  EXPECT_EQ(std::chrono::seconds(5), ttl_);
+
+  expectQuery("bar.com", callback);
+  resolve("bar.com");
+  callback(DnsResolver::ResolutionStatus::Success,
+           TestUtility::makeDnsResponse({"10.0.0.2"}, std::chrono::seconds(3600)));
+  EXPECT_EQ(std::chrono::seconds(60), ttl_);
+}
+
+// Failed and empty results are kept for the negative TTL.
+TEST_F(CachingDnsResolverTest, NegativeCaching) {
+  initialize(R"EOF(
+negative_ttl: 2s
+  )EOF");
+  DnsResolver::ResolveCb callback;
+  expectQuery("foo.com", callback);
+  resolve("foo.com");
+  callback(DnsResolver::ResolutionStatus::Failure, {});
+  expectQuery("bar.com", callback);
+  resolve("bar.com");
+  callback(DnsResolver::ResolutionStatus::Success, {});
+
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ(DnsResolver::ResolutionStatus::Failure, status_);
+  EXPECT_EQ(nullptr, resolve("bar.com"));
+  EXPECT_EQ(DnsResolver::ResolutionStatus::Success, status_);
+  EXPECT_TRUE(addresses_.empty());
+  EXPECT_EQ(2, counter("cache_negative_hit"));
+
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  expectQuery("foo.com", callback);
+  EXPECT_NE(nullptr, resolve("foo.com"));
+}
+
+// Once a result expires, it is served stale while a single query refreshes it.
+TEST_F(CachingDnsResolverTest, StaleWhileRevalidate) {
+  initialize(R"EOF(
+stale_ttl: 30s
+  )EOF");
+  DnsResolver::ResolveCb callback;
+  expectQuery("foo.com", callback);
+  resolve("foo.com");
+  callback(DnsResolver::ResolutionStatus::Success,
+           TestUtility::makeDnsResponse({"10.0.0.1"}, std::chrono::seconds(10)));
+
+  time_system_.advanceTimeWait(std::chrono::seconds(15));
+  expectQuery("foo.com", callback);
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ(std::list<std::string>{"10.0.0.1"}, addresses_);
+  EXPECT_EQ(std::chrono::seconds(0), ttl_);
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ(2, counter("cache_stale_hit"));
+
+  callback(DnsResolver::ResolutionStatus::Success,
+           TestUtility::makeDnsResponse({"10.0.0.2"}, std::chrono::seconds(10)));
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ(std::list<std::string>{"10.0.0.2"}, addresses_);
+  EXPECT_EQ(1, counter("cache_hit"));
+
+  // Past the stale TTL, lookups wait for the refresh.
+  time_system_.advanceTimeWait(std::chrono::seconds(40));
+  expectQuery("foo.com", callback);
+  EXPECT_NE(nullptr, resolve("foo.com"));
+}
+
+// A cancelled resolution is not called back, but its query still fills the cache.
+TEST_F(CachingDnsResolverTest, CancelPendingResolution) {
+  initialize();
+  DnsResolver::ResolveCb callback;
+  expectQuery("foo.com", callback);
+  resolve("foo.com")->cancel();
+  EXPECT_CALL(upstream_resolver_->active_query_, cancel()).Times(0);
+
+  callback(DnsResolver::ResolutionStatus::Success,
+           TestUtility::makeDnsResponse({"10.0.0.1"}, std::chrono::seconds(10)));
+  EXPECT_EQ(0U, results_);
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ(1U, results_);
+}
+
+// A query which the underlying resolver completes inline completes the resolution inline.
+TEST_F(CachingDnsResolverTest, InlineQueryCompletion) {
+  initialize();
+  EXPECT_CALL(*upstream_resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(Invoke([](const std::string&, DnsLookupFamily,
+                          DnsResolver::ResolveCb callback) -> ActiveDnsQuery* {
+        callback(DnsResolver::ResolutionStatus::Success,
+                 TestUtility::makeDnsResponse({"127.0.0.1"}, std::chrono::seconds(0)));
+        return nullptr;
+      }));
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ(1U, results_);
+  EXPECT_EQ(std::list<std::string>{"127.0.0.1"}, addresses_);
+}
+
+TEST_F(CachingDnsResolverTest, DestroyCancelsQueries) {
+  initialize();
+  DnsResolver::ResolveCb callback;
+  expectQuery("foo.com", callback);
+  resolve("foo.com");
+  EXPECT_CALL(upstream_resolver_->active_query_, cancel());
+  resolver_.reset();
+  EXPECT_EQ(0U, results_);
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
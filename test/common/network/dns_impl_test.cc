@@ -5,6 +5,7 @@
 
 #include "envoy/common/platform.h"
 #include "envoy/config/core/v3/address.pb.h"
+#include "envoy/config/core/v3/resolver.pb.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/network/address.h"
 #include "envoy/network/dns.h"
@@ -13,10 +14,12 @@
 #include "common/common/utility.h"
 #include "common/event/dispatcher_impl.h"
 #include "common/network/address_impl.h"
+#include "common/network/caching_dns_resolver.h"
 #include "common/network/dns_impl.h"
 #include "common/network/filter_impl.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/utility.h"
+#include "common/stats/isolated_store_impl.h"
 #include "common/stream_info/stream_info_impl.h"
 
 #include "test/mocks/network/mocks.h"
@@ -798,6 +801,42 @@ TEST_P(DnsImplTest, Cancel) {
 }
 
 // Validate working of querying ttl of resource record.
+// Validate that a caching resolver in front of the resolver answers repeated lookups of both
+// existing and missing names from its cache, without querying the server again.
+TEST_P(DnsImplTest, CachingResolverLookup) {
+  server_->addHosts("some.good.domain", {"201.134.56.7"}, RecordType::A);
+  server_->setRecordTtl(std::chrono::seconds(300));
+  Stats::IsolatedStoreImpl stats_store;
+  resolver_ = std::make_shared<CachingDnsResolver>(
+      resolver_, dispatcher_->timeSource(), envoy::config::core::v3::DnsResolutionCacheConfig(),
+      stats_store);
+
+  EXPECT_NE(nullptr, resolveWithExpectations("some.good.domain", DnsLookupFamily::V4Only,
+                                             DnsResolver::ResolutionStatus::Success,
+                                             {"201.134.56.7"}, {}, absl::nullopt));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_NE(nullptr,
+            resolveWithExpectations("some.bad.domain", DnsLookupFamily::V4Only,
+                                    DnsResolver::ResolutionStatus::Failure, {}, {}, absl::nullopt));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  // The server now has other records, which the cache doesn't see until the results expire.
+  server_->addHosts("some.good.domain", {"123.4.5.6"}, RecordType::A);
+  server_->addHosts("some.bad.domain", {"6.5.4.3"}, RecordType::A);
+  EXPECT_EQ(nullptr, resolveWithExpectations("some.good.domain", DnsLookupFamily::V4Only,
+                                             DnsResolver::ResolutionStatus::Success,
+                                             {"201.134.56.7"}, {}, absl::nullopt));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(nullptr,
+            resolveWithExpectations("some.bad.domain", DnsLookupFamily::V4Only,
+                                    DnsResolver::ResolutionStatus::Failure, {}, {}, absl::nullopt));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  EXPECT_EQ(2UL, stats_store.counter("dns_resolution_cache.cache_miss").value());
+  EXPECT_EQ(1UL, stats_store.counter("dns_resolution_cache.cache_hit").value());
+  EXPECT_EQ(1UL, stats_store.counter("dns_resolution_cache.cache_negative_hit").value());
+}
+
 TEST_P(DnsImplTest, RecordTtlLookup) {
   if (GetParam() == Address::IpVersion::v4) {
     EXPECT_EQ(nullptr, resolveWithExpectations("localhost", DnsLookupFamily::V4Only,
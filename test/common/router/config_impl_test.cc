@@ -3655,6 +3655,38 @@ virtual_hosts:
   EXPECT_EQ(100, ProtobufPercentHelper::fractionalPercentDenominatorToInt(percent.denominator()));
 }
 
+TEST_F(RouteMatcherTest, HedgeLatency) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+- domains: [www.lyft.com]
+  name: www
+  routes:
+  - match: {prefix: /foo}
+    route:
+      cluster: www
+      hedge_policy: {latency_hedging: {percentile: {value: 99}}}
+  - match: {prefix: /}
+    route: {cluster: www}
+  )EOF";
+
+  TestConfigImpl config(parseRouteConfigurationFromYaml(yaml), factory_context_, true);
+
+  HedgeController* hedge_controller = config.route(genHeaders("www.lyft.com", "/foo", "GET"), 0)
+                                          ->routeEntry()
+                                          ->hedgePolicy()
+                                          .latencyHedgeController();
+  ASSERT_NE(nullptr, hedge_controller);
+  // The controller is shared by all requests of the route.
+  EXPECT_EQ(hedge_controller, config.route(genHeaders("www.lyft.com", "/foo", "GET"), 0)
+                                  ->routeEntry()
+                                  ->hedgePolicy()
+                                  .latencyHedgeController());
+  EXPECT_EQ(nullptr, config.route(genHeaders("www.lyft.com", "/", "GET"), 0)
+                         ->routeEntry()
+                         ->hedgePolicy()
+                         .latencyHedgeController());
+}
+
 TEST_F(RouteMatcherTest, HedgeVirtualHostLevel) {
   const std::string yaml = R"EOF(
 virtual_hosts:
@@ -0,0 +1,150 @@
+#include <chrono>
+#include <string>
+
+#include "envoy/config/route/v3/route_components.pb.h"
+
+#include "common/router/hedge_controller_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+using std::chrono::milliseconds;
+
+envoy::config::route::v3::HedgePolicy::LatencyHedging parseLatencyHedging(const std::string& yaml) {
+  envoy::config::route::v3::HedgePolicy::LatencyHedging latency_hedging;
+  TestUtility::loadFromYaml(yaml, latency_hedging);
+  return latency_hedging;
+}
+
+TEST(HedgeControllerImplTest, Buckets) {
+  EXPECT_EQ(0, HedgeControllerImpl::bucketIndex(milliseconds(0)));
+  EXPECT_EQ(3, HedgeControllerImpl::bucketIndex(milliseconds(3)));
+  EXPECT_EQ(4, HedgeControllerImpl::bucketIndex(milliseconds(4)));
+  EXPECT_EQ(8, HedgeControllerImpl::bucketIndex(milliseconds(8)));
+  EXPECT_EQ(8, HedgeControllerImpl::bucketIndex(milliseconds(9)));
+  EXPECT_EQ(9, HedgeControllerImpl::bucketIndex(milliseconds(10)));
+  EXPECT_EQ(HedgeControllerImpl::NumBuckets - 1,
+            HedgeControllerImpl::bucketIndex(milliseconds(3600 * 1000)));
+
+  // Every response time falls in a bucket which ends at or after it, and the buckets are
+  // contiguous.
+  for (size_t index = 1; index < HedgeControllerImpl::NumBuckets; ++index) {
+    const milliseconds lower_bound =
+        HedgeControllerImpl::bucketUpperBound(index - 1) + milliseconds(1);
+    const milliseconds upper_bound = HedgeControllerImpl::bucketUpperBound(index);
+    EXPECT_LE(lower_bound, upper_bound);
+    EXPECT_EQ(index, HedgeControllerImpl::bucketIndex(lower_bound));
+    EXPECT_EQ(index, HedgeControllerImpl::bucketIndex(upper_bound));
+  }
+}
+
+TEST(HedgeControllerImplTest, HedgeDelay) {
+  HedgeControllerImpl controller(parseLatencyHedging(R"EOF(
+percentile:
+  value: 90
+min_samples: 10
+)EOF"));
+
+  // Requests are not hedged until enough response times have been observed.
+  for (uint32_t i = 1; i < 10; ++i) {
+    controller.recordResponseTime(milliseconds(i));
+  }
+  EXPECT_FALSE(controller.hedgeDelay().has_value());
+
+  // 9 of the 10 response times are at most 9ms.
+  controller.recordResponseTime(milliseconds(100));
+  EXPECT_EQ(milliseconds(9), controller.hedgeDelay());
+
+  // The 90th percentile moves to the bucket of 100ms, which covers 96ms to 111ms.
+  for (uint32_t i = 0; i < 10; ++i) {
+    controller.recordResponseTime(milliseconds(100));
+  }
+  EXPECT_EQ(milliseconds(111), controller.hedgeDelay());
+}
+
+TEST(HedgeControllerImplTest, MinDelay) {
+  HedgeControllerImpl controller(parseLatencyHedging(R"EOF(
+min_delay: 0.05s
+min_samples: 1
+)EOF"));
+
+  controller.recordResponseTime(milliseconds(1));
+  EXPECT_EQ(milliseconds(50), controller.hedgeDelay());
+}
+
+TEST(HedgeControllerImplTest, ResponseTimesDecay) {
+  HedgeControllerImpl controller(parseLatencyHedging(R"EOF(
+percentile:
+  value: 50
+min_samples: 1
+)EOF"));
+
+  // After many fast responses, the route slows down: the median follows once the older response
+  // times have been halved enough.
+  for (uint32_t i = 0; i < 1000; ++i) {
+    controller.recordResponseTime(milliseconds(1));
+  }
+  EXPECT_EQ(milliseconds(1), controller.hedgeDelay());
+  for (uint32_t i = 0; i < 1000; ++i) {
+    controller.recordResponseTime(milliseconds(100));
+  }
+  EXPECT_EQ(milliseconds(111), controller.hedgeDelay());
+}
+
+TEST(HedgeControllerImplTest, Budget) {
+  HedgeControllerImpl controller(parseLatencyHedging(R"EOF(
+budget:
+  value: 10
+)EOF"));
+
+  // No request, no hedge.
+  EXPECT_FALSE(controller.tryHedge());
+
+  for (uint32_t i = 0; i < 100; ++i) {
+    controller.onRequest();
+  }
+  for (uint32_t i = 0; i < 10; ++i) {
+    EXPECT_TRUE(controller.tryHedge());
+  }
+  EXPECT_FALSE(controller.tryHedge());
+
+  // Every further 10 requests allow for another hedge.
+  for (uint32_t i = 0; i < 10; ++i) {
+    controller.onRequest();
+  }
+  EXPECT_TRUE(controller.tryHedge());
+  EXPECT_FALSE(controller.tryHedge());
+}
+
+TEST(HedgeControllerImplTest, BudgetDecays) {
+  HedgeControllerImpl controller(parseLatencyHedging("{}"));
+
+  // The default budget is 10% of the requests.
+  for (uint32_t i = 0; i < 999; ++i) {
+    controller.onRequest();
+  }
+  uint32_t hedges = 0;
+  while (controller.tryHedge()) {
+    hedges++;
+  }
+  EXPECT_EQ(99, hedges);
+
+  // The 1000th request halves the requests to 500 and the hedges to 49, which keeps the hedges
+  // within 10% of the recent requests.
+  controller.onRequest();
+  EXPECT_TRUE(controller.tryHedge());
+  EXPECT_FALSE(controller.tryHedge());
+  for (uint32_t i = 0; i < 10; ++i) {
+    controller.onRequest();
+  }
+  EXPECT_TRUE(controller.tryHedge());
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
@@ -324,6 +324,8 @@ TEST_F(RouterRetryStateImplTest, RuntimeGuard) {
   setup(request_headers);
   EXPECT_TRUE(state_->enabled());
   EXPECT_EQ(RetryStatus::No, state_->shouldRetryReset(remote_reset_, callback_));
+  // The retry reserved before checking the runtime guard is released.
+  EXPECT_EQ(0UL, cluster_.resourceManager(Upstream::ResourcePriority::Default).retries().count());
 }
 
 TEST_F(RouterRetryStateImplTest, PolicyConnectFailureOtherReset) {
@@ -1088,6 +1090,37 @@ TEST_F(RouterRetryStateImplTest, BudgetRuntimeSetOnly) {
   EXPECT_EQ(RetryStatus::Yes, state_->shouldRetryHeaders(response_headers, callback_));
 }
 
+TEST_F(RouterRetryStateImplTest, BudgetOverflowReleasesRetry) {
+  cluster_.resetResourceManagerWithRetryBudget(
+      0 /* cx */, 0 /* rq_pending */, 0 /* rq */, 0 /* rq_retry */, 0 /* conn_pool */,
+      50.0 /* budget_percent */, 1 /* min_retry_concurrency */);
+  ResourceLimit& retries = cluster_.resourceManager(Upstream::ResourcePriority::Default).retries();
+
+  Http::TestRequestHeaderMapImpl request_headers{{"x-envoy-retry-on", "5xx"},
+                                                 {"x-envoy-max-retries", "42"}};
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "500"}};
+  setup(request_headers);
+
+  // The retry allowed by the minimum concurrency is taken by another request, so this one
+  // overflows and does not hold on to the retry it reserved.
+  incrOutstandingResource(TestResourceType::Retry, 1);
+  EXPECT_EQ(RetryStatus::NoOverflow, state_->shouldRetryHeaders(response_headers, callback_));
+  EXPECT_EQ(1UL, retries.count());
+  EXPECT_EQ(1UL, cluster_.stats().upstream_rq_retry_overflow_.value());
+
+  // With 4 active requests, half of them may be retried at once.
+  incrOutstandingResource(TestResourceType::Request, 4);
+  expectTimerCreateAndEnable();
+  EXPECT_EQ(RetryStatus::Yes, state_->shouldRetryHeaders(response_headers, callback_));
+  EXPECT_EQ(2UL, retries.count());
+
+  // Another request takes one more retry, which leaves none for this request once it gives back
+  // the retry it holds.
+  incrOutstandingResource(TestResourceType::Retry, 1);
+  EXPECT_EQ(RetryStatus::NoOverflow, state_->shouldRetryHeaders(response_headers, callback_));
+  EXPECT_EQ(2UL, retries.count());
+}
+
 TEST_F(RouterRetryStateImplTest, ParseRetryOn) {
   // RETRY_ON_5XX             0x1
   // RETRY_ON_GATEWAY_ERROR   0x2
@@ -2419,7 +2419,119 @@ TEST_F(RouterTest, HedgedPerTryTimeoutFirstRequestSucceeds) {
   response_decoder1->decodeHeaders(std::move(response_headers), true);
   EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
 
-  // TODO: Verify hedge stats here once they are implemented.
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge")
+                    .value());
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_abandoned")
+                    .value());
+}
+
+// Tests that a request is hedged once it has taken longer than the delay of the latency hedge
+// controller of the route, and that the slower request is reset once the other one responds.
+TEST_F(RouterTest, LatencyHedgeSecondRequestSucceeds) {
+  NiceMock<MockHedgeController> hedge_controller;
+  callbacks_.route_->route_entry_.hedge_policy_.latency_hedge_controller_ = &hedge_controller;
+  EXPECT_CALL(hedge_controller, onRequest());
+  EXPECT_CALL(hedge_controller, hedgeDelay())
+      .WillOnce(Return(absl::optional<std::chrono::milliseconds>(10)));
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke(
+          [&](Http::ResponseDecoder&,
+              Http::ConnectionPool::Callbacks& callbacks) -> Http::ConnectionPool::Cancellable* {
+            EXPECT_CALL(*router_.retry_state_, onHostAttempted(_));
+            callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_, upstream_stream_info_);
+            return nullptr;
+          }));
+  // The hedge timer is created after the response timer.
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableTimer(std::chrono::milliseconds(10), _));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+  expectResponseTimerCreate();
+
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(hedge_controller, tryHedge()).WillOnce(Return(true));
+  router_.retry_state_->expectHedgedPerTryTimeoutRetry();
+  hedge_timer->invokeCallback();
+
+  NiceMock<Http::MockRequestEncoder> encoder2;
+  Http::ResponseDecoder* response_decoder2 = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke(
+          [&](Http::ResponseDecoder& decoder,
+              Http::ConnectionPool::Callbacks& callbacks) -> Http::ConnectionPool::Cancellable* {
+            response_decoder2 = &decoder;
+            EXPECT_CALL(*router_.retry_state_, onHostAttempted(_));
+            callbacks.onPoolReady(encoder2, cm_.conn_pool_.host_, upstream_stream_info_);
+            return nullptr;
+          }));
+  router_.retry_state_->callback_();
+  EXPECT_EQ(2U,
+            callbacks_.route_->route_entry_.virtual_cluster_.stats().upstream_rq_total_.value());
+
+  // The first request is reset once the hedged request responds, and the response time of the
+  // hedged request is recorded.
+  EXPECT_CALL(encoder1.stream_, resetStream(_));
+  EXPECT_CALL(encoder2.stream_, resetStream(_)).Times(0);
+  EXPECT_CALL(hedge_controller, recordResponseTime(_));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  response_decoder2->decodeHeaders(std::move(response_headers), true);
+
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge")
+                    .value());
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_abandoned")
+                    .value());
+}
+
+// Tests that no request is hedged once the hedge budget of the route is exhausted.
+TEST_F(RouterTest, LatencyHedgeBudgetExceeded) {
+  NiceMock<MockHedgeController> hedge_controller;
+  callbacks_.route_->route_entry_.hedge_policy_.latency_hedge_controller_ = &hedge_controller;
+  EXPECT_CALL(hedge_controller, hedgeDelay())
+      .WillOnce(Return(absl::optional<std::chrono::milliseconds>(10)));
+
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke(
+          [&](Http::ResponseDecoder& decoder,
+              Http::ConnectionPool::Callbacks& callbacks) -> Http::ConnectionPool::Cancellable* {
+            response_decoder = &decoder;
+            callbacks.onPoolReady(encoder, cm_.conn_pool_.host_, upstream_stream_info_);
+            return nullptr;
+          }));
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableTimer(std::chrono::milliseconds(10), _));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+  expectResponseTimerCreate();
+
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(hedge_controller, tryHedge()).WillOnce(Return(false));
+  EXPECT_CALL(*router_.retry_state_, shouldHedgeRetryPerTryTimeout(_)).Times(0);
+  hedge_timer->invokeCallback();
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_budget_exceeded")
+                    .value());
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge")
+                    .value());
 }
 
 // Tests that an upstream request is reset even if it can't be retried as long as there is
@@ -5092,6 +5204,48 @@ TEST_F(RouterTest, UpstreamTimingSingleRequest) {
             std::chrono::milliseconds(32));
 }
 
+class RouterLatencyMonitorTest : public RouterTest {
+public:
+  // Sends a request that takes 10ms to the first response byte and verifies whether the sample is
+  // reported to the host's latency monitor.
+  void testLatencySample(Upstream::LoadBalancerType lb_type, bool expect_sample) {
+    cm_.thread_local_cluster_.cluster_.info_->lb_type_ = lb_type;
+    NiceMock<Http::MockRequestEncoder> encoder;
+    Http::ResponseDecoder* response_decoder = nullptr;
+    EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+        .WillOnce(Invoke(
+            [&](Http::ResponseDecoder& decoder,
+                Http::ConnectionPool::Callbacks& callbacks) -> Http::ConnectionPool::Cancellable* {
+              response_decoder = &decoder;
+              callbacks.onPoolReady(encoder, cm_.conn_pool_.host_, upstream_stream_info_);
+              return nullptr;
+            }));
+    expectResponseTimerCreate();
+
+    Http::TestRequestHeaderMapImpl headers{};
+    HttpTestUtility::addDefaultHeaders(headers);
+    router_.decodeHeaders(headers, true);
+    test_time_.advanceTimeWait(std::chrono::milliseconds(10));
+
+    EXPECT_CALL(cm_.conn_pool_.host_->latency_monitor_,
+                putResponseTime(std::chrono::microseconds(10000), _))
+        .Times(expect_sample ? 1 : 0);
+    Http::ResponseHeaderMapPtr response_headers(
+        new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+    response_decoder->decodeHeaders(std::move(response_headers), true);
+  }
+};
+
+// Hosts of a cluster that is not latency aware are not sent response time samples.
+TEST_F(RouterLatencyMonitorTest, NotLatencyAware) {
+  testLatencySample(Upstream::LoadBalancerType::RoundRobin, false);
+}
+
+// Hosts of a PEAK_EWMA cluster are sent the time to first response byte.
+TEST_F(RouterLatencyMonitorTest, PeakEwma) {
+  testLatencySample(Upstream::LoadBalancerType::PeakEwma, true);
+}
+
 // Verify that upstream timing information is set into the StreamInfo when a
 // retry occurs (and not before).
 TEST_F(RouterTest, UpstreamTimingRetry) {
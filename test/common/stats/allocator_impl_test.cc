@@ -1,4 +1,5 @@
 #include <string>
+#include <vector>
 
 #include "common/stats/allocator_impl.h"
 #include "common/stats/symbol_table_creator.h"
@@ -55,6 +56,64 @@ TEST_F(AllocatorImplTest, CountersWithSameName) {
   EXPECT_EQ(2, c2->value());
 }
 
+// Counters matching a sharded counter prefix behave like other counters.
+TEST_F(AllocatorImplTest, ShardedCounters) {
+  alloc_.setShardedCounterPrefixes({"cluster.busy."});
+  CounterSharedPtr sharded = alloc_.makeCounter(makeStat("cluster.busy.upstream_rq_total"),
+                                                StatName(), {});
+  CounterSharedPtr plain = alloc_.makeCounter(makeStat("cluster.idle.upstream_rq_total"),
+                                              StatName(), {});
+
+  for (const CounterSharedPtr& counter : {sharded, plain}) {
+    EXPECT_FALSE(counter->used());
+    counter->inc();
+    counter->add(4);
+    EXPECT_TRUE(counter->used());
+    EXPECT_EQ(5, counter->value());
+    EXPECT_EQ(5, counter->latch());
+    EXPECT_EQ(0, counter->latch());
+    counter->inc();
+    EXPECT_EQ(1, counter->latch());
+    counter->reset();
+    EXPECT_EQ(0, counter->value());
+    counter->add(2);
+    EXPECT_EQ(2, counter->value());
+    EXPECT_EQ(2, counter->latch());
+  }
+
+  // The increments of all threads add up.
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < 8; ++i) {
+    threads.push_back(Thread::threadFactoryForTest().createThread([&sharded]() {
+      for (uint32_t j = 0; j < 1000; ++j) {
+        sharded->inc();
+      }
+    }));
+  }
+  for (Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+  EXPECT_EQ(8002, sharded->value());
+  EXPECT_EQ(8000, sharded->latch());
+}
+
+// Resetting a sharded counter keeps the increments pending for the next latch, like CounterImpl.
+TEST_F(AllocatorImplTest, ShardedCounterLatchAfterReset) {
+  alloc_.setShardedCounterPrefixes({"cluster.busy."});
+  CounterSharedPtr counter = alloc_.makeCounter(makeStat("cluster.busy.upstream_rq_total"),
+                                                StatName(), {});
+  counter->add(3);
+  EXPECT_EQ(3, counter->latch());
+  counter->add(5);
+  counter->reset();
+  EXPECT_EQ(0, counter->value());
+  EXPECT_EQ(5, counter->latch());
+  counter->add(2);
+  EXPECT_EQ(2, counter->value());
+  EXPECT_EQ(2, counter->latch());
+  EXPECT_EQ(0, counter->latch());
+}
+
 TEST_F(AllocatorImplTest, GaugesWithSameName) {
   StatName gauge_name = makeStat("gauges.name");
   GaugeSharedPtr g1 = alloc_.makeGauge(gauge_name, StatName(), {}, Gauge::ImportMode::Accumulate);
@@ -75,6 +134,31 @@ TEST_F(AllocatorImplTest, GaugesWithSameName) {
   EXPECT_EQ(0, g2->value());
 }
 
+TEST_F(AllocatorImplTest, GaugeDirty) {
+  GaugeSharedPtr gauge =
+      alloc_.makeGauge(makeStat("gauge.name"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  EXPECT_FALSE(gauge->clearDirty());
+  gauge->set(5);
+  EXPECT_TRUE(gauge->clearDirty());
+  EXPECT_FALSE(gauge->clearDirty());
+  EXPECT_TRUE(gauge->used());
+
+  // Every kind of write marks the gauge dirty, even one leaving its value unchanged.
+  gauge->add(1);
+  EXPECT_TRUE(gauge->clearDirty());
+  gauge->sub(1);
+  EXPECT_TRUE(gauge->clearDirty());
+  gauge->set(5);
+  EXPECT_TRUE(gauge->clearDirty());
+  gauge->setParentValue(2);
+  EXPECT_TRUE(gauge->clearDirty());
+  EXPECT_EQ(7, gauge->value());
+
+  // Clearing the dirty bit leaves the other flags alone.
+  EXPECT_TRUE(gauge->used());
+  EXPECT_EQ(Gauge::ImportMode::Accumulate, gauge->importMode());
+}
+
 // Test for a race-condition where we may decrement the ref-count of a stat to
 // zero at the same time as we are allocating another instance of that
 // stat. This test reproduces that race organically by having a 12 threads each
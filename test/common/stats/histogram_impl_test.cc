@@ -1,3 +1,6 @@
+#include <cmath>
+#include <vector>
+
 #include "envoy/config/metrics/v3/stats.pb.h"
 
 #include "common/stats/histogram_impl.h"
@@ -95,5 +98,82 @@ TEST_F(HistogramSettingsImplTest, Priority) {
   EXPECT_EQ(settings_->buckets("abcd"), ConstSupportedBuckets({1, 2}));
 }
 
+// Test that only histograms matching a compact configuration are compact.
+TEST_F(HistogramSettingsImplTest, Compact) {
+  envoy::config::metrics::v3::HistogramBucketSettings setting;
+  setting.mutable_match()->set_prefix("a");
+  setting.mutable_buckets()->Add(1);
+  setting.set_compact(true);
+  buckets_configs_.push_back(setting);
+
+  initialize();
+  EXPECT_TRUE(settings_->compact("abcd"));
+  EXPECT_FALSE(settings_->compact("test"));
+}
+
+// Test that only histograms matching a configuration with a sample buffer buffer their samples.
+TEST_F(HistogramSettingsImplTest, SampleBufferSize) {
+  envoy::config::metrics::v3::HistogramBucketSettings setting;
+  setting.mutable_match()->set_prefix("a");
+  setting.mutable_buckets()->Add(1);
+  setting.set_sample_buffer_size(64);
+  buckets_configs_.push_back(setting);
+
+  initialize();
+  EXPECT_EQ(64, settings_->sampleBufferSize("abcd"));
+  EXPECT_EQ(0, settings_->sampleBufferSize("test"));
+}
+
+TEST(CompactHistogramTest, RecordAndMerge) {
+  ConstSupportedBuckets buckets{10, 100};
+  CompactHistogram histogram(buckets);
+  EXPECT_EQ(0, histogram.sampleCount());
+  EXPECT_TRUE(std::isnan(histogram.quantile(0.5)));
+
+  // Samples on the bound of a bucket are counted in it.
+  histogram.recordValue(5);
+  histogram.recordValue(10);
+  histogram.recordValue(50);
+  histogram.recordValue(1000);
+  EXPECT_EQ(std::vector<uint64_t>({2, 1, 1}), histogram.counts());
+  EXPECT_EQ(4, histogram.sampleCount());
+  EXPECT_EQ(1065, histogram.sampleSum());
+
+  CompactHistogram other(buckets);
+  other.recordValue(20);
+  histogram.merge(other);
+  EXPECT_EQ(std::vector<uint64_t>({2, 2, 1}), histogram.counts());
+  EXPECT_EQ(1085, histogram.sampleSum());
+
+  histogram.clear();
+  EXPECT_EQ(std::vector<uint64_t>({0, 0, 0}), histogram.counts());
+  EXPECT_EQ(0, histogram.sampleSum());
+}
+
+TEST(CompactHistogramTest, Quantiles) {
+  ConstSupportedBuckets buckets{10, 100};
+  CompactHistogram histogram(buckets);
+  for (uint64_t value : {1, 2, 3, 4, 20, 30, 40, 50}) {
+    histogram.recordValue(value);
+  }
+
+  // Quantiles are interpolated linearly within the buckets.
+  EXPECT_DOUBLE_EQ(0, histogram.quantile(0));
+  EXPECT_DOUBLE_EQ(5, histogram.quantile(0.25));
+  EXPECT_DOUBLE_EQ(10, histogram.quantile(0.5));
+  EXPECT_DOUBLE_EQ(55, histogram.quantile(0.75));
+  EXPECT_DOUBLE_EQ(100, histogram.quantile(1));
+
+  // Nothing is known about samples above the last bucket but that they are above it.
+  histogram.recordValue(1000);
+  EXPECT_DOUBLE_EQ(100, histogram.quantile(1));
+
+  HistogramStatisticsImpl statistics(buckets);
+  statistics.refresh(histogram);
+  EXPECT_EQ(9, statistics.sampleCount());
+  EXPECT_EQ(1150, statistics.sampleSum());
+  EXPECT_EQ(std::vector<uint64_t>({4, 8}), statistics.computedBuckets());
+}
+
 } // namespace Stats
 } // namespace Envoy
@@ -0,0 +1,103 @@
+#include "common/stats/lazy_stats.h"
+
+#include "test/common/stats/stat_test_utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+namespace {
+
+class LazyStatPoolTest : public testing::Test {
+protected:
+  LazyStatPoolTest() : scope_(store_.createScope("cluster.foo.")), pool_(*scope_) {}
+
+  TestUtil::TestStore store_;
+  ScopePtr scope_;
+  LazyStatPool pool_;
+};
+
+TEST_F(LazyStatPoolTest, Counter) {
+  Counter& counter = pool_.counterFromString("upstream_rq_total");
+  EXPECT_EQ(0, counter.value());
+  EXPECT_EQ(0, counter.latch());
+  EXPECT_FALSE(counter.used());
+  counter.add(0);
+  counter.reset();
+  EXPECT_FALSE(store_.findCounterByString("cluster.foo.upstream_rq_total"));
+  EXPECT_EQ(0, pool_.numAllocated());
+
+  counter.inc();
+  counter.add(2);
+  auto allocated = store_.findCounterByString("cluster.foo.upstream_rq_total");
+  ASSERT_TRUE(allocated);
+  EXPECT_EQ(3, allocated->get().value());
+  EXPECT_EQ(3, counter.value());
+  EXPECT_TRUE(counter.used());
+  EXPECT_EQ(3, counter.latch());
+  EXPECT_EQ("cluster.foo.upstream_rq_total", counter.name());
+  EXPECT_EQ(allocated->get().statName(), counter.statName());
+  EXPECT_EQ(1, pool_.numAllocated());
+}
+
+TEST_F(LazyStatPoolTest, CounterNameAllocates) {
+  Counter& counter = pool_.counterFromString("upstream_rq_total");
+  EXPECT_EQ("cluster.foo.upstream_rq_total", counter.name());
+  EXPECT_TRUE(store_.findCounterByString("cluster.foo.upstream_rq_total"));
+  EXPECT_FALSE(counter.used());
+}
+
+TEST_F(LazyStatPoolTest, Gauge) {
+  Gauge& gauge = pool_.gaugeFromString("upstream_cx_active", Gauge::ImportMode::Accumulate);
+  EXPECT_EQ(0, gauge.value());
+  EXPECT_EQ(Gauge::ImportMode::Accumulate, gauge.importMode());
+  EXPECT_FALSE(gauge.clearDirty());
+  gauge.set(0);
+  gauge.add(0);
+  EXPECT_FALSE(store_.findGaugeByString("cluster.foo.upstream_cx_active"));
+
+  gauge.inc();
+  gauge.add(4);
+  auto allocated = store_.findGaugeByString("cluster.foo.upstream_cx_active");
+  ASSERT_TRUE(allocated);
+  EXPECT_EQ(5, allocated->get().value());
+  EXPECT_EQ(Gauge::ImportMode::Accumulate, allocated->get().importMode());
+  gauge.sub(2);
+  gauge.dec();
+  EXPECT_EQ(2, gauge.value());
+
+  // Once allocated, setting the gauge to zero has to reach the stat.
+  gauge.set(0);
+  EXPECT_EQ(0, allocated->get().value());
+}
+
+TEST_F(LazyStatPoolTest, Histogram) {
+  Histogram& histogram =
+      pool_.histogramFromString("upstream_cx_connect_ms", Histogram::Unit::Milliseconds);
+  EXPECT_EQ(Histogram::Unit::Milliseconds, histogram.unit());
+  EXPECT_FALSE(histogram.used());
+  EXPECT_FALSE(store_.findHistogramByString("cluster.foo.upstream_cx_connect_ms"));
+
+  histogram.recordValue(10);
+  auto allocated = store_.findHistogramByString("cluster.foo.upstream_cx_connect_ms");
+  ASSERT_TRUE(allocated);
+  EXPECT_EQ(Histogram::Unit::Milliseconds, allocated->get().unit());
+  EXPECT_EQ(1, pool_.numAllocated());
+}
+
+// Stats of the same name handed out by pools of two scopes with the same prefix share the stat,
+// as stats allocated eagerly in the two scopes would.
+TEST_F(LazyStatPoolTest, SharedAcrossPools) {
+  ScopePtr scope2 = store_.createScope("cluster.foo.");
+  LazyStatPool pool2(*scope2);
+  Counter& counter1 = pool_.counterFromString("upstream_rq_total");
+  Counter& counter2 = pool2.counterFromString("upstream_rq_total");
+  counter1.inc();
+  counter2.inc();
+  EXPECT_EQ(2, counter1.value());
+  EXPECT_EQ(2, counter2.value());
+}
+
+} // namespace
+} // namespace Stats
+} // namespace Envoy
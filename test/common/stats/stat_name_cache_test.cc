@@ -0,0 +1,78 @@
+#include <string>
+
+#include "common/stats/stat_name_cache.h"
+#include "common/stats/symbol_table_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+namespace {
+
+class StatNameCacheTest : public testing::Test {
+protected:
+  StatNameCacheTest() : pool_(symbol_table_), cache_(symbol_table_) {}
+
+  const std::string& get(StatName name, uint64_t generation) {
+    return cache_.get(name, generation, [this, name]() {
+      renders_++;
+      return symbol_table_.toString(name);
+    });
+  }
+
+  SymbolTableImpl symbol_table_;
+  StatNamePool pool_;
+  StatNameCache<std::string> cache_;
+  uint32_t renders_{};
+};
+
+TEST_F(StatNameCacheTest, RendersOnce) {
+  const StatName name = pool_.add("a.b");
+  EXPECT_EQ("a.b", get(name, 0));
+  EXPECT_EQ("a.b", get(name, 1));
+  EXPECT_EQ(1, renders_);
+  EXPECT_EQ(1, cache_.size());
+}
+
+TEST_F(StatNameCacheTest, SweepDropsUnusedEntries) {
+  const StatName used = pool_.add("used");
+  const StatName unused = pool_.add("unused");
+  get(used, 0);
+  get(unused, 0);
+  get(used, 1);
+
+  cache_.sweep(1);
+  EXPECT_EQ(1, cache_.size());
+  EXPECT_EQ("used", get(used, 2));
+  EXPECT_EQ(2, renders_);
+
+  // A swept entry is rendered again the next time it is used.
+  EXPECT_EQ("unused", get(unused, 2));
+  EXPECT_EQ(3, renders_);
+}
+
+TEST_F(StatNameCacheTest, FindAndInsert) {
+  const StatName name = pool_.add("a");
+  EXPECT_EQ(nullptr, cache_.find(name, 0));
+  EXPECT_EQ("value", cache_.insert(name, 0, "value"));
+  const std::string* value = cache_.find(name, 1);
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ("value", *value);
+
+  // The generation is updated by find().
+  cache_.sweep(1);
+  EXPECT_EQ(1, cache_.size());
+  cache_.sweep(2);
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(StatNameCacheTest, Clear) {
+  get(pool_.add("a"), 0);
+  get(pool_.add("b"), 0);
+  cache_.clear();
+  EXPECT_EQ(0, cache_.size());
+}
+
+} // namespace
+} // namespace Stats
+} // namespace Envoy
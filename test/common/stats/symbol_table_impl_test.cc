@@ -266,7 +266,6 @@ TEST_P(StatNameTest, TestSuccessfulDecode) {
 class StatNameDeathTest : public StatNameTest {
 public:
   void decodeSymbolVec(const SymbolVec& symbol_vec) {
-    Thread::LockGuard lock(real_symbol_table_->lock_);
     for (Symbol symbol : symbol_vec) {
       real_symbol_table_->fromSymbol(symbol);
     }
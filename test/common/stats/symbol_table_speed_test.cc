@@ -3,6 +3,9 @@
 //
 // NOLINT(namespace-envoy)
 
+#include <string>
+#include <vector>
+
 #include "common/common/logger.h"
 #include "common/common/thread.h"
 #include "common/stats/isolated_store_impl.h"
@@ -12,6 +15,7 @@
 #include "test/common/stats/make_elements_helper.h"
 #include "test/test_common/utility.h"
 
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "benchmark/benchmark.h"
 
@@ -90,6 +94,79 @@ static void BM_JoinElements(benchmark::State& state) {
 }
 BENCHMARK(BM_JoinElements);
 
+namespace {
+
+// Holds a symbol table shared by the threads of the contention benchmarks below, with names
+// encoded up front. The table is built by the first thread to get here, and shared by all
+// threads and runs.
+struct SharedTable {
+  static constexpr uint32_t NumNames = 1000;
+
+  SharedTable() : pool_(table_) {
+    for (uint32_t i = 0; i < NumNames; ++i) {
+      names_.push_back(pool_.add(absl::StrCat("cluster.service_", i, ".upstream_rq_total")));
+      strings_.push_back(table_.toString(names_.back()));
+    }
+  }
+
+  static SharedTable& get() {
+    static SharedTable* shared_table = new SharedTable();
+    return *shared_table;
+  }
+
+  Envoy::Stats::SymbolTableImpl table_;
+  Envoy::Stats::StatNamePool pool_;
+  std::vector<Envoy::Stats::StatName> names_;
+  std::vector<std::string> strings_;
+};
+
+} // namespace
+
+// Decodes existing names from each benchmark thread, as admin and the stat sinks do while the
+// workers create stats.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_DecodeContended(benchmark::State& state) {
+  SharedTable& shared = SharedTable::get();
+  uint32_t index = state.thread_index;
+  size_t length = 0;
+  for (auto _ : state) {
+    length += shared.table_.toString(shared.names_[index++ % SharedTable::NumNames]).size();
+  }
+  benchmark::DoNotOptimize(length);
+}
+BENCHMARK(BM_DecodeContended)->ThreadRange(1, 32)->UseRealTime();
+
+// Encodes and frees existing names from each benchmark thread, as workers do when looking up
+// stats by name.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_EncodeExistingContended(benchmark::State& state) {
+  SharedTable& shared = SharedTable::get();
+  uint32_t index = state.thread_index;
+  for (auto _ : state) {
+    Envoy::Stats::StatNameStorage storage(shared.strings_[index++ % SharedTable::NumNames],
+                                          shared.table_);
+    storage.free(shared.table_);
+  }
+}
+BENCHMARK(BM_EncodeExistingContended)->ThreadRange(1, 32)->UseRealTime();
+
+// Encodes and frees names made of tokens private to each benchmark thread, so that the symbols
+// are allocated and freed every time.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_EncodeDistinctContended(benchmark::State& state) {
+  SharedTable& shared = SharedTable::get();
+  std::vector<std::string> strings;
+  for (uint32_t i = 0; i < 100; ++i) {
+    strings.push_back(absl::StrCat("thread_", state.thread_index, ".name_", i));
+  }
+  uint32_t index = 0;
+  for (auto _ : state) {
+    Envoy::Stats::StatNameStorage storage(strings[index++ % strings.size()], shared.table_);
+    storage.free(shared.table_);
+  }
+}
+BENCHMARK(BM_EncodeDistinctContended)->ThreadRange(1, 32)->UseRealTime();
+
 int main(int argc, char** argv) {
   Envoy::Thread::MutexBasicLockable lock;
   Envoy::Logger::Context logger_context(spdlog::level::warn,
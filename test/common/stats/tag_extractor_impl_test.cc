@@ -367,6 +367,103 @@ TEST(TagExtractorTest, ExtractRegexPrefix) {
   EXPECT_EQ("", extractRegexPrefix("prefix(foo)"));
 }
 
+TEST(TagExtractorTokensTest, Pattern) {
+  TagExtractorTokensImpl tag_extractor("cluster_name", "cluster.$.*.**");
+  EXPECT_EQ("cluster_name", tag_extractor.name());
+  EXPECT_EQ("cluster", tag_extractor.prefixToken());
+  std::string name = "cluster.test_cluster.upstream_cx_total";
+  TagVector tags;
+  IntervalSetImpl<size_t> remove_characters;
+  ASSERT_TRUE(tag_extractor.extractTag(name, tags, remove_characters));
+  EXPECT_EQ("cluster.upstream_cx_total", StringUtil::removeCharacters(name, remove_characters));
+  ASSERT_EQ(1, tags.size());
+  EXPECT_EQ("test_cluster", tags.at(0).value_);
+  EXPECT_EQ("cluster_name", tags.at(0).name_);
+
+  tags.clear();
+  EXPECT_FALSE(tag_extractor.extractTag("cluster.test_cluster", tags, remove_characters));
+  EXPECT_FALSE(tag_extractor.extractTag("listener.test_cluster.foo", tags, remove_characters));
+  EXPECT_TRUE(tags.empty());
+}
+
+TEST(TagExtractorTokensTest, CaptureLastToken) {
+  TagExtractorTokensImpl tag_extractor("cipher", "listener.*.ssl.cipher.$");
+  std::string name = "listener.0.ssl.cipher.AES256";
+  TagVector tags;
+  IntervalSetImpl<size_t> remove_characters;
+  ASSERT_TRUE(tag_extractor.extractTag(name, tags, remove_characters));
+  EXPECT_EQ("listener.0.ssl.cipher", StringUtil::removeCharacters(name, remove_characters));
+  ASSERT_EQ(1, tags.size());
+  EXPECT_EQ("AES256", tags.at(0).value_);
+
+  // Without "**", the pattern must match all the tokens of the name.
+  EXPECT_FALSE(
+      tag_extractor.extractTag("listener.0.ssl.cipher.AES256.foo", tags, remove_characters));
+}
+
+TEST(TagExtractorTokensTest, SubstrMismatch) {
+  TagExtractorTokensImpl tag_extractor("vcluster", "vhost.*.vcluster.$.**", ".vcluster.");
+  EXPECT_EQ("vhost", tag_extractor.prefixToken());
+  TagVector tags;
+  IntervalSetImpl<size_t> remove_characters;
+  EXPECT_FALSE(tag_extractor.extractTag("vhost.foo.bar.baz", tags, remove_characters));
+  EXPECT_TRUE(tag_extractor.extractTag("vhost.foo.vcluster.baz.total", tags, remove_characters));
+}
+
+TEST(TagExtractorTokensTest, NoPrefix) {
+  TagExtractorTokensImpl tag_extractor("foo", "*.$.**");
+  EXPECT_EQ("", tag_extractor.prefixToken());
+}
+
+TEST(TagExtractorTokensTest, InvalidPattern) {
+  EXPECT_THROW_WITH_MESSAGE(TagExtractorTokensImpl("foo", "cluster.*.**"), EnvoyException,
+                            "Invalid tag pattern 'cluster.*.**': expected exactly one '$' token");
+  EXPECT_THROW_WITH_MESSAGE(TagExtractorTokensImpl("foo", "$.$"), EnvoyException,
+                            "Invalid tag pattern '$.$': expected exactly one '$' token");
+  EXPECT_THROW_WITH_MESSAGE(TagExtractorTokensImpl("foo", "**.$"), EnvoyException,
+                            "Invalid tag pattern '**.$': '**' can only be the last token");
+}
+
+TEST(TagExtractorTokensTest, PatternFromRegex) {
+  EXPECT_EQ("cluster.$.*.**", TagExtractorTokensImpl::patternFromRegex("^cluster\\.((.*?)\\.)"));
+  EXPECT_EQ("auth.client_ssl.$.*.**",
+            TagExtractorTokensImpl::patternFromRegex("^auth\\.client_ssl\\.((.*?)\\.)"));
+  EXPECT_EQ("$.*.**", TagExtractorTokensImpl::patternFromRegex("^((.*?)\\.)"));
+  EXPECT_EQ(absl::nullopt, TagExtractorTokensImpl::patternFromRegex("cluster\\.((.*?)\\.)"));
+  EXPECT_EQ(absl::nullopt, TagExtractorTokensImpl::patternFromRegex("^cluster\\.((.+?)\\.)"));
+  EXPECT_EQ(absl::nullopt, TagExtractorTokensImpl::patternFromRegex("^tcp\\.((.*?)\\.)\\w+?$"));
+  EXPECT_EQ(absl::nullopt,
+            TagExtractorTokensImpl::patternFromRegex("^listener(?=\\.).*?\\.http\\.((.*?)\\.)"));
+  EXPECT_EQ(absl::nullopt, TagExtractorTokensImpl::patternFromRegex("^cluster.((.*?)\\.)"));
+}
+
+// The extractors compiled from regexes extract the same tags as the regexes.
+TEST(TagExtractorTokensTest, SameAsRegex) {
+  const std::vector<std::string> regexes = {"^cluster\\.((.*?)\\.)", "^a\\.b_1\\.((.*?)\\.)",
+                                            "^((.*?)\\.)"};
+  const std::vector<std::string> names = {
+      "cluster.foo.bar", "cluster.foo.", "cluster.foo", "cluster..bar", "cluster.",
+      "cluster",         "clusters.foo", "a.b_1.c.d",   "a.b_1.c",      "a.b_1..",
+      "foo.bar",         ".foo",         "foo",         ""};
+  for (const std::string& regex : regexes) {
+    TagExtractorImpl regex_extractor("foo", regex);
+    TagExtractorPtr tokens_extractor = TagExtractorImpl::createTagExtractor("foo", regex);
+    ASSERT_NE(nullptr, dynamic_cast<const TagExtractorTokensImpl*>(tokens_extractor.get()));
+    EXPECT_EQ(regex_extractor.prefixToken(), tokens_extractor->prefixToken());
+    for (const std::string& name : names) {
+      TagVector regex_tags, tokens_tags;
+      IntervalSetImpl<size_t> regex_remove_characters, tokens_remove_characters;
+      EXPECT_EQ(regex_extractor.extractTag(name, regex_tags, regex_remove_characters),
+                tokens_extractor->extractTag(name, tokens_tags, tokens_remove_characters))
+          << regex << " " << name;
+      EXPECT_EQ(regex_tags, tokens_tags) << regex << " " << name;
+      EXPECT_EQ(StringUtil::removeCharacters(name, regex_remove_characters),
+                StringUtil::removeCharacters(name, tokens_remove_characters))
+          << regex << " " << name;
+    }
+  }
+}
+
 TEST(TagExtractorTest, CreateTagExtractorNoRegex) {
   EXPECT_THROW_WITH_REGEX(TagExtractorImpl::createTagExtractor("no such default tag", ""),
                           EnvoyException, "^No regex specified for tag specifier and no default");
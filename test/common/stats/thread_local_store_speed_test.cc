@@ -8,10 +8,12 @@
 #include "common/event/dispatcher_impl.h"
 #include "common/stats/allocator_impl.h"
 #include "common/stats/fake_symbol_table_impl.h"
+#include "common/stats/histogram_impl.h"
 #include "common/stats/tag_producer_impl.h"
 #include "common/stats/thread_local_store.h"
 #include "common/thread_local/thread_local_impl.h"
 
+#include "test/benchmark/main.h"
 #include "test/common/stats/stat_test_utility.h"
 #include "test/test_common/simulated_time_system.h"
 #include "test/test_common/test_time.h"
@@ -21,6 +23,13 @@
 
 namespace Envoy {
 
+// A sink dropping the histogram samples, to measure the cost of delivering them.
+class NullSink : public Stats::Sink {
+public:
+  void flush(Stats::MetricSnapshot&) override {}
+  void onHistogramComplete(const Stats::Histogram&, uint64_t) override {}
+};
+
 class ThreadLocalStorePerf {
 public:
   ThreadLocalStorePerf()
@@ -63,11 +72,32 @@ public:
     store_.initializeThreading(*dispatcher_, *tls_);
   }
 
+  /**
+   * @return a request latency histogram delivered to a sink, buffering sample_buffer_size
+   *         samples per thread, or none if 0.
+   */
+  Stats::Histogram& latencyHistogram(uint32_t sample_buffer_size) {
+    envoy::config::metrics::v3::StatsConfig stats_config;
+    if (sample_buffer_size != 0) {
+      auto* setting = stats_config.add_histogram_bucket_settings();
+      setting->mutable_match()->set_prefix("cluster.");
+      for (double bucket : Stats::HistogramSettingsImpl::defaultBuckets()) {
+        setting->add_buckets(bucket);
+      }
+      setting->set_sample_buffer_size(sample_buffer_size);
+    }
+    store_.setHistogramSettings(std::make_unique<Stats::HistogramSettingsImpl>(stats_config));
+    store_.addSink(sink_);
+    return store_.histogramFromString("cluster.upstream_rq_time",
+                                      Stats::Histogram::Unit::Milliseconds);
+  }
+
 private:
   Stats::SymbolTablePtr symbol_table_;
   Event::SimulatedTimeSystem time_system_;
   Stats::AllocatorImpl heap_alloc_;
   Event::DispatcherPtr dispatcher_;
+  NullSink sink_;
   ThreadLocal::InstanceImplPtr tls_;
   Stats::ThreadLocalStoreImpl store_;
   Api::ApiPtr api_;
@@ -75,6 +105,37 @@ private:
   std::vector<std::unique_ptr<Stats::StatNameStorage>> stat_names_;
 };
 
+// A counter which all benchmark threads increment, as the workers do with the
+// counters of a busy cluster, e.g. upstream_rq_total. The counter is allocated
+// both shared by all threads and sharded per thread.
+class CounterIncPerf {
+public:
+  CounterIncPerf()
+      : symbol_table_(Stats::SymbolTableCreator::makeSymbolTable()), alloc_(*symbol_table_),
+        pool_(*symbol_table_) {
+    alloc_.setShardedCounterPrefixes({"cluster.sharded."});
+    shared_counter_ =
+        alloc_.makeCounter(pool_.add("cluster.shared.upstream_rq_total"), Stats::StatName(), {});
+    sharded_counter_ =
+        alloc_.makeCounter(pool_.add("cluster.sharded.upstream_rq_total"), Stats::StatName(), {});
+  }
+
+  ~CounterIncPerf() {
+    shared_counter_.reset();
+    sharded_counter_.reset();
+    pool_.clear();
+  }
+
+  Stats::Counter& counter(bool sharded) { return sharded ? *sharded_counter_ : *shared_counter_; }
+
+private:
+  Stats::SymbolTablePtr symbol_table_;
+  Stats::AllocatorImpl alloc_;
+  Stats::StatNamePool pool_;
+  Stats::CounterSharedPtr shared_counter_;
+  Stats::CounterSharedPtr sharded_counter_;
+};
+
 } // namespace Envoy
 
 // Tests the single-threaded performance of the thread-local-store stats caches
@@ -101,5 +162,44 @@ static void BM_StatsWithTls(benchmark::State& state) {
 }
 BENCHMARK(BM_StatsWithTls);
 
+// Tests the cost of recording a request latency histogram on a thread, delivering each sample to
+// a sink as it is recorded, or buffering range(0) samples and delivering them in batches.
+static void BM_HistogramRecordValue(benchmark::State& state) {
+  Envoy::ThreadLocalStorePerf context;
+  context.initThreading();
+  Envoy::Stats::Histogram& histogram = context.latencyHistogram(state.range(0));
+
+  uint64_t value = 0;
+  for (auto _ : state) {
+    histogram.recordValue(++value % 5000);
+  }
+}
+BENCHMARK(BM_HistogramRecordValue)->Arg(0)->Arg(16)->Arg(256);
+
 // TODO(jmarantz): add multi-threaded variant of this test, that aggressively
 // looks up stats in multiple threads to try to trigger contention issues.
+
+// Tests the multi-threaded performance of incrementing the same counter from
+// all threads, with a shared counter, or with a sharded one if range(0) is set.
+static void BM_CounterIncMultiThreaded(benchmark::State& state) {
+  if (Envoy::benchmark::skipExpensiveBenchmarks() && state.threads > 8) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  // Built once by the first thread to get here, and shared by all threads and runs.
+  static Envoy::CounterIncPerf* context = new Envoy::CounterIncPerf();
+  Envoy::Stats::Counter& counter = context->counter(state.range(0) != 0);
+
+  for (auto _ : state) {
+    counter.inc();
+  }
+}
+BENCHMARK(BM_CounterIncMultiThreaded)
+    ->Arg(0)
+    ->Arg(1)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(32)
+    ->Threads(64)
+    ->UseRealTime();
@@ -32,6 +32,7 @@ using testing::_;
 using testing::HasSubstr;
 using testing::InSequence;
 using testing::NiceMock;
+using testing::Property;
 using testing::Ref;
 using testing::Return;
 
@@ -1464,6 +1465,122 @@ TEST_F(HistogramTest, ParentHistogramBucketSummary) {
             parent_histogram->bucketSummary());
 }
 
+TEST_F(HistogramTest, CompactHistogram) {
+  envoy::config::metrics::v3::StatsConfig stats_config;
+  TestUtility::loadFromYaml(R"EOF(
+histogram_bucket_settings:
+- match:
+    prefix: compact
+  buckets: [10, 100]
+  compact: true
+)EOF",
+                            stats_config);
+  store_->setHistogramSettings(std::make_unique<HistogramSettingsImpl>(stats_config));
+
+  Histogram& histogram = store_->histogramFromString("compact", Histogram::Unit::Unspecified);
+  for (uint64_t value : {5, 10, 50, 1000}) {
+    EXPECT_CALL(sink_, onHistogramComplete(Ref(histogram), value));
+    histogram.recordValue(value);
+  }
+  store_->mergeHistograms([]() -> void {});
+  ASSERT_EQ(1, store_->histograms().size());
+  ParentHistogramSharedPtr parent_histogram = store_->histograms()[0];
+  EXPECT_EQ("B10(2,2) B100(3,3)", parent_histogram->bucketSummary());
+  EXPECT_EQ(4, parent_histogram->intervalStatistics().sampleCount());
+  EXPECT_EQ(1065, parent_histogram->intervalStatistics().sampleSum());
+  // Samples above the last bucket are only known to be above it.
+  EXPECT_EQ("P0: 0, P25: 5, P50: 10, P75: 100, P90: 100, P95: 100, P99: 100, P99.5: 100, "
+            "P99.9: 100, P100: 100",
+            parent_histogram->intervalStatistics().quantileSummary());
+
+  // The interval histogram only holds the samples recorded since the previous merge.
+  EXPECT_CALL(sink_, onHistogramComplete(Ref(histogram), 20));
+  histogram.recordValue(20);
+  store_->mergeHistograms([]() -> void {});
+  EXPECT_EQ("B10(0,2) B100(1,4)", parent_histogram->bucketSummary());
+  EXPECT_EQ(1, parent_histogram->intervalStatistics().sampleCount());
+  EXPECT_EQ(5, parent_histogram->cumulativeStatistics().sampleCount());
+}
+
+// Validates that the values of a histogram with a sample buffer are recorded and delivered to the
+// sinks in batches, once the buffer is full or when the histograms are merged.
+TEST_F(HistogramTest, BufferedHistogram) {
+  envoy::config::metrics::v3::StatsConfig stats_config;
+  TestUtility::loadFromYaml(R"EOF(
+histogram_bucket_settings:
+- match:
+    prefix: buffered
+  buckets: [10, 100]
+  compact: true
+  sample_buffer_size: 3
+)EOF",
+                            stats_config);
+  store_->setHistogramSettings(std::make_unique<HistogramSettingsImpl>(stats_config));
+
+  Histogram& histogram = store_->histogramFromString("buffered", Histogram::Unit::Unspecified);
+  Histogram& unbuffered = store_->histogramFromString("unbuffered", Histogram::Unit::Unspecified);
+  EXPECT_CALL(sink_, onHistogramComplete(_, _)).Times(0);
+  histogram.recordValue(5);
+  histogram.recordValue(50);
+  testing::Mock::VerifyAndClearExpectations(&sink_);
+
+  // The third value fills the buffer, so the batch is delivered with the thread local histogram,
+  // which has the same name.
+  {
+    InSequence s;
+    for (uint64_t value : {5, 50, 500}) {
+      EXPECT_CALL(sink_, onHistogramComplete(Property(&Histogram::name, "buffered"), value));
+    }
+  }
+  histogram.recordValue(500);
+  testing::Mock::VerifyAndClearExpectations(&sink_);
+
+  EXPECT_CALL(sink_, onHistogramComplete(Ref(unbuffered), 1));
+  unbuffered.recordValue(1);
+  histogram.recordValue(20);
+  testing::Mock::VerifyAndClearExpectations(&sink_);
+
+  // The merge records and delivers the values left in the buffer.
+  EXPECT_CALL(sink_, onHistogramComplete(Property(&Histogram::name, "buffered"), 20));
+  store_->mergeHistograms([]() -> void {});
+  NameHistogramMap name_histogram_map = makeHistogramMap(store_->histograms());
+  const ParentHistogramSharedPtr& parent_histogram = name_histogram_map["buffered"];
+  EXPECT_EQ("B10(1,1) B100(3,3)", parent_histogram->bucketSummary());
+  EXPECT_EQ(4, parent_histogram->intervalStatistics().sampleCount());
+  EXPECT_EQ(575, parent_histogram->intervalStatistics().sampleSum());
+  EXPECT_EQ(1, name_histogram_map["unbuffered"]->intervalStatistics().sampleCount());
+}
+
+// Validates that the values left in the buffer of a histogram are delivered to the sinks when the
+// histogram is released, rather than lost with its thread local histograms.
+TEST_F(HistogramTest, BufferedHistogramReleased) {
+  envoy::config::metrics::v3::StatsConfig stats_config;
+  TestUtility::loadFromYaml(R"EOF(
+histogram_bucket_settings:
+- match:
+    prefix: scope.buffered
+  buckets: [10, 100]
+  sample_buffer_size: 3
+)EOF",
+                            stats_config);
+  store_->setHistogramSettings(std::make_unique<HistogramSettingsImpl>(stats_config));
+
+  ScopePtr scope = store_->createScope("scope.");
+  Histogram& histogram = scope->histogramFromString("buffered", Histogram::Unit::Unspecified);
+  EXPECT_CALL(sink_, onHistogramComplete(_, _)).Times(0);
+  histogram.recordValue(5);
+  histogram.recordValue(50);
+  testing::Mock::VerifyAndClearExpectations(&sink_);
+
+  {
+    InSequence s;
+    for (uint64_t value : {5, 50}) {
+      EXPECT_CALL(sink_, onHistogramComplete(Property(&Histogram::name, "scope.buffered"), value));
+    }
+  }
+  scope.reset();
+}
+
 class ThreadLocalRealThreadsTestBase : public ThreadLocalStoreNoMocksTestBase {
 protected:
   static constexpr uint32_t NumScopes = 1000;
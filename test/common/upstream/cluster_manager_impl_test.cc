@@ -520,7 +520,8 @@ TEST_P(ClusterManagerSubsetInitializationTest, SubsetLoadBalancerInitialization)
   const std::string yaml = fmt::format(yamlPattern, cluster_type, policy_name);
 
   if (GetParam() == envoy::config::cluster::v3::Cluster::hidden_envoy_deprecated_ORIGINAL_DST_LB ||
-      GetParam() == envoy::config::cluster::v3::Cluster::CLUSTER_PROVIDED) {
+      GetParam() == envoy::config::cluster::v3::Cluster::CLUSTER_PROVIDED ||
+      GetParam() == envoy::config::cluster::v3::Cluster::PEAK_EWMA) {
     EXPECT_THROW_WITH_MESSAGE(
         create(parseBootstrapFromV3Yaml(yaml)), EnvoyException,
         fmt::format("cluster: LB policy {} cannot be combined with lb_subset_config",
@@ -585,6 +586,25 @@ TEST_F(ClusterManagerImplTest, SubsetLoadBalancerClusterProvidedLbRestriction) {
       "cluster: LB policy CLUSTER_PROVIDED cannot be combined with lb_subset_config");
 }
 
+TEST_F(ClusterManagerImplTest, SubsetLoadBalancerPeakEwmaRestriction) {
+  const std::string yaml = R"EOF(
+ static_resources:
+  clusters:
+  - name: cluster_1
+    connect_timeout: 0.250s
+    type: static
+    lb_policy: peak_ewma
+    lb_subset_config:
+      fallback_policy: ANY_ENDPOINT
+      subset_selectors:
+        - keys: [ "x" ]
+  )EOF";
+
+  EXPECT_THROW_WITH_MESSAGE(
+      create(parseBootstrapFromV3Yaml(yaml)), EnvoyException,
+      "cluster: LB policy PEAK_EWMA cannot be combined with lb_subset_config");
+}
+
 TEST_F(ClusterManagerImplTest, SubsetLoadBalancerLocalityAware) {
   const std::string yaml = R"EOF(
  static_resources:
@@ -3829,6 +3849,48 @@ TEST_F(ClusterManagerImplTest, ConnPoolsNotDrainedOnHostSetChange) {
       hosts_added, {}, 100);
 }
 
+TEST_F(ClusterManagerImplTest, PredictivePrefetch) {
+  const std::string yaml = R"EOF(
+  static_resources:
+    clusters:
+    - name: cluster_1
+      connect_timeout: 0.250s
+      lb_policy: ROUND_ROBIN
+      type: STATIC
+      prefetch_policy:
+        predictive_prefetch_ratio: 2
+  )EOF";
+
+  ReadyWatcher initialized;
+  EXPECT_CALL(initialized, ready());
+  create(parseBootstrapFromV3Yaml(yaml));
+  cluster_manager_->setInitializedCb([&]() -> void { initialized.ready(); });
+
+  Cluster& cluster = cluster_manager_->activeClusters().begin()->second;
+  HostVector hosts{makeTestHost(cluster.info(), "tcp://127.0.0.1:80"),
+                   makeTestHost(cluster.info(), "tcp://127.0.0.1:81")};
+  auto hosts_ptr = std::make_shared<HostVector>(hosts);
+  cluster.prioritySet().updateHosts(
+      0, HostSetImpl::partitionHosts(hosts_ptr, HostsPerLocalityImpl::empty()), nullptr, hosts, {},
+      100);
+
+  Http::ConnectionPool::MockInstance* cp1 = new NiceMock<Http::ConnectionPool::MockInstance>();
+  Http::ConnectionPool::MockInstance* cp2 = new NiceMock<Http::ConnectionPool::MockInstance>();
+  EXPECT_CALL(factory_, allocateConnPool_(_, _, _)).WillOnce(Return(cp1)).WillOnce(Return(cp2));
+
+  // The stream goes to the first host. The second host is predicted next and its pool prefetches a
+  // connection, then the first host is predicted again and its pool declines to prefetch.
+  EXPECT_CALL(*cp2, maybePrefetch(2)).WillOnce(Return(true));
+  EXPECT_CALL(*cp1, maybePrefetch(2)).WillOnce(Return(false));
+  EXPECT_EQ(cp1, cluster_manager_->httpConnPoolForCluster("cluster_1", ResourcePriority::Default,
+                                                          Http::Protocol::Http11, nullptr));
+
+  // The next stream goes to the predicted host.
+  EXPECT_CALL(*cp2, maybePrefetch(2)).WillOnce(Return(false));
+  EXPECT_EQ(cp2, cluster_manager_->httpConnPoolForCluster("cluster_1", ResourcePriority::Default,
+                                                          Http::Protocol::Http11, nullptr));
+}
+
 TEST_F(ClusterManagerImplTest, InvalidPriorityLocalClusterNameStatic) {
   std::string yaml = R"EOF(
 static_resources:
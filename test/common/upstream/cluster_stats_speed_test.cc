@@ -0,0 +1,96 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures the time and heap memory taken by the stats of many clusters, allocated up front as by
+// default, or when first written as with TrackClusterStats.lazy_stats.
+
+#include <memory>
+#include <vector>
+
+#include "envoy/config/metrics/v3/stats.pb.h"
+
+#include "common/memory/stats.h"
+#include "common/stats/allocator_impl.h"
+#include "common/stats/lazy_stats.h"
+#include "common/stats/symbol_table_impl.h"
+#include "common/stats/tag_producer_impl.h"
+#include "common/stats/thread_local_store.h"
+#include "common/upstream/upstream_impl.h"
+
+#include "test/benchmark/main.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+// The stats of one cluster, as ClusterInfoImpl holds them.
+struct ClusterStatsHolder {
+  ClusterStatsHolder(Stats::Store& store, uint32_t index, bool lazy)
+      : scope_(store.createScope(absl::StrCat("cluster.cluster_", index, "."))),
+        lazy_stats_(lazy ? std::make_unique<Stats::LazyStatPool>(*scope_) : nullptr),
+        stats_(lazy ? ClusterInfoImpl::generateStats(*lazy_stats_)
+                    : ClusterInfoImpl::generateStats(*scope_)) {}
+
+  Stats::ScopePtr scope_;
+  std::unique_ptr<Stats::LazyStatPool> lazy_stats_;
+  ClusterStats stats_;
+};
+
+// The store the clusters allocate their stats in, with the default tag extraction.
+struct StoreHolder {
+  StoreHolder() : alloc_(symbol_table_), store_(alloc_) {
+    store_.setTagProducer(std::make_unique<Stats::TagProducerImpl>(stats_config_));
+  }
+
+  Stats::SymbolTableImpl symbol_table_;
+  Stats::AllocatorImpl alloc_;
+  Stats::ThreadLocalStoreImpl store_;
+  envoy::config::metrics::v3::StatsConfig stats_config_;
+};
+
+} // namespace
+
+// Creates the stats of range(0) clusters, lazily if range(1) is set, each of which then serves one
+// request, writing the handful of stats a lightly loaded cluster does.
+static void createClusterStats(::benchmark::State& state) {
+  const uint32_t num_clusters =
+      Envoy::benchmark::skipExpensiveBenchmarks() ? 100 : static_cast<uint32_t>(state.range(0));
+  const bool lazy = state.range(1) != 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto store = std::make_unique<StoreHolder>();
+    std::vector<std::unique_ptr<ClusterStatsHolder>> clusters;
+    clusters.reserve(num_clusters);
+    const size_t start_mem = Memory::Stats::totalCurrentlyAllocated();
+    state.ResumeTiming();
+
+    for (uint32_t i = 0; i < num_clusters; ++i) {
+      clusters.push_back(std::make_unique<ClusterStatsHolder>(store->store_, i, lazy));
+      ClusterStats& stats = clusters.back()->stats_;
+      stats.membership_total_.set(1);
+      stats.membership_healthy_.set(1);
+      stats.membership_degraded_.set(0);
+      stats.upstream_cx_total_.inc();
+      stats.upstream_cx_http1_total_.inc();
+      stats.upstream_rq_total_.inc();
+      stats.upstream_rq_completed_.inc();
+    }
+
+    state.PauseTiming();
+    const size_t end_mem = Memory::Stats::totalCurrentlyAllocated();
+    state.counters["memory_per_cluster"] = (end_mem - start_mem) / num_clusters;
+    clusters.clear();
+    store.reset();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(createClusterStats)
+    ->Args({20000, 0})
+    ->Args({20000, 1})
+    ->Unit(::benchmark::kMillisecond);
+
+} // namespace Upstream
+} // namespace Envoy
@@ -390,6 +390,68 @@ TEST_F(ConnPoolMapImplTest, CircuitBreakerUsesProvidedPriorityHigh) {
   test_map->getPool(2, getBasicFactory());
 }
 
+// Show that when the circuit breaker limit is hit, the least recently used idle pool is freed.
+TEST_F(ConnPoolMapImplTest, GetPoolLimitHitFreesLeastRecentlyUsedIdlePool) {
+  TestMapPtr test_map = makeTestMapWithLimit(3);
+
+  test_map->getPool(1, getBasicFactory());
+  test_map->getPool(2, getBasicFactory());
+  test_map->getPool(3, getBasicFactory());
+  test_map->getPool(1, getNeverCalledFactory());
+  test_map->getPool(4, getBasicFactory());
+
+  // Pool 2 is the least recently used, so it should be the one which was freed.
+  test_map->getPool(1, getNeverCalledFactory());
+  test_map->getPool(3, getNeverCalledFactory());
+  test_map->getPool(4, getNeverCalledFactory());
+  EXPECT_EQ(test_map->size(), 3);
+}
+
+TEST_F(ConnPoolMapImplTest, IdlePoolsUnderPerHostLimitAreKept) {
+  host_->cluster_.max_idle_conn_pools_per_host_ = 2;
+  TestMapPtr test_map = makeTestMap();
+
+  test_map->getPool(1, getBasicFactory());
+  test_map->getPool(2, getBasicFactory());
+  test_map->getPool(3, getBasicFactory());
+
+  EXPECT_EQ(test_map->size(), 3);
+  EXPECT_EQ(host_->cluster_.stats_.upstream_cx_pool_idle_evicted_.value(), 0);
+}
+
+// Show that idle pools beyond the per host limit are freed in least recently used order, while
+// pools with active connections are kept.
+TEST_F(ConnPoolMapImplTest, IdlePoolsOverPerHostLimitAreFreed) {
+  host_->cluster_.max_idle_conn_pools_per_host_ = 1;
+  TestMapPtr test_map = makeTestMap();
+
+  test_map->getPool(1, getBasicFactory());
+  test_map->getPool(2, getActivePoolFactory());
+  test_map->getPool(3, getBasicFactory());
+  test_map->getPool(4, getBasicFactory());
+
+  // Pool 1 is freed when pool 4 is created, as pool 3 is the one idle pool which is kept.
+  EXPECT_EQ(test_map->size(), 3);
+  EXPECT_EQ(host_->cluster_.stats_.upstream_cx_pool_idle_evicted_.value(), 1);
+  test_map->getPool(2, getNeverCalledFactory());
+  test_map->getPool(3, getNeverCalledFactory());
+  test_map->getPool(4, getNeverCalledFactory());
+  test_map->getPool(1, getBasicFactory());
+  EXPECT_EQ(mock_pools_.size(), 5);
+}
+
+TEST_F(ConnPoolMapImplTest, IdlePoolsPerHostLimitReleasesCircuitBreaker) {
+  host_->cluster_.max_idle_conn_pools_per_host_ = 0;
+  TestMapPtr test_map = makeTestMapWithLimit(2);
+
+  test_map->getPool(1, getBasicFactory());
+  test_map->getPool(2, getBasicFactory());
+
+  EXPECT_EQ(test_map->size(), 1);
+  EXPECT_EQ(host_->cluster_.circuit_breakers_stats_.cx_pool_open_.value(), 0);
+  EXPECT_EQ(host_->cluster_.stats_.upstream_cx_pool_idle_evicted_.value(), 1);
+}
+
 // The following tests only die in debug builds, so don't run them if this isn't one.
 #if !defined(NDEBUG)
 class ConnPoolMapImplDeathTest : public ConnPoolMapImplTest {};
@@ -13,6 +13,7 @@
 #include "common/config/utility.h"
 #include "common/singleton/manager_impl.h"
 #include "common/upstream/eds.h"
+#include "common/upstream/load_balancer_impl.h"
 
 #include "server/transport_socket_config_impl.h"
 
@@ -87,12 +88,42 @@ public:
         std::chrono::milliseconds(), false);
   }
 
+  // Mirror the cluster's membership updates into num_workers worker local priority sets, each
+  // with a load balancer, the same way the cluster manager fans updates out to its workers.
+  void addWorkers(uint32_t num_workers) {
+    for (uint32_t i = 0; i < num_workers; ++i) {
+      auto worker = std::make_unique<Worker>(stats_);
+      worker->priority_set_.getOrCreateHostSet(0);
+      worker->lb_ = std::make_unique<RoundRobinLoadBalancer>(worker->priority_set_, nullptr,
+                                                             worker->stats_, runtime_, random_,
+                                                             worker->common_config_);
+      workers_.push_back(std::move(worker));
+    }
+    cluster_->prioritySet().addPriorityUpdateCb(
+        [this](uint32_t priority, const HostVector& hosts_added, const HostVector& hosts_removed) {
+          const auto& host_set = cluster_->prioritySet().hostSetsPerPriority()[priority];
+          for (auto& worker : workers_) {
+            worker->priority_set_.updateHosts(priority, HostSetImpl::updateHostsParams(*host_set),
+                                              host_set->localityWeights(), hosts_added,
+                                              hosts_removed, host_set->overprovisioningFactor());
+          }
+        });
+  }
+
   // Set up an EDS config with multiple priorities, localities, weights and make sure
-  // they are loaded as expected.
+  // they are loaded as expected. Host weights cycle through 1..num_weights.
   void priorityAndLocalityWeightedHelper(bool ignore_unknown_dynamic_fields, size_t num_hosts,
-                                         bool healthy) {
+                                         bool healthy, uint32_t num_weights = 1) {
     state_.PauseTiming();
+    auto response = makeResponse(ignore_unknown_dynamic_fields, num_hosts, healthy, num_weights);
+    state_.ResumeTiming();
+    deliverResponse(std::move(response), num_hosts);
+  }
 
+  // Builds an EDS response with num_hosts hosts in a single locality of priority 1.
+  std::unique_ptr<envoy::service::discovery::v3::DiscoveryResponse>
+  makeResponse(bool ignore_unknown_dynamic_fields, size_t num_hosts, bool healthy,
+               uint32_t num_weights) {
     envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
     cluster_load_assignment.set_cluster_name("fare");
 
@@ -117,6 +148,7 @@ public:
           lb_endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address();
       socket_address->set_address("10.0.1." + std::to_string(i / 60000));
       socket_address->set_port_value((port + i) % 60000);
+      lb_endpoint->mutable_load_balancing_weight()->set_value(1 + i % num_weights);
     }
 
     // this is what we're actually testing:
@@ -132,12 +164,25 @@ public:
                      "");
       resource->set_type_url("type.googleapis.com/envoy.api.v2.ClusterLoadAssignment");
     }
-    state_.ResumeTiming();
+    return response;
+  }
+
+  void deliverResponse(std::unique_ptr<envoy::service::discovery::v3::DiscoveryResponse> response,
+                       size_t num_hosts) {
     grpc_mux_->grpcStreamForTest().onReceiveMessage(std::move(response));
     ASSERT(cluster_->prioritySet().hostSetsPerPriority()[1]->hostsPerLocality().get()[0].size() ==
            num_hosts);
   }
 
+  struct Worker {
+    Worker(Stats::Scope& stats) : stats_(ClusterInfoImpl::generateStats(stats)) {}
+
+    PrioritySetImpl priority_set_;
+    ClusterStats stats_;
+    envoy::config::cluster::v3::Cluster::CommonLbConfig common_config_;
+    std::unique_ptr<RoundRobinLoadBalancer> lb_;
+  };
+
   State& state_;
   const bool v2_config_;
   const std::string type_url_;
@@ -164,6 +209,7 @@ public:
   NiceMock<Grpc::MockAsyncStream> async_stream_;
   Config::GrpcMuxImplSharedPtr grpc_mux_;
   Config::GrpcSubscriptionImplPtr subscription_;
+  std::vector<std::unique_ptr<Worker>> workers_;
 };
 
 } // namespace Upstream
@@ -216,3 +262,33 @@ static void healthOnlyUpdate(State& state) {
 }
 
 BENCHMARK(healthOnlyUpdate)->Range(1, 100000)->Unit(benchmark::kMillisecond);
+
+// Measures how an update adding a single host to a large cluster scales with the number of
+// workers the update is applied to, with equal (1) or mixed (> 1) host weights.
+static void workerUpdate(State& state) {
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Context logging_state(spdlog::level::warn,
+                                       Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock, false);
+  for (auto _ : state) {
+    // Only the update adding a host is timed, not the setup or the initial load of the cluster.
+    state.PauseTiming();
+    auto speed_test = std::make_unique<Envoy::Upstream::EdsSpeedTest>(state, false);
+    const uint32_t workers = skipExpensiveBenchmarks() ? 1 : state.range(0);
+    const uint32_t endpoints = skipExpensiveBenchmarks() ? 1 : state.range(1);
+    speed_test->addWorkers(workers);
+    speed_test->deliverResponse(speed_test->makeResponse(true, endpoints, true, state.range(2)),
+                                endpoints);
+    auto response = speed_test->makeResponse(true, endpoints + 1, true, state.range(2));
+    state.ResumeTiming();
+
+    speed_test->deliverResponse(std::move(response), endpoints + 1);
+
+    state.PauseTiming();
+    speed_test.reset();
+    state.ResumeTiming();
+  }
+}
+
+BENCHMARK(workerUpdate)
+    ->Ranges({{1, 16}, {1000, 100000}, {1, 3}})
+    ->Unit(benchmark::kMillisecond);
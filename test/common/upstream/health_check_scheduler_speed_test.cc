@@ -0,0 +1,89 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures the CPU spent to schedule and fire the timers of 10k health check probes, each of which
+// re-arms a timeout when it fires, as a health check session does. The probes are spread across a
+// 10ms interval, and either use a dispatcher timer each or are driven by a HealthCheckScheduler.
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "common/upstream/health_check_scheduler.h"
+
+#include "test/benchmark/main.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+constexpr uint32_t NumProbes = 10000;
+constexpr std::chrono::milliseconds Interval(10);
+
+class Probes {
+public:
+  Probes(Event::Dispatcher& dispatcher,
+         const std::function<Event::TimerPtr(Event::TimerCb)>& timer_factory)
+      : dispatcher_(dispatcher) {
+    for (uint32_t i = 0; i < NumProbes; ++i) {
+      timeout_timers_.push_back(timer_factory([]() {}));
+      Event::Timer& timeout_timer = *timeout_timers_.back();
+      interval_timers_.push_back(timer_factory([this, &timeout_timer]() {
+        timeout_timer.enableTimer(std::chrono::seconds(1));
+        timeout_timer.disableTimer();
+        if (++fired_ == NumProbes) {
+          dispatcher_.exit();
+        }
+      }));
+    }
+  }
+
+  // Starts all probes spread across the interval, and waits until they have fired.
+  void run() {
+    fired_ = 0;
+    for (uint32_t i = 0; i < NumProbes; ++i) {
+      interval_timers_[i]->enableTimer(std::chrono::milliseconds(1 + i % Interval.count()));
+    }
+    dispatcher_.run(Event::Dispatcher::RunType::RunUntilExit);
+  }
+
+private:
+  Event::Dispatcher& dispatcher_;
+  std::vector<Event::TimerPtr> timeout_timers_;
+  std::vector<Event::TimerPtr> interval_timers_;
+  uint32_t fired_{};
+};
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
+
+// A dispatcher timer per probe and timeout.
+static void dispatcherTimers(benchmark::State& state) {
+  Envoy::Api::ApiPtr api = Envoy::Api::createApiForTest();
+  Envoy::Event::DispatcherPtr dispatcher = api->allocateDispatcher("test_thread");
+  Envoy::Upstream::Probes probes(*dispatcher, [&dispatcher](Envoy::Event::TimerCb cb) {
+    return dispatcher->createTimer(cb);
+  });
+  for (auto _ : state) {
+    probes.run();
+  }
+}
+BENCHMARK(dispatcherTimers)->Unit(benchmark::kMicrosecond);
+
+// All probes and timeouts driven by a single scheduler timer.
+static void schedulerTimers(benchmark::State& state) {
+  Envoy::Api::ApiPtr api = Envoy::Api::createApiForTest();
+  Envoy::Event::DispatcherPtr dispatcher = api->allocateDispatcher("test_thread");
+  Envoy::Upstream::HealthCheckScheduler scheduler(*dispatcher, std::chrono::milliseconds(1));
+  Envoy::Upstream::Probes probes(*dispatcher, [&scheduler](Envoy::Event::TimerCb cb) {
+    return scheduler.createTimer(cb);
+  });
+  for (auto _ : state) {
+    probes.run();
+  }
+}
+BENCHMARK(schedulerTimers)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <vector>
+
+#include "common/upstream/health_check_scheduler.h"
+
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+class HealthCheckSchedulerTest : public testing::Test {
+protected:
+  // Advances time in steps of a millisecond, running the dispatcher after each one.
+  void advance(std::chrono::milliseconds duration) {
+    for (int64_t i = 0; i < duration.count(); ++i) {
+      time_system_.advanceTimeAsync(std::chrono::milliseconds(1));
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+
+  // Returns a timer which records the time since the start of the test when it fires.
+  Event::TimerPtr recordingTimer(std::vector<std::chrono::milliseconds>& fired) {
+    return scheduler_.createTimer([this, &fired]() {
+      fired.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(
+          time_system_.monotonicTime() - start_));
+    });
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  Api::ApiPtr api_{Api::createApiForTest(time_system_)};
+  Event::DispatcherPtr dispatcher_{api_->allocateDispatcher("test_thread")};
+  const MonotonicTime start_{time_system_.monotonicTime()};
+  HealthCheckScheduler scheduler_{*dispatcher_, std::chrono::milliseconds(100)};
+};
+
+// Deadlines are rounded up to the next tick.
+TEST_F(HealthCheckSchedulerTest, FiresOnTickAfterDeadline) {
+  std::vector<std::chrono::milliseconds> fired;
+  Event::TimerPtr timer = recordingTimer(fired);
+  timer->enableTimer(std::chrono::milliseconds(150));
+  EXPECT_TRUE(timer->enabled());
+  EXPECT_EQ(1, scheduler_.enabledTimers());
+
+  advance(std::chrono::milliseconds(199));
+  EXPECT_TRUE(fired.empty());
+  advance(std::chrono::milliseconds(1));
+  EXPECT_EQ(std::vector<std::chrono::milliseconds>{std::chrono::milliseconds(200)}, fired);
+  EXPECT_FALSE(timer->enabled());
+  EXPECT_EQ(0, scheduler_.enabledTimers());
+}
+
+// Timers due within the same tick fire together.
+TEST_F(HealthCheckSchedulerTest, BatchesTimersOfSameTick) {
+  std::vector<std::chrono::milliseconds> fired;
+  Event::TimerPtr timer1 = recordingTimer(fired);
+  Event::TimerPtr timer2 = recordingTimer(fired);
+  Event::TimerPtr timer3 = recordingTimer(fired);
+  timer1->enableTimer(std::chrono::milliseconds(10));
+  timer2->enableTimer(std::chrono::milliseconds(90));
+  timer3->enableTimer(std::chrono::milliseconds(110));
+
+  advance(std::chrono::milliseconds(200));
+  EXPECT_EQ((std::vector<std::chrono::milliseconds>{std::chrono::milliseconds(100),
+                                                     std::chrono::milliseconds(100),
+                                                     std::chrono::milliseconds(200)}),
+            fired);
+}
+
+// A timer enabled with an earlier deadline than the pending ones is not delayed by them.
+TEST_F(HealthCheckSchedulerTest, EarlierTimerRearmsTick) {
+  std::vector<std::chrono::milliseconds> fired;
+  Event::TimerPtr late_timer = recordingTimer(fired);
+  Event::TimerPtr early_timer = recordingTimer(fired);
+  late_timer->enableTimer(std::chrono::milliseconds(500));
+  early_timer->enableTimer(std::chrono::milliseconds(50));
+
+  advance(std::chrono::milliseconds(500));
+  EXPECT_EQ((std::vector<std::chrono::milliseconds>{std::chrono::milliseconds(100),
+                                                     std::chrono::milliseconds(500)}),
+            fired);
+}
+
+// Timers further out than a rotation of the wheel fire on their own tick, not on the first pass
+// over their slot.
+TEST_F(HealthCheckSchedulerTest, BeyondWheelRotation) {
+  HealthCheckScheduler scheduler(*dispatcher_, std::chrono::milliseconds(1));
+  bool fired = false;
+  Event::TimerPtr timer = scheduler.createTimer([&fired]() { fired = true; });
+  timer->enableTimer(std::chrono::milliseconds(1000));
+  // Keeps the wheel ticking on every slot while the other timer is pending.
+  Event::TimerPtr early_timer = scheduler.createTimer([]() {});
+  early_timer->enableTimer(std::chrono::milliseconds(1));
+
+  advance(std::chrono::milliseconds(999));
+  EXPECT_FALSE(fired);
+  advance(std::chrono::milliseconds(1));
+  EXPECT_TRUE(fired);
+}
+
+TEST_F(HealthCheckSchedulerTest, DisableAndReenable) {
+  std::vector<std::chrono::milliseconds> fired;
+  Event::TimerPtr timer = recordingTimer(fired);
+  timer->enableTimer(std::chrono::milliseconds(100));
+  timer->disableTimer();
+  EXPECT_FALSE(timer->enabled());
+  EXPECT_EQ(0, scheduler_.enabledTimers());
+  advance(std::chrono::milliseconds(200));
+  EXPECT_TRUE(fired.empty());
+
+  // Enabling an enabled timer replaces its deadline.
+  timer->enableTimer(std::chrono::milliseconds(100));
+  timer->enableTimer(std::chrono::milliseconds(300));
+  EXPECT_EQ(1, scheduler_.enabledTimers());
+  advance(std::chrono::milliseconds(300));
+  EXPECT_EQ(std::vector<std::chrono::milliseconds>{std::chrono::milliseconds(500)}, fired);
+}
+
+// Callbacks may re-enable their own timer, and disable or destroy timers which expired on the
+// same tick but did not run yet.
+TEST_F(HealthCheckSchedulerTest, CallbacksModifyTimers) {
+  uint32_t periodic_fired = 0;
+  Event::TimerPtr periodic;
+  periodic = scheduler_.createTimer([&]() {
+    if (++periodic_fired < 3) {
+      periodic->enableTimer(std::chrono::milliseconds(100));
+    }
+  });
+  bool destroyed_fired = false;
+  Event::TimerPtr destroyed = scheduler_.createTimer([&]() { destroyed_fired = true; });
+  Event::TimerPtr destroyer = scheduler_.createTimer([&]() { destroyed.reset(); });
+  periodic->enableTimer(std::chrono::milliseconds(100));
+  destroyer->enableTimer(std::chrono::milliseconds(100));
+  destroyed->enableTimer(std::chrono::milliseconds(100));
+
+  advance(std::chrono::milliseconds(300));
+  EXPECT_EQ(3, periodic_fired);
+  EXPECT_FALSE(destroyed_fired);
+  EXPECT_EQ(0, scheduler_.enabledTimers());
+}
+
+// Ticks which passed while no timer was enabled don't fire timers enabled afterwards early.
+TEST_F(HealthCheckSchedulerTest, IdleTicksSkipped) {
+  advance(std::chrono::milliseconds(1050));
+  std::vector<std::chrono::milliseconds> fired;
+  Event::TimerPtr timer = recordingTimer(fired);
+  timer->enableTimer(std::chrono::milliseconds(100));
+  advance(std::chrono::milliseconds(200));
+  EXPECT_EQ(std::vector<std::chrono::milliseconds>{std::chrono::milliseconds(1200)}, fired);
+}
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
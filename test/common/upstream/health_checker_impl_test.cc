@@ -36,6 +36,7 @@
 #include "gtest/gtest.h"
 
 using testing::_;
+using testing::AtLeast;
 using testing::DoAll;
 using testing::InSequence;
 using testing::Invoke;
@@ -3082,6 +3083,30 @@ TEST_F(TcpHealthCheckerImplTest, Success) {
   read_filter_->onData(response, false);
 }
 
+// With probe scheduling, the timers of all sessions are driven by a single dispatcher timer, and
+// the first probes are spread across the interval rather than started right away.
+TEST_F(TcpHealthCheckerImplTest, ProbeScheduling) {
+  const std::string yaml = R"EOF(
+    timeout: 1s
+    interval: 10s
+    unhealthy_threshold: 2
+    healthy_threshold: 2
+    probe_scheduling:
+      resolution: 0.1s
+      spread_initial_probes: true
+    tcp_health_check: {}
+    )EOF";
+
+  auto* tick_timer = new Event::MockTimer(&dispatcher_);
+  allocHealthChecker(yaml);
+  cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster_->info_, "tcp://127.0.0.1:80"),
+      makeTestHost(cluster_->info_, "tcp://127.0.0.1:81")};
+  EXPECT_CALL(dispatcher_, createClientConnection_(_, _, _, _)).Times(0);
+  EXPECT_CALL(*tick_timer, enableTimer(_, _)).Times(AtLeast(1));
+  health_checker_->start();
+}
+
 // Tests that a successful healthcheck will disconnect the client when reuse_connection is false.
 TEST_F(TcpHealthCheckerImplTest, DataWithoutReusingConnection) {
   InSequence s;
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cmath>
+
+#include "common/upstream/host_latency_monitor_impl.h"
+
+#include "test/test_common/simulated_time_system.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+class PeakEwmaHostLatencyMonitorTest : public testing::Test {
+protected:
+  MonotonicTime now() { return time_system_.monotonicTime(); }
+  void advance(std::chrono::milliseconds duration) { time_system_.advanceTimeWait(duration); }
+
+  Event::SimulatedTimeSystem time_system_;
+  PeakEwmaHostLatencyMonitor monitor_{std::chrono::seconds(10)};
+};
+
+TEST(HostLatencyMonitorNullImplTest, NoEstimate) {
+  HostLatencyMonitorNullImpl monitor;
+  monitor.putResponseTime(std::chrono::microseconds(100), MonotonicTime());
+  EXPECT_FALSE(monitor.latencyEstimate(MonotonicTime()).has_value());
+}
+
+TEST_F(PeakEwmaHostLatencyMonitorTest, NoSamples) {
+  EXPECT_FALSE(monitor_.latencyEstimate(now()).has_value());
+}
+
+// The first sample becomes the estimate.
+TEST_F(PeakEwmaHostLatencyMonitorTest, FirstSample) {
+  monitor_.putResponseTime(std::chrono::microseconds(500), now());
+  EXPECT_DOUBLE_EQ(500, monitor_.latencyEstimate(now()).value());
+}
+
+// A sample above the estimate replaces it immediately.
+TEST_F(PeakEwmaHostLatencyMonitorTest, PeakReplacesEstimate) {
+  monitor_.putResponseTime(std::chrono::microseconds(100), now());
+  advance(std::chrono::milliseconds(1));
+  monitor_.putResponseTime(std::chrono::microseconds(10000), now());
+  EXPECT_DOUBLE_EQ(10000, monitor_.latencyEstimate(now()).value());
+}
+
+// Samples below the estimate are averaged in according to the elapsed time.
+TEST_F(PeakEwmaHostLatencyMonitorTest, LowerSampleAveraged) {
+  monitor_.putResponseTime(std::chrono::microseconds(10000), now());
+  advance(std::chrono::seconds(10));
+  monitor_.putResponseTime(std::chrono::microseconds(1000), now());
+
+  // One decay period elapsed, so the old estimate keeps a weight of 1/e.
+  const double weight = std::exp(-1.0);
+  EXPECT_NEAR(10000 * weight + 1000 * (1 - weight), monitor_.latencyEstimate(now()).value(), 1e-6);
+
+  // Samples arriving back to back barely move the estimate.
+  const double estimate = monitor_.latencyEstimate(now()).value();
+  monitor_.putResponseTime(std::chrono::microseconds(1), now());
+  EXPECT_DOUBLE_EQ(estimate, monitor_.latencyEstimate(now()).value());
+}
+
+// Without new samples the estimate decays toward zero.
+TEST_F(PeakEwmaHostLatencyMonitorTest, EstimateDecays) {
+  monitor_.putResponseTime(std::chrono::microseconds(1000), now());
+  advance(std::chrono::seconds(10));
+  EXPECT_NEAR(1000 * std::exp(-1.0), monitor_.latencyEstimate(now()).value(), 1e-6);
+  advance(std::chrono::seconds(1000));
+  EXPECT_NEAR(0, monitor_.latencyEstimate(now()).value(), 1e-6);
+}
+
+// A sample timestamped before the last update does not amplify the estimate.
+TEST_F(PeakEwmaHostLatencyMonitorTest, OutOfOrderSample) {
+  const MonotonicTime earlier = now();
+  advance(std::chrono::seconds(1));
+  monitor_.putResponseTime(std::chrono::microseconds(1000), now());
+  EXPECT_DOUBLE_EQ(1000, monitor_.latencyEstimate(earlier).value());
+}
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
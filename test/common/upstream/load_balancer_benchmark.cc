@@ -1,18 +1,26 @@
 // Usage: bazel run //test/common/upstream:load_balancer_benchmark
 
+#include <algorithm>
 #include <memory>
+#include <queue>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
 #include "common/common/random_generator.h"
+#include "common/config/metadata.h"
+#include "common/config/well_known_names.h"
 #include "common/memory/stats.h"
+#include "common/router/metadatamatchcriteria_impl.h"
 #include "common/upstream/maglev_lb.h"
 #include "common/upstream/ring_hash_lb.h"
+#include "common/upstream/subset_lb.h"
 #include "common/upstream/upstream_impl.h"
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/upstream/mocks.h"
+#include "test/test_common/simulated_time_system.h"
 
+#include "absl/strings/str_cat.h"
 #include "benchmark/benchmark.h"
 
 namespace Envoy {
@@ -22,7 +30,10 @@ namespace {
 class BaseTester {
 public:
   // We weight the first weighted_subset_percent of hosts with weight.
-  BaseTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0) {
+  BaseTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0,
+             LoadBalancerType lb_type = LoadBalancerType::RoundRobin) {
+    // Hosts only carry a latency monitor when created for a latency aware load balancer.
+    info_->lb_type_ = lb_type;
     HostVector hosts;
     ASSERT(num_hosts < 65536);
     for (uint64_t i = 0; i < num_hosts; i++) {
@@ -82,6 +93,79 @@ public:
   std::unique_ptr<LeastRequestLoadBalancer> lb_;
 };
 
+// Simulates request traffic against hosts of differing speed: the first tenth of the hosts are
+// ten times slower than the rest, and every host slows down as requests queue up on it.
+class LatencySimulationTester : public BaseTester {
+public:
+  LatencySimulationTester(uint64_t num_hosts, bool peak_ewma)
+      : BaseTester(num_hosts, 0, 0,
+                   peak_ewma ? LoadBalancerType::PeakEwma : LoadBalancerType::LeastRequest) {
+    for (const auto& host : priority_set_.hostSetsPerPriority()[0]->hosts()) {
+      const bool slow = base_latency_us_.size() < num_hosts / 10;
+      base_latency_us_[host.get()] = slow ? 10000 : 1000;
+    }
+    if (peak_ewma) {
+      lb_ = std::make_unique<PeakEwmaLoadBalancer>(priority_set_, &local_priority_set_, stats_,
+                                                   runtime_, random_, common_config_, time_system_);
+    } else {
+      envoy::config::cluster::v3::Cluster::LeastRequestLbConfig lr_lb_config;
+      lr_lb_config.mutable_choice_count()->set_value(2);
+      lb_ = std::make_unique<LeastRequestLoadBalancer>(priority_set_, &local_priority_set_,
+                                                       stats_, runtime_, random_, common_config_,
+                                                       lr_lb_config);
+    }
+  }
+
+  // Sends num_requests requests spaced interval apart and returns the sorted request latencies in
+  // microseconds.
+  std::vector<uint64_t> run(uint64_t num_requests, std::chrono::microseconds interval) {
+    struct Completion {
+      bool operator>(const Completion& other) const { return time_ > other.time_; }
+
+      MonotonicTime time_;
+      HostConstSharedPtr host_;
+      std::chrono::microseconds latency_;
+    };
+    std::priority_queue<Completion, std::vector<Completion>, std::greater<Completion>> inflight;
+    std::vector<uint64_t> latencies;
+    latencies.reserve(num_requests);
+
+    const MonotonicTime start = time_system_.monotonicTime();
+    for (uint64_t i = 0; i < num_requests; ++i) {
+      const MonotonicTime now = start + interval * i;
+      while (!inflight.empty() && inflight.top().time_ <= now) {
+        const Completion& completion = inflight.top();
+        time_system_.setMonotonicTime(completion.time_);
+        completion.host_->stats().rq_active_.dec();
+        completion.host_->latencyMonitor().putResponseTime(completion.latency_, completion.time_);
+        inflight.pop();
+      }
+      time_system_.setMonotonicTime(now);
+
+      HostConstSharedPtr host = lb_->chooseHost(nullptr);
+      const uint64_t active = host->stats().rq_active_.value();
+      host->stats().rq_active_.inc();
+      // Each queued request adds an eighth of the base latency, with +/-50% jitter.
+      const uint64_t base = base_latency_us_[host.get()];
+      const uint64_t latency = base * (8 + active) / 8 * (50 + random_.random() % 100) / 100;
+      latencies.push_back(latency);
+      inflight.push({now + std::chrono::microseconds(latency), host,
+                     std::chrono::microseconds(latency)});
+    }
+
+    while (!inflight.empty()) {
+      inflight.top().host_->stats().rq_active_.dec();
+      inflight.pop();
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  absl::flat_hash_map<const Host*, uint64_t> base_latency_us_;
+  LoadBalancerPtr lb_;
+};
+
 void BM_RoundRobinLoadBalancerBuild(benchmark::State& state) {
   for (auto _ : state) {
     state.PauseTiming();
@@ -203,14 +287,58 @@ BENCHMARK(BM_MaglevLoadBalancerBuildTable)
     ->Arg(100)
     ->Arg(200)
     ->Arg(500)
+    ->Arg(2500)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+
+// Times the table rebuild after an update that replaces hosts_changed hosts, as happens on an EDS
+// update. Permutations for hosts that are not replaced are reused from the previous build.
+void BM_MaglevLoadBalancerRebuildTable(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    const uint64_t num_hosts = state.range(0);
+    const uint64_t hosts_changed = state.range(1);
+    MaglevTester tester(num_hosts);
+    tester.maglev_lb_->initialize();
+
+    const HostVector& old_hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+    HostVector hosts(old_hosts.begin() + hosts_changed, old_hosts.end());
+    HostVector hosts_removed(old_hosts.begin(), old_hosts.begin() + hosts_changed);
+    HostVector hosts_added;
+    for (uint64_t i = 0; i < hosts_changed; i++) {
+      hosts_added.push_back(
+          makeTestHost(tester.info_, fmt::format("tcp://10.1.{}.{}:6379", i / 256, i % 256)));
+    }
+    hosts.insert(hosts.end(), hosts_added.begin(), hosts_added.end());
+    HostVectorConstSharedPtr updated_hosts = std::make_shared<HostVector>(hosts);
+    HostsPerLocalityConstSharedPtr hosts_per_locality = makeHostsPerLocality({hosts});
+
+    // We are only interested in timing the table rebuild triggered by the update.
+    state.ResumeTiming();
+    tester.priority_set_.updateHosts(
+        0, HostSetImpl::partitionHosts(updated_hosts, hosts_per_locality), {}, hosts_added,
+        hosts_removed, absl::nullopt);
+  }
+}
+BENCHMARK(BM_MaglevLoadBalancerRebuildTable)
+    ->Args({500, 1})
+    ->Args({500, 50})
+    ->Args({2500, 1})
+    ->Args({2500, 250})
+    ->Args({10000, 1})
+    ->Args({10000, 1000})
     ->Unit(benchmark::kMillisecond);
 
 class TestLoadBalancerContext : public LoadBalancerContextBase {
 public:
   // Upstream::LoadBalancerContext
   absl::optional<uint64_t> computeHashKey() override { return hash_key_; }
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() override {
+    return metadata_match_.get();
+  }
 
   absl::optional<uint64_t> hash_key_;
+  Router::MetadataMatchCriteriaConstPtr metadata_match_;
 };
 
 void computeHitStats(benchmark::State& state,
@@ -263,6 +391,33 @@ BENCHMARK(BM_LeastRequestLoadBalancerChooseHost)
     ->Args({100, 100, 1000000})
     ->Unit(benchmark::kMillisecond);
 
+void BM_LatencyAwareLoadBalancerSimulation(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    const bool peak_ewma = state.range(0) != 0;
+    const uint64_t num_hosts = state.range(1);
+    const uint64_t num_requests = state.range(2);
+    LatencySimulationTester tester(num_hosts, peak_ewma);
+    state.ResumeTiming();
+
+    // Send about one request per host every two milliseconds.
+    const std::vector<uint64_t> latencies =
+        tester.run(num_requests, std::chrono::microseconds(2000 / num_hosts));
+
+    state.PauseTiming();
+    state.counters["p50_latency_us"] = latencies[latencies.size() / 2];
+    state.counters["p99_latency_us"] = latencies[latencies.size() * 99 / 100];
+    state.counters["p999_latency_us"] = latencies[latencies.size() * 999 / 1000];
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_LatencyAwareLoadBalancerSimulation)
+    ->Args({0, 10, 100000})
+    ->Args({1, 10, 100000})
+    ->Args({0, 100, 100000})
+    ->Args({1, 100, 100000})
+    ->Unit(benchmark::kMillisecond);
+
 void BM_RingHashLoadBalancerChooseHost(benchmark::State& state) {
   for (auto _ : state) {
     // Do not time the creation of the ring.
@@ -485,6 +640,131 @@ BENCHMARK(BM_MaglevLoadBalancerWeighted)
     ->Args({500, 95, 75, 25, 10000})
     ->Unit(benchmark::kMillisecond);
 
+// Hosts carry a "stage" key and num_selectors further keys; selector i selects on "stage" and
+// "key<i>", which has i + 2 distinct values. This yields 2 * (i + 2) subsets for selector i.
+class SubsetTester {
+public:
+  SubsetTester(uint64_t num_hosts, uint64_t num_selectors) : num_selectors_(num_selectors) {
+    for (uint64_t i = 0; i < num_selectors; i++) {
+      auto* selector = subset_config_.add_subset_selectors();
+      selector->add_keys("stage");
+      selector->add_keys(fmt::format("key{}", i));
+    }
+    subset_config_.set_fallback_policy(
+        envoy::config::cluster::v3::Cluster::LbSubsetConfig::ANY_ENDPOINT);
+    subset_info_ = std::make_unique<LoadBalancerSubsetInfoImpl>(subset_config_);
+
+    HostVector hosts;
+    ASSERT(num_hosts < 65536);
+    for (uint64_t i = 0; i < num_hosts; i++) {
+      hosts.push_back(makeHost(i));
+    }
+    updateHosts(hosts, {});
+  }
+
+  HostSharedPtr makeHost(uint64_t index) {
+    envoy::config::core::v3::Metadata metadata;
+    const std::string& filter = Config::MetadataFilters::get().ENVOY_LB;
+    Config::Metadata::mutableMetadataValue(metadata, filter, "stage")
+        .set_string_value(index % 2 == 0 ? "prod" : "canary");
+    for (uint64_t i = 0; i < num_selectors_; i++) {
+      Config::Metadata::mutableMetadataValue(metadata, filter, fmt::format("key{}", i))
+          .set_string_value(absl::StrCat(index % (i + 2)));
+    }
+    return makeTestHost(info_, fmt::format("tcp://10.0.{}.{}:6379", index / 256, index % 256),
+                        metadata);
+  }
+
+  void updateHosts(const HostVector& hosts_added, const HostVector& hosts_removed) {
+    for (const auto& host : hosts_removed) {
+      hosts_.erase(std::find(hosts_.begin(), hosts_.end(), host));
+    }
+    hosts_.insert(hosts_.end(), hosts_added.begin(), hosts_added.end());
+
+    HostVectorConstSharedPtr updated_hosts = std::make_shared<HostVector>(hosts_);
+    HostsPerLocalityConstSharedPtr hosts_per_locality = makeHostsPerLocality({hosts_});
+    priority_set_.updateHosts(0, HostSetImpl::partitionHosts(updated_hosts, hosts_per_locality),
+                              {}, hosts_added, hosts_removed, absl::nullopt);
+  }
+
+  void initialize() {
+    lb_ = std::make_unique<SubsetLoadBalancer>(
+        LoadBalancerType::RoundRobin, priority_set_, nullptr, stats_, stats_store_, runtime_,
+        random_, *subset_info_, absl::nullopt, absl::nullopt, common_config_);
+  }
+
+  Envoy::Thread::MutexBasicLockable lock_;
+  Envoy::Logger::Context logging_context_{spdlog::level::warn,
+                                          Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock_, false};
+
+  const uint64_t num_selectors_;
+  HostVector hosts_;
+  PrioritySetImpl priority_set_;
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterStats stats_{ClusterInfoImpl::generateStats(stats_store_)};
+  NiceMock<Runtime::MockLoader> runtime_;
+  Random::RandomGeneratorImpl random_;
+  envoy::config::cluster::v3::Cluster::CommonLbConfig common_config_;
+  envoy::config::cluster::v3::Cluster::LbSubsetConfig subset_config_;
+  std::unique_ptr<LoadBalancerSubsetInfoImpl> subset_info_;
+  std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
+  std::unique_ptr<SubsetLoadBalancer> lb_;
+};
+
+void BM_SubsetLoadBalancerBuild(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    SubsetTester tester(state.range(0), state.range(1));
+    state.ResumeTiming();
+
+    tester.initialize();
+
+    state.PauseTiming();
+    state.counters["subsets"] = tester.stats_.lb_subsets_active_.value();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_SubsetLoadBalancerBuild)
+    ->Args({1000, 8})
+    ->Args({10000, 8})
+    ->Args({10000, 32})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_SubsetLoadBalancerChooseHost(benchmark::State& state) {
+  SubsetTester tester(state.range(0), state.range(1));
+  tester.initialize();
+
+  // Match the last selector, so that the criteria carry the most distinct values.
+  ProtobufWkt::Struct metadata_matches;
+  (*metadata_matches.mutable_fields())["stage"].set_string_value("prod");
+  (*metadata_matches.mutable_fields())[fmt::format("key{}", state.range(1) - 1)].set_string_value(
+      "0");
+  TestLoadBalancerContext context;
+  context.metadata_match_ = std::make_unique<Router::MetadataMatchCriteriaImpl>(metadata_matches);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tester.lb_->chooseHost(&context));
+  }
+}
+BENCHMARK(BM_SubsetLoadBalancerChooseHost)->Args({10000, 8})->Args({10000, 32});
+
+void BM_SubsetLoadBalancerHostChurn(benchmark::State& state) {
+  SubsetTester tester(state.range(0), state.range(1));
+  tester.initialize();
+
+  // Replace one host per iteration with a host carrying the same metadata.
+  uint64_t index = 0;
+  for (auto _ : state) {
+    const HostSharedPtr removed = tester.hosts_.front();
+    tester.updateHosts({tester.makeHost(index++ % state.range(0))}, {removed});
+  }
+}
+BENCHMARK(BM_SubsetLoadBalancerHostChurn)
+    ->Args({1000, 8})
+    ->Args({10000, 8})
+    ->Args({10000, 32})
+    ->Unit(benchmark::kMillisecond);
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -398,6 +398,87 @@ TEST_F(MaglevLoadBalancerTest, LocalityWeightedLopsided) {
   EXPECT_EQ(MaglevTable::DefaultTableSize - 1023, counts[0]);
 }
 
+// Hosts that survive a host set update reuse their cached permutation, removed hosts are evicted,
+// and the rebuilt table matches a table built from scratch.
+TEST_F(MaglevLoadBalancerTest, PermutationCacheReusedAcrossUpdates) {
+  host_set_.hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(7);
+  EXPECT_EQ(6, lb_->permutationCache().size());
+
+  // Remove the first host and add a new one.
+  HostSharedPtr removed = host_set_.hosts_[0];
+  HostSharedPtr added = makeTestHost(info_, "tcp://127.0.0.1:96");
+  host_set_.hosts_.erase(host_set_.hosts_.begin());
+  host_set_.hosts_.push_back(added);
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({added}, {removed});
+  EXPECT_EQ(6, lb_->permutationCache().size());
+
+  NormalizedHostWeightVector normalized_host_weights;
+  for (const auto& host : host_set_.hosts_) {
+    normalized_host_weights.push_back({host, 1.0 / host_set_.hosts_.size()});
+  }
+  MaglevLoadBalancerStats stats{ALL_MAGLEV_LOAD_BALANCER_STATS(POOL_GAUGE(stats_store_))};
+  MaglevTable expected(normalized_host_weights, 1.0 / host_set_.hosts_.size(), 7, false, stats);
+  EXPECT_TRUE(expected.compact());
+
+  LoadBalancerPtr lb = lb_->factory()->create();
+  for (uint32_t i = 0; i < 7; ++i) {
+    TestLoadBalancerContext context(i);
+    EXPECT_EQ(expected.chooseHost(i, 0), lb->chooseHost(&context));
+    EXPECT_NE(removed, lb->chooseHost(&context));
+  }
+}
+
+// With bounded loads enabled, a host at its bound overflows to another host in a consistent order
+// while hosts under their bound are still chosen by the table.
+TEST_F(MaglevLoadBalancerTest, BoundedLoad) {
+  host_set_.hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  common_config_.mutable_consistent_hashing_lb_config()->mutable_hash_balance_factor()->set_value(
+      150);
+  init(7);
+
+  // With 6 active requests each host may have ceil(ceil(7 * 1.5) / 6) = 2 active requests.
+  stats_.upstream_rq_active_.set(6);
+  host_set_.hosts_[2]->stats().rq_active_.set(2);
+
+  // maglev: i=0 host=127.0.0.1:92
+  // maglev: i=1 host=127.0.0.1:94
+  LoadBalancerPtr lb = lb_->factory()->create();
+  {
+    TestLoadBalancerContext context(1);
+    EXPECT_EQ(host_set_.hosts_[4], lb->chooseHost(&context));
+  }
+  HostConstSharedPtr overflow_host;
+  {
+    TestLoadBalancerContext context(0);
+    overflow_host = lb->chooseHost(&context);
+    EXPECT_NE(nullptr, overflow_host);
+    EXPECT_NE(host_set_.hosts_[2], overflow_host);
+  }
+  {
+    TestLoadBalancerContext context(0);
+    EXPECT_EQ(overflow_host, lb->chooseHost(&context));
+  }
+
+  // Once the host is under its bound it is chosen again.
+  host_set_.hosts_[2]->stats().rq_active_.set(1);
+  {
+    TestLoadBalancerContext context(0);
+    EXPECT_EQ(host_set_.hosts_[2], lb->chooseHost(&context));
+  }
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
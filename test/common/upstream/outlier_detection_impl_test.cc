@@ -1,5 +1,6 @@
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -1485,6 +1486,111 @@ TEST_F(OutlierDetectorImplTest, Consecutive_5xxAlreadyEjected) {
   loadRq(hosts_[0], 5, 500);
 }
 
+// A host whose recent response time percentile exceeds a multiple of the cluster median is ejected
+// on the next advance of the latency window, without waiting for the interval timer.
+TEST_F(OutlierDetectorImplTest, LatencyEjection) {
+  const std::string yaml = R"EOF(
+latency_window: 10s
+latency_request_volume: 10
+  )EOF";
+  envoy::config::cluster::v3::OutlierDetection outlier_detection;
+  TestUtility::loadFromYaml(yaml, outlier_detection);
+
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+  // The detector creates the interval timer first, which is handed the most recently created mock.
+  Event::MockTimer* latency_timer = interval_timer_;
+  interval_timer_ = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  EXPECT_CALL(*latency_timer, enableTimer(std::chrono::milliseconds(1000), _));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, outlier_detection, dispatcher_, runtime_, time_system_, event_logger_));
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+  EXPECT_EQ(10000UL, detector->config().latencyWindowMs());
+  EXPECT_EQ(99UL, detector->config().latencyPercentile());
+  EXPECT_EQ(300UL, detector->config().latencyThresholdPercent());
+  EXPECT_EQ(5UL, detector->config().latencyMinimumHosts());
+  EXPECT_EQ(10UL, detector->config().latencyRequestVolume());
+  EXPECT_EQ(100UL, detector->config().enforcingLatency());
+  ON_CALL(runtime_.snapshot_, featureEnabled("outlier_detection.enforcing_latency", 100))
+      .WillByDefault(Return(true));
+
+  // Three times the median is not enough for an ejection.
+  for (uint32_t i = 0; i < 10; ++i) {
+    for (uint32_t j = 0; j < 4; ++j) {
+      hosts_[j]->outlierDetector().putResponseTime(std::chrono::milliseconds(100));
+    }
+    hosts_[4]->outlierDetector().putResponseTime(std::chrono::milliseconds(290));
+  }
+  EXPECT_CALL(*latency_timer, enableTimer(std::chrono::milliseconds(1000), _));
+  latency_timer->invokeCallback();
+  EXPECT_FALSE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+
+  // A brownout of the host shows in its 99th percentile after a few slow responses.
+  for (uint32_t i = 0; i < 5; ++i) {
+    hosts_[4]->outlierDetector().putResponseTime(std::chrono::milliseconds(1000));
+  }
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*latency_timer, enableTimer(std::chrono::milliseconds(1000), _));
+  latency_timer->invokeCallback();
+  EXPECT_TRUE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, outlier_detection_ejections_active_.value());
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_detected_latency")
+                     .value());
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_enforced_latency")
+                     .value());
+  EXPECT_EQ(
+      1UL,
+      cluster_.info_->stats_store_.counter("outlier_detection.ejections_enforced_total").value());
+
+  // Only four hosts are left to compare, which is below the minimum.
+  for (uint32_t i = 0; i < 5; ++i) {
+    hosts_[3]->outlierDetector().putResponseTime(std::chrono::milliseconds(1000));
+  }
+  EXPECT_CALL(*latency_timer, enableTimer(std::chrono::milliseconds(1000), _));
+  latency_timer->invokeCallback();
+  EXPECT_FALSE(hosts_[3]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+}
+
+TEST_F(OutlierDetectorImplTest, LatencyEjectionNotEnforcing) {
+  const std::string yaml = R"EOF(
+latency_window: 1s
+latency_request_volume: 1
+latency_minimum_hosts: 2
+enforcing_latency: 0
+  )EOF";
+  envoy::config::cluster::v3::OutlierDetection outlier_detection;
+  TestUtility::loadFromYaml(yaml, outlier_detection);
+
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({"tcp://127.0.0.1:80", "tcp://127.0.0.1:81", "tcp://127.0.0.1:82"});
+  Event::MockTimer* latency_timer = interval_timer_;
+  interval_timer_ = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*latency_timer, enableTimer(std::chrono::milliseconds(100), _)).Times(2);
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, outlier_detection, dispatcher_, runtime_, time_system_, event_logger_));
+
+  hosts_[0]->outlierDetector().putResponseTime(std::chrono::milliseconds(10));
+  hosts_[1]->outlierDetector().putResponseTime(std::chrono::milliseconds(10));
+  hosts_[2]->outlierDetector().putResponseTime(std::chrono::milliseconds(100));
+  latency_timer->invokeCallback();
+  EXPECT_FALSE(hosts_[2]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_detected_latency")
+                     .value());
+  EXPECT_EQ(0UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_enforced_latency")
+                     .value());
+}
+
 TEST(DetectorHostMonitorNullImplTest, All) {
   DetectorHostMonitorNullImpl null_sink;
 
@@ -1615,6 +1721,55 @@ TEST(OutlierUtility, SRThreshold) {
   EXPECT_EQ(52.0, success_rate_nums.ejection_threshold_);   // ejection threshold
 }
 
+TEST(LatencyWindowTest, Buckets) {
+  for (uint64_t ms = 0; ms < 8; ++ms) {
+    EXPECT_EQ(ms, LatencyWindow::bucketIndex(ms));
+    EXPECT_EQ(ms, LatencyWindow::bucketLowerBound(ms));
+  }
+  EXPECT_EQ(8U, LatencyWindow::bucketIndex(8));
+  EXPECT_EQ(8U, LatencyWindow::bucketIndex(9));
+  EXPECT_EQ(9U, LatencyWindow::bucketIndex(10));
+  EXPECT_EQ(12U, LatencyWindow::bucketIndex(16));
+  EXPECT_EQ(10UL, LatencyWindow::bucketLowerBound(9));
+  EXPECT_EQ(16UL, LatencyWindow::bucketLowerBound(12));
+  for (uint32_t i = 1; i < LatencyWindow::NumLatencyBuckets; ++i) {
+    EXPECT_EQ(i, LatencyWindow::bucketIndex(LatencyWindow::bucketLowerBound(i)));
+    EXPECT_EQ(i - 1, LatencyWindow::bucketIndex(LatencyWindow::bucketLowerBound(i) - 1));
+  }
+  // Response times beyond the last bucket are counted in it.
+  EXPECT_EQ(LatencyWindow::NumLatencyBuckets - 1,
+            LatencyWindow::bucketIndex(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(LatencyWindowTest, Percentile) {
+  LatencyWindow window;
+  EXPECT_FALSE(window.percentile(50, 0).has_value());
+  for (uint64_t ms = 1; ms <= 100; ++ms) {
+    window.record(std::chrono::milliseconds(ms));
+  }
+  EXPECT_FALSE(window.percentile(50, 101).has_value());
+  EXPECT_EQ(1UL, window.percentile(0, 100));
+  EXPECT_EQ(48UL, window.percentile(50, 100));
+  EXPECT_EQ(96UL, window.percentile(99, 100));
+  EXPECT_EQ(96UL, window.percentile(100, 100));
+}
+
+// Response times slide out of the window after a rotation of the ring.
+TEST(LatencyWindowTest, Advance) {
+  LatencyWindow window;
+  window.record(std::chrono::milliseconds(1000));
+  for (uint32_t i = 0; i < LatencyWindow::NumSubBuckets - 1; ++i) {
+    window.advance();
+    window.record(std::chrono::milliseconds(1));
+    EXPECT_EQ(896UL, window.percentile(100, 1));
+  }
+  window.advance();
+  EXPECT_EQ(1UL, window.percentile(100, 1));
+
+  window.clear();
+  EXPECT_FALSE(window.percentile(100, 1).has_value());
+}
+
 } // namespace
 } // namespace Outlier
 } // namespace Upstream
@@ -0,0 +1,109 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures the contention on the circuit breakers of a single busy cluster, which all benchmark
+// threads send requests to as the workers of a large proxy do: every request checks the request
+// and pending request limits, and acquires and releases both, with the shared counters of the
+// resource manager and with its per worker counters.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/runtime/runtime.h"
+
+#include "common/common/random_generator.h"
+#include "common/runtime/runtime_impl.h"
+#include "common/stats/isolated_store_impl.h"
+#include "common/upstream/resource_manager_impl.h"
+
+#include "test/benchmark/main.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+// Serves a snapshot without any override to all threads. The runtime loader only serves
+// snapshots to threads registered with thread local storage, which benchmark threads are not.
+class StaticLoader : public Runtime::Loader {
+public:
+  StaticLoader()
+      : stats_{ALL_RUNTIME_STATS(POOL_COUNTER(store_), POOL_GAUGE(store_))},
+        snapshot_(std::make_shared<Runtime::SnapshotImpl>(
+            random_, stats_, std::vector<Runtime::OverrideLayerConstPtr>{})) {}
+
+  // Runtime::Loader
+  void initialize(Upstream::ClusterManager&) override {}
+  const Runtime::Snapshot& snapshot() override { return *snapshot_; }
+  Runtime::SnapshotConstSharedPtr threadsafeSnapshot() override { return snapshot_; }
+  void mergeValues(const absl::node_hash_map<std::string, std::string>&) override {}
+  void startRtdsSubscriptions(ReadyCallback on_done) override { on_done(); }
+  Stats::Scope& getRootScope() override { return store_; }
+
+private:
+  Stats::IsolatedStoreImpl store_;
+  Random::RandomGeneratorImpl random_;
+  Runtime::RuntimeStats stats_;
+  const std::shared_ptr<const Runtime::SnapshotImpl> snapshot_;
+};
+
+struct Cluster {
+  explicit Cluster(bool per_worker_counters)
+      : cb_stats_{ALL_CLUSTER_CIRCUIT_BREAKERS_STATS(POOL_GAUGE(store_), POOL_GAUGE(store_))},
+        resource_manager_(loader_, "circuit_breakers.benchmark.default.", 1024, 1024, 1024, 3,
+                          1024, cb_stats_, absl::nullopt, absl::nullopt, per_worker_counters) {}
+
+  Stats::IsolatedStoreImpl store_;
+  StaticLoader loader_;
+  ClusterCircuitBreakersStats cb_stats_;
+  ResourceManagerImpl resource_manager_;
+};
+
+} // namespace
+
+// Sends requests from each benchmark thread to a cluster with per worker counters if range(0) is
+// set, or with shared counters otherwise.
+static void resourceManagerRequests(::benchmark::State& state) {
+  if (benchmark::skipExpensiveBenchmarks() && state.threads > 8) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  // Built once by the first thread to get here, and shared by all threads and runs.
+  static Cluster* shared_counters_cluster = new Cluster(false);
+  static Cluster* per_worker_counters_cluster = new Cluster(true);
+  ResourceManager& resource_manager = state.range(0) != 0
+                                          ? per_worker_counters_cluster->resource_manager_
+                                          : shared_counters_cluster->resource_manager_;
+
+  uint64_t overflows = 0;
+  for (auto _ : state) {
+    if (!resource_manager.pendingRequests().canCreate()) {
+      overflows++;
+      continue;
+    }
+    resource_manager.pendingRequests().inc();
+    if (resource_manager.requests().canCreate()) {
+      resource_manager.requests().inc();
+      resource_manager.pendingRequests().dec();
+      resource_manager.requests().dec();
+    } else {
+      resource_manager.pendingRequests().dec();
+      overflows++;
+    }
+  }
+  state.counters["overflows"] = overflows;
+}
+BENCHMARK(resourceManagerRequests)
+    ->Arg(0)
+    ->Arg(1)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(32)
+    ->Threads(64)
+    ->UseRealTime();
+
+} // namespace Upstream
+} // namespace Envoy
@@ -1,3 +1,5 @@
+#include <vector>
+
 #include "envoy/stats/stats.h"
 #include "envoy/upstream/upstream.h"
 
@@ -5,6 +7,7 @@
 
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
+#include "test/test_common/thread_factory_for_test.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -28,7 +31,7 @@ TEST(ResourceManagerImplTest, RuntimeResourceManager) {
       runtime, "circuit_breakers.runtime_resource_manager_test.default.", 0, 0, 0, 1, 0,
       ClusterCircuitBreakersStats{
           ALL_CLUSTER_CIRCUIT_BREAKERS_STATS(POOL_GAUGE(store), POOL_GAUGE(store))},
-      absl::nullopt, absl::nullopt);
+      absl::nullopt, absl::nullopt, false);
 
   EXPECT_CALL(
       runtime.snapshot_,
@@ -87,7 +90,8 @@ TEST(ResourceManagerImplTest, RemainingResourceGauges) {
       ALL_CLUSTER_CIRCUIT_BREAKERS_STATS(POOL_GAUGE(store), POOL_GAUGE(store))};
   ResourceManagerImpl resource_manager(runtime,
                                        "circuit_breakers.runtime_resource_manager_test.default.", 1,
-                                       2, 1, 0, 3, stats, absl::nullopt, absl::nullopt);
+                                       2, 1, 0, 3, stats, absl::nullopt, absl::nullopt,
+                                       false);
 
   // Test remaining_cx_ gauge
   EXPECT_EQ(1U, resource_manager.connections().max());
@@ -154,7 +158,7 @@ TEST(ResourceManagerImplTest, RetryBudgetOverrideGauge) {
 
   // Test retry budgets disable remaining_retries gauge (it should always be 0).
   ResourceManagerImpl rm(runtime, "circuit_breakers.runtime_resource_manager_test.default.", 1, 2,
-                         1, 0, 3, stats, 20.0, 5);
+                         1, 0, 3, stats, 20.0, 5, false);
 
   EXPECT_EQ(5U, rm.retries().max());
   EXPECT_EQ(0U, stats.remaining_retries_.value());
@@ -164,6 +168,75 @@ TEST(ResourceManagerImplTest, RetryBudgetOverrideGauge) {
   EXPECT_EQ(0U, stats.remaining_retries_.value());
   rm.retries().dec();
 }
+
+TEST(ResourceManagerImplTest, PerWorkerCounters) {
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl store;
+
+  auto stats = ClusterCircuitBreakersStats{
+      ALL_CLUSTER_CIRCUIT_BREAKERS_STATS(POOL_GAUGE(store), POOL_GAUGE(store))};
+  ResourceManagerImpl resource_manager(runtime,
+                                       "circuit_breakers.runtime_resource_manager_test.default.", 8,
+                                       8, 8, 8, 8, stats, absl::nullopt, absl::nullopt, true);
+  ResourceLimit& requests = resource_manager.requests();
+
+  // The limit is enforced exactly.
+  for (uint32_t i = 0; i < 8; ++i) {
+    EXPECT_TRUE(requests.canCreate());
+    requests.inc();
+  }
+  EXPECT_FALSE(requests.canCreate());
+  EXPECT_EQ(8U, requests.count());
+
+  // The gauges follow the counts that threads publish once they have moved by a few resources.
+  EXPECT_EQ(0U, stats.remaining_rq_.value());
+  EXPECT_EQ(1U, stats.rq_open_.value());
+  requests.dec();
+  EXPECT_TRUE(requests.canCreate());
+  EXPECT_EQ(7U, requests.count());
+  EXPECT_EQ(0U, stats.remaining_rq_.value());
+  requests.decBy(7);
+  EXPECT_EQ(0U, requests.count());
+  EXPECT_EQ(8U, stats.remaining_rq_.value());
+  EXPECT_EQ(0U, stats.rq_open_.value());
+}
+
+TEST(ResourceManagerImplTest, PerWorkerCountersAcrossThreads) {
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl store;
+
+  auto stats = ClusterCircuitBreakersStats{
+      ALL_CLUSTER_CIRCUIT_BREAKERS_STATS(POOL_GAUGE(store), POOL_GAUGE(store))};
+  ResourceManagerImpl resource_manager(
+      runtime, "circuit_breakers.runtime_resource_manager_test.default.", 1024, 1024, 1024, 1024,
+      1024, stats, absl::nullopt, absl::nullopt, true);
+  ResourceLimit& connections = resource_manager.connections();
+
+  // Each thread releases some of the connections acquired by this thread, and leaves some of its
+  // own.
+  for (uint32_t i = 0; i < 800; ++i) {
+    connections.inc();
+  }
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < 8; ++i) {
+    threads.push_back(Thread::threadFactoryForTest().createThread([&connections]() {
+      for (uint32_t j = 0; j < 1000; ++j) {
+        connections.inc();
+        connections.dec();
+      }
+      connections.decBy(100);
+      for (uint32_t j = 0; j < 10; ++j) {
+        connections.inc();
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  EXPECT_EQ(80U, connections.count());
+  EXPECT_TRUE(connections.canCreate());
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
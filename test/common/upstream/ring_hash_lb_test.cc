@@ -773,6 +773,37 @@ TEST_P(RingHashLoadBalancerTest, LopsidedWeightSmallScale) {
   }
 }
 
+// With bounded loads enabled, requests for a key whose host is at its bound are spread to hosts
+// under their bound, and the bound is respected across many requests for the same key.
+TEST_P(RingHashLoadBalancerTest, BoundedLoad) {
+  hostSet().hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93")};
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({}, {});
+
+  config_ = envoy::config::cluster::v3::Cluster::RingHashLbConfig();
+  config_.value().mutable_minimum_ring_size()->set_value(1024);
+  common_config_.mutable_consistent_hashing_lb_config()->mutable_hash_balance_factor()->set_value(
+      125);
+  init();
+
+  // Simulate 40 in-flight requests all hashing to the same key. With a balance factor of 1.25 no
+  // host should ever exceed ceil(ceil(41 * 1.25) / 4) = 13 active requests.
+  LoadBalancerPtr lb = lb_->factory()->create();
+  TestLoadBalancerContext context(42);
+  for (uint32_t i = 0; i < 40; ++i) {
+    HostConstSharedPtr host = lb->chooseHost(&context);
+    ASSERT_NE(nullptr, host);
+    host->stats().rq_active_.inc();
+    stats_.upstream_rq_active_.inc();
+  }
+  for (const auto& host : hostSet().hosts_) {
+    EXPECT_LE(host->stats().rq_active_.value(), 13U);
+    EXPECT_GT(host->stats().rq_active_.value(), 0U);
+  }
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -956,6 +956,41 @@ TEST_P(SubsetLoadBalancerTest, OnlyMetadataChanged) {
   EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_13));
 }
 
+// Metadata changes of existing hosts are picked up by updates that also add or remove hosts.
+TEST_P(SubsetLoadBalancerTest, MetadataChangedWithHostsAdded) {
+  TestLoadBalancerContext context_10({{"version", "1.0"}});
+  TestLoadBalancerContext context_11({{"version", "1.1"}});
+  TestLoadBalancerContext context_12({{"version", "1.2"}});
+
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::config::cluster::v3::Cluster::LbSubsetConfig::NO_FALLBACK));
+
+  std::vector<SubsetSelectorPtr> subset_selectors = {makeSelector({"version"})};
+  EXPECT_CALL(subset_info_, subsetSelectors()).WillRepeatedly(ReturnRef(subset_selectors));
+
+  init({{"tcp://127.0.0.1:8000", {{"version", "1.0"}}},
+        {"tcp://127.0.0.1:8001", {{"version", "1.0"}}}});
+  EXPECT_EQ(1U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_created_.value());
+
+  host_set_.hosts_[1]->metadata(buildMetadata("1.1"));
+  modifyHosts({makeHost("tcp://127.0.0.1:8002", {{"version", "1.2"}})}, {});
+
+  EXPECT_EQ(3U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(3U, stats_.lb_subsets_created_.value());
+  EXPECT_EQ(0U, stats_.lb_subsets_removed_.value());
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_11));
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(&context_12));
+
+  // Removing the only host of a subset purges it.
+  modifyHosts({}, {host_set_.hosts_[2]});
+
+  EXPECT_EQ(2U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_removed_.value());
+  EXPECT_EQ(nullptr, lb_->chooseHost(&context_12));
+}
+
 TEST_P(SubsetLoadBalancerTest, EmptySubsetsPurged) {
   std::vector<SubsetSelectorPtr> subset_selectors = {makeSelector({"version"}),
                                                      makeSelector({"version", "stage"})};
@@ -2063,6 +2063,39 @@ TEST_F(ClusterImplTest, CloseConnectionsOnHostHealthFailure) {
               ClusterInfo::Features::CLOSE_CONNECTIONS_ON_HOST_HEALTH_FAILURE);
 }
 
+// Test that the correct feature() is set when shared_http2_connection_pool is configured.
+TEST_F(ClusterImplTest, SharedHttp2ConnectionPool) {
+  auto dns_resolver = std::make_shared<Network::MockDnsResolver>();
+
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    http2_protocol_options: {}
+    shared_http2_connection_pool: {}
+    load_assignment:
+        endpoints:
+          - lb_endpoints:
+            - endpoint:
+                address:
+                  socket_address:
+                    address: foo.bar.com
+                    port_value: 443
+  )EOF";
+  envoy::config::cluster::v3::Cluster cluster_config = parseClusterFromV3Yaml(yaml);
+  Envoy::Stats::ScopePtr scope = stats_.createScope(fmt::format(
+      "cluster.{}.", cluster_config.alt_stat_name().empty() ? cluster_config.name()
+                                                            : cluster_config.alt_stat_name()));
+  Envoy::Server::Configuration::TransportSocketFactoryContextImpl factory_context(
+      admin_, ssl_context_manager_, *scope, cm_, local_info_, dispatcher_, random_, stats_,
+      singleton_manager_, tls_, validation_visitor_, *api_);
+
+  StrictDnsClusterImpl cluster(cluster_config, runtime_, dns_resolver, factory_context,
+                               std::move(scope), false);
+  EXPECT_TRUE(cluster.info()->features() & ClusterInfo::Features::SHARED_HTTP2_CONNECTION_POOL);
+}
+
 class TestBatchUpdateCb : public PrioritySet::BatchUpdateCb {
 public:
   TestBatchUpdateCb(HostVectorSharedPtr hosts, HostsPerLocalitySharedPtr hosts_per_locality)
@@ -2469,6 +2502,31 @@ TEST_F(ClusterInfoImplTest, TestTrackRequestResponseSizes) {
   EXPECT_EQ(Stats::Histogram::Unit::Bytes, req_resp_stats.upstream_rs_body_size_.unit());
 }
 
+TEST_F(ClusterInfoImplTest, TestLazyStats) {
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    track_cluster_stats: { lazy_stats : true }
+  )EOF";
+
+  auto cluster = makeCluster(yaml);
+  ClusterStats& stats = cluster->info()->stats();
+  EXPECT_EQ(0, stats.upstream_rq_total_.value());
+  EXPECT_FALSE(stats_.findCounterByString("cluster.name.upstream_rq_total"));
+
+  stats.upstream_rq_total_.inc();
+  stats.upstream_cx_active_.inc();
+  auto upstream_rq_total = stats_.findCounterByString("cluster.name.upstream_rq_total");
+  ASSERT_TRUE(upstream_rq_total);
+  EXPECT_EQ(1, upstream_rq_total->get().value());
+  auto upstream_cx_active = stats_.findGaugeByString("cluster.name.upstream_cx_active");
+  ASSERT_TRUE(upstream_cx_active);
+  EXPECT_EQ(1, upstream_cx_active->get().value());
+  EXPECT_FALSE(stats_.findCounterByString("cluster.name.upstream_rq_timeout"));
+}
+
 TEST_F(ClusterInfoImplTest, TestTrackRemainingResourcesGauges) {
   const std::string yaml = R"EOF(
     name: name
@@ -0,0 +1,90 @@
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "extensions/common/dynamic_forward_proxy/dns_cache_host_map.h"
+
+#include "test/extensions/common/dynamic_forward_proxy/mocks.h"
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace DynamicForwardProxy {
+namespace {
+
+TEST(DnsCacheHostMapTest, NumShards) {
+  EXPECT_EQ(1, DnsCacheHostMap(1).numShards());
+  EXPECT_EQ(16, DnsCacheHostMap(1024).numShards());
+  EXPECT_EQ(32, DnsCacheHostMap(1025).numShards());
+  EXPECT_EQ(16384, DnsCacheHostMap(1000000).numShards());
+  EXPECT_EQ(65536, DnsCacheHostMap(std::numeric_limits<uint32_t>::max()).numShards());
+}
+
+// Returns the info of a host, or nullptr if the host is not in the map.
+DnsHostInfoSharedPtr findHost(const DnsCacheHostMap& host_map, absl::string_view host) {
+  const DnsHostInfoSharedPtr* host_info = host_map.find(host);
+  return host_info != nullptr ? *host_info : nullptr;
+}
+
+TEST(DnsCacheHostMapTest, InsertFindErase) {
+  DnsCacheHostMap host_map(256);
+  std::vector<DnsHostInfoSharedPtr> host_infos;
+  for (uint32_t i = 0; i < 256; ++i) {
+    host_infos.push_back(std::make_shared<MockDnsHostInfo>());
+    host_map.insert(absl::StrCat("host", i, ".com"), host_infos.back());
+  }
+  EXPECT_EQ(256, host_map.size());
+  for (uint32_t i = 0; i < 256; ++i) {
+    EXPECT_EQ(host_infos[i], findHost(host_map, absl::StrCat("host", i, ".com")));
+  }
+  EXPECT_EQ(nullptr, host_map.find("host256.com"));
+
+  // Inserting a host which is in the map replaces its info.
+  const DnsHostInfoSharedPtr new_host_info = std::make_shared<MockDnsHostInfo>();
+  host_map.insert("host0.com", new_host_info);
+  EXPECT_EQ(256, host_map.size());
+  EXPECT_EQ(new_host_info, findHost(host_map, "host0.com"));
+
+  for (uint32_t i = 0; i < 256; i += 2) {
+    EXPECT_TRUE(host_map.erase(absl::StrCat("host", i, ".com")).has_value());
+  }
+  EXPECT_FALSE(host_map.erase("host256.com").has_value());
+  EXPECT_EQ(128, host_map.size());
+  for (uint32_t i = 0; i < 256; ++i) {
+    const DnsHostInfoSharedPtr expected = i % 2 == 0 ? nullptr : host_infos[i];
+    EXPECT_EQ(expected, findHost(host_map, absl::StrCat("host", i, ".com")));
+  }
+}
+
+// A copy of the map which is given the shards replaced by the changes of another copy holds the
+// same hosts, and shares the shards rather than copying them.
+TEST(DnsCacheHostMapTest, UpdateShard) {
+  DnsCacheHostMap host_map(1024);
+  DnsCacheHostMap copy(1024);
+  const DnsHostInfoSharedPtr host_info = std::make_shared<MockDnsHostInfo>();
+  for (uint32_t i = 0; i < 100; ++i) {
+    const size_t index = host_map.insert(absl::StrCat("host", i, ".com"), host_info);
+    copy.updateShard(index, host_map.shard(index), host_map.size());
+  }
+  const absl::optional<size_t> index = host_map.erase("host0.com");
+  ASSERT_TRUE(index.has_value());
+  copy.updateShard(index.value(), host_map.shard(index.value()), host_map.size());
+
+  EXPECT_EQ(99, copy.size());
+  EXPECT_EQ(nullptr, copy.find("host0.com"));
+  for (uint32_t i = 1; i < 100; ++i) {
+    EXPECT_EQ(host_info, findHost(copy, absl::StrCat("host", i, ".com")));
+  }
+  for (size_t i = 0; i < host_map.numShards(); ++i) {
+    EXPECT_EQ(host_map.shard(i), copy.shard(i));
+  }
+}
+
+} // namespace
+} // namespace DynamicForwardProxy
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
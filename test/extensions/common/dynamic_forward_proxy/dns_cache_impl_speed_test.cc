@@ -0,0 +1,242 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures how the dynamic forward proxy DNS cache scales to a large number of distinct hosts, as
+// when fronting many tenants: loading them into the cache, with and without evicting least
+// recently used hosts, and looking them up from several workers at once. The propagation of every
+// new host by copying the whole host map, which the sharded host map replaces, is measured for
+// comparison at sizes where it completes, as is looking up hosts in shards shared through atomic
+// shared pointers rather than published to a copy of the map of each worker.
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/extensions/common/dynamic_forward_proxy/v3/dns_cache.pb.h"
+
+#include "common/common/hash.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/common/dynamic_forward_proxy/dns_cache_host_map.h"
+#include "extensions/common/dynamic_forward_proxy/dns_cache_impl.h"
+
+#include "test/benchmark/main.h"
+#include "test/extensions/common/dynamic_forward_proxy/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace DynamicForwardProxy {
+namespace {
+
+std::vector<std::string> hostNames(uint32_t num_hosts) {
+  std::vector<std::string> hosts;
+  hosts.reserve(num_hosts);
+  for (uint32_t i = 0; i < num_hosts; ++i) {
+    hosts.push_back(absl::StrCat("tenant", i, ".example.com"));
+  }
+  return hosts;
+}
+
+// Resolves every host inline, as a hit in a resolution cache does.
+class InlineDnsResolver : public Network::DnsResolver {
+public:
+  // Network::DnsResolver
+  Network::ActiveDnsQuery* resolve(const std::string&, Network::DnsLookupFamily,
+                                   ResolveCb callback) override {
+    callback(ResolutionStatus::Success, std::list<Network::DnsResponse>(response_));
+    return nullptr;
+  }
+
+private:
+  const std::list<Network::DnsResponse> response_{TestUtility::makeDnsResponse({"10.0.0.1"})};
+};
+
+class NullLoadDnsCacheEntryCallbacks : public DnsCache::LoadDnsCacheEntryCallbacks {
+public:
+  // DnsCache::LoadDnsCacheEntryCallbacks
+  void onLoadDnsCacheComplete() override {}
+};
+
+} // namespace
+
+// Loads range(0) distinct hosts into a cache holding at most range(1) hosts, which evicts the least
+// recently used hosts once full if range(2) is set, or lets new hosts overflow otherwise.
+static void dnsCacheLoad(::benchmark::State& state) {
+  const uint32_t num_hosts = state.range(0);
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts > 10000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  const std::vector<std::string> hosts = hostNames(num_hosts);
+  envoy::extensions::common::dynamic_forward_proxy::v3::DnsCacheConfig config;
+  config.set_name("benchmark");
+  config.mutable_max_hosts()->set_value(state.range(1));
+  config.set_evict_least_recently_used_hosts(state.range(2) != 0);
+  NullLoadDnsCacheEntryCallbacks callbacks;
+  for (auto _ : state) {
+    state.PauseTiming();
+    NiceMock<Event::MockDispatcher> dispatcher;
+    ON_CALL(dispatcher, createDnsResolver(_, _))
+        .WillByDefault(Return(std::make_shared<InlineDnsResolver>()));
+    NiceMock<ThreadLocal::MockInstance> tls;
+    NiceMock<Random::MockRandomGenerator> random;
+    NiceMock<Runtime::MockLoader> loader;
+    Stats::IsolatedStoreImpl store;
+    auto dns_cache = std::make_unique<DnsCacheImpl>(dispatcher, tls, random, loader, store, config);
+    state.ResumeTiming();
+
+    for (const std::string& host : hosts) {
+      dns_cache->loadDnsCacheEntry(host, 443, callbacks);
+    }
+
+    state.PauseTiming();
+    dns_cache.reset();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(dnsCacheLoad)
+    ->Args({10000, 10000, 0})
+    ->Args({1000000, 1000000, 0})
+    ->Args({1000000, 65536, 0})
+    ->Args({1000000, 65536, 1})
+    ->Unit(::benchmark::kMillisecond);
+
+// Inserts range(0) hosts into a host map sized for them.
+static void hostMapInsert(::benchmark::State& state) {
+  const uint32_t num_hosts = state.range(0);
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts > 16384) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  const std::vector<std::string> hosts = hostNames(num_hosts);
+  const DnsHostInfoSharedPtr host_info = std::make_shared<NiceMock<MockDnsHostInfo>>();
+  for (auto _ : state) {
+    DnsCacheHostMap host_map(num_hosts);
+    for (const std::string& host : hosts) {
+      host_map.insert(host, host_info);
+    }
+  }
+}
+BENCHMARK(hostMapInsert)->Arg(1024)->Arg(16384)->Arg(1000000)->Unit(::benchmark::kMillisecond);
+
+// Inserts range(0) hosts into a map copied to the workers after every insertion, as the cache did
+// before the sharded host map.
+static void fullHostMapCopyInsert(::benchmark::State& state) {
+  const uint32_t num_hosts = state.range(0);
+  const std::vector<std::string> hosts = hostNames(num_hosts);
+  const DnsHostInfoSharedPtr host_info = std::make_shared<NiceMock<MockDnsHostInfo>>();
+  using HostMap = absl::flat_hash_map<std::string, DnsHostInfoSharedPtr>;
+  for (auto _ : state) {
+    HostMap primary_hosts;
+    std::shared_ptr<const HostMap> tls_host_map;
+    for (const std::string& host : hosts) {
+      primary_hosts.emplace(host, host_info);
+      tls_host_map = std::make_shared<const HostMap>(primary_hosts);
+    }
+  }
+}
+BENCHMARK(fullHostMapCopyInsert)->Arg(1024)->Arg(16384)->Unit(::benchmark::kMillisecond);
+
+namespace {
+
+constexpr uint32_t NumLookupHosts = 1000000;
+
+// The hosts looked up, and the primary host map holding them. Built once by the first thread to
+// get here, and shared by all threads and runs.
+const std::vector<std::string>& lookupHosts() {
+  static const std::vector<std::string>* hosts =
+      new std::vector<std::string>(hostNames(NumLookupHosts));
+  return *hosts;
+}
+
+const DnsCacheHostMap& lookupHostMap() {
+  static const DnsCacheHostMap* host_map = [] {
+    auto* host_map = new DnsCacheHostMap(NumLookupHosts);
+    const DnsHostInfoSharedPtr host_info = std::make_shared<NiceMock<MockDnsHostInfo>>();
+    for (const std::string& host : lookupHosts()) {
+      host_map->insert(host, host_info);
+    }
+    return host_map;
+  }();
+  return *host_map;
+}
+
+} // namespace
+
+// Looks up hosts of a host map holding 1M hosts from each benchmark thread, in a copy of the map
+// of its own which shares the shards of the primary map, as the workers do.
+static void hostMapLookup(::benchmark::State& state) {
+  if (benchmark::skipExpensiveBenchmarks()) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  const std::vector<std::string>& hosts = lookupHosts();
+  const DnsCacheHostMap& primary_host_map = lookupHostMap();
+  DnsCacheHostMap host_map(NumLookupHosts);
+  for (size_t i = 0; i < primary_host_map.numShards(); ++i) {
+    host_map.updateShard(i, primary_host_map.shard(i), primary_host_map.size());
+  }
+
+  // Each thread walks the hosts with a different stride, so that threads don't look up the same
+  // host at the same time.
+  const uint32_t stride = 7919 * (state.thread_index + 1);
+  uint32_t index = 0;
+  for (auto _ : state) {
+    ::benchmark::DoNotOptimize(host_map.find(hosts[index]));
+    index = (index + stride) % NumLookupHosts;
+  }
+}
+BENCHMARK(hostMapLookup)->Threads(1)->Threads(4)->Threads(16)->MeasureProcessCPUTime();
+
+// Looks up the same hosts in the shards of the primary host map, shared by all benchmark threads
+// and loaded with std::atomic_load() on every lookup so that the main thread could replace them
+// concurrently. With libstdc++, std::atomic_load() of a shared pointer takes one of a few global
+// mutexes picked by the address of the pointer, and copies the pointer.
+static void atomicSharedShardLookup(::benchmark::State& state) {
+  if (benchmark::skipExpensiveBenchmarks()) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  const std::vector<std::string>& hosts = lookupHosts();
+  static std::vector<DnsCacheHostMap::ShardConstSharedPtr>* shards = [] {
+    const DnsCacheHostMap& primary_host_map = lookupHostMap();
+    auto* shards = new std::vector<DnsCacheHostMap::ShardConstSharedPtr>();
+    for (size_t i = 0; i < primary_host_map.numShards(); ++i) {
+      shards->push_back(primary_host_map.shard(i));
+    }
+    return shards;
+  }();
+
+  const uint32_t stride = 7919 * (state.thread_index + 1);
+  uint32_t index = 0;
+  for (auto _ : state) {
+    const std::string& host = hosts[index];
+    const DnsCacheHostMap::ShardConstSharedPtr shard =
+        std::atomic_load(&(*shards)[HashUtil::xxHash64(host) & (shards->size() - 1)]);
+    ::benchmark::DoNotOptimize(shard->find(host));
+    index = (index + stride) % NumLookupHosts;
+  }
+}
+BENCHMARK(atomicSharedShardLookup)->Threads(1)->Threads(4)->Threads(16)->MeasureProcessCPUTime();
+
+} // namespace DynamicForwardProxy
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
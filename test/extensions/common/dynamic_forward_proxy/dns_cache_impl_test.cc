@@ -645,6 +645,77 @@ TEST_F(DnsCacheImplTest, MaxHostOverflow) {
   EXPECT_EQ(1, TestUtility::findCounter(store_, "dns_cache.foo.host_overflow")->value());
 }
 
+// Once the cache is full, a new host replaces the least recently used one.
+TEST_F(DnsCacheImplTest, MaxHostEvictLeastRecentlyUsed) {
+  config_.mutable_max_hosts()->set_value(2);
+  config_.set_evict_least_recently_used_hosts(true);
+  initialize();
+
+  MockLoadDnsCacheEntryCallbacks callbacks;
+  Network::DnsResolver::ResolveCb resolve_cb;
+  const auto load_host = [&](const std::string& host, const std::string& address) {
+    new Event::MockTimer(&dispatcher_);
+    EXPECT_CALL(*resolver_, resolve(host, _, _))
+        .WillOnce(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+    auto result = dns_cache_->loadDnsCacheEntry(host, 80, callbacks);
+    EXPECT_EQ(DnsCache::LoadDnsCacheEntryStatus::Loading, result.status_);
+    EXPECT_CALL(update_callbacks_, onDnsHostAddOrUpdate(host, _));
+    EXPECT_CALL(callbacks, onLoadDnsCacheComplete());
+    resolve_cb(Network::DnsResolver::ResolutionStatus::Success,
+               TestUtility::makeDnsResponse({address}));
+  };
+
+  load_host("foo.com", "10.0.0.1");
+  load_host("bar.com", "10.0.0.2");
+  // foo.com is used after both hosts were added, which leaves bar.com the least recently used.
+  simTime().advanceTimeWait(std::chrono::seconds(1));
+  dns_cache_->hosts()["foo.com"]->touch();
+
+  EXPECT_CALL(update_callbacks_, onDnsHostRemove("bar.com"));
+  load_host("baz.com", "10.0.0.3");
+  EXPECT_EQ(1, TestUtility::findCounter(store_, "dns_cache.foo.host_evicted")->value());
+  EXPECT_EQ(0, TestUtility::findCounter(store_, "dns_cache.foo.host_overflow")->value());
+  checkStats(3 /* attempt */, 3 /* success */, 0 /* failure */, 3 /* address changed */,
+             3 /* added */, 1 /* removed */, 2 /* num hosts */);
+
+  EXPECT_EQ(DnsCache::LoadDnsCacheEntryStatus::InCache,
+            dns_cache_->loadDnsCacheEntry("foo.com", 80, callbacks).status_);
+  EXPECT_EQ(DnsCache::LoadDnsCacheEntryStatus::InCache,
+            dns_cache_->loadDnsCacheEntry("baz.com", 80, callbacks).status_);
+
+  // foo.com has not been used since it got a second chance, so it goes next.
+  EXPECT_CALL(update_callbacks_, onDnsHostRemove("foo.com"));
+  load_host("bar.com", "10.0.0.2");
+  EXPECT_EQ(2, TestUtility::findCounter(store_, "dns_cache.foo.host_evicted")->value());
+}
+
+// Hosts whose first resolution is pending are not evicted, so a new host overflows if all hosts
+// are pending.
+TEST_F(DnsCacheImplTest, MaxHostEvictionOverflow) {
+  config_.mutable_max_hosts()->set_value(1);
+  config_.set_evict_least_recently_used_hosts(true);
+  initialize();
+
+  MockLoadDnsCacheEntryCallbacks callbacks;
+  new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*resolver_, resolve("foo.com", _, _)).WillOnce(Return(&resolver_->active_query_));
+  auto result = dns_cache_->loadDnsCacheEntry("foo.com", 80, callbacks);
+  EXPECT_EQ(DnsCache::LoadDnsCacheEntryStatus::Loading, result.status_);
+
+  // The overflow is only detected on the main thread, which completes the pending resolution.
+  MockLoadDnsCacheEntryCallbacks overflow_callbacks;
+  Event::PostCb post_cb;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  auto overflow_result = dns_cache_->loadDnsCacheEntry("bar.com", 80, overflow_callbacks);
+  EXPECT_EQ(DnsCache::LoadDnsCacheEntryStatus::Loading, overflow_result.status_);
+  EXPECT_CALL(overflow_callbacks, onLoadDnsCacheComplete());
+  post_cb();
+  EXPECT_EQ(1, TestUtility::findCounter(store_, "dns_cache.foo.host_overflow")->value());
+  EXPECT_EQ(0, TestUtility::findCounter(store_, "dns_cache.foo.host_evicted")->value());
+
+  EXPECT_CALL(resolver_->active_query_, cancel());
+}
+
 TEST_F(DnsCacheImplTest, CircuitBreakersNotInvoked) {
   initialize();
 
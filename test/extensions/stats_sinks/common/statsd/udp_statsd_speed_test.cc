@@ -0,0 +1,128 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures flushing the counters of a large Envoy to a statsd receiver on the loopback interface.
+// The receiver never reads, so the kernel drops the datagrams once its receive buffer fills up,
+// which costs the sender the same.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/stats/allocator_impl.h"
+#include "common/stats/symbol_table_impl.h"
+
+#include "extensions/stat_sinks/common/statsd/statsd.h"
+
+#include "test/benchmark/main.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/network_utility.h"
+#include "test/test_common/threadsafe_singleton_injector.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace Common {
+namespace Statsd {
+namespace {
+
+// Counters of many clusters, built once and shared by all the benchmarks.
+class Snapshot : public Stats::MetricSnapshot {
+public:
+  explicit Snapshot(uint32_t num_counters) : alloc_(symbol_table_), pool_(symbol_table_) {
+    constexpr uint32_t CountersPerCluster = 100;
+    for (uint32_t i = 0; i < num_counters; ++i) {
+      const Stats::StatName name =
+          pool_.add(absl::StrCat("cluster.cluster_", i / CountersPerCluster, ".upstream_rq_",
+                                 i % CountersPerCluster));
+      Stats::CounterSharedPtr counter = alloc_.makeCounter(name, Stats::StatName(), {});
+      counter->add(i + 1);
+      counter_snapshots_.push_back({i + 1, *counter});
+      counters_.push_back(std::move(counter));
+    }
+  }
+
+  static Snapshot& get() {
+    static Snapshot* snapshot =
+        new Snapshot(Envoy::benchmark::skipExpensiveBenchmarks() ? 1000 : 500 * 1000);
+    return *snapshot;
+  }
+
+  // Stats::MetricSnapshot
+  const std::vector<CounterSnapshot>& counters() override { return counter_snapshots_; }
+  const std::vector<std::reference_wrapper<const Stats::Gauge>>& gauges() override {
+    return gauges_;
+  }
+  const std::vector<std::reference_wrapper<const Stats::ParentHistogram>>& histograms() override {
+    return histograms_;
+  }
+  const std::vector<std::reference_wrapper<const Stats::TextReadout>>& textReadouts() override {
+    return text_readouts_;
+  }
+  const std::vector<CounterSnapshot>& changedCounters() override { return counter_snapshots_; }
+  const std::vector<std::reference_wrapper<const Stats::Gauge>>& changedGauges() override {
+    return gauges_;
+  }
+
+  Stats::SymbolTableImpl symbol_table_;
+
+private:
+  Stats::AllocatorImpl alloc_;
+  Stats::StatNamePool pool_;
+  std::vector<Stats::CounterSharedPtr> counters_;
+  std::vector<CounterSnapshot> counter_snapshots_;
+  std::vector<std::reference_wrapper<const Stats::Gauge>> gauges_;
+  std::vector<std::reference_wrapper<const Stats::ParentHistogram>> histograms_;
+  std::vector<std::reference_wrapper<const Stats::TextReadout>> text_readouts_;
+};
+
+// Writes each datagram with its own system call, as on platforms without sendmmsg().
+class NoMmsgOsSysCallsImpl : public Api::OsSysCallsImpl {
+public:
+  bool supportsMmsg() const override { return false; }
+};
+
+} // namespace
+
+// Flushes all the counters. range(0) is the maximum datagram size, with 0 sending one metric per
+// datagram, range(1) whether to cache the formatted names across flushes and range(2) whether to
+// write the datagrams with sendmmsg().
+static void flushCounters(::benchmark::State& state) {
+  Snapshot& snapshot = Snapshot::get();
+  NoMmsgOsSysCallsImpl no_mmsg_os_sys_calls;
+  std::unique_ptr<TestThreadsafeSingletonInjector<Api::OsSysCallsImpl>> injector;
+  if (state.range(2) == 0) {
+    injector = std::make_unique<TestThreadsafeSingletonInjector<Api::OsSysCallsImpl>>(
+        &no_mmsg_os_sys_calls);
+  }
+  testing::NiceMock<ThreadLocal::MockInstance> tls;
+  Network::Test::UdpSyncPeer receiver(Network::Address::IpVersion::v4);
+  UdpStatsdSink sink(tls, receiver.localAddress(), false, getDefaultPrefix(),
+                     static_cast<uint64_t>(state.range(0)), false,
+                     state.range(1) != 0 ? &snapshot.symbol_table_ : nullptr);
+
+  for (auto _ : state) {
+    sink.flush(snapshot);
+  }
+  state.counters["metrics_per_flush"] = snapshot.counters().size();
+  tls.shutdownThread();
+}
+BENCHMARK(flushCounters)
+    ->Args({0, 0, 0})
+    ->Args({0, 0, 1})
+    ->Args({0, 1, 1})
+    ->Args({1432, 0, 0})
+    ->Args({1432, 0, 1})
+    ->Args({1432, 1, 1})
+    ->Args({8932, 1, 1})
+    ->Unit(::benchmark::kMillisecond);
+
+} // namespace Statsd
+} // namespace Common
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
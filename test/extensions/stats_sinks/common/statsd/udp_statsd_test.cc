@@ -32,11 +32,13 @@ namespace {
 class MockWriter : public UdpStatsdSink::Writer {
 public:
   MOCK_METHOD(void, write, (const std::string& message));
-  MOCK_METHOD(void, writeBuffer, (Buffer::Instance & buffer));
+  MOCK_METHOD(void, writeBatch, (const DatagramBatch& batch));
 
   void delegateBufferFake() {
-    ON_CALL(*this, writeBuffer).WillByDefault([this](Buffer::Instance& buffer) {
-      this->buffer_writes.push_back(buffer.toString());
+    ON_CALL(*this, writeBatch).WillByDefault([this](const DatagramBatch& batch) {
+      for (uint64_t i = 0; i < batch.size(); ++i) {
+        this->buffer_writes.push_back(std::string(batch.datagram(i)));
+      }
     });
   }
 
@@ -171,7 +173,7 @@ TEST(UdpStatsdSinkTest, CheckActualStats) {
   counter.latch_ = 1;
   snapshot.counters_.push_back({1, counter});
 
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBuffer(_))
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_))
       .Times(1);
   sink.flush(snapshot);
   EXPECT_EQ(writer_ptr->buffer_writes.size(), 1);
@@ -184,7 +186,7 @@ TEST(UdpStatsdSinkTest, CheckActualStats) {
   gauge.used_ = true;
   snapshot.gauges_.push_back(gauge);
 
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBuffer(_));
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
   sink.flush(snapshot);
   EXPECT_EQ(writer_ptr->buffer_writes.size(), 2);
   EXPECT_EQ(writer_ptr->buffer_writes.at(1), "envoy.test_gauge:1|g");
@@ -198,6 +200,42 @@ TEST(UdpStatsdSinkTest, CheckActualStats) {
   tls_.shutdownThread();
 }
 
+TEST(UdpStatsdSinkTest, SkipUnchangedMetrics) {
+  NiceMock<Stats::MockMetricSnapshot> snapshot;
+  auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
+  writer_ptr->delegateBufferFake();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  UdpStatsdSink sink(tls_, writer_ptr, false, getDefaultPrefix(), 1024, true);
+
+  NiceMock<Stats::MockCounter> counter;
+  counter.name_ = "test_counter";
+  counter.used_ = true;
+  NiceMock<Stats::MockCounter> unchanged_counter;
+  unchanged_counter.name_ = "unchanged_counter";
+  unchanged_counter.used_ = true;
+  snapshot.counters_.push_back({1, counter});
+  snapshot.counters_.push_back({0, unchanged_counter});
+  snapshot.changed_counters_.push_back({1, counter});
+
+  NiceMock<Stats::MockGauge> gauge;
+  gauge.name_ = "test_gauge";
+  gauge.value_ = 1;
+  gauge.used_ = true;
+  NiceMock<Stats::MockGauge> unchanged_gauge;
+  unchanged_gauge.name_ = "unchanged_gauge";
+  unchanged_gauge.used_ = true;
+  snapshot.gauges_.push_back(gauge);
+  snapshot.gauges_.push_back(unchanged_gauge);
+  snapshot.changed_gauges_.push_back(gauge);
+
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
+  sink.flush(snapshot);
+  ASSERT_EQ(writer_ptr->buffer_writes.size(), 1);
+  EXPECT_EQ(writer_ptr->buffer_writes.at(0), "envoy.test_counter:1|c\nenvoy.test_gauge:1|g");
+
+  tls_.shutdownThread();
+}
+
 TEST(UdpStatsdSinkTest, CheckMetricLargerThanBuffer) {
   NiceMock<Stats::MockMetricSnapshot> snapshot;
   auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
@@ -212,10 +250,11 @@ TEST(UdpStatsdSinkTest, CheckMetricLargerThanBuffer) {
   counter.latch_ = 1;
   snapshot.counters_.push_back({1, counter});
 
-  // Expect the metric to skip the buffer
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr),
-              write("envoy.test_counter:1|c"));
+  // Expect the metric to be written in a datagram of its own.
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
   sink.flush(snapshot);
+  EXPECT_EQ(writer_ptr->buffer_writes.size(), 1);
+  EXPECT_EQ(writer_ptr->buffer_writes.at(0), "envoy.test_counter:1|c");
   counter.used_ = false;
 
   NiceMock<Stats::MockGauge> gauge;
@@ -224,10 +263,11 @@ TEST(UdpStatsdSinkTest, CheckMetricLargerThanBuffer) {
   gauge.used_ = true;
   snapshot.gauges_.push_back(gauge);
 
-  // Expect the metric to skip the buffer
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr),
-              write("envoy.test_gauge:1|g"));
+  // Expect the metric to be written in a datagram of its own.
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
   sink.flush(snapshot);
+  EXPECT_EQ(writer_ptr->buffer_writes.size(), 2);
+  EXPECT_EQ(writer_ptr->buffer_writes.at(1), "envoy.test_gauge:1|g");
 
   tls_.shutdownThread();
 }
@@ -253,7 +293,7 @@ TEST(UdpStatsdSinkTest, CheckBufferedWritesWithinBufferSize) {
   snapshot.gauges_.push_back(gauge);
 
   // Expect both metrics to be present in single write
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBuffer(_))
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_))
       .Times(1);
   sink.flush(snapshot);
   EXPECT_EQ(writer_ptr->buffer_writes.size(), 1);
@@ -288,9 +328,8 @@ TEST(UdpStatsdSinkTest, CheckBufferedWritesExceedingBufferSize) {
   gauge.used_ = true;
   snapshot.gauges_.push_back(gauge);
 
-  // Expect both metrics to be present in single write
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBuffer(_))
-      .Times(2);
+  // Expect the metrics to be split over two datagrams, written in a single batch.
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
   sink.flush(snapshot);
   EXPECT_EQ(writer_ptr->buffer_writes.size(), 2);
   EXPECT_EQ(writer_ptr->buffer_writes.at(0), "envoy.test_counter_1:1|c\nenvoy.test_counter_2:1|c");
@@ -299,6 +338,105 @@ TEST(UdpStatsdSinkTest, CheckBufferedWritesExceedingBufferSize) {
   tls_.shutdownThread();
 }
 
+// Validates that a batch of histogram samples is packed into datagrams in a single write.
+TEST(UdpStatsdSinkTest, HistogramSamples) {
+  auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
+  writer_ptr->delegateBufferFake();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  uint64_t buffer_size = 80;
+  UdpStatsdSink sink(tls_, writer_ptr, true, getDefaultPrefix(), buffer_size);
+
+  NiceMock<Stats::MockHistogram> timer;
+  timer.name_ = "test_timer";
+  timer.setTagExtractedName("test_timer");
+  timer.setTags({Stats::Tag{"key", "value"}});
+
+  const std::vector<uint64_t> values{5, 10, 15};
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
+  sink.onHistogramSamples(timer, values);
+  ASSERT_EQ(writer_ptr->buffer_writes.size(), 2);
+  EXPECT_EQ(writer_ptr->buffer_writes.at(0),
+            "envoy.test_timer:5|ms|#key:value\nenvoy.test_timer:10|ms|#key:value");
+  EXPECT_EQ(writer_ptr->buffer_writes.at(1), "envoy.test_timer:15|ms|#key:value");
+
+  // An empty batch writes nothing.
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_))
+      .Times(0);
+  sink.onHistogramSamples(timer, {});
+
+  tls_.shutdownThread();
+}
+
+TEST(DatagramBatchTest, Packing) {
+  DatagramBatch batch(20);
+  EXPECT_EQ(0, batch.size());
+  batch.add("a:", 1, "|c", "");
+  batch.add("b:", 22, "|g", "");
+  EXPECT_EQ(1, batch.size());
+  EXPECT_EQ("a:1|c\nb:22|g", batch.datagram(0));
+
+  // Doesn't fit in the open datagram, so starts a new one.
+  batch.add("c:", 333, "|c", "|#k:v");
+  // Too large for any datagram, so gets one of its own.
+  batch.add("too_large_metric:", 1, "|c", "");
+  batch.add("d:", 4, "|c", "");
+  ASSERT_EQ(4, batch.size());
+  EXPECT_EQ("c:333|c|#k:v", batch.datagram(1));
+  EXPECT_EQ("too_large_metric:1|c", batch.datagram(2));
+  EXPECT_EQ("d:4|c", batch.datagram(3));
+  EXPECT_EQ(49, batch.bytes());
+
+  // A size of zero sends one metric per datagram.
+  DatagramBatch unpacked(0);
+  unpacked.add("a:", 1, "|c", "");
+  unpacked.add("b:", 2, "|c", "");
+  ASSERT_EQ(2, unpacked.size());
+  EXPECT_EQ("a:1|c", unpacked.datagram(0));
+  EXPECT_EQ("b:2|c", unpacked.datagram(1));
+}
+
+TEST(UdpStatsdSinkTest, NameCache) {
+  Stats::TestSymbolTable symbol_table;
+  NiceMock<Stats::MockMetricSnapshot> snapshot;
+  auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
+  writer_ptr->delegateBufferFake();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  UdpStatsdSink sink(tls_, writer_ptr, true, getDefaultPrefix(), 1024, false, &*symbol_table);
+
+  NiceMock<Stats::MockCounter> counter;
+  counter.name_ = "test_counter";
+  counter.used_ = true;
+  counter.setTags({Stats::Tag{"key", "value"}});
+  snapshot.counters_.push_back({1, counter});
+  NiceMock<Stats::MockGauge> gauge;
+  gauge.name_ = "test_gauge";
+  gauge.value_ = 1;
+  gauge.used_ = true;
+  snapshot.gauges_.push_back(gauge);
+
+  // The second flush uses the names cached by the first.
+  sink.flush(snapshot);
+  EXPECT_EQ(2, sink.getNameCacheSizeForTest());
+  gauge.value_ = 2;
+  snapshot.counters_[0].delta_ = 3;
+  sink.flush(snapshot);
+  EXPECT_EQ(2, sink.getNameCacheSizeForTest());
+  ASSERT_EQ(writer_ptr->buffer_writes.size(), 2);
+  EXPECT_EQ(writer_ptr->buffer_writes.at(0),
+            "envoy.test_counter:1|c|#key:value\nenvoy.test_gauge:1|g");
+  EXPECT_EQ(writer_ptr->buffer_writes.at(1),
+            "envoy.test_counter:3|c|#key:value\nenvoy.test_gauge:2|g");
+
+  // The name of a metric which is no longer flushed is eventually dropped.
+  snapshot.gauges_.clear();
+  for (uint32_t i = 0; i < 32; ++i) {
+    sink.flush(snapshot);
+  }
+  EXPECT_EQ(1, sink.getNameCacheSizeForTest());
+
+  tls_.shutdownThread();
+}
+
 TEST(UdpStatsdSinkTest, CheckActualStatsWithCustomPrefix) {
   NiceMock<Stats::MockMetricSnapshot> snapshot;
   auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
@@ -312,7 +450,7 @@ TEST(UdpStatsdSinkTest, CheckActualStatsWithCustomPrefix) {
   counter.latch_ = 1;
   snapshot.counters_.push_back({1, counter});
 
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBuffer(_));
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
   sink.flush(snapshot);
   EXPECT_EQ(writer_ptr->buffer_writes.size(), 1);
   EXPECT_EQ(writer_ptr->buffer_writes.at(0), "test_prefix.test_counter:1|c");
@@ -377,7 +515,7 @@ TEST(UdpStatsdSinkWithTagsTest, CheckActualStats) {
   counter.setTags(tags);
   snapshot.counters_.push_back({1, counter});
 
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBuffer(_));
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
   sink.flush(snapshot);
   EXPECT_EQ(writer_ptr->buffer_writes.size(), 1);
   EXPECT_EQ(writer_ptr->buffer_writes.at(0), "envoy.test_counter:1|c|#key1:value1,key2:value2");
@@ -390,7 +528,7 @@ TEST(UdpStatsdSinkWithTagsTest, CheckActualStats) {
   gauge.setTags(tags);
   snapshot.gauges_.push_back(gauge);
 
-  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBuffer(_));
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), writeBatch(_));
   sink.flush(snapshot);
   EXPECT_EQ(writer_ptr->buffer_writes.size(), 2);
   EXPECT_EQ(writer_ptr->buffer_writes.at(1), "envoy.test_gauge:1|g|#key1:value1,key2:value2");
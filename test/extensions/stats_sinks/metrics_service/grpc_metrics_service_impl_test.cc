@@ -190,6 +190,40 @@ TEST_F(MetricsServiceSinkTest, ReportCountersAsDeltas) {
   sink.flush(snapshot_);
 }
 
+// Test that verifies only the counters and gauges changed since the previous flush are reported
+// when configured to do so.
+TEST_F(MetricsServiceSinkTest, SkipUnchangedMetrics) {
+  MetricsServiceSink sink(streamer_, time_system_, true, true);
+
+  auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
+  counter->name_ = "test_counter";
+  counter->used_ = true;
+  auto unchanged_counter = std::make_shared<NiceMock<Stats::MockCounter>>();
+  unchanged_counter->name_ = "unchanged_counter";
+  unchanged_counter->used_ = true;
+  snapshot_.counters_.push_back({1, *counter});
+  snapshot_.counters_.push_back({0, *unchanged_counter});
+  snapshot_.changed_counters_.push_back({1, *counter});
+
+  auto gauge = std::make_shared<NiceMock<Stats::MockGauge>>();
+  gauge->name_ = "test_gauge";
+  gauge->used_ = true;
+  auto unchanged_gauge = std::make_shared<NiceMock<Stats::MockGauge>>();
+  unchanged_gauge->name_ = "unchanged_gauge";
+  unchanged_gauge->used_ = true;
+  snapshot_.gauges_.push_back(*gauge);
+  snapshot_.gauges_.push_back(*unchanged_gauge);
+  snapshot_.changed_gauges_.push_back(*gauge);
+
+  EXPECT_CALL(*streamer_, send(_))
+      .WillOnce(Invoke([](envoy::service::metrics::v3::StreamMetricsMessage& message) {
+        ASSERT_EQ(2, message.envoy_metrics_size());
+        EXPECT_EQ("test_counter", message.envoy_metrics(0).name());
+        EXPECT_EQ("test_gauge", message.envoy_metrics(1).name());
+      }));
+  sink.flush(snapshot_);
+}
+
 } // namespace
 } // namespace MetricsService
 } // namespace StatSinks
@@ -0,0 +1,63 @@
+#include "envoy/config/metrics/v3/stats.pb.h"
+#include "envoy/registry/registry.h"
+
+#include "common/protobuf/utility.h"
+
+#include "extensions/stat_sinks/shared_memory/config.h"
+#include "extensions/stat_sinks/shared_memory/shared_memory_reader.h"
+#include "extensions/stat_sinks/shared_memory/shared_memory_sink.h"
+#include "extensions/stat_sinks/well_known_names.h"
+
+#include "test/mocks/server/instance.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+namespace {
+
+TEST(StatsConfigTest, ValidSharedMemorySink) {
+  const std::string name = StatsSinkNames::get().SharedMemory;
+
+  envoy::config::metrics::v3::SharedMemoryStatsSink sink_config;
+  const std::string path = TestEnvironment::temporaryPath("shared_memory_stats_config");
+  sink_config.set_path(path);
+
+  Server::Configuration::StatsSinkFactory* factory =
+      Registry::FactoryRegistry<Server::Configuration::StatsSinkFactory>::getFactory(name);
+  ASSERT_NE(factory, nullptr);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  TestUtility::jsonConvert(sink_config, *message);
+
+  NiceMock<Server::Configuration::MockServerFactoryContext> server;
+  Stats::SinkPtr sink = factory->createStatsSink(*message, server);
+  EXPECT_NE(dynamic_cast<SharedMemoryStatsSink*>(sink.get()), nullptr);
+
+  SharedMemoryStatsReader reader(path);
+  EXPECT_EQ(0, reader.numStats());
+}
+
+TEST(StatsConfigTest, SharedMemorySinkWithoutPath) {
+  const std::string name = StatsSinkNames::get().SharedMemory;
+  Server::Configuration::StatsSinkFactory* factory =
+      Registry::FactoryRegistry<Server::Configuration::StatsSinkFactory>::getFactory(name);
+  ASSERT_NE(factory, nullptr);
+
+  envoy::config::metrics::v3::SharedMemoryStatsSink sink_config;
+  NiceMock<Server::Configuration::MockServerFactoryContext> server;
+  EXPECT_THROW(factory->createStatsSink(sink_config, server), ProtoValidationException);
+}
+
+} // namespace
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,221 @@
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "envoy/common/exception.h"
+
+#include "extensions/stat_sinks/shared_memory/shared_memory_reader.h"
+#include "extensions/stat_sinks/shared_memory/shared_memory_sink.h"
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/mocks/stats/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Extensions {
+namespace StatSinks {
+namespace SharedMemory {
+namespace {
+
+class SharedMemoryStatsSinkTest : public testing::Test {
+protected:
+  SharedMemoryStatsSinkTest() : path_(TestEnvironment::temporaryPath("shared_memory_stats")) {
+    ON_CALL(snapshot_, counters()).WillByDefault(ReturnRef(snapshot_.counters_));
+    ON_CALL(snapshot_, gauges()).WillByDefault(ReturnRef(snapshot_.gauges_));
+  }
+
+  std::unique_ptr<SharedMemoryStatsSink> makeSink(uint32_t max_stats, uint32_t name_bytes) {
+    return std::make_unique<SharedMemoryStatsSink>(path_, max_stats, name_bytes,
+                                                   store_.symbolTable(), time_system_);
+  }
+
+  void addCounter(const std::string& name, uint64_t value) {
+    Stats::Counter& counter = store_.counterFromString(name);
+    counter.add(value);
+    snapshot_.counters_.push_back({value, counter});
+  }
+
+  void addGauge(const std::string& name, uint64_t value) {
+    Stats::Gauge& gauge = store_.gaugeFromString(name, Stats::Gauge::ImportMode::Accumulate);
+    gauge.set(value);
+    snapshot_.gauges_.push_back(gauge);
+  }
+
+  uint64_t lookup(const SharedMemoryStatsReader& reader, absl::string_view name) {
+    const absl::optional<uint32_t> position = reader.find(name);
+    EXPECT_TRUE(position.has_value()) << name;
+    return position.has_value() ? reader.value(position.value()) : 0;
+  }
+
+  const std::string path_;
+  Stats::TestUtil::TestStore store_;
+  Event::SimulatedTimeSystem time_system_;
+  NiceMock<Stats::MockMetricSnapshot> snapshot_;
+};
+
+TEST_F(SharedMemoryStatsSinkTest, ExportsCountersAndGauges) {
+  auto sink = makeSink(16, 1024);
+  SharedMemoryStatsReader reader(path_);
+  EXPECT_EQ(0, reader.numStats());
+  EXPECT_EQ(0, reader.flushCount());
+
+  addCounter("cluster.foo.upstream_rq_total", 5);
+  addGauge("cluster.foo.upstream_cx_active", 7);
+  time_system_.setSystemTime(SystemTime(std::chrono::milliseconds(1234)));
+  sink->flush(snapshot_);
+
+  EXPECT_EQ(2, reader.numStats());
+  EXPECT_EQ(0, reader.numDropped());
+  EXPECT_EQ(1, reader.flushCount());
+  EXPECT_EQ(1234, reader.flushTimeMs());
+  EXPECT_EQ("cluster.foo.upstream_rq_total", reader.name(0));
+  EXPECT_EQ(StatType::Counter, reader.type(0));
+  EXPECT_EQ(5, reader.value(0));
+  EXPECT_EQ("cluster.foo.upstream_cx_active", reader.name(1));
+  EXPECT_EQ(StatType::Gauge, reader.type(1));
+  EXPECT_EQ(7, reader.value(1));
+  EXPECT_FALSE(reader.find("cluster.foo.upstream_rq_active").has_value());
+
+  // Later flushes update the values in place.
+  store_.counterFromString("cluster.foo.upstream_rq_total").add(3);
+  store_.gaugeFromString("cluster.foo.upstream_cx_active", Stats::Gauge::ImportMode::Accumulate)
+      .dec();
+  sink->flush(snapshot_);
+  EXPECT_EQ(2, reader.numStats());
+  EXPECT_EQ(2, reader.flushCount());
+  EXPECT_EQ(8, lookup(reader, "cluster.foo.upstream_rq_total"));
+  EXPECT_EQ(6, lookup(reader, "cluster.foo.upstream_cx_active"));
+
+  // A reader mapping the file later sees the same stats.
+  SharedMemoryStatsReader reader2(path_);
+  EXPECT_EQ(2, reader2.numStats());
+  EXPECT_EQ(8, lookup(reader2, "cluster.foo.upstream_rq_total"));
+}
+
+TEST_F(SharedMemoryStatsSinkTest, ManyStats) {
+  constexpr uint32_t NumStats = 1000;
+  auto sink = makeSink(NumStats, NumStats * 64);
+  for (uint32_t i = 0; i < NumStats; ++i) {
+    addCounter(absl::StrCat("cluster.cluster_", i, ".upstream_rq_total"), i);
+  }
+  sink->flush(snapshot_);
+
+  SharedMemoryStatsReader reader(path_);
+  EXPECT_EQ(NumStats, reader.numStats());
+  EXPECT_EQ(0, reader.numDropped());
+  for (uint32_t i = 0; i < NumStats; ++i) {
+    EXPECT_EQ(i, lookup(reader, absl::StrCat("cluster.cluster_", i, ".upstream_rq_total")));
+  }
+  EXPECT_FALSE(reader.find("cluster.cluster_1000.upstream_rq_total").has_value());
+}
+
+TEST_F(SharedMemoryStatsSinkTest, DropsStatsWhenFull) {
+  auto sink = makeSink(2, 1024);
+  addCounter("a", 1);
+  addCounter("b", 2);
+  addCounter("c", 3);
+  sink->flush(snapshot_);
+  sink->flush(snapshot_);
+
+  SharedMemoryStatsReader reader(path_);
+  EXPECT_EQ(2, reader.numStats());
+  // The stats which are not exported are counted for the last flush only.
+  EXPECT_EQ(1, reader.numDropped());
+  EXPECT_EQ(1, lookup(reader, "a"));
+  EXPECT_EQ(2, lookup(reader, "b"));
+  EXPECT_FALSE(reader.find("c").has_value());
+
+  snapshot_.counters_.pop_back();
+  sink->flush(snapshot_);
+  EXPECT_EQ(0, reader.numDropped());
+}
+
+// A stat which is no longer flushed, as it was freed, keeps its entry, which it gets back if it is
+// flushed again later.
+TEST_F(SharedMemoryStatsSinkTest, StatFlushedAgain) {
+  auto sink = makeSink(16, 1024);
+  addCounter("a", 1);
+  addCounter("b", 2);
+  sink->flush(snapshot_);
+
+  snapshot_.counters_.pop_back();
+  for (uint32_t i = 0; i < 32; ++i) {
+    sink->flush(snapshot_);
+  }
+  addCounter("b", 3);
+  sink->flush(snapshot_);
+
+  SharedMemoryStatsReader reader(path_);
+  EXPECT_EQ(2, reader.numStats());
+  EXPECT_EQ("b", reader.name(1));
+  EXPECT_EQ(5, reader.value(1));
+}
+
+TEST_F(SharedMemoryStatsSinkTest, DropsStatsWithoutRoomForTheirName) {
+  auto sink = makeSink(16, 8);
+  addCounter("counter", 1);
+  addCounter("x", 2);
+  addCounter("y", 3);
+  sink->flush(snapshot_);
+
+  SharedMemoryStatsReader reader(path_);
+  EXPECT_EQ(2, reader.numStats());
+  EXPECT_EQ(1, reader.numDropped());
+  EXPECT_EQ(1, lookup(reader, "counter"));
+  EXPECT_EQ(2, lookup(reader, "x"));
+}
+
+// A new sink replaces the file rather than rewriting it, so readers of the previous file can keep
+// reading it.
+TEST_F(SharedMemoryStatsSinkTest, ReplacesFile) {
+  auto sink = makeSink(16, 1024);
+  addCounter("a", 1);
+  sink->flush(snapshot_);
+  SharedMemoryStatsReader reader(path_);
+
+  auto sink2 = makeSink(16, 1024);
+  EXPECT_EQ(1, reader.numStats());
+  EXPECT_EQ(1, lookup(reader, "a"));
+  SharedMemoryStatsReader reader2(path_);
+  EXPECT_EQ(0, reader2.numStats());
+}
+
+TEST_F(SharedMemoryStatsSinkTest, BadPath) {
+  EXPECT_THROW_WITH_REGEX(
+      SharedMemoryStatsSink("/nonexistent/dir/stats", 16, 1024, store_.symbolTable(),
+                            time_system_),
+      EnvoyException, "unable to create shared memory stats file '/nonexistent/dir/stats'");
+}
+
+TEST_F(SharedMemoryStatsSinkTest, ReaderErrors) {
+  EXPECT_THROW_WITH_REGEX(SharedMemoryStatsReader("/nonexistent/dir/stats"), EnvoyException,
+                          "unable to open shared memory stats file");
+
+  {
+    std::ofstream file(path_, std::ios::trunc);
+    file << "not stats";
+  }
+  EXPECT_THROW_WITH_REGEX(SharedMemoryStatsReader reader(path_), EnvoyException, "too small");
+
+  {
+    std::ofstream file(path_, std::ios::trunc);
+    file << std::string(sizeof(RegionHeader), 'x');
+  }
+  EXPECT_THROW_WITH_REGEX(SharedMemoryStatsReader reader(path_), EnvoyException,
+                          "does not have layout version 1");
+}
+
+} // namespace
+} // namespace SharedMemory
+} // namespace StatSinks
+} // namespace Extensions
+} // namespace Envoy
@@ -19,6 +19,9 @@ namespace Router {
 MockDirectResponseEntry::MockDirectResponseEntry() = default;
 MockDirectResponseEntry::~MockDirectResponseEntry() = default;
 
+MockHedgeController::MockHedgeController() = default;
+MockHedgeController::~MockHedgeController() = default;
+
 TestRetryPolicy::TestRetryPolicy() { num_retries_ = 1; }
 
 TestRetryPolicy::~TestRetryPolicy() = default;
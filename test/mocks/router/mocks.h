@@ -81,6 +81,17 @@ public:
   bool shadow_enabled_{};
 };
 
+class MockHedgeController : public HedgeController {
+public:
+  MockHedgeController();
+  ~MockHedgeController() override;
+
+  MOCK_METHOD(void, onRequest, ());
+  MOCK_METHOD(absl::optional<std::chrono::milliseconds>, hedgeDelay, (), (const));
+  MOCK_METHOD(bool, tryHedge, ());
+  MOCK_METHOD(void, recordResponseTime, (std::chrono::milliseconds response_time));
+};
+
 class TestHedgePolicy : public HedgePolicy {
 public:
   // Router::HedgePolicy
@@ -89,10 +100,12 @@ public:
     return additional_request_chance_;
   }
   bool hedgeOnPerTryTimeout() const override { return hedge_on_per_try_timeout_; }
+  HedgeController* latencyHedgeController() const override { return latency_hedge_controller_; }
 
   uint32_t initial_requests_{};
   envoy::type::v3::FractionalPercent additional_request_chance_{};
   bool hedge_on_per_try_timeout_{};
+  HedgeController* latency_hedge_controller_{};
 };
 
 class TestRetryPolicy : public RetryPolicy {
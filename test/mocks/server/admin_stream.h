@@ -15,6 +15,7 @@ public:
 
   MOCK_METHOD(void, setEndStreamOnComplete, (bool));
   MOCK_METHOD(void, addOnDestroyCallback, (std::function<void()>));
+  MOCK_METHOD(void, setNextChunkCallback, (NextChunkCb));
   MOCK_METHOD(const Buffer::Instance*, getRequestBody, (), (const));
   MOCK_METHOD(Http::RequestHeaderMap&, getRequestHeaders, (), (const));
   MOCK_METHOD(NiceMock<Http::MockStreamDecoderFilterCallbacks>&, getDecoderFilterCallbacks, (),
@@ -77,6 +77,15 @@ public:
   MOCK_METHOD(void, setUnhealthy, ());
 };
 
+class MockHostLatencyMonitor : public HostLatencyMonitor {
+public:
+  MockHostLatencyMonitor();
+  ~MockHostLatencyMonitor() override;
+
+  MOCK_METHOD(void, putResponseTime, (std::chrono::microseconds time, MonotonicTime now));
+  MOCK_METHOD(absl::optional<double>, latencyEstimate, (MonotonicTime now), (const));
+};
+
 class MockHostDescription : public HostDescription {
 public:
   MockHostDescription();
@@ -91,6 +100,7 @@ public:
   MOCK_METHOD(const ClusterInfo&, cluster, (), (const));
   MOCK_METHOD(Outlier::DetectorHostMonitor&, outlierDetector, (), (const));
   MOCK_METHOD(HealthCheckHostMonitor&, healthChecker, (), (const));
+  MOCK_METHOD(HostLatencyMonitor&, latencyMonitor, (), (const));
   MOCK_METHOD(const std::string&, hostnameForHealthChecks, (), (const));
   MOCK_METHOD(const std::string&, hostname, (), (const));
   MOCK_METHOD(Network::TransportSocketFactory&, transportSocketFactory, (), (const));
@@ -109,6 +119,7 @@ public:
   Network::Address::InstanceConstSharedPtr address_;
   testing::NiceMock<Outlier::MockDetectorHostMonitor> outlier_detector_;
   testing::NiceMock<MockHealthCheckHostMonitor> health_checker_;
+  testing::NiceMock<MockHostLatencyMonitor> latency_monitor_;
   Network::TransportSocketFactoryPtr socket_factory_;
   testing::NiceMock<MockClusterInfo> cluster_;
   HostStats stats_;
@@ -181,6 +192,7 @@ public:
   MOCK_METHOD(const std::string&, hostname, (), (const));
   MOCK_METHOD(Network::TransportSocketFactory&, transportSocketFactory, (), (const));
   MOCK_METHOD(Outlier::DetectorHostMonitor&, outlierDetector, (), (const));
+  MOCK_METHOD(HostLatencyMonitor&, latencyMonitor, (), (const));
   MOCK_METHOD(void, setHealthChecker_, (HealthCheckHostMonitorPtr & health_checker));
   MOCK_METHOD(void, setOutlierDetector_, (Outlier::DetectorHostMonitorPtr & outlier_detector));
   MOCK_METHOD(HostStats&, stats, (), (const));
@@ -196,6 +208,7 @@ public:
   testing::NiceMock<MockClusterInfo> cluster_;
   Network::TransportSocketFactoryPtr socket_factory_;
   testing::NiceMock<Outlier::MockDetectorHostMonitor> outlier_detector_;
+  testing::NiceMock<MockHostLatencyMonitor> latency_monitor_;
   HostStats stats_;
   mutable Stats::TestSymbolTable symbol_table_;
   mutable std::unique_ptr<Stats::StatNameManagedStorage> locality_zone_stat_name_;
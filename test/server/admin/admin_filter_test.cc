@@ -1,5 +1,7 @@
 #include "server/admin/admin_filter.h"
 
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/server/instance.h"
 #include "test/test_common/environment.h"
 
@@ -7,6 +9,7 @@
 #include "gtest/gtest.h"
 
 using testing::InSequence;
+using testing::InvokeWithoutArgs;
 using testing::NiceMock;
 
 namespace Envoy {
@@ -77,5 +80,44 @@ TEST_P(AdminFilterTest, Trailers) {
   EXPECT_EQ(Http::FilterTrailersStatus::StopIteration, filter_.decodeTrailers(request_trailers));
 }
 
+TEST_P(AdminFilterTest, ChunkedResponse) {
+  int chunks_left = 3;
+  AdminFilter filter([&chunks_left](absl::string_view, Http::ResponseHeaderMap&,
+                                    Buffer::OwnedImpl& response, AdminFilter& admin_filter) {
+    response.add("head\n");
+    admin_filter.setNextChunkCallback([&chunks_left](Buffer::Instance& chunk) {
+      chunk.add(absl::StrCat("chunk ", chunks_left, "\n"));
+      return --chunks_left > 0;
+    });
+    return Http::Code::OK;
+  });
+  filter.setDecoderFilterCallbacks(callbacks_);
+  auto* next_chunk_cb = new NiceMock<Event::MockSchedulableCallback>(&callbacks_.dispatcher_);
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("head\n"), false));
+  EXPECT_CALL(callbacks_, addDownstreamWatermarkCallbacks(_));
+  filter.decodeHeaders(request_headers_, true);
+  EXPECT_TRUE(next_chunk_cb->enabled_);
+
+  // The next chunk waits for the client to catch up.
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("chunk 3\n"), false))
+      .WillOnce(InvokeWithoutArgs([&filter]() { filter.onAboveWriteBufferHighWatermark(); }));
+  next_chunk_cb->invokeCallback();
+  EXPECT_FALSE(next_chunk_cb->enabled_);
+  filter.onBelowWriteBufferLowWatermark();
+  EXPECT_TRUE(next_chunk_cb->enabled_);
+
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("chunk 2\n"), false));
+  next_chunk_cb->invokeCallback();
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("chunk 1\n"), true));
+  next_chunk_cb->invokeCallback();
+  EXPECT_FALSE(next_chunk_cb->enabled_);
+  EXPECT_EQ(0, chunks_left);
+
+  EXPECT_CALL(callbacks_, removeDownstreamWatermarkCallbacks(_));
+  filter.onDestroy();
+}
+
 } // namespace Server
 } // namespace Envoy
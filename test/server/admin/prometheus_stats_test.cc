@@ -5,6 +5,8 @@
 #include "test/mocks/stats/mocks.h"
 #include "test/test_common/utility.h"
 
+#include "absl/strings/str_join.h"
+
 using testing::NiceMock;
 using testing::ReturnRef;
 
@@ -701,5 +703,78 @@ envoy_cluster_test_1_upstream_cx_total{a_tag_name="a.tag-value"} 0
   EXPECT_EQ(expected_output, response.toString());
 }
 
+TEST_F(PrometheusStatsFormatterTest, OutputInChunks) {
+  addCounter("cluster.test_1.upstream_cx_total",
+             {{makeStat("a.tag-name"), makeStat("a.tag-value")}});
+  addCounter("cluster.test_1.upstream_cx_total",
+             {{makeStat("a.tag-name"), makeStat("b.tag-value")}});
+  addGauge("cluster.test_2.upstream_cx_active",
+           {{makeStat("another_tag_name"), makeStat("another_tag-value")}});
+
+  // Each chunk of at least a byte holds one metric, and the TYPE annotation before it.
+  PrometheusStatsRenderer renderer(counters_, gauges_, histograms_, false, absl::nullopt, nullptr);
+  std::vector<std::string> chunks;
+  bool more = true;
+  while (more) {
+    Buffer::OwnedImpl chunk;
+    more = renderer.nextChunk(chunk, 1);
+    chunks.push_back(chunk.toString());
+  }
+  EXPECT_EQ(2UL, renderer.metricNameCount());
+
+  const std::vector<std::string> expected_chunks = {
+      "# TYPE envoy_cluster_test_1_upstream_cx_total counter\n"
+      "envoy_cluster_test_1_upstream_cx_total{a_tag_name=\"a.tag-value\"} 0\n",
+      "envoy_cluster_test_1_upstream_cx_total{a_tag_name=\"b.tag-value\"} 0\n\n",
+      "# TYPE envoy_cluster_test_2_upstream_cx_active gauge\n"
+      "envoy_cluster_test_2_upstream_cx_active{another_tag_name=\"another_tag-value\"} 0\n\n"};
+  EXPECT_EQ(expected_chunks, chunks);
+
+  // Rendering in a single chunk gives the same output.
+  Buffer::OwnedImpl response;
+  PrometheusStatsFormatter::statsAsPrometheus(counters_, gauges_, histograms_, response, false,
+                                              absl::nullopt);
+  EXPECT_EQ(absl::StrJoin(chunks, ""), response.toString());
+}
+
+TEST_F(PrometheusStatsFormatterTest, NameCache) {
+  addCounter("cluster.test_1.upstream_cx_total",
+             {{makeStat("a.tag-name"), makeStat("a.tag-value")}});
+  addCounter("cluster.test_1.upstream_cx_total",
+             {{makeStat("a.tag-name"), makeStat("b.tag-value")}});
+  addGauge("cluster.test_2.upstream_cx_active",
+           {{makeStat("another_tag_name"), makeStat("another_tag-value")}});
+
+  auto render = [this](const PrometheusNameCacheSharedPtr& name_cache,
+                       const absl::optional<std::regex>& regex) {
+    PrometheusStatsRenderer renderer(counters_, gauges_, histograms_, false, regex, name_cache);
+    Buffer::OwnedImpl response;
+    while (renderer.nextChunk(response, 1)) {
+    }
+    return response.toString();
+  };
+
+  {
+    auto name_cache = std::make_shared<PrometheusNameCache>(*symbol_table_);
+    const std::string output = render(nullptr, absl::nullopt);
+
+    // Two metric names, and the tags of three metrics.
+    EXPECT_EQ(output, render(name_cache, absl::nullopt));
+    EXPECT_EQ(5UL, name_cache->size());
+    EXPECT_EQ(output, render(name_cache, absl::nullopt));
+    EXPECT_EQ(5UL, name_cache->size());
+
+    // Entries are not dropped by filtered scrapes, which don't render all metrics.
+    const std::regex regex("test_2");
+    EXPECT_EQ(render(nullptr, regex), render(name_cache, regex));
+    EXPECT_EQ(5UL, name_cache->size());
+
+    // Entries of metrics which no longer exist are dropped by the next unfiltered scrape.
+    counters_.pop_back();
+    EXPECT_EQ(render(nullptr, absl::nullopt), render(name_cache, absl::nullopt));
+    EXPECT_EQ(4UL, name_cache->size());
+  }
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -0,0 +1,144 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures rendering the stats of a large Envoy in admin, as one buffer and in chunks.
+
+#include <algorithm>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/allocator_impl.h"
+#include "common/stats/symbol_table_impl.h"
+
+#include "server/admin/prometheus_stats.h"
+#include "server/admin/stats_handler.h"
+
+#include "test/benchmark/main.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Server {
+namespace {
+
+// The size of the chunks the admin handlers render.
+constexpr uint64_t ChunkSize = 64 * 1024;
+
+// Counters of many clusters, with the cluster name extracted as a tag, built once and shared by
+// all the benchmarks.
+struct StatsFixture {
+  explicit StatsFixture(uint32_t num_stats) : alloc_(symbol_table_), pool_(symbol_table_) {
+    constexpr uint32_t StatsPerCluster = 100;
+    const Stats::StatName tag_name = pool_.add("envoy.cluster_name");
+    for (uint32_t i = 0; i < num_stats; ++i) {
+      const std::string cluster = absl::StrCat("cluster_", i / StatsPerCluster);
+      const std::string stat = absl::StrCat("upstream_rq_", i % StatsPerCluster);
+      const Stats::StatName name = pool_.add(absl::StrCat("cluster.", cluster, ".", stat));
+      const Stats::StatName tag_extracted_name = pool_.add(absl::StrCat("cluster.", stat));
+      counters_.push_back(
+          alloc_.makeCounter(name, tag_extracted_name, {{tag_name, pool_.add(cluster)}}));
+      counters_.back()->add(i);
+    }
+  }
+
+  static StatsFixture& get() {
+    static StatsFixture* fixture = new StatsFixture(
+        Envoy::benchmark::skipExpensiveBenchmarks() ? 1000 : 1000 * 1000);
+    return *fixture;
+  }
+
+  Stats::SymbolTableImpl symbol_table_;
+  Stats::AllocatorImpl alloc_;
+  Stats::StatNamePool pool_;
+  std::vector<Stats::CounterSharedPtr> counters_;
+};
+
+} // namespace
+
+// Renders the Prometheus output in one buffer, as the admin handler used to.
+static void prometheusSingleBuffer(::benchmark::State& state) {
+  StatsFixture& fixture = StatsFixture::get();
+  uint64_t bytes = 0;
+  for (auto _ : state) {
+    Buffer::OwnedImpl response;
+    PrometheusStatsFormatter::statsAsPrometheus(fixture.counters_, {}, {}, response, false,
+                                                absl::nullopt);
+    bytes = response.length();
+  }
+  state.counters["bytes"] = bytes;
+  state.counters["max_buffered"] = bytes;
+}
+BENCHMARK(prometheusSingleBuffer)->Unit(::benchmark::kMillisecond);
+
+// Renders the Prometheus output in chunks, each written out before rendering the next, with a
+// name cache kept across scrapes if range(0) is set.
+static void prometheusChunks(::benchmark::State& state) {
+  StatsFixture& fixture = StatsFixture::get();
+  PrometheusNameCacheSharedPtr name_cache;
+  if (state.range(0) != 0) {
+    name_cache = std::make_shared<PrometheusNameCache>(fixture.symbol_table_);
+  }
+  uint64_t bytes = 0;
+  uint64_t max_buffered = 0;
+  for (auto _ : state) {
+    PrometheusStatsRenderer renderer(fixture.counters_, {}, {}, false, absl::nullopt, name_cache);
+    bytes = 0;
+    bool more = true;
+    while (more) {
+      Buffer::OwnedImpl chunk;
+      more = renderer.nextChunk(chunk, ChunkSize);
+      bytes += chunk.length();
+      max_buffered = std::max(max_buffered, chunk.length());
+    }
+  }
+  state.counters["bytes"] = bytes;
+  state.counters["max_buffered"] = max_buffered;
+}
+BENCHMARK(prometheusChunks)->Arg(0)->Arg(1)->Unit(::benchmark::kMillisecond);
+
+// Renders the Prometheus output of the stats of one cluster in a hundred, filtered by regex.
+static void prometheusFiltered(::benchmark::State& state) {
+  StatsFixture& fixture = StatsFixture::get();
+  const absl::optional<std::regex> regex(std::regex("cluster_[0-9]*00\\."));
+  uint64_t bytes = 0;
+  for (auto _ : state) {
+    PrometheusStatsRenderer renderer(fixture.counters_, {}, {}, false, regex, nullptr);
+    bytes = 0;
+    bool more = true;
+    while (more) {
+      Buffer::OwnedImpl chunk;
+      more = renderer.nextChunk(chunk, ChunkSize);
+      bytes += chunk.length();
+    }
+  }
+  state.counters["bytes"] = bytes;
+}
+BENCHMARK(prometheusFiltered)->Unit(::benchmark::kMillisecond);
+
+// Renders the JSON output in chunks, each written out before rendering the next.
+static void jsonChunks(::benchmark::State& state) {
+  StatsFixture& fixture = StatsFixture::get();
+  uint64_t bytes = 0;
+  uint64_t max_buffered = 0;
+  for (auto _ : state) {
+    StatsJsonRenderer renderer({}, fixture.counters_, {}, {}, false, absl::nullopt);
+    bytes = 0;
+    bool more = true;
+    while (more) {
+      Buffer::OwnedImpl chunk;
+      more = renderer.nextChunk(chunk, ChunkSize);
+      bytes += chunk.length();
+      max_buffered = std::max(max_buffered, chunk.length());
+    }
+  }
+  state.counters["bytes"] = bytes;
+  state.counters["max_buffered"] = max_buffered;
+}
+BENCHMARK(jsonChunks)->Unit(::benchmark::kMillisecond);
+
+} // namespace Server
+} // namespace Envoy
@@ -26,12 +26,13 @@ public:
   }
 
   static std::string
-  statsAsJsonHandler(std::map<std::string, uint64_t>& all_stats,
-                     std::map<std::string, std::string>& all_text_readouts,
-                     const std::vector<Stats::ParentHistogramSharedPtr>& all_histograms,
+  statsAsJsonHandler(const std::vector<Stats::ParentHistogramSharedPtr>& all_histograms,
                      const bool used_only, const absl::optional<std::regex> regex = absl::nullopt) {
-    return StatsHandler::statsAsJson(all_stats, all_text_readouts, all_histograms, used_only, regex,
-                                     true /*pretty_print*/);
+    StatsJsonRenderer renderer({}, {}, {}, all_histograms, used_only, regex);
+    Buffer::OwnedImpl response;
+    while (renderer.nextChunk(response, 1)) {
+    }
+    return response.toString();
   }
 
   Stats::SymbolTablePtr symbol_table_;
@@ -72,9 +73,7 @@ TEST_P(AdminStatsTest, StatsAsJson) {
   std::sort(histograms.begin(), histograms.end(),
             [](const Stats::ParentHistogramSharedPtr& a,
                const Stats::ParentHistogramSharedPtr& b) -> bool { return a->name() < b->name(); });
-  std::map<std::string, uint64_t> all_stats;
-  std::map<std::string, std::string> all_text_readouts;
-  std::string actual_json = statsAsJsonHandler(all_stats, all_text_readouts, histograms, false);
+  std::string actual_json = statsAsJsonHandler(histograms, false);
 
   const std::string expected_json = R"EOF({
     "stats": [
@@ -215,10 +214,7 @@ TEST_P(AdminStatsTest, UsedOnlyStatsAsJson) {
 
   store_->mergeHistograms([]() -> void {});
 
-  std::map<std::string, uint64_t> all_stats;
-  std::map<std::string, std::string> all_text_readouts;
-  std::string actual_json =
-      statsAsJsonHandler(all_stats, all_text_readouts, store_->histograms(), true);
+  std::string actual_json = statsAsJsonHandler(store_->histograms(), true);
 
   // Expected JSON should not have h2 values as it is not used.
   const std::string expected_json = R"EOF({
@@ -315,11 +311,8 @@ TEST_P(AdminStatsTest, StatsAsJsonFilterString) {
 
   store_->mergeHistograms([]() -> void {});
 
-  std::map<std::string, uint64_t> all_stats;
-  std::map<std::string, std::string> all_text_readouts;
-  std::string actual_json =
-      statsAsJsonHandler(all_stats, all_text_readouts, store_->histograms(), false,
-                         absl::optional<std::regex>{std::regex("[a-z]1")});
+  std::string actual_json = statsAsJsonHandler(store_->histograms(), false,
+                                               absl::optional<std::regex>{std::regex("[a-z]1")});
 
   // Because this is a filter case, we don't expect to see any stats except for those containing
   // "h1" in their name.
@@ -426,11 +419,8 @@ TEST_P(AdminStatsTest, UsedOnlyStatsAsJsonFilterString) {
 
   store_->mergeHistograms([]() -> void {});
 
-  std::map<std::string, uint64_t> all_stats;
-  std::map<std::string, std::string> all_text_readouts;
-  std::string actual_json =
-      statsAsJsonHandler(all_stats, all_text_readouts, store_->histograms(), true,
-                         absl::optional<std::regex>{std::regex("h[12]")});
+  std::string actual_json = statsAsJsonHandler(store_->histograms(), true,
+                                               absl::optional<std::regex>{std::regex("h[12]")});
 
   // Expected JSON should not have h2 values as it is not used, and should not have h3 values as
   // they are used but do not match.
@@ -506,6 +496,40 @@ TEST_P(AdminStatsTest, UsedOnlyStatsAsJsonFilterString) {
   store_->shutdownThreading();
 }
 
+TEST_P(AdminStatsTest, StatsAsJsonInChunks) {
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  store_->counterFromString("c1").add(10);
+  store_->counterFromString("c2");
+  store_->gaugeFromString("g1", Stats::Gauge::ImportMode::Accumulate).set(5);
+  store_->textReadoutFromString("t1").set("say \"hi\"\n");
+
+  // Each chunk of at least a byte holds one stat.
+  StatsJsonRenderer renderer(store_->textReadouts(), store_->counters(), store_->gauges(), {},
+                             false, absl::nullopt);
+  std::vector<std::string> chunks;
+  bool more = true;
+  while (more) {
+    Buffer::OwnedImpl chunk;
+    more = renderer.nextChunk(chunk, 1);
+    chunks.push_back(chunk.toString());
+  }
+
+  const std::vector<std::string> expected_chunks = {
+      R"EOF({"stats":[{"name":"t1","value":"say \"hi\"\n"})EOF",
+      R"EOF(,{"name":"c1","value":10})EOF", R"EOF(,{"name":"c2","value":0})EOF",
+      R"EOF(,{"name":"g1","value":5}]})EOF"};
+  EXPECT_EQ(expected_chunks, chunks);
+  store_->shutdownThreading();
+}
+
+TEST_P(AdminStatsTest, EmptyStatsAsJson) {
+  StatsJsonRenderer renderer({}, {}, {}, {}, false, absl::nullopt);
+  Buffer::OwnedImpl response;
+  EXPECT_FALSE(renderer.nextChunk(response, 1));
+  EXPECT_EQ(R"EOF({"stats":[]})EOF", response.toString());
+}
+
 INSTANTIATE_TEST_SUITE_P(IpVersions, AdminInstanceTest,
                          testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
                          TestUtility::ipTestParamsToString);
@@ -63,7 +63,7 @@ protected:
             server_.random(), server_.dnsResolver(), server_.sslContextManager(),
             server_.dispatcher(), server_.localInfo(), server_.secretManager(),
             server_.messageValidationContext(), *api_, server_.httpContext(), server_.grpcContext(),
-            server_.accessLogManager(), server_.singletonManager()) {}
+            server_.accessLogManager(), server_.singletonManager(), nullptr) {}
 
   void addStatsdFakeClusterConfig(envoy::config::metrics::v3::StatsSink& sink) {
     envoy::config::metrics::v3::StatsdSink statsd_sink;
@@ -95,6 +95,48 @@ TEST(ServerInstanceUtil, flushHelper) {
   InstanceUtil::flushMetricsToSinks(sinks, mock_store);
 }
 
+TEST(ServerInstanceUtil, FlushChangedMetrics) {
+  Stats::TestUtil::TestStore store;
+  Stats::Counter& c1 = store.counter("c1");
+  Stats::Counter& c2 = store.counter("c2");
+  Stats::Gauge& g1 = store.gauge("g1", Stats::Gauge::ImportMode::Accumulate);
+  Stats::Gauge& g2 = store.gauge("g2", Stats::Gauge::ImportMode::Accumulate);
+  c1.inc();
+  c2.inc();
+  g1.set(1);
+  g2.set(2);
+
+  std::list<Stats::SinkPtr> sinks;
+  Stats::MockSink* sink = new StrictMock<Stats::MockSink>();
+  sinks.emplace_back(sink);
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    EXPECT_EQ(2, snapshot.changedCounters().size());
+    EXPECT_EQ(2, snapshot.changedGauges().size());
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store);
+
+  // Only the metrics written since the previous flush are reported as changed, while the full
+  // snapshot still holds all of them.
+  c2.add(3);
+  g1.set(1);
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    EXPECT_EQ(2, snapshot.counters().size());
+    EXPECT_EQ(2, snapshot.gauges().size());
+    ASSERT_EQ(1, snapshot.changedCounters().size());
+    EXPECT_EQ("c2", snapshot.changedCounters()[0].counter_.get().name());
+    EXPECT_EQ(3, snapshot.changedCounters()[0].delta_);
+    ASSERT_EQ(1, snapshot.changedGauges().size());
+    EXPECT_EQ("g1", snapshot.changedGauges()[0].get().name());
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store);
+
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    EXPECT_TRUE(snapshot.changedCounters().empty());
+    EXPECT_TRUE(snapshot.changedGauges().empty());
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store);
+}
+
 class RunHelperTest : public testing::Test {
 public:
   RunHelperTest() {
@@ -340,6 +382,19 @@ TEST_P(ServerInstanceImplTest, ProxyVersionOveridesFromBootstrap) {
   server_thread->join();
 }
 
+// The shared HTTP/2 connection pool threads are watched by the guard dog, and stopped on shutdown.
+TEST_P(ServerInstanceImplTest, SharedHttp2ConnectionPoolThreads) {
+  auto server_thread = startTestServer(
+      "test/server/test_data/server/shared_http2_connection_pool_bootstrap.yaml", false);
+  EXPECT_TRUE(TestUtility::waitForCounterEq(stats_store_, "server.h2pool_0.watchdog_miss", 0,
+                                            time_system_));
+  EXPECT_TRUE(TestUtility::waitForCounterEq(stats_store_, "server.h2pool_1.watchdog_miss", 0,
+                                            time_system_));
+
+  server_->dispatcher().post([&] { server_->shutdown(); });
+  server_thread->join();
+}
+
 TEST_P(ServerInstanceImplTest, EmptyShutdownLifecycleNotifications) {
   auto server_thread = startTestServer("test/server/test_data/server/node_bootstrap.yaml", false);
   server_->dispatcher().post([&] { server_->shutdown(); });
@@ -0,0 +1,58 @@
+/**
+ * Utility to read the stats an Envoy configured with the envoy.stat_sinks.shared_memory sink
+ * mirrors to a file, without going through the admin endpoints.
+ *
+ * Usage:
+ *
+ * shared_memory_stats <stats file path> [stat name...]
+ *
+ * Prints the name and value of each stat in the file, or of the given stats only. Exits with a
+ * failure if any of the given stats is not in the file.
+ */
+#include <cstdlib>
+#include <iostream>
+
+#include "envoy/common/exception.h"
+
+#include "extensions/stat_sinks/shared_memory/shared_memory_reader.h"
+
+#include "absl/types/optional.h"
+
+// NOLINT(namespace-envoy)
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <stats file path> [stat name...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  using Envoy::Extensions::StatSinks::SharedMemory::SharedMemoryStatsReader;
+  try {
+    const SharedMemoryStatsReader reader(argv[1]);
+    if (argc == 2) {
+      const uint32_t num_stats = reader.numStats();
+      for (uint32_t position = 0; position < num_stats; ++position) {
+        std::cout << reader.name(position) << ": " << reader.value(position) << std::endl;
+      }
+      if (reader.numDropped() > 0) {
+        std::cerr << reader.numDropped() << " stats were not exported for lack of room"
+                  << std::endl;
+      }
+      return EXIT_SUCCESS;
+    }
+
+    int result = EXIT_SUCCESS;
+    for (int i = 2; i < argc; ++i) {
+      const absl::optional<uint32_t> position = reader.find(argv[i]);
+      if (position.has_value()) {
+        std::cout << argv[i] << ": " << reader.value(position.value()) << std::endl;
+      } else {
+        std::cerr << argv[i] << ": not found" << std::endl;
+        result = EXIT_FAILURE;
+      }
+    }
+    return result;
+  } catch (const Envoy::EnvoyException& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}